@@ -46,6 +46,7 @@ void Hardstuck::onUnload()
 	ShutdownBackend();
 	UnregisterUi();
 	pendingMatchUploads_.clear();
+	DiagnosticLogger::Shutdown();
 }
 
 void Hardstuck::InitializeSettingsService()
@@ -90,6 +91,17 @@ void Hardstuck::InitializeBackend()
 	);
 	if (cvarManager)
 	{
+		// Storage and upload settings take effect while running, not only after a reload.
+		for (const char* name : { settings::kStoreDurabilityCvarName, settings::kStoreSyncIntervalCvarName,
+		                          settings::kApiBaseUrlCvarName, settings::kUploadBatchSizeCvarName })
+		{
+			cvarManager->getCvar(name).addOnValueChanged([this](std::string, CVarWrapper) {
+				if (backend_)
+				{
+					backend_->ApplySettings();
+				}
+			});
+		}
 		cvarManager->log("HS: backend created");
 	}
 }
@@ -192,6 +204,7 @@ void Hardstuck::DispatchPayloadAsync(const std::string& endpoint, const std::str
 }
 
 void Hardstuck::RenderHistoryWindow(const HistorySnapshot& snapshot,
+	uint64_t snapshotVersion,
 	const std::string& errorMessage,
 	bool loading,
 	std::chrono::system_clock::time_point lastFetched)
@@ -201,7 +214,7 @@ void Hardstuck::RenderHistoryWindow(const HistorySnapshot& snapshot,
 		? CurrentSessionTypeString(inFreeplay, 0)
 		: activeFocus_;
 	const bool manualActive = focusedSessionActive_;
-	HsRenderHistoryWindowUi(snapshot, errorMessage, loading, lastFetched, &showHistoryWindow_, sessionLabel, manualActive);
+	HsRenderHistoryWindowUi(snapshot, snapshotVersion, errorMessage, loading, lastFetched, &showHistoryWindow_, sessionLabel, manualActive);
 }
 
 void Hardstuck::RenderSettings()
@@ -821,14 +834,23 @@ void Hardstuck::Render()
 	{
 		backend_->SnapshotRequestState(lastResponse, lastError);
 	}
-	std::string storageStatus;
-	size_t buffered = 0;
 	if (backend_)
 	{
-		backend_->SnapshotStorageDiagnostics(storageStatus, buffered);
-		if (!storageStatus.empty())
+		HsBackend::StorageDiagnostics storage;
+		backend_->SnapshotStorageDiagnostics(storage);
+		if (!storage.status.empty())
 		{
-			lastResponse = storageStatus + " | buffered=" + std::to_string(buffered);
+			lastResponse = storage.status + " | buffered=" + std::to_string(storage.bufferedCount) +
+				" | queue=" + std::to_string(storage.queueDepth) +
+				" | write=" + std::to_string(storage.lastWriteLatency.count() / 1000) + "ms";
+			if (storage.uploadsEnabled)
+			{
+				lastResponse += " | upload=" + std::to_string(storage.uploadPending);
+				if (storage.uploadBackoff.count() > 0)
+				{
+					lastResponse += " (retry " + std::to_string(storage.uploadBackoff.count() / 1000) + "s)";
+				}
+			}
 		}
 	}
 
@@ -837,25 +859,29 @@ void Hardstuck::Render()
 		return;
 	}
 
-	HistorySnapshot historySnapshot;
+	// Shared, immutable snapshot: holding it for the frame costs a refcount, not a copy.
+	static const HistorySnapshot kEmptyHistory;
+	std::shared_ptr<const HistorySnapshot> historySnapshot;
+	uint64_t historyVersion = 0;
 	std::string historyError;
 	bool historyLoading = false;
 	std::chrono::system_clock::time_point historyLastFetched;
 	if (backend_ && (showHistoryWindow_ || menuOpen_ || showOverlayStandalone_))
 	{
-		backend_->SnapshotHistory(historySnapshot, historyError, historyLoading, historyLastFetched);
+		backend_->SnapshotHistory(historySnapshot, historyVersion, historyError, historyLoading, historyLastFetched);
 	}
+	const HistorySnapshot& history = historySnapshot ? *historySnapshot : kEmptyHistory;
 
 	if (showHistoryWindow_)
 	{
-		RenderHistoryWindow(historySnapshot, historyError, historyLoading, historyLastFetched);
+		RenderHistoryWindow(history, historyVersion, historyError, historyLoading, historyLastFetched);
 	}
 	if (!menuOpen_ && !showOverlayStandalone_)
 	{
 		return;
 	}
 
-	RenderOverlay(lastResponse, lastError, historySnapshot, historyError, historyLoading, historyLastFetched);
+	RenderOverlay(lastResponse, lastError, history, historyError, historyLoading, historyLastFetched);
 }
 
 // Stub implementations for match event hooks
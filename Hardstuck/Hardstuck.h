@@ -78,6 +78,7 @@ private:
 	void OpenHistoryWindow();
 	void ExecuteHistoryWindowCommand();
 	void RenderHistoryWindow(const HistorySnapshot& snapshot,
+	                         uint64_t snapshotVersion,
 	                         const std::string& errorMessage,
 	                         bool loading,
 	                         std::chrono::system_clock::time_point lastFetched);
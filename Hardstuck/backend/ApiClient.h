@@ -1,38 +1,85 @@
 #pragma once
 
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <vector>
 
-struct HttpHeader {
-    std::string name;
-    std::string value;
+#include "backend/HttpTransport.h"
 
-    HttpHeader() = default;
-    HttpHeader(std::string n, std::string v) : name(std::move(n)), value(std::move(v)) {}
+struct ApiResult {
+    bool success{false};
+    std::string response;
+    std::string error;
 };
 
 class ApiClient {
 public:
-    ApiClient(std::string baseUrl);
+    using Callback = std::function<void(const ApiResult&)>;
+
+    // A null transport selects the platform default: pooled WinHTTP on Windows, the
+    // POSIX socket transport elsewhere.
+    ApiClient(std::string baseUrl, std::shared_ptr<IHttpTransport> transport = nullptr);
+    ~ApiClient();
+
+    ApiClient(const ApiClient&) = delete;
+    ApiClient& operator=(const ApiClient&) = delete;
+
     void SetBaseUrl(std::string newBaseUrl);
     std::string NormalizeBaseUrl(const std::string& url) const;
     std::string BuildUrl(const std::string& endpoint) const;
+    // `statusCode` (optional) receives the HTTP status, or 0 when no response arrived.
     bool PostJson(const std::string& endpoint,
                   const std::string& body,
                   const std::vector<HttpHeader>& headers,
                   std::string& response,
-                  std::string& error) const;
+                  std::string& error,
+                  int* statusCode = nullptr) const;
     bool GetJson(const std::string& endpoint,
                  const std::vector<HttpHeader>& headers,
                  std::string& response,
                  std::string& error) const;
 
+    // Queue a POST on the client's worker thread; requests run in order over the pooled
+    // transport. Anything still queued when the client is destroyed fails with an error.
+    std::future<ApiResult> PostJsonAsync(const std::string& endpoint,
+                                         std::string body,
+                                         std::vector<HttpHeader> headers);
+    void PostJsonAsync(const std::string& endpoint,
+                       std::string body,
+                       std::vector<HttpHeader> headers,
+                       Callback onComplete);
+
 private:
+    struct PendingRequest {
+        std::string url;
+        std::string body;
+        std::vector<HttpHeader> headers;
+        std::promise<ApiResult> promise;
+        Callback onComplete;
+    };
+
     bool SendRequest(const std::string& method,
-                     const std::string& endpoint,
+                     const std::string& url,
                      const std::vector<HttpHeader>& headers,
                      const std::string* body,
                      std::string& response,
-                     std::string& error) const;
+                     std::string& error,
+                     int* statusCode = nullptr) const;
+    void Enqueue(PendingRequest request);
+    void RunWorker();
+
     std::string baseUrl;
+    std::shared_ptr<IHttpTransport> transport;
+
+    std::mutex queueMutex;
+    std::condition_variable queueCv;
+    std::deque<PendingRequest> queue;
+    bool stopping{false};
+    std::thread worker;
 };
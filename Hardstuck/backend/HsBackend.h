@@ -8,9 +8,14 @@
 #include <future>
 #include <mutex>
 #include <chrono>
+#include <memory>
 
 #include "history/HistoryTypes.h"
 #include "storage/LocalDataStore.h"
+#include "storage/StoreWriter.h"
+#include "storage/UploadQueue.h"
+#include "backend/ApiClient.h"
+#include "backend/UploadSyncer.h"
 #include "payload/HsPayloadBuilder.h"
 
 class CVarManagerWrapper;
@@ -26,6 +31,22 @@ public:
                CVarManagerWrapper* cvarManager,
                GameWrapper* gameWrapper,
                SettingsService* settingsService);
+    ~HsBackend();
+
+    // Storage health for the status line (thread-safe copy).
+    struct StorageDiagnostics
+    {
+        std::string status;
+        size_t bufferedCount{0};
+        size_t queueDepth{0};
+        size_t queueHighWater{0};
+        uint64_t rejectedWrites{0};
+        std::chrono::microseconds lastWriteLatency{0};
+        std::chrono::microseconds maxWriteLatency{0};
+        bool uploadsEnabled{false};
+        size_t uploadPending{0};
+        std::chrono::milliseconds uploadBackoff{0};
+    };
 
     // Network + logging of match payloads
     void DispatchPayloadAsync(const std::string& endpoint, const std::string& body);
@@ -45,11 +66,15 @@ public:
 
     // Snapshot request state for UI (thread-safe copy).
     void SnapshotRequestState(std::string& lastResponse, std::string& lastError) const;
-    void SnapshotStorageDiagnostics(std::string& status, size_t& bufferedCount) const;
+    void SnapshotStorageDiagnostics(StorageDiagnostics& diagnostics) const;
+
+    // Re-queue payloads whose write failed and wait for the writer to drain.
     void FlushBufferedWrites();
 
-    // Snapshot history state for UI (thread-safe copy).
-    void SnapshotHistory(HistorySnapshot& snapshot,
+    // Snapshot history state for UI. The snapshot is shared and immutable, so this only
+    // bumps a refcount; `version` changes whenever a reload publishes a new one.
+    void SnapshotHistory(std::shared_ptr<const HistorySnapshot>& snapshot,
+                         uint64_t& version,
                          std::string& errorMessage,
                          bool& loading,
                          std::chrono::system_clock::time_point& lastFetched) const;
@@ -59,7 +84,16 @@ public:
 
     std::filesystem::path GetStorePath() const;
 
+    // Re-read the store durability, sync interval, backend URL and upload batch size. Called
+    // when one of their cvars changes; uploads start, stop or move to the new server.
+    void ApplySettings();
+
 private:
+    StoreFile::Durability ReadStoreDurability() const;
+    void ConfigureUploads();
+    void OnBatchPersisted(const StoreWriter::BatchResult& result);
+    void BufferForRetry(std::vector<std::string> payloads);
+
     // Non-owning pointers to plugin services
     CVarManagerWrapper* cvarManager_;
     GameWrapper*        gameWrapper_;
@@ -74,20 +108,35 @@ private:
     std::vector<std::future<void>> pendingRequests_;
     std::string lastResponseMessage_;
     std::string lastErrorMessage_;
-    std::deque<std::string> bufferedPayloads_;
+    std::deque<std::string> bufferedPayloads_; // writes that failed or overflowed the writer queue
     std::string lastWriteStatus_;
     static constexpr size_t kMaxBufferedPayloads = 8;
 
     // History state
     mutable std::mutex historyMutex_;
-    HistorySnapshot historySnapshot_;
+    std::shared_ptr<const HistorySnapshot> historySnapshot_;
+    uint64_t historyVersion_{0};
     std::string historyErrorMessage_;
     bool historyLoading_{false};
     std::chrono::system_clock::time_point historyLastFetched_{};
     bool historyDirty_{true};
 
+    // Outbound sync: stored payloads are queued on disk and uploaded in batches. The
+    // client and syncer exist only while a backend URL is configured; the queue, once
+    // opened, for the backend's lifetime. The pointers are guarded by uploadMutex_.
+    mutable std::mutex uploadMutex_;
+    std::string uploadBaseUrl_;
+    size_t uploadBatchSize_{0};
+    std::unique_ptr<UploadQueue> uploadQueue_;
+    std::unique_ptr<ApiClient> apiClient_;
+    std::unique_ptr<UploadSyncer> uploader_;
+
     // Cached last match payload
     mutable std::mutex payloadMutex_;
     std::string lastPayload_;
     std::string lastPayloadContext_;
+
+    // Declared last so the writer drains and joins before anything it calls back into,
+    // including the upload queue.
+    std::unique_ptr<StoreWriter> writer_;
 };
@@ -0,0 +1,50 @@
+// HttpTransport.h
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+struct HttpHeader
+{
+    std::string name;
+    std::string value;
+
+    HttpHeader() = default;
+    HttpHeader(std::string n, std::string v) : name(std::move(n)), value(std::move(v)) {}
+};
+
+struct HttpRequest
+{
+    std::string method;
+    std::string url;
+    std::vector<HttpHeader> headers;
+    const std::string* body{nullptr};
+};
+
+struct HttpResponse
+{
+    int statusCode{0};
+    std::string body;
+};
+
+struct ParsedUrl
+{
+    bool secure{false};
+    std::string host;
+    uint16_t port{80};
+    std::string path{"/"};
+};
+
+bool ParseHttpUrl(const std::string& url, ParsedUrl& parsed, std::string& error);
+
+// One HTTP exchange. Implementations own connection reuse and must be safe to call from
+// several threads; a non-2xx status is still a successful Send.
+class IHttpTransport
+{
+public:
+    virtual ~IHttpTransport() = default;
+
+    virtual bool Send(const HttpRequest& request, HttpResponse& response, std::string& error) = 0;
+};
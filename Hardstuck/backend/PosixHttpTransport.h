@@ -0,0 +1,50 @@
+// PosixHttpTransport.h
+#pragma once
+
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "backend/HttpTransport.h"
+
+// Minimal HTTP/1.1 client over non-blocking POSIX sockets, waited on with epoll. Idle
+// connections are pooled per host:port and reused while the server allows keep-alive;
+// responses may be Content-Length delimited, chunked, or closed by the server. Plain
+// http:// only. On Windows Send() reports an error; use WinHttpTransport there.
+class PosixHttpTransport : public IHttpTransport
+{
+public:
+    struct Options
+    {
+        std::chrono::milliseconds connectTimeout{5000};
+        std::chrono::milliseconds ioTimeout{15000};
+        size_t maxIdlePerHost{4};
+    };
+
+    PosixHttpTransport();
+    explicit PosixHttpTransport(Options options);
+    ~PosixHttpTransport() override;
+
+    PosixHttpTransport(const PosixHttpTransport&) = delete;
+    PosixHttpTransport& operator=(const PosixHttpTransport&) = delete;
+
+    bool Send(const HttpRequest& request, HttpResponse& response, std::string& error) override;
+
+private:
+    struct Connection
+    {
+        int fd{-1};
+        int poller{-1};
+    };
+
+    bool TakeIdle(const std::string& key, Connection& connection);
+    void ReturnIdle(const std::string& key, Connection connection);
+    bool Connect(const ParsedUrl& url, Connection& connection, std::string& error) const;
+    static void Close(Connection& connection);
+
+    Options options_;
+    std::mutex mutex_;
+    std::map<std::string, std::vector<Connection>> idle_;
+};
@@ -0,0 +1,89 @@
+// UploadSyncer.h
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "storage/UploadQueue.h"
+
+class ApiClient;
+
+// Drains an UploadQueue to the backend on its own thread. Each request carries a batch of
+// up to `batchSize` records; a 2xx acknowledges the whole batch. Retryable failures back
+// off exponentially with jitter until a request succeeds again; that includes answers
+// about the endpoint rather than the records (a redirect, 401/403, 404/405), so a wrong URL
+// or bad credentials never cost the queue anything. A rejection of the records themselves
+// (400/413/422) is not retried as is: the batch is halved until the rejected record is
+// alone, and that record goes to the queue's dead-letter file and is acknowledged past so
+// the queue behind it keeps moving.
+class UploadSyncer
+{
+public:
+    struct Options
+    {
+        std::string endpoint{"/api/mmr-log/batch"};
+        size_t batchSize{50};
+        size_t maxBatchBytes{512 * 1024};
+        std::chrono::milliseconds initialBackoff{2000};
+        std::chrono::milliseconds maxBackoff{5 * 60 * 1000};
+    };
+
+    struct Stats
+    {
+        uint64_t batchesSent{0};
+        uint64_t recordsSent{0};
+        uint64_t failedRequests{0};
+        uint64_t rejectedRequests{0}; // record rejections, counted apart from failures
+        uint64_t droppedRecords{0};   // rejected on their own and dead-lettered
+        uint32_t consecutiveFailures{0};
+        std::chrono::milliseconds currentBackoff{0};
+        std::string lastError;
+    };
+
+    UploadSyncer(UploadQueue& queue, ApiClient& client, Options options);
+    ~UploadSyncer();
+
+    UploadSyncer(const UploadSyncer&) = delete;
+    UploadSyncer& operator=(const UploadSyncer&) = delete;
+
+    // Wake the thread after new records were appended. Does not cut a backoff short.
+    void Notify();
+
+    // Finish the request in flight, if any, and join the thread. Called by the destructor.
+    void Stop();
+
+    Stats GetStats() const;
+
+    // {"records":[{"seq":1,"payload":{...}},...]}; payloads are embedded verbatim.
+    static std::string BuildBatchBody(const std::vector<UploadQueue::Record>& records);
+
+    // Delay before retry number `failures` (1-based): the capped exponential step, of which
+    // the upper half is randomised so clients that failed together do not retry together.
+    static std::chrono::milliseconds BackoffDelay(uint32_t failures, const Options& options, std::mt19937_64& rng);
+
+    // Whether a failed request means the server will never accept some record in the batch:
+    // 400, 413 or 422. Anything else (no response, 3xx, other 4xx, 5xx) is retried unchanged
+    // after a backoff.
+    static bool IsRecordRejection(int statusCode);
+
+private:
+    void Run();
+
+    UploadQueue& queue_;
+    ApiClient& client_;
+    Options options_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable wakeCv_;
+    bool notified_{true};
+    bool stopping_{false};
+    std::chrono::steady_clock::time_point retryAt_{};
+    Stats stats_;
+    std::thread thread_;
+};
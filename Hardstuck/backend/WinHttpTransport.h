@@ -0,0 +1,31 @@
+// WinHttpTransport.h
+#pragma once
+
+#include <map>
+#include <mutex>
+#include <string>
+
+#include "backend/HttpTransport.h"
+
+// WinHTTP transport that keeps one session for its lifetime and one connection handle per
+// host:port. WinHTTP pools keep-alive sockets per session, so later requests to the same
+// host skip the TCP and TLS handshakes. On other platforms Send() reports an error.
+class WinHttpTransport : public IHttpTransport
+{
+public:
+    WinHttpTransport();
+    ~WinHttpTransport() override;
+
+    WinHttpTransport(const WinHttpTransport&) = delete;
+    WinHttpTransport& operator=(const WinHttpTransport&) = delete;
+
+    bool Send(const HttpRequest& request, HttpResponse& response, std::string& error) override;
+
+private:
+    // HINTERNET handles, kept opaque so the header does not pull in <windows.h>.
+    void* AcquireConnection(const ParsedUrl& url, std::string& error);
+
+    std::mutex mutex_;
+    void* session_{nullptr};
+    std::map<std::string, void*> connections_;
+};
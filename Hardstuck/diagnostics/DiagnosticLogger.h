@@ -1,12 +1,32 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
 #include <string>
 
 class DiagnosticLogger {
 public:
-    // Initialize logger; called once from plugin startup.
+    struct Stats {
+        uint64_t written{0};
+        uint64_t dropped{0};   // records lost because the ring was full
+        size_t queued{0};
+        size_t capacity{0};
+    };
+
+    // Initialize logger; called once from plugin startup. Opens the log file and starts the
+    // background flusher. Log() calls it on first use.
     static void Init();
 
-    // Thread-safe append message with timestamp.
+    // Thread-safe and non-blocking: the message is timestamped and pushed onto a fixed-size
+    // lock-free ring, and a background thread writes it out. Dropped and counted when full.
     static void Log(const std::string& msg);
+
+    // Block until everything logged so far has been written to the file.
+    static void Flush();
+
+    // Drain the ring, stop the flusher, and close the file. Call from plugin unload; any
+    // later Log() writes synchronously.
+    static void Shutdown();
+
+    static Stats GetStats();
 };
@@ -0,0 +1,39 @@
+// HistoryColumns.h
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "history/HistoryTypes.h"
+
+// Builds MmrColumns and the plain loops that run over them. The kernels take raw spans so
+// the compiler can vectorise them; none of them allocate.
+namespace HistoryColumns
+{
+    // Extend `columns` with history[firstEntry..]. Falls back to a full rebuild when the new
+    // entries sort before the last column row, and returns false when it did.
+    bool Append(MmrColumns& columns, const std::vector<MmrHistoryEntry>& history, size_t firstEntry);
+    void Rebuild(MmrColumns& columns, const std::vector<MmrHistoryEntry>& history);
+
+    // Rows of one playlist, in order. Deltas are kept from the source columns.
+    MmrColumns Filter(const MmrColumns& columns, SymbolId playlist);
+
+    void MinMax(const int32_t* values, size_t count, int32_t& minValue, int32_t& maxValue);
+    void ToFloat(const int32_t* values, size_t count, float* out);
+
+    // out[0] = 0, out[i] = series[i] - series[i - 1].
+    void AdjacentDeltas(const float* series, size_t count, float* out);
+
+    // Largest-Triangle-Three-Buckets: pick at most `target` rows of `values` that keep the
+    // shape of the line, peaks included. Writes ascending row indices (always the first and
+    // last row) to `selected`, which needs room for min(count, target) entries, and returns
+    // how many were written. Every row is kept when count <= target.
+    size_t DownsampleLttb(const int32_t* values, size_t count, size_t target, uint32_t* selected);
+
+    // Map series[i] onto a plot rectangle: x spreads the points evenly from x0 to x1, y maps
+    // [minValue, maxValue] onto [y1, y0] (screen y grows downwards). `xy` receives
+    // interleaved x, y pairs.
+    void Project(const float* series, size_t count, float minValue, float maxValue,
+                 float x0, float y0, float x1, float y1, float* xy);
+}
@@ -2,7 +2,12 @@
 #pragma once
 #include "HistoryTypes.h"
 
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <map>
 #include <optional>
@@ -25,6 +30,8 @@ namespace HistoryJson
         Type type = Type::Null;
         std::string stringValue;
         double numberValue = 0.0;
+        int64_t integerValue = 0;
+        bool isInteger = false; // numberValue came from an integer literal that fits integerValue
         bool boolValue = false;
         std::vector<Value> arrayValue;
         std::map<std::string, Value> objectValue;
@@ -54,8 +61,160 @@ namespace HistoryJson
 
     const Value* GetMember(const Value& object, const std::string& key);
     std::optional<std::string> AsString(const Value* value);
+    // Integer literals are returned exactly; other numbers are rounded. AsInt returns
+    // nullopt when the value does not fit in an int.
     std::optional<int> AsInt(const Value* value);
+    std::optional<int64_t> AsInt64(const Value* value);
     std::vector<std::string> AsStringList(const Value* value);
 
+    // Bump allocator backing a ViewDocument. Reset() frees every allocation at once and
+    // keeps the largest block for the next parse.
+    class Arena
+    {
+    public:
+        void* Allocate(size_t bytes, size_t alignment);
+        void Reset();
+
+    private:
+        struct Block
+        {
+            std::unique_ptr<std::byte[]> data;
+            size_t size{0};
+        };
+
+        std::vector<Block> blocks_;
+        size_t used_{0};
+    };
+
+    struct ViewMember;
+
+    // Zero-copy counterpart of Value. Strings point into the parsed buffer, or into the
+    // arena when they had escapes; arrays and objects are flat spans in the arena.
+    struct ViewValue
+    {
+        Type type = Type::Null;
+        std::string_view stringValue;
+        double numberValue = 0.0;
+        int64_t integerValue = 0;
+        bool isInteger = false;
+        bool boolValue = false;
+        const ViewValue* elements = nullptr;
+        const ViewMember* members = nullptr;
+        uint32_t size = 0;
+    };
+
+    struct ViewMember
+    {
+        std::string_view key;
+        ViewValue value;
+    };
+
+    // Parses into arena-backed ViewValues. The source buffer must outlive the document,
+    // and each Parse() invalidates views from the previous one. Reusing one document
+    // across many lines keeps parsing allocation-free once the arena has warmed up.
+    class ViewDocument
+    {
+    public:
+        bool Parse(std::string_view data, std::string& error);
+        const ViewValue& Root() const { return root_; }
+
+    private:
+        friend class ViewParser;
+
+        Arena arena_;
+        std::vector<ViewValue> elementStack_;
+        std::vector<ViewMember> memberStack_;
+        ViewValue root_;
+    };
+
+    const ViewValue* GetMember(const ViewValue& object, std::string_view key);
+    std::optional<std::string_view> AsString(const ViewValue* value);
+    std::optional<int> AsInt(const ViewValue* value);
+    std::optional<int64_t> AsInt64(const ViewValue* value);
+
+    template <size_t N>
+    using KeyList = std::array<std::string_view, N>;
+
+    // Pull-style reader for flat records: walks the top-level object once, parses only the
+    // scalars named in a compile-time KeyList and skips every other subtree by scanning
+    // for its closing bracket. Nothing is materialized; wanted values arrive as ViewValues
+    // whose views stay valid until the callback returns.
+    class FieldExtractor
+    {
+    public:
+        explicit FieldExtractor(std::string_view data);
+
+        // Calls onField(keyIndex, value) for the first occurrence of each wanted key.
+        // Wanted keys holding arrays/objects are skipped and reported with size 0.
+        template <size_t N, typename OnField>
+        bool Extract(const KeyList<N>& keys, OnField&& onField, std::string& error)
+        {
+            static_assert(N <= 64, "FieldExtractor tracks wanted keys in a 64-bit mask");
+            uint64_t seen = 0;
+            bool done = false;
+            if (!BeginObject(done, error))
+            {
+                return false;
+            }
+            while (!done)
+            {
+                std::string_view key;
+                if (!NextKey(key, error))
+                {
+                    return false;
+                }
+
+                size_t index = N;
+                for (size_t i = 0; i < N; ++i)
+                {
+                    if (keys[i] == key && !(seen & (uint64_t{1} << i)))
+                    {
+                        index = i;
+                        break;
+                    }
+                }
+
+                if (index == N)
+                {
+                    if (!SkipValue(error))
+                    {
+                        return false;
+                    }
+                }
+                else
+                {
+                    ViewValue value;
+                    if (!ReadValue(value, error))
+                    {
+                        return false;
+                    }
+                    seen |= uint64_t{1} << index;
+                    onField(index, static_cast<const ViewValue&>(value));
+                }
+
+                if (!NextMember(done, error))
+                {
+                    return false;
+                }
+            }
+            return Finish(error);
+        }
+
+    private:
+        bool BeginObject(bool& empty, std::string& error);
+        bool NextKey(std::string_view& key, std::string& error);
+        bool NextMember(bool& done, std::string& error);
+        bool ReadValue(ViewValue& value, std::string& error);
+        bool ReadString(std::string_view& value, std::string& error);
+        bool SkipValue(std::string& error);
+        bool SkipString(std::string& error);
+        bool Finish(std::string& error);
+        void SkipWhitespace();
+
+        std::string_view data_;
+        size_t pos_{0};
+        std::string scratch_;
+    };
+
     bool ParseHistoryResponse(const std::string& payload, HistorySnapshot& snapshot, std::string& error);
 }
@@ -0,0 +1,49 @@
+// HistoryRollups.h
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "history/HistoryTypes.h"
+
+enum class RollupPeriod : uint8_t
+{
+    Day,
+    Week,
+    Season,
+};
+
+// Incremental maintenance and range queries for HistorySnapshot::rollups.
+//
+// Bucket keys: a day is EpochDay; a week counts Monday-based weeks since the epoch; a season
+// is the competitive season number (free-to-play numbering, 0 for anything earlier). Season
+// starts come from a built-in calendar, with later seasons assumed to follow every 13 weeks.
+namespace HistoryRollups
+{
+    int32_t Key(RollupPeriod period, int32_t day);
+    int32_t FirstDay(RollupPeriod period, int32_t key);
+
+    RollupTable& Table(PeriodRollups& rollups, RollupPeriod period);
+    const RollupTable& Table(const PeriodRollups& rollups, RollupPeriod period);
+
+    // Fold MMR rows [rollups.mmrRows, columns.Size()) into every table. Rows must extend the
+    // columns already folded in; after the columns are rebuilt, call ResetMmr first.
+    void AddMmrRows(PeriodRollups& rollups, const MmrColumns& columns, const std::vector<MmrHistoryEntry>& history);
+    void ResetMmr(PeriodRollups& rollups);
+
+    // Order-independent sums, fed by whoever owns the source records.
+    void AddSessionSeconds(PeriodRollups& rollups, int32_t day, SymbolId sessionType, double seconds);
+    void AddTrainingMinutes(PeriodRollups& rollups, int32_t day, float minutes);
+
+    // nullptr when the table has no bucket for `key`.
+    const RollupBucket* Find(const RollupTable& table, int32_t key);
+
+    // Buckets with fromKey <= key <= toKey, as a [first, last) range of table.buckets.
+    std::pair<size_t, size_t> Range(const RollupTable& table, int32_t fromKey, int32_t toKey);
+
+    // One playlist over buckets [first, last): open of the first period played, close of
+    // the last, and summed deltas and games.
+    RollupStats Combine(const RollupTable& table, size_t first, size_t last, SymbolId playlist);
+}
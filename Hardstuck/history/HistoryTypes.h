@@ -1,8 +1,10 @@
 #pragma once
 
+#include <cstdint>
 #include <string>
 #include <vector>
-#include <map>
+
+#include "history/SymbolTable.h"
 
 struct HistoryFilters {
     std::string playlist;
@@ -12,13 +14,17 @@ struct HistoryFilters {
     std::string sessionEnd;
 };
 
+// Times in the history model are UTC epoch seconds, parsed once when entries are built;
+// 0 means the source had no usable timestamp. Day buckets are whole days since the epoch
+// (EpochDay), so sorting and per-day grouping compare integers. Strings are produced only
+// by the UI.
 struct HistoryStatus {
-    std::string receivedAt;
-    std::string generatedAt;
+    int64_t receivedAt = 0;
+    int64_t generatedAt = 0;
     int mmrEntries = 0;
     int trainingSessions = 0;
-    std::string lastMmrTimestamp;
-    std::string lastTrainingTimestamp;
+    int64_t lastMmrTimestamp = 0;
+    int64_t lastTrainingTimestamp = 0;
     int mmrLimit = 0;
     int sessionLimit = 0;
     HistoryFilters filters;
@@ -26,18 +32,20 @@ struct HistoryStatus {
 
 struct MmrHistoryEntry {
     std::string id;
-    std::string timestamp;
-    std::string playlist;
+    int64_t timestamp = 0;
+    int32_t day = 0;
+    SymbolId playlist = 0;
     int mmr = 0;
     int gamesPlayedDiff = 0;
-    std::string source;
+    SymbolId source = 0;
 };
 
 struct TrainingHistoryEntry {
     std::string id;
-    std::string startedTime;
-    std::string finishedTime;
-    std::string source;
+    int64_t startedTime = 0;
+    int64_t finishedTime = 0;
+    int32_t day = 0; // day of finishedTime, or of startedTime when unfinished
+    SymbolId source = 0;
     std::string presetId;
     std::string notes;
     int actualDuration = 0;
@@ -45,21 +53,94 @@ struct TrainingHistoryEntry {
     int blocks = 0;
 };
 
+// Positions in HistorySnapshot::mmrHistory; -1 when there is no such entry.
+struct LatestMmrPair {
+    int latest = -1;
+    int previous = -1;
+};
+
+// Columnar copy of mmrHistory in timestamp order (ties keep history order), for chart and
+// aggregate loops that only need a few numeric fields. Maintained by HistoryColumns.
+struct MmrColumns {
+    std::vector<int64_t> timestamps;
+    std::vector<int32_t> days;
+    std::vector<int32_t> mmr;
+    std::vector<SymbolId> playlist;
+    std::vector<int32_t> delta;    // change from the previous entry of the same playlist
+    std::vector<uint32_t> entry;   // position in mmrHistory
+    std::vector<int32_t> lastMmrByPlaylist; // append state, indexed by playlist id
+
+    size_t Size() const { return mmr.size(); }
+};
+
+// One playlist over one rollup period.
+struct RollupStats {
+    int32_t open = 0;    // first MMR of the period
+    int32_t close = 0;   // last MMR of the period
+    int32_t min = 0;
+    int32_t max = 0;
+    int32_t delta = 0;   // close minus the previous period's close (minus open for the first one)
+    int32_t games = 0;   // sum of gamesPlayedDiff
+    int32_t entries = 0; // 0 when the playlist was not played in the period
+};
+
+// Totals for one day, week or season. Keys are defined by HistoryRollups.
+struct RollupBucket {
+    int32_t key = 0;
+    std::vector<RollupStats> byPlaylist;        // indexed by playlist id
+    SymbolId lastPlaylist = 0;                  // playlist of the period's last MMR entry
+    std::vector<double> secondsBySessionType;   // indexed by session type id
+    float trainingMinutes = 0.0f;
+};
+
+struct RollupTable {
+    std::vector<RollupBucket> buckets; // ascending key
+};
+
+// Per-period tables kept next to the snapshot so range views (the comparison table, exports)
+// read a few buckets instead of regrouping every entry. Maintained by HistoryRollups.
+struct PeriodRollups {
+    RollupTable days;
+    RollupTable weeks;
+    RollupTable seasons;
+    size_t mmrRows = 0; // MmrColumns rows folded in so far
+};
+
+// Names for the SymbolId fields of a snapshot, one table per field so aggregates indexed
+// by id stay dense.
+struct HistorySymbols {
+    SymbolTable playlists;
+    SymbolTable sources;
+    SymbolTable sessionTypes;
+};
+
 struct HistorySnapshot {
+    HistorySymbols symbols;
     std::vector<MmrHistoryEntry> mmrHistory;
+    MmrColumns mmrColumns;
+    PeriodRollups rollups;
     std::vector<TrainingHistoryEntry> trainingHistory;
     HistoryStatus status;
     struct Aggregates
     {
-        std::map<std::string, double> timeBySessionType; // seconds
+        std::vector<double> secondsBySessionType; // indexed by session type id
         struct MmrDelta
         {
-            std::string timestamp;
-            std::string playlist;
-            std::string sessionType;
+            int64_t timestamp = 0;
+            SymbolId playlist = 0;
+            SymbolId sessionType = 0;
             int mmr = 0;
             int delta = 0;
         };
         std::vector<MmrDelta> mmrDeltas;
     } aggregates;
+
+    // Kept up to date by SnapshotIndex as entries are added, so per-frame readers (the
+    // overlay) look values up instead of scanning the history.
+    struct Index
+    {
+        LatestMmrPair overall;
+        std::vector<LatestMmrPair> byPlaylist; // indexed by playlist id
+        int32_t latestDay = 0; // day of the overall latest entry
+    } index;
 };
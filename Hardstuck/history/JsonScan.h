@@ -0,0 +1,42 @@
+// JsonScan.h
+#pragma once
+
+#include <cstddef>
+#include <string_view>
+
+// Byte scanners for the JSON hot loops. Each returns the index of the first matching byte
+// at or after `pos`, or data.size() when there is none. SSE2/AVX2 variants are picked at
+// runtime from the CPU's features; the scalar versions are the reference behaviour.
+namespace HistoryJson::Scan
+{
+    enum class Level
+    {
+        Scalar,
+        Sse2,
+        Avx2
+    };
+
+    // Best level this CPU supports.
+    Level DetectedLevel();
+    Level ActiveLevel();
+    // Override the active level (clamped to DetectedLevel()); meant for tests and benches.
+    void SetLevel(Level level);
+
+    // First '"' or '\\' — the end of an escape-free string run.
+    size_t FindQuoteOrBackslash(std::string_view data, size_t pos);
+    // First '"', '{', '}', '[' or ']' — the next byte that matters when skipping a subtree.
+    size_t FindStructural(std::string_view data, size_t pos);
+    // First byte that std::isspace would reject (space and \t \n \v \f \r are skipped).
+    size_t SkipWhitespace(std::string_view data, size_t pos);
+    // First '\n' — the end of a JSONL record.
+    size_t FindNewline(std::string_view data, size_t pos);
+
+    // Reference implementations, used for short tails and by the differential test.
+    namespace Scalar
+    {
+        size_t FindQuoteOrBackslash(std::string_view data, size_t pos);
+        size_t FindStructural(std::string_view data, size_t pos);
+        size_t SkipWhitespace(std::string_view data, size_t pos);
+        size_t FindNewline(std::string_view data, size_t pos);
+    }
+}
@@ -0,0 +1,23 @@
+// SnapshotIndex.h
+#pragma once
+
+#include <cstddef>
+
+#include "history/HistoryTypes.h"
+
+// Incremental maintenance of HistorySnapshot::index, mmrColumns and rollups. Callers that
+// append to mmrHistory or trainingHistory pass the position of the first new entry; entries
+// may arrive in any timestamp order. Rollup session seconds come from the local store and
+// are not recomputed by Rebuild.
+namespace SnapshotIndex
+{
+    void AddMmrEntries(HistorySnapshot& snapshot, size_t firstEntry);
+    void AddTrainingEntries(HistorySnapshot& snapshot, size_t firstEntry);
+
+    // Drop and recompute the whole index.
+    void Rebuild(HistorySnapshot& snapshot);
+
+    // Minutes trained on the day of the latest MMR entry, or the last session's minutes
+    // when there is no MMR history. Constant time.
+    float LatestDayTrainingMinutes(const HistorySnapshot& snapshot);
+}
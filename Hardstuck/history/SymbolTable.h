@@ -0,0 +1,40 @@
+// SymbolTable.h
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+using SymbolId = uint16_t;
+
+// Interns a low-cardinality text field (playlist, source, session type) to small dense
+// ids. Id 0 is always the empty string and ids never change for the life of the table,
+// so per-symbol aggregates can live in flat arrays indexed by id.
+class SymbolTable
+{
+public:
+    SymbolTable();
+
+    // Id for `value`, added on first use. Falls back to 0 once the id space is exhausted.
+    SymbolId Intern(std::string_view value);
+
+    // Id of a value interned earlier; false when it never was.
+    bool Find(std::string_view value, SymbolId& id) const;
+
+    const std::string& Name(SymbolId id) const;
+    size_t Size() const { return names_.size(); }
+
+private:
+    struct Hash
+    {
+        using is_transparent = void;
+        size_t operator()(std::string_view value) const { return std::hash<std::string_view>{}(value); }
+    };
+
+    std::vector<std::string> names_;
+    std::unordered_map<std::string, SymbolId, Hash, std::equal_to<>> ids_;
+};
@@ -15,6 +15,10 @@ namespace settings
     constexpr char kPostMatchDelayCvarName[] = "hs_post_match_mmr_delay";
     constexpr char kFocusListCvarName[] = "hs_focus_list";
     constexpr char kDailyGoalMinutesCvarName[] = "hs_daily_goal_minutes";
+    constexpr char kStoreSyncIntervalCvarName[] = "hs_store_sync_interval_ms";
+    constexpr char kStoreDurabilityCvarName[] = "hs_store_durability";
+    constexpr char kApiBaseUrlCvarName[] = "hs_api_base_url";
+    constexpr char kUploadBatchSizeCvarName[] = "hs_upload_batch_size";
 }
 
 class ISettingsService
@@ -39,4 +43,8 @@ public:
     virtual void SetDailyGoalMinutes(int minutes) = 0;
     virtual int GetGamesPlayedIncrement() const = 0;
     virtual float GetPostMatchMmrDelaySeconds() const = 0;
+    virtual int GetStoreSyncIntervalMs() const = 0;
+    virtual std::string GetStoreDurability() const = 0;
+    virtual std::string GetApiBaseUrl() const = 0;
+    virtual int GetUploadBatchSize() const = 0;
 };
@@ -29,6 +29,10 @@ public:
     void SetDailyGoalMinutes(int minutes) override;
     int GetGamesPlayedIncrement() const override;
     float GetPostMatchMmrDelaySeconds() const override;
+    int GetStoreSyncIntervalMs() const override;
+    std::string GetStoreDurability() const override;
+    std::string GetApiBaseUrl() const override;
+    int GetUploadBatchSize() const override;
 
 private:
     static std::vector<std::string> NormalizeFocusList(const std::vector<std::string>& focuses);
@@ -5,106 +5,40 @@
 #include <cctype>
 #include <sstream>
 
-#ifdef _WIN32
-#include <windows.h>
-#include <winhttp.h>
-#pragma comment(lib, "winhttp.lib")
-#endif
+#include "backend/PosixHttpTransport.h"
+#include "backend/WinHttpTransport.h"
 
 namespace
 {
-#ifdef _WIN32
-    struct ParsedUrl
-    {
-        bool secure;
-        std::wstring host;
-        INTERNET_PORT port;
-        std::wstring path;
-    };
-
-    std::wstring ToWide(const std::string& value)
-    {
-        if (value.empty())
-        {
-            return std::wstring();
-        }
-
-        int sizeNeeded = MultiByteToWideChar(CP_UTF8, 0, value.data(), static_cast<int>(value.size()), nullptr, 0);
-        if (sizeNeeded <= 0)
-        {
-            return std::wstring();
-        }
-
-        std::wstring result;
-        result.resize(sizeNeeded);
-        MultiByteToWideChar(CP_UTF8, 0, value.data(), static_cast<int>(value.size()), result.data(), sizeNeeded);
-        return result;
-    }
-
-    bool ParseUrl(const std::string& url, ParsedUrl& parsed, std::string& error)
+    std::shared_ptr<IHttpTransport> MakeDefaultTransport()
     {
-        std::string working = url;
-        parsed.secure = false;
-
-        const std::string https = "https://";
-        const std::string http = "http://";
-
-        if (working.rfind(https, 0) == 0)
-        {
-            parsed.secure = true;
-            working.erase(0, https.size());
-        }
-        else if (working.rfind(http, 0) == 0)
-        {
-            working.erase(0, http.size());
-        }
-        else
-        {
-            error = "URL must start with http:// or https://";
-            return false;
-        }
-
-        std::string::size_type slashPos = working.find('/');
-        std::string hostPort = slashPos == std::string::npos ? working : working.substr(0, slashPos);
-        std::string path = slashPos == std::string::npos ? "/" : working.substr(slashPos);
-
-        if (hostPort.empty())
-        {
-            error = "URL missing host";
-            return false;
-        }
-
-        INTERNET_PORT port = parsed.secure ? 443 : 80;
-        std::string::size_type colonPos = hostPort.find(':');
-        if (colonPos != std::string::npos)
-        {
-            std::string portString = hostPort.substr(colonPos + 1);
-            hostPort = hostPort.substr(0, colonPos);
-            try
-            {
-                port = static_cast<INTERNET_PORT>(std::stoi(portString));
-            }
-            catch (const std::exception&)
-            {
-                error = "Invalid port in URL";
-                return false;
-            }
-        }
-
-        parsed.host = ToWide(hostPort);
-        parsed.port = port;
-        parsed.path = ToWide(path);
-        return true;
-    }
+#ifdef _WIN32
+        return std::make_shared<WinHttpTransport>();
+#else
+        return std::make_shared<PosixHttpTransport>();
 #endif
-
+    }
 } // namespace
 
-ApiClient::ApiClient(std::string baseUrl)
+ApiClient::ApiClient(std::string baseUrl, std::shared_ptr<IHttpTransport> transport)
+    : transport(transport ? std::move(transport) : MakeDefaultTransport())
 {
     SetBaseUrl(std::move(baseUrl));
 }
 
+ApiClient::~ApiClient()
+{
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        stopping = true;
+    }
+    queueCv.notify_all();
+    if (worker.joinable())
+    {
+        worker.join();
+    }
+}
+
 void ApiClient::SetBaseUrl(std::string newBaseUrl)
 {
     baseUrl = NormalizeBaseUrl(std::move(newBaseUrl));
@@ -155,201 +89,173 @@ std::string ApiClient::BuildUrl(const std::string& endpoint) const
 }
 
 bool ApiClient::SendRequest(const std::string& method,
-                            const std::string& endpoint,
+                            const std::string& url,
                             const std::vector<HttpHeader>& headers,
                             const std::string* body,
                             std::string& response,
-                            std::string& error) const
+                            std::string& error,
+                            int* statusCode) const
 {
-#ifdef _WIN32
-    if (baseUrl.empty())
-    {
-        error = "API base URL is empty";
-        return false;
-    }
-
-    const std::string url = BuildUrl(endpoint);
-
-    ParsedUrl parsed;
-    if (!ParseUrl(url, parsed, error))
+    HttpRequest request;
+    request.method = method;
+    request.url = url;
+    request.headers = headers;
+    request.body = body;
+
+    HttpResponse httpResponse;
+    if (statusCode)
     {
-        return false;
+        *statusCode = 0;
     }
-
-    HINTERNET session = WinHttpOpen(L"HardstuckPlugin/1.0",
-                                    WINHTTP_ACCESS_TYPE_AUTOMATIC_PROXY,
-                                    WINHTTP_NO_PROXY_NAME,
-                                    WINHTTP_NO_PROXY_BYPASS,
-                                    0);
-    if (!session)
+    if (!transport->Send(request, httpResponse, error))
     {
-        error = "WinHttpOpen failed: " + std::to_string(GetLastError());
         return false;
     }
-
-    HINTERNET connection = WinHttpConnect(session, parsed.host.c_str(), parsed.port, 0);
-    if (!connection)
+    if (statusCode)
     {
-        error = "WinHttpConnect failed: " + std::to_string(GetLastError());
-        WinHttpCloseHandle(session);
-        return false;
+        *statusCode = httpResponse.statusCode;
     }
 
-    DWORD flags = parsed.secure ? WINHTTP_FLAG_SECURE : 0;
-    std::wstring wideMethod = ToWide(method);
-    if (wideMethod.empty())
+    response = std::move(httpResponse.body);
+    if (httpResponse.statusCode >= 200 && httpResponse.statusCode < 300)
     {
-        error = "HTTP method is empty";
-        WinHttpCloseHandle(connection);
-        WinHttpCloseHandle(session);
-        return false;
+        error.clear();
+        return true;
     }
 
-    HINTERNET request = WinHttpOpenRequest(connection,
-                                           wideMethod.c_str(),
-                                           parsed.path.c_str(),
-                                           nullptr,
-                                           WINHTTP_NO_REFERER,
-                                           WINHTTP_DEFAULT_ACCEPT_TYPES,
-                                           flags);
-    if (!request)
+    std::ostringstream oss;
+    oss << "HTTP " << httpResponse.statusCode;
+    if (!response.empty())
     {
-        error = "WinHttpOpenRequest failed: " + std::to_string(GetLastError());
-        WinHttpCloseHandle(connection);
-        WinHttpCloseHandle(session);
-        return false;
+        oss << ": " << response;
     }
+    error = oss.str();
+    return false;
+}
 
-    for (const auto& header : headers)
+bool ApiClient::PostJson(const std::string& endpoint,
+                         const std::string& body,
+                         const std::vector<HttpHeader>& headers,
+                         std::string& response,
+                         std::string& error,
+                         int* statusCode) const
+{
+    std::vector<HttpHeader> requestHeaders = headers;
+    requestHeaders.emplace_back("Content-Type", "application/json");
+    if (statusCode)
     {
-        if (header.name.empty())
-        {
-            continue;
-        }
-
-        std::string joined = header.name + ": " + header.value + "\r\n";
-        std::wstring wideHeader = ToWide(joined);
-        if (!wideHeader.empty())
-        {
-            WinHttpAddRequestHeaders(request, wideHeader.c_str(), -1L, WINHTTP_ADDREQ_FLAG_ADD);
-        }
+        *statusCode = 0;
     }
-
-    const bool hasBody = body != nullptr && !body->empty();
-    BOOL result = WinHttpSendRequest(request,
-                                     WINHTTP_NO_ADDITIONAL_HEADERS,
-                                     0,
-                                     hasBody ? (LPVOID)body->data() : WINHTTP_NO_REQUEST_DATA,
-                                     hasBody ? static_cast<DWORD>(body->size()) : 0,
-                                     hasBody ? static_cast<DWORD>(body->size()) : 0,
-                                     0);
-    if (!result)
+    if (baseUrl.empty())
     {
-        error = "WinHttpSendRequest failed: " + std::to_string(GetLastError());
-        WinHttpCloseHandle(request);
-        WinHttpCloseHandle(connection);
-        WinHttpCloseHandle(session);
+        error = "API base URL is empty";
         return false;
     }
+    return SendRequest("POST", BuildUrl(endpoint), requestHeaders, &body, response, error, statusCode);
+}
 
-    result = WinHttpReceiveResponse(request, nullptr);
-    if (!result)
+bool ApiClient::GetJson(const std::string& endpoint,
+                        const std::vector<HttpHeader>& headers,
+                        std::string& response,
+                        std::string& error) const
+{
+    if (baseUrl.empty())
     {
-        error = "WinHttpReceiveResponse failed: " + std::to_string(GetLastError());
-        WinHttpCloseHandle(request);
-        WinHttpCloseHandle(connection);
-        WinHttpCloseHandle(session);
+        error = "API base URL is empty";
         return false;
     }
+    return SendRequest("GET", BuildUrl(endpoint), headers, nullptr, response, error);
+}
+
+std::future<ApiResult> ApiClient::PostJsonAsync(const std::string& endpoint,
+                                                std::string body,
+                                                std::vector<HttpHeader> headers)
+{
+    PendingRequest request;
+    request.url = baseUrl.empty() ? std::string() : BuildUrl(endpoint);
+    request.body = std::move(body);
+    request.headers = std::move(headers);
+    std::future<ApiResult> result = request.promise.get_future();
+    Enqueue(std::move(request));
+    return result;
+}
+
+void ApiClient::PostJsonAsync(const std::string& endpoint,
+                              std::string body,
+                              std::vector<HttpHeader> headers,
+                              Callback onComplete)
+{
+    PendingRequest request;
+    request.url = baseUrl.empty() ? std::string() : BuildUrl(endpoint);
+    request.body = std::move(body);
+    request.headers = std::move(headers);
+    request.onComplete = std::move(onComplete);
+    Enqueue(std::move(request));
+}
 
-    DWORD statusCode = 0;
-    DWORD statusSize = sizeof(statusCode);
-    if (!WinHttpQueryHeaders(request,
-                             WINHTTP_QUERY_STATUS_CODE | WINHTTP_QUERY_FLAG_NUMBER,
-                             WINHTTP_HEADER_NAME_BY_INDEX,
-                             &statusCode,
-                             &statusSize,
-                             WINHTTP_NO_HEADER_INDEX))
+void ApiClient::Enqueue(PendingRequest request)
+{
+    request.headers.emplace_back("Content-Type", "application/json");
     {
-        error = "Unable to query HTTP status code: " + std::to_string(GetLastError());
-        WinHttpCloseHandle(request);
-        WinHttpCloseHandle(connection);
-        WinHttpCloseHandle(session);
-        return false;
+        std::lock_guard<std::mutex> lock(queueMutex);
+        // The worker starts on first use so clients that only make blocking calls never
+        // own a thread.
+        if (!worker.joinable())
+        {
+            worker = std::thread(&ApiClient::RunWorker, this);
+        }
+        queue.push_back(std::move(request));
     }
+    queueCv.notify_one();
+}
 
-    std::ostringstream responseStream;
-    DWORD availableBytes = 0;
-    do
+void ApiClient::RunWorker()
+{
+    for (;;)
     {
-        if (!WinHttpQueryDataAvailable(request, &availableBytes))
+        PendingRequest request;
         {
-            error = "WinHttpQueryDataAvailable failed: " + std::to_string(GetLastError());
-            break;
+            std::unique_lock<std::mutex> lock(queueMutex);
+            queueCv.wait(lock, [this] { return stopping || !queue.empty(); });
+            if (stopping)
+            {
+                break;
+            }
+            request = std::move(queue.front());
+            queue.pop_front();
         }
 
-        if (!availableBytes)
+        ApiResult result;
+        if (request.url.empty())
         {
-            break;
+            result.error = "API base URL is empty";
         }
-
-        std::string buffer;
-        buffer.resize(availableBytes);
-        DWORD downloaded = 0;
-        if (!WinHttpReadData(request, buffer.data(), availableBytes, &downloaded))
+        else
         {
-            error = "WinHttpReadData failed: " + std::to_string(GetLastError());
-            break;
+            result.success = SendRequest("POST", request.url, request.headers, &request.body, result.response, result.error);
         }
 
-        responseStream.write(buffer.data(), downloaded);
-    } while (availableBytes > 0);
-
-    WinHttpCloseHandle(request);
-    WinHttpCloseHandle(connection);
-    WinHttpCloseHandle(session);
+        if (request.onComplete)
+        {
+            request.onComplete(result);
+        }
+        request.promise.set_value(std::move(result));
+    }
 
-    const bool success = statusCode >= 200 && statusCode < 300;
-    response = responseStream.str();
-    if (success)
+    // Fail whatever is still queued so no caller waits on a future that never resolves.
+    std::deque<PendingRequest> abandoned;
     {
-        error.clear();
-        return true;
+        std::lock_guard<std::mutex> lock(queueMutex);
+        abandoned.swap(queue);
     }
-
-    std::ostringstream oss;
-    oss << "HTTP " << statusCode;
-    if (!response.empty())
+    for (auto& request : abandoned)
     {
-        oss << ": " << response;
+        ApiResult result;
+        result.error = "ApiClient shut down";
+        if (request.onComplete)
+        {
+            request.onComplete(result);
+        }
+        request.promise.set_value(std::move(result));
     }
-    error = oss.str();
-    return false;
-#else
-    (void)method;
-    (void)endpoint;
-    (void)headers;
-    (void)body;
-    error = "HTTP client is only available on Windows";
-    return false;
-#endif
-}
-
-bool ApiClient::PostJson(const std::string& endpoint,
-                         const std::string& body,
-                         const std::vector<HttpHeader>& headers,
-                         std::string& response,
-                         std::string& error) const
-{
-    std::vector<HttpHeader> requestHeaders = headers;
-    requestHeaders.emplace_back("Content-Type", "application/json");
-    return SendRequest("POST", endpoint, requestHeaders, &body, response, error);
-}
-
-bool ApiClient::GetJson(const std::string& endpoint,
-                        const std::vector<HttpHeader>& headers,
-                        std::string& response,
-                        std::string& error) const
-{
-    return SendRequest("GET", endpoint, headers, nullptr, response, error);
 }
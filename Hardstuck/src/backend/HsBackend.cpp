@@ -4,6 +4,7 @@
 
 #include <algorithm>
 #include <filesystem>
+#include <utility>
 
 #include "diagnostics/DiagnosticLogger.h"
 #include "settings/SettingsService.h"
@@ -23,7 +24,109 @@ HsBackend::HsBackend(std::unique_ptr<LocalDataStore> dataStore,
     , settingsService_(settingsService)
     , dataStore_(std::move(dataStore))
     , userId_(std::move(userId))
+    , historySnapshot_(std::make_shared<const HistorySnapshot>())
 {
+    ConfigureUploads(); // first, so the writer's first batch is queued for upload too
+    if (dataStore_)
+    {
+        StoreWriter::Options options;
+        if (settingsService_)
+        {
+            options.syncInterval = std::chrono::milliseconds(settingsService_->GetStoreSyncIntervalMs());
+            options.durability = ReadStoreDurability();
+        }
+        writer_ = std::make_unique<StoreWriter>(*dataStore_, options, [this](const StoreWriter::BatchResult& result) {
+            OnBatchPersisted(result);
+        });
+    }
+}
+
+void HsBackend::ApplySettings()
+{
+    if (!settingsService_)
+    {
+        return;
+    }
+    if (writer_)
+    {
+        writer_->Reconfigure(std::chrono::milliseconds(settingsService_->GetStoreSyncIntervalMs()), ReadStoreDurability());
+    }
+    ConfigureUploads();
+}
+
+StoreFile::Durability HsBackend::ReadStoreDurability() const
+{
+    StoreFile::Durability durability = StoreFile::Durability::Flush;
+    const std::string name = settingsService_->GetStoreDurability();
+    if (!StoreFile::ParseDurability(name, durability))
+    {
+        DiagnosticLogger::Log("HsBackend: unknown hs_store_durability '" + name + "', using flush");
+    }
+    return durability;
+}
+
+void HsBackend::ConfigureUploads()
+{
+    if (!dataStore_ || !settingsService_)
+    {
+        return;
+    }
+    const std::string apiBaseUrl = settingsService_->GetApiBaseUrl();
+    UploadSyncer::Options uploadOptions;
+    uploadOptions.batchSize = static_cast<size_t>(settingsService_->GetUploadBatchSize());
+
+    std::unique_ptr<UploadSyncer> previousUploader;
+    std::unique_ptr<ApiClient> previousClient;
+    {
+        std::lock_guard<std::mutex> lock(uploadMutex_);
+        if (apiBaseUrl == uploadBaseUrl_ && uploadOptions.batchSize == uploadBatchSize_)
+        {
+            return;
+        }
+        uploadBaseUrl_ = apiBaseUrl;
+        uploadBatchSize_ = uploadOptions.batchSize;
+        previousUploader = std::move(uploader_);
+        previousClient = std::move(apiClient_);
+        if (!apiBaseUrl.empty() && !uploadQueue_)
+        {
+            // Created on first use and kept, so switching servers loses nothing queued.
+            std::string error;
+            uploadQueue_ = std::make_unique<UploadQueue>(dataStore_->GetStorePath().parent_path());
+            if (!uploadQueue_->Open(error))
+            {
+                DiagnosticLogger::Log("HsBackend: upload queue unavailable, uploads disabled: " + error);
+                uploadQueue_.reset();
+            }
+        }
+    }
+
+    // The old syncer finishes its request in flight before the new one starts, so no batch
+    // goes out twice. Stored payloads keep being queued meanwhile.
+    const bool wasUploading = previousUploader != nullptr;
+    previousUploader.reset();
+    previousClient.reset();
+    if (apiBaseUrl.empty() || !uploadQueue_)
+    {
+        if (wasUploading && apiBaseUrl.empty())
+        {
+            DiagnosticLogger::Log("HsBackend: backend URL cleared, uploads disabled");
+        }
+        return;
+    }
+    auto client = std::make_unique<ApiClient>(apiBaseUrl);
+    auto uploader = std::make_unique<UploadSyncer>(*uploadQueue_, *client, uploadOptions);
+    DiagnosticLogger::Log("HsBackend: uploading to " + client->BuildUrl(uploadOptions.endpoint));
+    std::lock_guard<std::mutex> lock(uploadMutex_);
+    apiClient_ = std::move(client);
+    uploader_ = std::move(uploader);
+}
+
+HsBackend::~HsBackend()
+{
+    // Drain queued payloads to disk (and into the upload queue) before the store goes
+    // away, then let the uploader finish its request in flight.
+    writer_.reset();
+    uploader_.reset();
 }
 
 void HsBackend::DispatchPayloadAsync(const std::string& endpoint, const std::string& body)
@@ -40,47 +143,78 @@ void HsBackend::DispatchPayloadAsync(const std::string& endpoint, const std::str
     DiagnosticLogger::Log(std::string("DispatchPayloadAsync: endpoint=") + endpoint +
                           ", body_len=" + std::to_string(body.size()));
 
+    if (!writer_->Enqueue(body))
+    {
+        DiagnosticLogger::Log("DispatchPayloadAsync: writer queue full, buffering payload for retry");
+        BufferForRetry({body});
+    }
+}
+
+void HsBackend::OnBatchPersisted(const StoreWriter::BatchResult& result)
+{
+    DiagnosticLogger::Log(std::string("StoreWriter: batch of ") + std::to_string(result.payloads.size()) +
+                          (result.success ? " stored in " : " failed after ") +
+                          std::to_string(result.latency.count()) + "us");
+
+    if (!result.success)
     {
-        std::lock_guard<std::mutex> lock(requestMutex_);
-        bufferedPayloads_.push_back(body);
-        if (bufferedPayloads_.size() > kMaxBufferedPayloads)
         {
-            bufferedPayloads_.pop_front();
+            std::lock_guard<std::mutex> lock(requestMutex_);
+            lastResponseMessage_.clear();
+            lastErrorMessage_ = result.error.empty() ? std::string("Failed to persist payload") : result.error;
+            lastWriteStatus_ = lastErrorMessage_;
         }
+        BufferForRetry(result.payloads);
+        return;
     }
 
-    CleanupFinishedRequests();
+    {
+        std::lock_guard<std::mutex> lock(requestMutex_);
+        lastResponseMessage_ = result.payloads.size() == 1
+            ? std::string("Stored payload locally")
+            : "Stored " + std::to_string(result.payloads.size()) + " payloads locally";
+        lastErrorMessage_.clear();
+        lastWriteStatus_ = "Last write ok";
+    }
+    {
+        std::lock_guard<std::mutex> historyLock(historyMutex_);
+        historyDirty_ = true;
+    }
 
-    auto future = std::async(std::launch::async, [this, body]() {
+    // Queued whenever a backend URL is set, even while the syncer is being replaced; the
+    // queue itself is never destroyed before the writer.
+    UploadQueue* queue = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(uploadMutex_);
+        queue = uploadBaseUrl_.empty() ? nullptr : uploadQueue_.get();
+    }
+    if (queue)
+    {
         std::string error;
-        bool success = dataStore_->AppendPayloadsWithVerification({body}, error);
-
-        std::lock_guard<std::mutex> lock(requestMutex_);
-        lastResponseMessage_.clear();
-        if (success)
+        if (!queue->Append(result.payloads, error))
         {
-            lastResponseMessage_ = "Stored payload locally";
-            lastErrorMessage_.clear();
-            lastWriteStatus_ = "Last write ok";
-            if (!bufferedPayloads_.empty() && bufferedPayloads_.front() == body)
-            {
-                bufferedPayloads_.pop_front();
-            }
-            {
-                std::lock_guard<std::mutex> historyLock(historyMutex_);
-                historyDirty_ = true;
-            }
+            // The payloads are safe in the local store; only their upload is lost.
+            DiagnosticLogger::Log("HsBackend: failed to queue payloads for upload: " + error);
+            return;
         }
-        else
+        std::lock_guard<std::mutex> lock(uploadMutex_);
+        if (uploader_)
         {
-            lastErrorMessage_ = error.empty() ? std::string("Failed to persist payload") : error;
-            lastWriteStatus_ = lastErrorMessage_;
+            uploader_->Notify();
         }
-    });
+    }
+}
 
+void HsBackend::BufferForRetry(std::vector<std::string> payloads)
+{
+    std::lock_guard<std::mutex> lock(requestMutex_);
+    for (auto& payload : payloads)
     {
-        std::lock_guard<std::mutex> lock(requestMutex_);
-        pendingRequests_.emplace_back(std::move(future));
+        bufferedPayloads_.push_back(std::move(payload));
+        if (bufferedPayloads_.size() > kMaxBufferedPayloads)
+        {
+            bufferedPayloads_.pop_front();
+        }
     }
 }
 
@@ -121,30 +255,48 @@ void HsBackend::FetchHistory()
     DiagnosticLogger::Log("FetchHistory: reading local store");
 
     auto future = std::async(std::launch::async, [this]() {
-        HistorySnapshot parsed;
+        // The store's own snapshot, not a copy; the same one again when nothing changed.
+        std::shared_ptr<const HistorySnapshot> published;
         std::string error;
-        bool success = dataStore_->LoadHistory(parsed, error);
+        const bool success = dataStore_->LoadHistory(published, error);
 
-        std::lock_guard<std::mutex> lock(historyMutex_);
-        historyLoading_ = false;
-        if (success)
         {
-            historySnapshot_ = std::move(parsed);
-            historyLastFetched_ = std::chrono::system_clock::now();
-            historyDirty_ = false;
-        }
+            // Swapped out under the lock, released after it: the previous snapshot is freed
+            // here unless a frame still holds it.
+            std::shared_ptr<const HistorySnapshot> previous;
+            std::lock_guard<std::mutex> lock(historyMutex_);
+            historyLoading_ = false;
+            if (success)
+            {
+                if (published != historySnapshot_)
+                {
+                    previous = std::exchange(historySnapshot_, std::move(published));
+                    ++historyVersion_;
+                }
+                historyLastFetched_ = std::chrono::system_clock::now();
+                historyDirty_ = false;
+            }
 
-        if (!error.empty())
-        {
-            historyErrorMessage_ = error;
-        }
-        else if (!success)
-        {
-            historyErrorMessage_ = "History load failed";
+            if (!error.empty())
+            {
+                historyErrorMessage_ = error;
+            }
+            else if (!success)
+            {
+                historyErrorMessage_ = "History load failed";
+            }
+            else
+            {
+                historyErrorMessage_.clear();
+            }
         }
-        else
+
+        // Segments a load has fully indexed are compressed here, after the snapshot is
+        // out, rather than while loading. Failures are logged by the store.
+        if (success)
         {
-            historyErrorMessage_.clear();
+            std::string compressError;
+            dataStore_->CompressSealedSegments(compressError);
         }
     });
 
@@ -191,11 +343,29 @@ void HsBackend::SnapshotRequestState(std::string& lastResponse, std::string& las
     lastError    = lastErrorMessage_;
 }
 
-void HsBackend::SnapshotStorageDiagnostics(std::string& status, size_t& bufferedCount) const
+void HsBackend::SnapshotStorageDiagnostics(StorageDiagnostics& diagnostics) const
 {
-    std::lock_guard<std::mutex> lock(requestMutex_);
-    status = lastWriteStatus_;
-    bufferedCount = bufferedPayloads_.size();
+    {
+        std::lock_guard<std::mutex> lock(requestMutex_);
+        diagnostics.status = lastWriteStatus_;
+        diagnostics.bufferedCount = bufferedPayloads_.size();
+    }
+    if (writer_)
+    {
+        const StoreWriter::Stats stats = writer_->GetStats();
+        diagnostics.queueDepth = stats.queueDepth;
+        diagnostics.queueHighWater = stats.queueHighWater;
+        diagnostics.rejectedWrites = stats.rejected;
+        diagnostics.lastWriteLatency = stats.lastLatency;
+        diagnostics.maxWriteLatency = stats.maxLatency;
+    }
+    std::lock_guard<std::mutex> lock(uploadMutex_);
+    if (uploader_)
+    {
+        diagnostics.uploadsEnabled = true;
+        diagnostics.uploadPending = uploadQueue_->PendingCount();
+        diagnostics.uploadBackoff = uploader_->GetStats().currentBackoff;
+    }
 }
 
 std::filesystem::path HsBackend::GetStorePath() const
@@ -207,13 +377,15 @@ std::filesystem::path HsBackend::GetStorePath() const
     return dataStore_->GetStorePath();
 }
 
-void HsBackend::SnapshotHistory(HistorySnapshot& snapshot,
+void HsBackend::SnapshotHistory(std::shared_ptr<const HistorySnapshot>& snapshot,
+                                 uint64_t& version,
                                  std::string& errorMessage,
                                  bool& loading,
                                  std::chrono::system_clock::time_point& lastFetched) const
 {
     std::lock_guard<std::mutex> lock(historyMutex_);
     snapshot     = historySnapshot_;
+    version      = historyVersion_;
     errorMessage = historyErrorMessage_;
     loading      = historyLoading_;
     lastFetched  = historyLastFetched_;
@@ -235,34 +407,34 @@ void HsBackend::CleanupFinishedRequests()
 
 void HsBackend::FlushBufferedWrites()
 {
-    if (!dataStore_)
+    if (!writer_)
     {
         return;
     }
     std::deque<std::string> toFlush;
     {
         std::lock_guard<std::mutex> lock(requestMutex_);
-        toFlush = bufferedPayloads_;
+        toFlush.swap(bufferedPayloads_);
     }
-    if (toFlush.empty())
+
+    size_t requeued = 0;
+    while (!toFlush.empty() && writer_->Enqueue(toFlush.front()))
     {
-        return;
+        toFlush.pop_front();
+        ++requeued;
+    }
+    if (!toFlush.empty())
+    {
+        BufferForRetry(std::vector<std::string>(toFlush.begin(), toFlush.end()));
     }
+    writer_->Flush();
 
-    std::string error;
-    if (dataStore_->AppendPayloadsWithVerification(std::vector<std::string>(toFlush.begin(), toFlush.end()), error))
+    if (requeued > 0)
     {
         std::lock_guard<std::mutex> lock(requestMutex_);
-        bufferedPayloads_.clear();
-        lastWriteStatus_ = "Buffered writes flushed";
+        if (bufferedPayloads_.empty())
         {
-            std::lock_guard<std::mutex> historyLock(historyMutex_);
-            historyDirty_ = true;
+            lastWriteStatus_ = "Buffered writes flushed";
         }
     }
-    else
-    {
-        std::lock_guard<std::mutex> lock(requestMutex_);
-        lastWriteStatus_ = error.empty() ? "Flush failed" : error;
-    }
 }
@@ -0,0 +1,59 @@
+// HttpTransport.cpp
+#include "pch.h"
+#include "backend/HttpTransport.h"
+
+#include <charconv>
+
+bool ParseHttpUrl(const std::string& url, ParsedUrl& parsed, std::string& error)
+{
+    std::string working = url;
+    parsed = ParsedUrl();
+
+    const std::string https = "https://";
+    const std::string http = "http://";
+
+    if (working.rfind(https, 0) == 0)
+    {
+        parsed.secure = true;
+        working.erase(0, https.size());
+    }
+    else if (working.rfind(http, 0) == 0)
+    {
+        working.erase(0, http.size());
+    }
+    else
+    {
+        error = "URL must start with http:// or https://";
+        return false;
+    }
+
+    std::string::size_type slashPos = working.find('/');
+    std::string hostPort = slashPos == std::string::npos ? working : working.substr(0, slashPos);
+    parsed.path = slashPos == std::string::npos ? "/" : working.substr(slashPos);
+
+    if (hostPort.empty())
+    {
+        error = "URL missing host";
+        return false;
+    }
+
+    parsed.port = parsed.secure ? 443 : 80;
+    std::string::size_type colonPos = hostPort.find(':');
+    if (colonPos != std::string::npos)
+    {
+        const char* first = hostPort.data() + colonPos + 1;
+        const char* last = hostPort.data() + hostPort.size();
+        unsigned port = 0;
+        const auto result = std::from_chars(first, last, port);
+        if (result.ec != std::errc() || result.ptr != last || port == 0 || port > 65535)
+        {
+            error = "Invalid port in URL";
+            return false;
+        }
+        parsed.port = static_cast<uint16_t>(port);
+        hostPort.erase(colonPos);
+    }
+
+    parsed.host = hostPort;
+    return true;
+}
@@ -0,0 +1,728 @@
+// PosixHttpTransport.cpp
+#include "pch.h"
+#include "backend/PosixHttpTransport.h"
+
+#ifndef _WIN32
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#endif
+
+#ifndef _WIN32
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    constexpr size_t kMaxLineBytes = 64 * 1024;
+    constexpr size_t kReadChunk = 16 * 1024;
+
+    std::string ErrnoText(const char* what)
+    {
+        return std::string(what) + ": " + std::strerror(errno);
+    }
+
+    std::string ToLower(std::string value)
+    {
+        std::transform(value.begin(), value.end(), value.begin(), [](unsigned char ch) {
+            return static_cast<char>(std::tolower(ch));
+        });
+        return value;
+    }
+
+    std::string Trim(const std::string& value)
+    {
+        size_t first = 0;
+        size_t last = value.size();
+        while (first < last && (value[first] == ' ' || value[first] == '\t'))
+        {
+            ++first;
+        }
+        while (last > first && (value[last - 1] == ' ' || value[last - 1] == '\t'))
+        {
+            --last;
+        }
+        return value.substr(first, last - first);
+    }
+
+    // Re-arms the connection's poller for `events` and waits until one fires or the
+    // deadline passes. Errors and hangups count as ready; the next send/recv reports them.
+    bool WaitFor(int poller, int fd, uint32_t events, Clock::time_point deadline, std::string& error)
+    {
+        epoll_event interest{};
+        interest.events = events;
+        interest.data.fd = fd;
+        if (epoll_ctl(poller, EPOLL_CTL_MOD, fd, &interest) != 0)
+        {
+            error = ErrnoText("epoll_ctl failed");
+            return false;
+        }
+
+        for (;;)
+        {
+            const auto remaining = std::chrono::ceil<std::chrono::milliseconds>(deadline - Clock::now());
+            if (remaining.count() <= 0)
+            {
+                error = "HTTP request timed out";
+                return false;
+            }
+
+            epoll_event ready{};
+            const int count = epoll_wait(poller, &ready, 1, static_cast<int>(remaining.count()));
+            if (count < 0)
+            {
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+                error = ErrnoText("epoll_wait failed");
+                return false;
+            }
+            if (count > 0)
+            {
+                return true;
+            }
+        }
+    }
+
+    // peerClosed reports a send refused because the server had already closed or reset the socket.
+    bool WriteAll(int fd, int poller, const std::string& data, Clock::time_point deadline, bool& peerClosed, std::string& error)
+    {
+        peerClosed = false;
+        size_t written = 0;
+        while (written < data.size())
+        {
+            const ssize_t sent = ::send(fd, data.data() + written, data.size() - written, MSG_NOSIGNAL);
+            if (sent > 0)
+            {
+                written += static_cast<size_t>(sent);
+                continue;
+            }
+            if (sent < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            {
+                if (!WaitFor(poller, fd, EPOLLOUT, deadline, error))
+                {
+                    return false;
+                }
+                continue;
+            }
+            peerClosed = sent < 0 && (errno == EPIPE || errno == ECONNRESET);
+            error = ErrnoText("send failed");
+            return false;
+        }
+        return true;
+    }
+
+    // Buffered reader over one response; every read honours the request deadline.
+    class ResponseReader
+    {
+    public:
+        ResponseReader(int fd, int poller, Clock::time_point deadline)
+            : fd_(fd), poller_(poller), deadline_(deadline)
+        {
+        }
+
+        bool ReadLine(std::string& line, std::string& error)
+        {
+            for (;;)
+            {
+                const size_t end = buffer_.find("\r\n", pos_);
+                if (end != std::string::npos)
+                {
+                    line.assign(buffer_, pos_, end - pos_);
+                    pos_ = end + 2;
+                    return true;
+                }
+                if (buffer_.size() - pos_ > kMaxLineBytes)
+                {
+                    error = "HTTP response line too long";
+                    return false;
+                }
+                if (!Fill(error))
+                {
+                    return false;
+                }
+                if (eof_)
+                {
+                    error = "Connection closed mid-response";
+                    return false;
+                }
+            }
+        }
+
+        bool ReadExact(size_t length, std::string& out, std::string& error)
+        {
+            while (buffer_.size() - pos_ < length)
+            {
+                if (!Fill(error))
+                {
+                    return false;
+                }
+                if (eof_)
+                {
+                    error = "Connection closed mid-response";
+                    return false;
+                }
+            }
+            out.append(buffer_, pos_, length);
+            pos_ += length;
+            return true;
+        }
+
+        bool ReadToEnd(std::string& out, std::string& error)
+        {
+            while (!eof_)
+            {
+                if (!Fill(error))
+                {
+                    return false;
+                }
+            }
+            out.append(buffer_, pos_, std::string::npos);
+            pos_ = buffer_.size();
+            return true;
+        }
+
+        // The server closed or reset the socket without sending a byte of the response.
+        // A timeout is not a close: the server may still be working on the request.
+        bool ClosedBeforeResponse() const { return received_ == 0 && (eof_ || reset_); }
+
+        // Bytes past the end of this response mean the server is out of step with us.
+        bool HasLeftover() const { return pos_ < buffer_.size(); }
+
+    private:
+        bool Fill(std::string& error)
+        {
+            if (pos_ > 0 && pos_ == buffer_.size())
+            {
+                buffer_.clear();
+                pos_ = 0;
+            }
+
+            const size_t offset = buffer_.size();
+            buffer_.resize(offset + kReadChunk);
+            for (;;)
+            {
+                const ssize_t got = ::recv(fd_, buffer_.data() + offset, kReadChunk, 0);
+                if (got > 0)
+                {
+                    buffer_.resize(offset + static_cast<size_t>(got));
+                    received_ += static_cast<size_t>(got);
+                    return true;
+                }
+                if (got == 0)
+                {
+                    buffer_.resize(offset);
+                    eof_ = true;
+                    return true;
+                }
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+                if (errno == EAGAIN || errno == EWOULDBLOCK)
+                {
+                    if (!WaitFor(poller_, fd_, EPOLLIN, deadline_, error))
+                    {
+                        buffer_.resize(offset);
+                        return false;
+                    }
+                    continue;
+                }
+                buffer_.resize(offset);
+                reset_ = errno == ECONNRESET;
+                error = ErrnoText("recv failed");
+                return false;
+            }
+        }
+
+        int fd_;
+        int poller_;
+        Clock::time_point deadline_;
+        std::string buffer_;
+        size_t pos_{0};
+        size_t received_{0};
+        bool eof_{false};
+        bool reset_{false};
+    };
+
+    bool ParseStatusLine(const std::string& line, int& statusCode, bool& http10, std::string& error)
+    {
+        // "HTTP/1.1 200 OK"
+        if (line.rfind("HTTP/1.", 0) != 0 || line.size() < 12 || line[8] != ' ')
+        {
+            error = "Malformed HTTP status line";
+            return false;
+        }
+        http10 = line[7] == '0';
+        const auto result = std::from_chars(line.data() + 9, line.data() + 12, statusCode);
+        if (result.ec != std::errc() || result.ptr != line.data() + 12)
+        {
+            error = "Malformed HTTP status code";
+            return false;
+        }
+        return true;
+    }
+
+    bool ReadChunkedBody(ResponseReader& reader, std::string& body, std::string& error)
+    {
+        std::string line;
+        for (;;)
+        {
+            if (!reader.ReadLine(line, error))
+            {
+                return false;
+            }
+            // Chunk extensions after ';' are ignored.
+            const size_t end = std::min(line.find(';'), line.size());
+            size_t chunkSize = 0;
+            const char* first = line.data();
+            const char* last = line.data() + end;
+            while (last > first && (last[-1] == ' ' || last[-1] == '\t'))
+            {
+                --last;
+            }
+            const auto result = std::from_chars(first, last, chunkSize, 16);
+            if (result.ec != std::errc() || result.ptr != last)
+            {
+                error = "Malformed chunk size";
+                return false;
+            }
+
+            if (chunkSize == 0)
+            {
+                // Trailer fields, if any, end with an empty line.
+                do
+                {
+                    if (!reader.ReadLine(line, error))
+                    {
+                        return false;
+                    }
+                } while (!line.empty());
+                return true;
+            }
+
+            if (!reader.ReadExact(chunkSize, body, error))
+            {
+                return false;
+            }
+            if (!reader.ReadLine(line, error))
+            {
+                return false;
+            }
+            if (!line.empty())
+            {
+                error = "Missing CRLF after chunk";
+                return false;
+            }
+        }
+    }
+
+    std::string ConnectionKey(const ParsedUrl& url)
+    {
+        return url.host + ":" + std::to_string(url.port);
+    }
+
+    std::string BuildRequest(const HttpRequest& request, const ParsedUrl& url)
+    {
+        const bool defaultPort = url.port == 80;
+        const size_t bodySize = request.body ? request.body->size() : 0;
+
+        std::string wire;
+        wire.reserve(256 + bodySize);
+        wire += request.method;
+        wire += ' ';
+        wire += url.path;
+        wire += " HTTP/1.1\r\nHost: ";
+        wire += url.host;
+        if (!defaultPort)
+        {
+            wire += ':';
+            wire += std::to_string(url.port);
+        }
+        wire += "\r\nUser-Agent: HardstuckPlugin/1.0\r\nConnection: keep-alive\r\n";
+        if (request.body != nullptr || request.method == "POST" || request.method == "PUT")
+        {
+            wire += "Content-Length: ";
+            wire += std::to_string(bodySize);
+            wire += "\r\n";
+        }
+        for (const auto& header : request.headers)
+        {
+            if (!header.name.empty())
+            {
+                wire += header.name;
+                wire += ": ";
+                wire += header.value;
+                wire += "\r\n";
+            }
+        }
+        wire += "\r\n";
+        if (bodySize > 0)
+        {
+            wire += *request.body;
+        }
+        return wire;
+    }
+
+    // True when an idle pooled socket has been closed by the peer (or has unexpected
+    // bytes waiting), so it must not carry another request.
+    bool IsStale(int fd)
+    {
+        char probe;
+        const ssize_t got = ::recv(fd, &probe, 1, MSG_PEEK | MSG_DONTWAIT);
+        if (got < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+        {
+            return false;
+        }
+        return true;
+    }
+
+    enum class Outcome
+    {
+        Ok,
+        Failed,
+        // A reused socket was refused on send, or closed or reset before the server sent a
+        // byte: the server dropped the idle connection without taking the request, so it can
+        // go out again on a fresh one. Timeouts never count, because the request may be live.
+        StaleConnection
+    };
+}
+#endif
+
+PosixHttpTransport::PosixHttpTransport()
+    : PosixHttpTransport(Options())
+{
+}
+
+PosixHttpTransport::PosixHttpTransport(Options options)
+    : options_(options)
+{
+}
+
+PosixHttpTransport::~PosixHttpTransport()
+{
+    for (auto& [key, connections] : idle_)
+    {
+        for (auto& connection : connections)
+        {
+            Close(connection);
+        }
+    }
+}
+
+void PosixHttpTransport::Close(Connection& connection)
+{
+#ifndef _WIN32
+    if (connection.poller >= 0)
+    {
+        ::close(connection.poller);
+    }
+    if (connection.fd >= 0)
+    {
+        ::close(connection.fd);
+    }
+#endif
+    connection = Connection();
+}
+
+bool PosixHttpTransport::TakeIdle(const std::string& key, Connection& connection)
+{
+#ifndef _WIN32
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = idle_.find(key);
+    while (it != idle_.end() && !it->second.empty())
+    {
+        connection = it->second.back();
+        it->second.pop_back();
+        if (!IsStale(connection.fd))
+        {
+            return true;
+        }
+        Close(connection);
+    }
+#else
+    (void)key;
+    (void)connection;
+#endif
+    return false;
+}
+
+void PosixHttpTransport::ReturnIdle(const std::string& key, Connection connection)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto& pool = idle_[key];
+        if (pool.size() < options_.maxIdlePerHost)
+        {
+            pool.push_back(connection);
+            return;
+        }
+    }
+    Close(connection);
+}
+
+bool PosixHttpTransport::Connect(const ParsedUrl& url, Connection& connection, std::string& error) const
+{
+#ifndef _WIN32
+    addrinfo hints{};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo* addresses = nullptr;
+    const std::string port = std::to_string(url.port);
+    const int lookup = ::getaddrinfo(url.host.c_str(), port.c_str(), &hints, &addresses);
+    if (lookup != 0)
+    {
+        error = "Failed to resolve " + url.host + ": " + gai_strerror(lookup);
+        return false;
+    }
+
+    const auto deadline = Clock::now() + options_.connectTimeout;
+    error = "No addresses for " + url.host;
+    for (addrinfo* address = addresses; address; address = address->ai_next)
+    {
+        Connection candidate;
+        candidate.fd = ::socket(address->ai_family, address->ai_socktype | SOCK_NONBLOCK | SOCK_CLOEXEC, address->ai_protocol);
+        if (candidate.fd < 0)
+        {
+            error = ErrnoText("socket failed");
+            continue;
+        }
+        candidate.poller = ::epoll_create1(EPOLL_CLOEXEC);
+        if (candidate.poller < 0)
+        {
+            error = ErrnoText("epoll_create1 failed");
+            Close(candidate);
+            continue;
+        }
+        epoll_event interest{};
+        interest.events = EPOLLOUT;
+        interest.data.fd = candidate.fd;
+        ::epoll_ctl(candidate.poller, EPOLL_CTL_ADD, candidate.fd, &interest);
+
+        const int noDelay = 1;
+        ::setsockopt(candidate.fd, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+
+        if (::connect(candidate.fd, address->ai_addr, address->ai_addrlen) != 0)
+        {
+            if (errno != EINPROGRESS)
+            {
+                error = ErrnoText("connect failed");
+                Close(candidate);
+                continue;
+            }
+            if (!WaitFor(candidate.poller, candidate.fd, EPOLLOUT, deadline, error))
+            {
+                Close(candidate);
+                continue;
+            }
+            int socketError = 0;
+            socklen_t length = sizeof(socketError);
+            ::getsockopt(candidate.fd, SOL_SOCKET, SO_ERROR, &socketError, &length);
+            if (socketError != 0)
+            {
+                error = std::string("connect failed: ") + std::strerror(socketError);
+                Close(candidate);
+                continue;
+            }
+        }
+
+        ::freeaddrinfo(addresses);
+        connection = candidate;
+        error.clear();
+        return true;
+    }
+
+    ::freeaddrinfo(addresses);
+    return false;
+#else
+    (void)url;
+    (void)connection;
+    error = "PosixHttpTransport is not available on Windows";
+    return false;
+#endif
+}
+
+bool PosixHttpTransport::Send(const HttpRequest& request, HttpResponse& response, std::string& error)
+{
+#ifndef _WIN32
+    ParsedUrl url;
+    if (!ParseHttpUrl(request.url, url, error))
+    {
+        return false;
+    }
+    if (url.secure)
+    {
+        error = "PosixHttpTransport does not support https://";
+        return false;
+    }
+    if (request.method.empty())
+    {
+        error = "HTTP method is empty";
+        return false;
+    }
+
+    const std::string key = ConnectionKey(url);
+    const std::string wire = BuildRequest(request, url);
+
+    // One retry, and only for a pooled socket the server closed while it sat idle.
+    for (int attempt = 0; attempt < 2; ++attempt)
+    {
+        Connection connection;
+        const bool reused = TakeIdle(key, connection);
+        if (!reused && !Connect(url, connection, error))
+        {
+            return false;
+        }
+
+        const auto deadline = Clock::now() + options_.ioTimeout;
+        ResponseReader reader(connection.fd, connection.poller, deadline);
+        bool keepAlive = true;
+        bool writeRefused = false;
+        auto exchange = [&]() -> Outcome {
+            if (!WriteAll(connection.fd, connection.poller, wire, deadline, writeRefused, error))
+            {
+                return Outcome::Failed;
+            }
+
+            std::string line;
+            bool http10 = false;
+            response.statusCode = 0;
+            response.body.clear();
+            // Interim 1xx responses carry no body; skip to the final one.
+            do
+            {
+                if (!reader.ReadLine(line, error) || !ParseStatusLine(line, response.statusCode, http10, error))
+                {
+                    return Outcome::Failed;
+                }
+
+                long long contentLength = -1;
+                bool chunked = false;
+                keepAlive = !http10;
+                for (;;)
+                {
+                    if (!reader.ReadLine(line, error))
+                    {
+                        return Outcome::Failed;
+                    }
+                    if (line.empty())
+                    {
+                        break;
+                    }
+                    const size_t colon = line.find(':');
+                    if (colon == std::string::npos)
+                    {
+                        continue;
+                    }
+                    const std::string name = ToLower(Trim(line.substr(0, colon)));
+                    const std::string value = ToLower(Trim(line.substr(colon + 1)));
+                    if (name == "content-length")
+                    {
+                        const auto result = std::from_chars(value.data(), value.data() + value.size(), contentLength);
+                        if (result.ec != std::errc() || result.ptr != value.data() + value.size() || contentLength < 0)
+                        {
+                            error = "Malformed Content-Length";
+                            return Outcome::Failed;
+                        }
+                    }
+                    else if (name == "transfer-encoding")
+                    {
+                        chunked = value.find("chunked") != std::string::npos;
+                    }
+                    else if (name == "connection")
+                    {
+                        if (value.find("close") != std::string::npos)
+                        {
+                            keepAlive = false;
+                        }
+                        else if (value.find("keep-alive") != std::string::npos)
+                        {
+                            keepAlive = true;
+                        }
+                    }
+                }
+
+                if (response.statusCode >= 100 && response.statusCode < 200)
+                {
+                    continue;
+                }
+
+                const bool bodyless = request.method == "HEAD" || response.statusCode == 204 || response.statusCode == 304;
+                if (bodyless)
+                {
+                    break;
+                }
+                if (chunked)
+                {
+                    if (!ReadChunkedBody(reader, response.body, error))
+                    {
+                        return Outcome::Failed;
+                    }
+                }
+                else if (contentLength >= 0)
+                {
+                    if (!reader.ReadExact(static_cast<size_t>(contentLength), response.body, error))
+                    {
+                        return Outcome::Failed;
+                    }
+                }
+                else
+                {
+                    keepAlive = false;
+                    if (!reader.ReadToEnd(response.body, error))
+                    {
+                        return Outcome::Failed;
+                    }
+                }
+            } while (response.statusCode >= 100 && response.statusCode < 200);
+
+            return Outcome::Ok;
+        };
+
+        Outcome outcome = exchange();
+        if (outcome == Outcome::Failed && reused && (writeRefused || reader.ClosedBeforeResponse()))
+        {
+            outcome = Outcome::StaleConnection;
+        }
+
+        if (outcome == Outcome::Ok)
+        {
+            if (keepAlive && !reader.HasLeftover())
+            {
+                ReturnIdle(key, connection);
+            }
+            else
+            {
+                Close(connection);
+            }
+            return true;
+        }
+
+        Close(connection);
+        if (outcome == Outcome::Failed)
+        {
+            return false;
+        }
+    }
+    return false;
+#else
+    (void)request;
+    (void)response;
+    error = "PosixHttpTransport is not available on Windows";
+    return false;
+#endif
+}
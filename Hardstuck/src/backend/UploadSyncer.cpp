@@ -0,0 +1,210 @@
+// UploadSyncer.cpp
+#include "pch.h"
+#include "backend/UploadSyncer.h"
+
+#include <algorithm>
+
+#include "backend/ApiClient.h"
+#include "diagnostics/DiagnosticLogger.h"
+
+UploadSyncer::UploadSyncer(UploadQueue& queue, ApiClient& client, Options options)
+    : queue_(queue)
+    , client_(client)
+    , options_(std::move(options))
+{
+    options_.batchSize = (std::max)(options_.batchSize, size_t{1});
+    thread_ = std::thread(&UploadSyncer::Run, this);
+}
+
+UploadSyncer::~UploadSyncer()
+{
+    Stop();
+}
+
+void UploadSyncer::Notify()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        notified_ = true;
+    }
+    wakeCv_.notify_one();
+}
+
+void UploadSyncer::Stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    wakeCv_.notify_one();
+    if (thread_.joinable())
+    {
+        thread_.join();
+    }
+}
+
+UploadSyncer::Stats UploadSyncer::GetStats() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+std::string UploadSyncer::BuildBatchBody(const std::vector<UploadQueue::Record>& records)
+{
+    size_t reserve = 16;
+    for (const auto& record : records)
+    {
+        reserve += record.payload.size() + 32;
+    }
+
+    std::string body;
+    body.reserve(reserve);
+    body += "{\"records\":[";
+    for (size_t i = 0; i < records.size(); ++i)
+    {
+        if (i > 0)
+        {
+            body += ',';
+        }
+        body += "{\"seq\":";
+        body += std::to_string(records[i].sequence);
+        body += ",\"payload\":";
+        body += records[i].payload;
+        body += '}';
+    }
+    body += "]}";
+    return body;
+}
+
+std::chrono::milliseconds UploadSyncer::BackoffDelay(uint32_t failures, const Options& options, std::mt19937_64& rng)
+{
+    if (failures == 0)
+    {
+        return std::chrono::milliseconds(0);
+    }
+
+    const int64_t cap = (std::max)(options.maxBackoff.count(), int64_t{1});
+    int64_t step = (std::max)(options.initialBackoff.count(), int64_t{1});
+    for (uint32_t i = 1; i < failures && step < cap; ++i)
+    {
+        step *= 2;
+    }
+    step = (std::min)(step, cap);
+
+    const int64_t half = step / 2;
+    std::uniform_int_distribution<int64_t> jitter(0, step - half);
+    return std::chrono::milliseconds(half + jitter(rng));
+}
+
+bool UploadSyncer::IsRecordRejection(int statusCode)
+{
+    return statusCode == 400 || statusCode == 413 || statusCode == 422;
+}
+
+void UploadSyncer::Run()
+{
+    std::mt19937_64 rng(std::random_device{}());
+    // After a permanent rejection, batches stay small until the rejected range is through.
+    size_t batchLimit = options_.batchSize;
+    uint64_t rejectedThrough = 0;
+    for (;;)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            if (std::chrono::steady_clock::now() < retryAt_)
+            {
+                wakeCv_.wait_until(lock, retryAt_, [this] { return stopping_; });
+            }
+            else
+            {
+                wakeCv_.wait(lock, [this] { return stopping_ || notified_; });
+            }
+            if (stopping_)
+            {
+                return;
+            }
+            notified_ = false;
+        }
+
+        const std::vector<UploadQueue::Record> batch = queue_.PeekBatch(batchLimit, options_.maxBatchBytes);
+        if (batch.empty())
+        {
+            continue;
+        }
+
+        const std::string body = BuildBatchBody(batch);
+        std::string response;
+        std::string error;
+        int statusCode = 0;
+        bool sent = client_.PostJson(options_.endpoint, body, {}, response, error, &statusCode);
+        const bool rejected = !sent && IsRecordRejection(statusCode);
+        if (rejected && batch.size() > 1)
+        {
+            // Narrow down to the record the server refuses; the halves go out right away.
+            batchLimit = batch.size() / 2;
+            rejectedThrough = (std::max)(rejectedThrough, batch.back().sequence);
+            DiagnosticLogger::Log("UploadSyncer: batch of " + std::to_string(batch.size()) + " rejected (" + error +
+                                  "), retrying in halves");
+            std::lock_guard<std::mutex> lock(mutex_);
+            ++stats_.rejectedRequests;
+            stats_.lastError = error;
+            notified_ = true;
+            continue;
+        }
+        if (rejected)
+        {
+            // The record is kept in the dead-letter file and the queue moves past it. If
+            // it cannot be kept, it stays queued and this counts as a failure.
+            std::string deadLetterError;
+            sent = queue_.DeadLetter(batch[0], error, deadLetterError);
+            std::lock_guard<std::mutex> lock(mutex_);
+            ++stats_.rejectedRequests;
+            if (sent)
+            {
+                ++stats_.droppedRecords;
+                DiagnosticLogger::Log("UploadSyncer: record " + std::to_string(batch[0].sequence) + " rejected (" +
+                                      error + "), moved to " + queue_.GetDeadLetterPath().filename().string());
+            }
+            else
+            {
+                error = deadLetterError;
+            }
+        }
+        if (sent && batch.back().sequence >= rejectedThrough)
+        {
+            batchLimit = options_.batchSize;
+        }
+        if (sent && !queue_.Acknowledge(batch.back().sequence, error))
+        {
+            // Delivered but not recorded. Back off like any failure; the resent batch
+            // carries the same sequence numbers so the server can discard it.
+            DiagnosticLogger::Log("UploadSyncer: failed to record ack: " + error);
+            sent = false;
+        }
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (sent)
+        {
+            if (!rejected)
+            {
+                ++stats_.batchesSent;
+                stats_.recordsSent += batch.size();
+            }
+            stats_.consecutiveFailures = 0;
+            stats_.currentBackoff = std::chrono::milliseconds(0);
+            stats_.lastError.clear();
+            retryAt_ = {};
+            // More may be waiting; go round again without sleeping.
+            notified_ = true;
+            continue;
+        }
+
+        ++stats_.failedRequests;
+        ++stats_.consecutiveFailures;
+        stats_.currentBackoff = BackoffDelay(stats_.consecutiveFailures, options_, rng);
+        stats_.lastError = error;
+        retryAt_ = std::chrono::steady_clock::now() + stats_.currentBackoff;
+        DiagnosticLogger::Log("UploadSyncer: batch of " + std::to_string(batch.size()) + " failed (" + error +
+                              "), retrying in " + std::to_string(stats_.currentBackoff.count()) + "ms");
+    }
+}
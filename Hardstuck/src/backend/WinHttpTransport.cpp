@@ -0,0 +1,227 @@
+// WinHttpTransport.cpp
+#include "pch.h"
+#include "backend/WinHttpTransport.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#include <winhttp.h>
+#pragma comment(lib, "winhttp.lib")
+#endif
+
+namespace
+{
+#ifdef _WIN32
+    std::wstring ToWide(const std::string& value)
+    {
+        if (value.empty())
+        {
+            return std::wstring();
+        }
+
+        int sizeNeeded = MultiByteToWideChar(CP_UTF8, 0, value.data(), static_cast<int>(value.size()), nullptr, 0);
+        if (sizeNeeded <= 0)
+        {
+            return std::wstring();
+        }
+
+        std::wstring result;
+        result.resize(sizeNeeded);
+        MultiByteToWideChar(CP_UTF8, 0, value.data(), static_cast<int>(value.size()), result.data(), sizeNeeded);
+        return result;
+    }
+
+    // Closes a request handle on every exit path.
+    struct RequestHandle
+    {
+        HINTERNET handle{nullptr};
+        ~RequestHandle()
+        {
+            if (handle)
+            {
+                WinHttpCloseHandle(handle);
+            }
+        }
+    };
+
+    std::string ConnectionKey(const ParsedUrl& url)
+    {
+        return url.host + ":" + std::to_string(url.port);
+    }
+#endif
+}
+
+WinHttpTransport::WinHttpTransport()
+{
+#ifdef _WIN32
+    session_ = WinHttpOpen(L"HardstuckPlugin/1.0",
+                           WINHTTP_ACCESS_TYPE_AUTOMATIC_PROXY,
+                           WINHTTP_NO_PROXY_NAME,
+                           WINHTTP_NO_PROXY_BYPASS,
+                           0);
+#endif
+}
+
+WinHttpTransport::~WinHttpTransport()
+{
+#ifdef _WIN32
+    for (auto& [key, connection] : connections_)
+    {
+        WinHttpCloseHandle(connection);
+    }
+    if (session_)
+    {
+        WinHttpCloseHandle(session_);
+    }
+#endif
+}
+
+void* WinHttpTransport::AcquireConnection(const ParsedUrl& url, std::string& error)
+{
+#ifdef _WIN32
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!session_)
+    {
+        error = "WinHttpOpen failed";
+        return nullptr;
+    }
+
+    const std::string key = ConnectionKey(url);
+    auto it = connections_.find(key);
+    if (it != connections_.end())
+    {
+        return it->second;
+    }
+
+    HINTERNET connection = WinHttpConnect(session_, ToWide(url.host).c_str(), url.port, 0);
+    if (!connection)
+    {
+        error = "WinHttpConnect failed: " + std::to_string(GetLastError());
+        return nullptr;
+    }
+    connections_.emplace(key, connection);
+    return connection;
+#else
+    (void)url;
+    error = "HTTP client is only available on Windows";
+    return nullptr;
+#endif
+}
+
+bool WinHttpTransport::Send(const HttpRequest& request, HttpResponse& response, std::string& error)
+{
+    ParsedUrl url;
+    if (!ParseHttpUrl(request.url, url, error))
+    {
+        return false;
+    }
+
+#ifdef _WIN32
+    HINTERNET connection = AcquireConnection(url, error);
+    if (!connection)
+    {
+        return false;
+    }
+
+    const std::wstring wideMethod = ToWide(request.method);
+    if (wideMethod.empty())
+    {
+        error = "HTTP method is empty";
+        return false;
+    }
+
+    RequestHandle handle;
+    handle.handle = WinHttpOpenRequest(connection,
+                                       wideMethod.c_str(),
+                                       ToWide(url.path).c_str(),
+                                       nullptr,
+                                       WINHTTP_NO_REFERER,
+                                       WINHTTP_DEFAULT_ACCEPT_TYPES,
+                                       url.secure ? WINHTTP_FLAG_SECURE : 0);
+    if (!handle.handle)
+    {
+        error = "WinHttpOpenRequest failed: " + std::to_string(GetLastError());
+        return false;
+    }
+
+    std::string joinedHeaders;
+    for (const auto& header : request.headers)
+    {
+        if (!header.name.empty())
+        {
+            joinedHeaders += header.name + ": " + header.value + "\r\n";
+        }
+    }
+    const std::wstring wideHeaders = ToWide(joinedHeaders);
+    if (!wideHeaders.empty())
+    {
+        WinHttpAddRequestHeaders(handle.handle, wideHeaders.c_str(), static_cast<DWORD>(-1L), WINHTTP_ADDREQ_FLAG_ADD);
+    }
+
+    const bool hasBody = request.body != nullptr && !request.body->empty();
+    const DWORD bodySize = hasBody ? static_cast<DWORD>(request.body->size()) : 0;
+    if (!WinHttpSendRequest(handle.handle,
+                            WINHTTP_NO_ADDITIONAL_HEADERS,
+                            0,
+                            hasBody ? const_cast<char*>(request.body->data()) : WINHTTP_NO_REQUEST_DATA,
+                            bodySize,
+                            bodySize,
+                            0))
+    {
+        error = "WinHttpSendRequest failed: " + std::to_string(GetLastError());
+        return false;
+    }
+
+    if (!WinHttpReceiveResponse(handle.handle, nullptr))
+    {
+        error = "WinHttpReceiveResponse failed: " + std::to_string(GetLastError());
+        return false;
+    }
+
+    DWORD statusCode = 0;
+    DWORD statusSize = sizeof(statusCode);
+    if (!WinHttpQueryHeaders(handle.handle,
+                             WINHTTP_QUERY_STATUS_CODE | WINHTTP_QUERY_FLAG_NUMBER,
+                             WINHTTP_HEADER_NAME_BY_INDEX,
+                             &statusCode,
+                             &statusSize,
+                             WINHTTP_NO_HEADER_INDEX))
+    {
+        error = "Unable to query HTTP status code: " + std::to_string(GetLastError());
+        return false;
+    }
+
+    // Drain the body completely; WinHTTP only returns the socket to the keep-alive pool
+    // once the response has been fully read.
+    response.statusCode = static_cast<int>(statusCode);
+    response.body.clear();
+    DWORD availableBytes = 0;
+    do
+    {
+        if (!WinHttpQueryDataAvailable(handle.handle, &availableBytes))
+        {
+            error = "WinHttpQueryDataAvailable failed: " + std::to_string(GetLastError());
+            return false;
+        }
+        if (!availableBytes)
+        {
+            break;
+        }
+
+        const size_t offset = response.body.size();
+        response.body.resize(offset + availableBytes);
+        DWORD downloaded = 0;
+        if (!WinHttpReadData(handle.handle, response.body.data() + offset, availableBytes, &downloaded))
+        {
+            error = "WinHttpReadData failed: " + std::to_string(GetLastError());
+            return false;
+        }
+        response.body.resize(offset + downloaded);
+    } while (availableBytes > 0);
+
+    return true;
+#else
+    (void)response;
+    error = "HTTP client is only available on Windows";
+    return false;
+#endif
+}
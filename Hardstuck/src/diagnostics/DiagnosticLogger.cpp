@@ -1,21 +1,88 @@
 #include "pch.h"
 #include "diagnostics/DiagnosticLogger.h"
 
+#include <atomic>
 #include <chrono>
+#include <condition_variable>
 #include <ctime>
 #include <filesystem>
 #include <fstream>
 #include <iomanip>
+#include <memory>
 #include <mutex>
 #include <sstream>
 #include <cstdlib>
+#include <thread>
 
-static std::mutex g_logMutex;
-static std::string g_logPath;
-
-void DiagnosticLogger::Init()
+namespace
 {
-    try {
+    constexpr size_t kRingCapacity = 4096; // power of two
+    constexpr size_t kRingMask = kRingCapacity - 1;
+    constexpr auto kFlushInterval = std::chrono::milliseconds(50);
+
+    enum class Mode { Stopped, Running, ShutDown };
+
+    // One ring cell. `sequence` is the bounded-queue ticket: equal to the cell's position
+    // when free for that position, position + 1 once a producer has published into it.
+    // `text` keeps its capacity between uses, so steady-state logging does not allocate.
+    struct Slot {
+        std::atomic<size_t> sequence{0};
+        std::chrono::system_clock::time_point time;
+        std::string text;
+    };
+
+    struct LoggerState {
+        LoggerState()
+            : slots(new Slot[kRingCapacity])
+        {
+            for (size_t i = 0; i < kRingCapacity; ++i) {
+                slots[i].sequence.store(i, std::memory_order_relaxed);
+            }
+        }
+
+        ~LoggerState();
+
+        std::unique_ptr<Slot[]> slots;
+        alignas(64) std::atomic<size_t> enqueuePos{0};
+        alignas(64) std::atomic<size_t> dequeuePos{0};
+        alignas(64) std::atomic<uint64_t> dropped{0};
+        std::atomic<uint64_t> written{0};
+        std::atomic<bool> wakePending{false};
+        std::atomic<Mode> mode{Mode::Stopped};
+
+        // Start/stop, the log path, and synchronous writes after shutdown.
+        std::mutex controlMutex;
+        std::string logPath;
+        std::thread flusher;
+
+        // Flusher wakeups and Flush() handshakes; never taken on the Log() fast path.
+        std::mutex wakeMutex;
+        std::condition_variable wakeCv;
+        std::condition_variable flushedCv;
+        bool stopping{false};
+        bool flushRequested{false};
+        size_t flushedThrough{0};
+    };
+
+    LoggerState& State()
+    {
+        static LoggerState state;
+        return state;
+    }
+
+    std::tm LocalTime(std::time_t t)
+    {
+        std::tm tm;
+#ifdef _WIN32
+        localtime_s(&tm, &t);
+#else
+        localtime_r(&t, &tm);
+#endif
+        return tm;
+    }
+
+    std::filesystem::path LogDirectory()
+    {
 #ifdef _WIN32
         char* appdata_env = nullptr;
         size_t env_len = 0;
@@ -41,32 +108,197 @@ void DiagnosticLogger::Init()
             base = std::filesystem::temp_directory_path();
         }
 #endif
+        return base / "bakkesmod" / "hardstuck_logs";
+    }
+
+    bool TryPush(LoggerState& state, const std::string& msg)
+    {
+        size_t pos = state.enqueuePos.load(std::memory_order_relaxed);
+        Slot* slot = nullptr;
+        for (;;) {
+            slot = &state.slots[pos & kRingMask];
+            const size_t sequence = slot->sequence.load(std::memory_order_acquire);
+            const auto diff = static_cast<std::ptrdiff_t>(sequence - pos);
+            if (diff == 0) {
+                if (state.enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false; // full: the flusher has not freed this cell yet
+            } else {
+                pos = state.enqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+
+        slot->time = std::chrono::system_clock::now();
+        try {
+            slot->text.assign(msg);
+        } catch (...) {
+            // The cell is claimed and must still be published, or the flusher stalls on it.
+            slot->text.clear();
+        }
+        slot->sequence.store(pos + 1, std::memory_order_release);
+
+        // Only wake the flusher early when the ring is filling up; otherwise it picks the
+        // record up on its next tick and the producer pays no syscall.
+        const size_t depth = pos + 1 - state.dequeuePos.load(std::memory_order_relaxed);
+        if (depth >= kRingCapacity / 2 && !state.wakePending.exchange(true, std::memory_order_relaxed)) {
+            state.wakeCv.notify_one();
+        }
+        return true;
+    }
+
+    // Single consumer. Appends every published record to `batch`, formatted as
+    // "YYYY-mm-dd HH:MM:SS - message\n", and returns how many it took.
+    size_t DrainInto(LoggerState& state, std::string& batch, std::time_t& stampSecond, char (&stamp)[32])
+    {
+        size_t drained = 0;
+        size_t pos = state.dequeuePos.load(std::memory_order_relaxed);
+        for (;;) {
+            Slot& slot = state.slots[pos & kRingMask];
+            if (slot.sequence.load(std::memory_order_acquire) != pos + 1) {
+                break;
+            }
+
+            const std::time_t second = std::chrono::system_clock::to_time_t(slot.time);
+            if (second != stampSecond) {
+                const std::tm tm = LocalTime(second);
+                std::strftime(stamp, sizeof(stamp), "%Y-%m-%d %H:%M:%S", &tm);
+                stampSecond = second;
+            }
+            batch += stamp;
+            batch += " - ";
+            batch += slot.text;
+            batch += '\n';
+            slot.text.clear();
+
+            slot.sequence.store(pos + kRingCapacity, std::memory_order_release);
+            ++pos;
+            ++drained;
+        }
+        state.dequeuePos.store(pos, std::memory_order_relaxed);
+        return drained;
+    }
+
+    void RunFlusher(LoggerState& state, std::ofstream file)
+    {
+        std::string batch;
+        std::time_t stampSecond = -1;
+        char stamp[32] = {};
+        uint64_t reportedDropped = 0;
+
+        for (;;) {
+            bool stopping = false;
+            {
+                std::unique_lock<std::mutex> lock(state.wakeMutex);
+                state.wakeCv.wait_for(lock, kFlushInterval, [&state] {
+                    return state.stopping || state.flushRequested ||
+                           state.wakePending.load(std::memory_order_relaxed);
+                });
+                stopping = state.stopping;
+            }
+            state.wakePending.store(false, std::memory_order_relaxed);
+
+            const size_t drained = DrainInto(state, batch, stampSecond, stamp);
+            const uint64_t dropped = state.dropped.load(std::memory_order_relaxed);
+            if (dropped != reportedDropped) {
+                const std::tm tm = LocalTime(std::time(nullptr));
+                char now[32];
+                std::strftime(now, sizeof(now), "%Y-%m-%d %H:%M:%S", &tm);
+                batch += now;
+                batch += " - DiagnosticLogger: ring full, dropped " + std::to_string(dropped - reportedDropped) + " records\n";
+                reportedDropped = dropped;
+            }
+
+            if (!batch.empty() && file) {
+                file.write(batch.data(), static_cast<std::streamsize>(batch.size()));
+                file.flush();
+            }
+            batch.clear();
+            state.written.fetch_add(drained, std::memory_order_relaxed);
+
+            {
+                std::lock_guard<std::mutex> lock(state.wakeMutex);
+                state.flushedThrough = state.dequeuePos.load(std::memory_order_relaxed);
+                state.flushRequested = false;
+            }
+            state.flushedCv.notify_all();
+
+            if (stopping) {
+                return;
+            }
+        }
+    }
+
+    // Caller holds controlMutex.
+    void StopFlusher(LoggerState& state)
+    {
+        if (!state.flusher.joinable()) {
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(state.wakeMutex);
+            state.stopping = true;
+        }
+        state.wakeCv.notify_one();
+        state.flusher.join();
+        {
+            std::lock_guard<std::mutex> lock(state.wakeMutex);
+            state.stopping = false;
+        }
+        state.flushedCv.notify_all();
+    }
+
+    LoggerState::~LoggerState()
+    {
+        // Backstop for hosts that never call Shutdown(); the plugin calls it on unload.
+        std::lock_guard<std::mutex> lock(controlMutex);
+        mode.store(Mode::ShutDown, std::memory_order_release);
+        StopFlusher(*this);
+    }
 
-        std::filesystem::path dir = base / "bakkesmod" / "hardstuck_logs";
+    void WriteSynchronously(LoggerState& state, const std::string& msg)
+    {
+        const std::tm tm = LocalTime(std::time(nullptr));
+        std::ostringstream oss;
+        oss << std::put_time(&tm, "%Y-%m-%d %H:%M:%S") << " - " << msg << "\n";
+
+        std::ofstream ofs(state.logPath, std::ios::out | std::ios::app);
+        if (ofs) {
+            ofs << oss.str();
+        }
+    }
+}
+
+void DiagnosticLogger::Init()
+{
+    LoggerState& state = State();
+    std::lock_guard<std::mutex> lock(state.controlMutex);
+    if (state.mode.load(std::memory_order_acquire) == Mode::Running) {
+        return;
+    }
+
+    try {
+        std::filesystem::path dir = LogDirectory();
         std::error_code ec;
         std::filesystem::create_directories(dir, ec);
 
-        auto now = std::chrono::system_clock::now();
-        std::time_t t = std::chrono::system_clock::to_time_t(now);
-        std::tm tm;
-#ifdef _WIN32
-        localtime_s(&tm, &t);
-#else
-        localtime_r(&t, &tm);
-#endif
-
+        const std::tm tm = LocalTime(std::chrono::system_clock::to_time_t(std::chrono::system_clock::now()));
         std::ostringstream oss;
         oss << std::put_time(&tm, "%Y%m%d-%H%M%S");
         std::string filename = std::string("hardstuck_") + oss.str() + ".log";
 
-        g_logPath = (dir / filename).string();
+        state.logPath = (dir / filename).string();
 
         // Write header
-        std::ofstream ofs(g_logPath, std::ios::out | std::ios::app);
+        std::ofstream ofs(state.logPath, std::ios::out | std::ios::app | std::ios::binary);
         if (ofs) {
             ofs << "--- Hardstuck Diagnostic Log " << oss.str() << " ---\n";
-            ofs.close();
+            ofs.flush();
         }
+
+        state.flusher = std::thread(RunFlusher, std::ref(state), std::move(ofs));
+        state.mode.store(Mode::Running, std::memory_order_release);
     } catch (...) {
         // Best-effort; do not throw
     }
@@ -74,28 +306,66 @@ void DiagnosticLogger::Init()
 
 void DiagnosticLogger::Log(const std::string& msg)
 {
-    std::lock_guard<std::mutex> lock(g_logMutex);
-    try {
-        if (g_logPath.empty()) {
-            Init();
-        }
-        auto now = std::chrono::system_clock::now();
-        std::time_t t = std::chrono::system_clock::to_time_t(now);
-        std::tm tm;
-#ifdef _WIN32
-        localtime_s(&tm, &t);
-#else
-        localtime_r(&t, &tm);
-#endif
+    LoggerState& state = State();
+    Mode mode = state.mode.load(std::memory_order_acquire);
+    if (mode == Mode::Stopped) {
+        Init();
+        mode = state.mode.load(std::memory_order_acquire);
+    }
 
-        std::ostringstream oss;
-        oss << std::put_time(&tm, "%Y-%m-%d %H:%M:%S") << " - " << msg << "\n";
+    if (mode == Mode::Running) {
+        if (!TryPush(state, msg)) {
+            state.dropped.fetch_add(1, std::memory_order_relaxed);
+        }
+        return;
+    }
 
-        std::ofstream ofs(g_logPath, std::ios::out | std::ios::app);
-        if (ofs) {
-            ofs << oss.str();
+    std::lock_guard<std::mutex> lock(state.controlMutex);
+    try {
+        if (!state.logPath.empty()) {
+            WriteSynchronously(state, msg);
         }
     } catch (...) {
         // swallow errors; logging must not crash plugin
     }
 }
+
+void DiagnosticLogger::Flush()
+{
+    LoggerState& state = State();
+    if (state.mode.load(std::memory_order_acquire) != Mode::Running) {
+        return;
+    }
+
+    const size_t target = state.enqueuePos.load(std::memory_order_acquire);
+    std::unique_lock<std::mutex> lock(state.wakeMutex);
+    state.flushRequested = true;
+    state.wakeCv.notify_one();
+    state.flushedCv.wait(lock, [&state, target] {
+        return state.flushedThrough >= target || state.mode.load(std::memory_order_acquire) != Mode::Running;
+    });
+}
+
+void DiagnosticLogger::Shutdown()
+{
+    LoggerState& state = State();
+    std::lock_guard<std::mutex> lock(state.controlMutex);
+    if (state.mode.load(std::memory_order_acquire) != Mode::Running) {
+        return;
+    }
+    state.mode.store(Mode::ShutDown, std::memory_order_release);
+    StopFlusher(state);
+}
+
+DiagnosticLogger::Stats DiagnosticLogger::GetStats()
+{
+    LoggerState& state = State();
+    Stats stats;
+    stats.written = state.written.load(std::memory_order_relaxed);
+    stats.dropped = state.dropped.load(std::memory_order_relaxed);
+    const size_t enqueued = state.enqueuePos.load(std::memory_order_relaxed);
+    const size_t dequeued = state.dequeuePos.load(std::memory_order_relaxed);
+    stats.queued = enqueued >= dequeued ? enqueued - dequeued : 0;
+    stats.capacity = kRingCapacity;
+    return stats;
+}
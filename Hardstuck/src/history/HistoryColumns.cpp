@@ -0,0 +1,237 @@
+// HistoryColumns.cpp
+#include "pch.h"
+#include "history/HistoryColumns.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+
+namespace
+{
+    void Reserve(MmrColumns& columns, size_t count)
+    {
+        columns.timestamps.reserve(count);
+        columns.days.reserve(count);
+        columns.mmr.reserve(count);
+        columns.playlist.reserve(count);
+        columns.delta.reserve(count);
+        columns.entry.reserve(count);
+    }
+
+    void Clear(MmrColumns& columns)
+    {
+        columns.timestamps.clear();
+        columns.days.clear();
+        columns.mmr.clear();
+        columns.playlist.clear();
+        columns.delta.clear();
+        columns.entry.clear();
+        columns.lastMmrByPlaylist.clear();
+    }
+
+    constexpr int32_t kUnseen = std::numeric_limits<int32_t>::min();
+
+    // Append rows for `order` (positions in history), continuing the per-playlist deltas.
+    void AppendRows(MmrColumns& columns,
+                    const std::vector<MmrHistoryEntry>& history,
+                    const uint32_t* order,
+                    size_t count)
+    {
+        std::vector<int32_t>& lastMmr = columns.lastMmrByPlaylist;
+        if (columns.Size() == 0)
+        {
+            Reserve(columns, count);
+        }
+        for (size_t i = 0; i < count; ++i)
+        {
+            const MmrHistoryEntry& entry = history[order[i]];
+            if (entry.playlist >= lastMmr.size())
+            {
+                lastMmr.resize(static_cast<size_t>(entry.playlist) + 1, kUnseen);
+            }
+            int32_t& last = lastMmr[entry.playlist];
+            columns.timestamps.push_back(entry.timestamp);
+            columns.days.push_back(entry.day);
+            columns.mmr.push_back(entry.mmr);
+            columns.playlist.push_back(entry.playlist);
+            columns.delta.push_back(last == kUnseen ? 0 : entry.mmr - last);
+            columns.entry.push_back(order[i]);
+            last = entry.mmr;
+        }
+    }
+}
+
+bool HistoryColumns::Append(MmrColumns& columns, const std::vector<MmrHistoryEntry>& history, size_t firstEntry)
+{
+    if (firstEntry >= history.size())
+    {
+        return true;
+    }
+
+    std::vector<uint32_t> order(history.size() - firstEntry);
+    std::iota(order.begin(), order.end(), static_cast<uint32_t>(firstEntry));
+    std::stable_sort(order.begin(), order.end(), [&history](uint32_t lhs, uint32_t rhs) {
+        return history[lhs].timestamp < history[rhs].timestamp;
+    });
+
+    if (columns.Size() != firstEntry
+        || (!columns.timestamps.empty() && history[order.front()].timestamp < columns.timestamps.back()))
+    {
+        Rebuild(columns, history);
+        return false;
+    }
+    AppendRows(columns, history, order.data(), order.size());
+    return true;
+}
+
+void HistoryColumns::Rebuild(MmrColumns& columns, const std::vector<MmrHistoryEntry>& history)
+{
+    Clear(columns);
+    std::vector<uint32_t> order(history.size());
+    std::iota(order.begin(), order.end(), 0u);
+    std::stable_sort(order.begin(), order.end(), [&history](uint32_t lhs, uint32_t rhs) {
+        return history[lhs].timestamp < history[rhs].timestamp;
+    });
+    AppendRows(columns, history, order.data(), order.size());
+}
+
+MmrColumns HistoryColumns::Filter(const MmrColumns& columns, SymbolId playlist)
+{
+    MmrColumns filtered;
+    const size_t count = columns.Size();
+    const size_t matches = static_cast<size_t>(std::count(columns.playlist.begin(), columns.playlist.end(), playlist));
+    Reserve(filtered, matches);
+    for (size_t row = 0; row < count; ++row)
+    {
+        if (columns.playlist[row] == playlist)
+        {
+            filtered.timestamps.push_back(columns.timestamps[row]);
+            filtered.days.push_back(columns.days[row]);
+            filtered.mmr.push_back(columns.mmr[row]);
+            filtered.playlist.push_back(playlist);
+            filtered.delta.push_back(columns.delta[row]);
+            filtered.entry.push_back(columns.entry[row]);
+        }
+    }
+    return filtered;
+}
+
+void HistoryColumns::MinMax(const int32_t* values, size_t count, int32_t& minValue, int32_t& maxValue)
+{
+    int32_t low = count > 0 ? values[0] : 0;
+    int32_t high = low;
+    for (size_t i = 0; i < count; ++i)
+    {
+        low = values[i] < low ? values[i] : low;
+        high = values[i] > high ? values[i] : high;
+    }
+    minValue = low;
+    maxValue = high;
+}
+
+void HistoryColumns::ToFloat(const int32_t* values, size_t count, float* out)
+{
+    for (size_t i = 0; i < count; ++i)
+    {
+        out[i] = static_cast<float>(values[i]);
+    }
+}
+
+void HistoryColumns::AdjacentDeltas(const float* series, size_t count, float* out)
+{
+    if (count == 0)
+    {
+        return;
+    }
+    out[0] = 0.0f;
+    for (size_t i = 1; i < count; ++i)
+    {
+        out[i] = series[i] - series[i - 1];
+    }
+}
+
+size_t HistoryColumns::DownsampleLttb(const int32_t* values, size_t count, size_t target, uint32_t* selected)
+{
+    if (count <= target || count <= 2)
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            selected[i] = static_cast<uint32_t>(i);
+        }
+        return count;
+    }
+    if (target < 3)
+    {
+        if (target == 0)
+        {
+            return 0;
+        }
+        selected[0] = 0;
+        if (target == 1)
+        {
+            return 1;
+        }
+        selected[1] = static_cast<uint32_t>(count - 1);
+        return 2;
+    }
+
+    // The first and last rows are fixed; the rows in between are split into target - 2
+    // buckets and each bucket keeps the row forming the largest triangle with the previous
+    // pick and the average of the next bucket. x is the row index.
+    const double bucketSize = static_cast<double>(count - 2) / static_cast<double>(target - 2);
+    size_t written = 0;
+    size_t anchor = 0;
+    selected[written++] = 0;
+    for (size_t bucket = 0; bucket < target - 2; ++bucket)
+    {
+        const size_t start = static_cast<size_t>(static_cast<double>(bucket) * bucketSize) + 1;
+        const size_t end = static_cast<size_t>(static_cast<double>(bucket + 1) * bucketSize) + 1;
+        const size_t nextStart = end;
+        const size_t nextEnd = (std::min)(static_cast<size_t>(static_cast<double>(bucket + 2) * bucketSize) + 1, count);
+
+        double nextY = 0.0;
+        for (size_t i = nextStart; i < nextEnd; ++i)
+        {
+            nextY += values[i];
+        }
+        nextY /= static_cast<double>(nextEnd - nextStart);
+        const double nextX = 0.5 * static_cast<double>(nextStart + nextEnd - 1);
+
+        const double anchorX = static_cast<double>(anchor);
+        const double anchorY = values[anchor];
+        double bestArea = -1.0;
+        size_t best = start;
+        for (size_t i = start; i < end; ++i)
+        {
+            // Twice the triangle area; the factor does not change the comparison.
+            const double area = std::abs((anchorX - nextX) * (values[i] - anchorY)
+                                         - (anchorX - static_cast<double>(i)) * (nextY - anchorY));
+            if (area > bestArea)
+            {
+                bestArea = area;
+                best = i;
+            }
+        }
+        selected[written++] = static_cast<uint32_t>(best);
+        anchor = best;
+    }
+    selected[written++] = static_cast<uint32_t>(count - 1);
+    return written;
+}
+
+void HistoryColumns::Project(const float* series, size_t count, float minValue, float maxValue,
+                             float x0, float y0, float x1, float y1, float* xy)
+{
+    if (count == 0)
+    {
+        return;
+    }
+    const float xStep = count > 1 ? (x1 - x0) / static_cast<float>(count - 1) : 0.0f;
+    const float yScale = (y1 - y0) / (std::max)(1.0f, maxValue - minValue);
+    for (size_t i = 0; i < count; ++i)
+    {
+        xy[2 * i] = x0 + xStep * static_cast<float>(i);
+        xy[2 * i + 1] = y1 - (series[i] - minValue) * yScale;
+    }
+}
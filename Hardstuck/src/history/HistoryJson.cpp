@@ -1,14 +1,192 @@
 // HistoryJson.cpp
 #include "pch.h"
 #include "history/HistoryJson.h"
+#include "history/JsonScan.h"
+#include "history/SnapshotIndex.h"
+#include "utils/HsUtils.h"
 
+#include <algorithm>
 #include <cctype>
+#include <charconv>
 #include <cmath>
 #include <cstring>
-#include <stdexcept>
+#include <limits>
 
 using namespace HistoryJson;
 
+namespace
+{
+    bool SkipDigits(std::string_view data, size_t& pos)
+    {
+        const size_t start = pos;
+        while (pos < data.size() && data[pos] >= '0' && data[pos] <= '9')
+        {
+            ++pos;
+        }
+        return pos != start;
+    }
+
+    struct NumberValue
+    {
+        double number{0.0};
+        int64_t integer{0};
+        bool isInteger{false};
+    };
+
+    // Validates a JSON number at `pos` and converts it without allocating. Integers that
+    // fit in int64_t are kept exactly alongside their double value.
+    bool ScanNumber(std::string_view data, size_t& pos, NumberValue& value, std::string& error)
+    {
+        const size_t start = pos;
+        if (pos < data.size() && data[pos] == '-')
+        {
+            ++pos;
+        }
+        if (pos < data.size() && data[pos] == '0')
+        {
+            ++pos;
+        }
+        else if (!SkipDigits(data, pos))
+        {
+            error = "Invalid number";
+            return false;
+        }
+
+        bool integral = true;
+        if (pos < data.size() && data[pos] == '.')
+        {
+            ++pos;
+            integral = false;
+            if (!SkipDigits(data, pos))
+            {
+                error = "Invalid number";
+                return false;
+            }
+        }
+        if (pos < data.size() && (data[pos] == 'e' || data[pos] == 'E'))
+        {
+            ++pos;
+            integral = false;
+            if (pos < data.size() && (data[pos] == '+' || data[pos] == '-'))
+            {
+                ++pos;
+            }
+            if (!SkipDigits(data, pos))
+            {
+                error = "Invalid number";
+                return false;
+            }
+        }
+
+        const char* first = data.data() + start;
+        const char* last = data.data() + pos;
+        value.isInteger = false;
+        if (integral)
+        {
+            const auto result = std::from_chars(first, last, value.integer);
+            if (result.ec == std::errc() && result.ptr == last)
+            {
+                value.isInteger = true;
+                value.number = static_cast<double>(value.integer);
+                return true;
+            }
+        }
+
+        // Fractions, exponents and integers beyond int64_t take the floating-point path.
+        const auto result = std::from_chars(first, last, value.number);
+        if (result.ec != std::errc() || result.ptr != last)
+        {
+            error = "Invalid number";
+            return false;
+        }
+        return true;
+    }
+
+    std::optional<int64_t> NumberAsInt64(Type type, bool isInteger, int64_t integer, double number, std::string_view text)
+    {
+        if (type == Type::Number)
+        {
+            if (isInteger)
+            {
+                return integer;
+            }
+            const double rounded = std::round(number);
+            if (!(rounded >= -9223372036854775808.0 && rounded < 9223372036854775808.0))
+            {
+                return std::nullopt;
+            }
+            return static_cast<int64_t>(rounded);
+        }
+        if (type == Type::String)
+        {
+            // Same leniency as std::stoi: leading whitespace and an explicit '+' are accepted.
+            size_t start = 0;
+            while (start < text.size() && std::isspace(static_cast<unsigned char>(text[start])))
+            {
+                ++start;
+            }
+            if (start < text.size() && text[start] == '+')
+            {
+                ++start;
+            }
+            const char* last = text.data() + text.size();
+            int64_t parsed = 0;
+            const auto result = std::from_chars(text.data() + start, last, parsed);
+            if (result.ec == std::errc() && result.ptr == last)
+            {
+                return parsed;
+            }
+        }
+        return std::nullopt;
+    }
+
+    std::optional<int> NarrowToInt(std::optional<int64_t> value)
+    {
+        if (!value || *value < std::numeric_limits<int>::min() || *value > std::numeric_limits<int>::max())
+        {
+            return std::nullopt;
+        }
+        return static_cast<int>(*value);
+    }
+
+    // Continues a string from the escape at `pos`, appending unescaped bytes to `out`
+    // (which already holds `length` bytes) through the closing quote.
+    bool CopyEscapedString(std::string_view data, size_t& pos, char* out, size_t& length, std::string& error)
+    {
+        while (pos < data.size())
+        {
+            const char c = data[pos++];
+            if (c == '"')
+            {
+                return true;
+            }
+            if (c != '\\')
+            {
+                out[length++] = c;
+                continue;
+            }
+            if (pos >= data.size())
+            {
+                error = "Invalid escape sequence";
+                return false;
+            }
+            const char escaped = data[pos++];
+            switch (escaped)
+            {
+            case 'b':  out[length++] = '\b'; break;
+            case 'f':  out[length++] = '\f'; break;
+            case 'n':  out[length++] = '\n'; break;
+            case 'r':  out[length++] = '\r'; break;
+            case 't':  out[length++] = '\t'; break;
+            default:   out[length++] = escaped; break;
+            }
+        }
+
+        error = "Unterminated string";
+        return false;
+    }
+}
+
 Parser::Parser(const std::string& data)
     : data_(data)
     , pos_(0)
@@ -173,8 +351,18 @@ bool Parser::ParseString(std::string& output, std::string& error)
         return false;
     }
 
+    const std::string_view data(data_);
     while (pos_ < data_.size())
     {
+        // Copy the escape-free run up to the next quote/backslash in one go.
+        const size_t special = Scan::FindQuoteOrBackslash(data, pos_);
+        output.append(data_, pos_, special - pos_);
+        pos_ = special;
+        if (pos_ >= data_.size())
+        {
+            break;
+        }
+
         char c = data_[pos_++];
         if (c == '"')
         {
@@ -200,9 +388,7 @@ bool Parser::ParseString(std::string& output, std::string& error)
             case 't':  output.push_back('\t'); break;
             default:   output.push_back(escaped); break;
             }
-            continue;
         }
-        output.push_back(c);
     }
 
     error = "Unterminated string";
@@ -211,72 +397,16 @@ bool Parser::ParseString(std::string& output, std::string& error)
 
 bool Parser::ParseNumber(Value& output, std::string& error)
 {
-    size_t start = pos_;
-    if (Peek() == '-')
-    {
-        ++pos_;
-    }
-
-    if (Peek() == '0')
-    {
-        ++pos_;
-    }
-    else if (std::isdigit(static_cast<unsigned char>(Peek())))
-    {
-        while (std::isdigit(static_cast<unsigned char>(Peek())))
-        {
-            ++pos_;
-        }
-    }
-    else
-    {
-        error = "Invalid number";
-        return false;
-    }
-
-    if (Peek() == '.')
-    {
-        ++pos_;
-        if (!std::isdigit(static_cast<unsigned char>(Peek())))
-        {
-            error = "Invalid number";
-            return false;
-        }
-        while (std::isdigit(static_cast<unsigned char>(Peek())))
-        {
-            ++pos_;
-        }
-    }
-
-    if (Peek() == 'e' || Peek() == 'E')
-    {
-        ++pos_;
-        if (Peek() == '+' || Peek() == '-')
-        {
-            ++pos_;
-        }
-        if (!std::isdigit(static_cast<unsigned char>(Peek())))
-        {
-            error = "Invalid number";
-            return false;
-        }
-        while (std::isdigit(static_cast<unsigned char>(Peek())))
-        {
-            ++pos_;
-        }
-    }
-
-    try
-    {
-        output.numberValue = std::stod(data_.substr(start, pos_ - start));
-    }
-    catch (const std::exception&)
+    NumberValue number;
+    if (!ScanNumber(data_, pos_, number, error))
     {
-        error = "Invalid number";
         return false;
     }
 
     output.type = Type::Number;
+    output.numberValue = number.number;
+    output.integerValue = number.integer;
+    output.isInteger = number.isInteger;
     return true;
 }
 
@@ -299,10 +429,7 @@ bool Parser::ParseLiteral(const char* literal, Value& output, Type type, std::st
 
 void Parser::SkipWhitespace()
 {
-    while (pos_ < data_.size() && std::isspace(static_cast<unsigned char>(data_[pos_])))
-    {
-        ++pos_;
-    }
+    pos_ = Scan::SkipWhitespace(data_, pos_);
 }
 
 char Parser::Peek() const
@@ -348,29 +475,17 @@ std::optional<std::string> HistoryJson::AsString(const Value* value)
 }
 
 std::optional<int> HistoryJson::AsInt(const Value* value)
+{
+    return NarrowToInt(AsInt64(value));
+}
+
+std::optional<int64_t> HistoryJson::AsInt64(const Value* value)
 {
     if (!value)
     {
         return std::nullopt;
     }
-    if (value->type == Type::Number)
-    {
-        return static_cast<int>(std::round(value->numberValue));
-    }
-    if (value->type == Type::String)
-    {
-        try
-        {
-            size_t idx = 0;
-            int parsed = std::stoi(value->stringValue, &idx);
-            if (idx == value->stringValue.size())
-            {
-                return parsed;
-            }
-        }
-        catch (...) {}
-    }
-    return std::nullopt;
+    return NumberAsInt64(value->type, value->isInteger, value->integerValue, value->numberValue, value->stringValue);
 }
 
 std::vector<std::string> HistoryJson::AsStringList(const Value* value)
@@ -390,6 +505,606 @@ std::vector<std::string> HistoryJson::AsStringList(const Value* value)
     return result;
 }
 
+void* Arena::Allocate(size_t bytes, size_t alignment)
+{
+    if (!blocks_.empty())
+    {
+        Block& block = blocks_.back();
+        const size_t aligned = (used_ + alignment - 1) & ~(alignment - 1);
+        if (aligned + bytes <= block.size)
+        {
+            used_ = aligned + bytes;
+            return block.data.get() + aligned;
+        }
+    }
+
+    constexpr size_t kMinBlockSize = 16 * 1024;
+    Block block;
+    block.size = (std::max)(kMinBlockSize, bytes + alignment);
+    if (!blocks_.empty())
+    {
+        block.size = (std::max)(block.size, blocks_.back().size * 2);
+    }
+    block.data = std::make_unique<std::byte[]>(block.size);
+    blocks_.push_back(std::move(block));
+
+    // operator new[] storage is suitably aligned for any fundamental type.
+    used_ = bytes;
+    return blocks_.back().data.get();
+}
+
+void Arena::Reset()
+{
+    if (blocks_.size() > 1)
+    {
+        // Keep only the largest (most recent) block so steady-state parses stay in one block.
+        Block largest = std::move(blocks_.back());
+        blocks_.clear();
+        blocks_.push_back(std::move(largest));
+    }
+    used_ = 0;
+}
+
+namespace HistoryJson
+{
+    class ViewParser
+    {
+    public:
+        ViewParser(ViewDocument& document, std::string_view data)
+            : document_(document)
+            , data_(data)
+        {
+        }
+
+        bool Parse(ViewValue& output, std::string& error)
+        {
+            SkipWhitespace();
+            if (!ParseValue(output, error))
+            {
+                return false;
+            }
+            SkipWhitespace();
+            if (pos_ != data_.size())
+            {
+                error = "Unexpected characters after JSON payload";
+                return false;
+            }
+            return true;
+        }
+
+    private:
+        bool ParseValue(ViewValue& output, std::string& error)
+        {
+            SkipWhitespace();
+            const char c = Peek();
+            if (c == '"')
+            {
+                output.type = Type::String;
+                return ParseString(output.stringValue, error);
+            }
+            if (c == '{')
+            {
+                return ParseObject(output, error);
+            }
+            if (c == '[')
+            {
+                return ParseArray(output, error);
+            }
+            if (c == 't')
+            {
+                return ParseLiteral("true", output, Type::Bool, error);
+            }
+            if (c == 'f')
+            {
+                return ParseLiteral("false", output, Type::Bool, error);
+            }
+            if (c == 'n')
+            {
+                return ParseLiteral("null", output, Type::Null, error);
+            }
+            if (c == '-' || (c >= '0' && c <= '9'))
+            {
+                return ParseNumber(output, error);
+            }
+            error = "Unexpected token in JSON";
+            return false;
+        }
+
+        // Children are staged on the document's reusable stacks and copied into the arena
+        // once the container closes, so nested containers never reallocate a parent.
+        bool ParseObject(ViewValue& output, std::string& error)
+        {
+            output.type = Type::Object;
+            ++pos_;
+
+            SkipWhitespace();
+            if (Consume('}'))
+            {
+                return true;
+            }
+
+            auto& stack = document_.memberStack_;
+            const size_t first = stack.size();
+            while (true)
+            {
+                ViewMember member;
+                if (!ParseString(member.key, error))
+                {
+                    stack.resize(first);
+                    return false;
+                }
+
+                SkipWhitespace();
+                if (!Consume(':'))
+                {
+                    error = "Expected ':' after key";
+                    stack.resize(first);
+                    return false;
+                }
+
+                if (!ParseValue(member.value, error))
+                {
+                    stack.resize(first);
+                    return false;
+                }
+                stack.push_back(member);
+
+                SkipWhitespace();
+                if (Consume('}'))
+                {
+                    break;
+                }
+                if (!Consume(','))
+                {
+                    error = "Expected ',' between object entries";
+                    stack.resize(first);
+                    return false;
+                }
+                SkipWhitespace();
+            }
+
+            output.members = CopyToArena(stack, first);
+            output.size = static_cast<uint32_t>(stack.size() - first);
+            stack.resize(first);
+            return true;
+        }
+
+        bool ParseArray(ViewValue& output, std::string& error)
+        {
+            output.type = Type::Array;
+            ++pos_;
+
+            SkipWhitespace();
+            if (Consume(']'))
+            {
+                return true;
+            }
+
+            auto& stack = document_.elementStack_;
+            const size_t first = stack.size();
+            while (true)
+            {
+                ViewValue element;
+                if (!ParseValue(element, error))
+                {
+                    stack.resize(first);
+                    return false;
+                }
+                stack.push_back(element);
+
+                SkipWhitespace();
+                if (Consume(']'))
+                {
+                    break;
+                }
+                if (!Consume(','))
+                {
+                    error = "Expected ',' between array entries";
+                    stack.resize(first);
+                    return false;
+                }
+                SkipWhitespace();
+            }
+
+            output.elements = CopyToArena(stack, first);
+            output.size = static_cast<uint32_t>(stack.size() - first);
+            stack.resize(first);
+            return true;
+        }
+
+        template <typename T>
+        const T* CopyToArena(const std::vector<T>& stack, size_t first)
+        {
+            const size_t count = stack.size() - first;
+            T* target = static_cast<T*>(document_.arena_.Allocate(sizeof(T) * count, alignof(T)));
+            std::uninitialized_copy(stack.begin() + static_cast<std::ptrdiff_t>(first), stack.end(), target);
+            return target;
+        }
+
+        bool ParseString(std::string_view& output, std::string& error)
+        {
+            if (!Consume('"'))
+            {
+                error = "Expected '\"'";
+                return false;
+            }
+
+            // Fast path: no escapes, so the view can point straight into the source.
+            const size_t start = pos_;
+            pos_ = Scan::FindQuoteOrBackslash(data_, pos_);
+            if (pos_ < data_.size())
+            {
+                if (data_[pos_] == '\\')
+                {
+                    return ParseEscapedString(start, output, error);
+                }
+                output = data_.substr(start, pos_ - start);
+                ++pos_;
+                return true;
+            }
+
+            error = "Unterminated string";
+            return false;
+        }
+
+        bool ParseEscapedString(size_t start, std::string_view& output, std::string& error)
+        {
+            // Unescaped text is never longer than the raw text, which ends before data_.size().
+            char* buffer = static_cast<char*>(document_.arena_.Allocate(data_.size() - start, 1));
+            size_t length = pos_ - start;
+            std::memcpy(buffer, data_.data() + start, length);
+            if (!CopyEscapedString(data_, pos_, buffer, length, error))
+            {
+                return false;
+            }
+            output = std::string_view(buffer, length);
+            return true;
+        }
+
+        bool ParseNumber(ViewValue& output, std::string& error)
+        {
+            NumberValue number;
+            if (!ScanNumber(data_, pos_, number, error))
+            {
+                return false;
+            }
+            output.type = Type::Number;
+            output.numberValue = number.number;
+            output.integerValue = number.integer;
+            output.isInteger = number.isInteger;
+            return true;
+        }
+
+        bool ParseLiteral(const char* literal, ViewValue& output, Type type, std::string& error)
+        {
+            const std::string_view expected(literal);
+            if (data_.substr(pos_, expected.size()) != expected)
+            {
+                error = "Unexpected literal";
+                return false;
+            }
+            pos_ += expected.size();
+            output.type = type;
+            output.boolValue = type == Type::Bool && literal[0] == 't';
+            return true;
+        }
+
+        void SkipWhitespace()
+        {
+            pos_ = Scan::SkipWhitespace(data_, pos_);
+        }
+
+        char Peek() const
+        {
+            return pos_ < data_.size() ? data_[pos_] : '\0';
+        }
+
+        bool Consume(char expected)
+        {
+            if (Peek() != expected)
+            {
+                return false;
+            }
+            ++pos_;
+            return true;
+        }
+
+        ViewDocument& document_;
+        std::string_view data_;
+        size_t pos_{0};
+    };
+}
+
+bool ViewDocument::Parse(std::string_view data, std::string& error)
+{
+    arena_.Reset();
+    elementStack_.clear();
+    memberStack_.clear();
+    root_ = ViewValue();
+
+    ViewParser parser(*this, data);
+    if (!parser.Parse(root_, error))
+    {
+        root_ = ViewValue();
+        return false;
+    }
+    return true;
+}
+
+const ViewValue* HistoryJson::GetMember(const ViewValue& object, std::string_view key)
+{
+    if (object.type != Type::Object)
+    {
+        return nullptr;
+    }
+    // Payload objects are small; a linear scan beats building a lookup table. The first
+    // duplicate wins, as with Value's map.
+    for (uint32_t i = 0; i < object.size; ++i)
+    {
+        if (object.members[i].key == key)
+        {
+            return &object.members[i].value;
+        }
+    }
+    return nullptr;
+}
+
+std::optional<std::string_view> HistoryJson::AsString(const ViewValue* value)
+{
+    if (!value || value->type != Type::String)
+    {
+        return std::nullopt;
+    }
+    return value->stringValue;
+}
+
+std::optional<int> HistoryJson::AsInt(const ViewValue* value)
+{
+    return NarrowToInt(AsInt64(value));
+}
+
+std::optional<int64_t> HistoryJson::AsInt64(const ViewValue* value)
+{
+    if (!value)
+    {
+        return std::nullopt;
+    }
+    return NumberAsInt64(value->type, value->isInteger, value->integerValue, value->numberValue, value->stringValue);
+}
+
+FieldExtractor::FieldExtractor(std::string_view data)
+    : data_(data)
+{
+}
+
+bool FieldExtractor::BeginObject(bool& empty, std::string& error)
+{
+    SkipWhitespace();
+    if (pos_ >= data_.size() || data_[pos_] != '{')
+    {
+        error = "Payload is not a JSON object";
+        return false;
+    }
+    ++pos_;
+    SkipWhitespace();
+    empty = pos_ < data_.size() && data_[pos_] == '}';
+    if (empty)
+    {
+        ++pos_;
+    }
+    return true;
+}
+
+bool FieldExtractor::NextKey(std::string_view& key, std::string& error)
+{
+    if (!ReadString(key, error))
+    {
+        return false;
+    }
+    SkipWhitespace();
+    if (pos_ >= data_.size() || data_[pos_] != ':')
+    {
+        error = "Expected ':' after key";
+        return false;
+    }
+    ++pos_;
+    SkipWhitespace();
+    return true;
+}
+
+bool FieldExtractor::NextMember(bool& done, std::string& error)
+{
+    SkipWhitespace();
+    if (pos_ < data_.size() && data_[pos_] == '}')
+    {
+        ++pos_;
+        done = true;
+        return true;
+    }
+    if (pos_ >= data_.size() || data_[pos_] != ',')
+    {
+        error = "Expected ',' between object entries";
+        return false;
+    }
+    ++pos_;
+    SkipWhitespace();
+    return true;
+}
+
+bool FieldExtractor::ReadValue(ViewValue& value, std::string& error)
+{
+    const char c = pos_ < data_.size() ? data_[pos_] : '\0';
+    if (c == '"')
+    {
+        value.type = Type::String;
+        return ReadString(value.stringValue, error);
+    }
+    if (c == '{' || c == '[')
+    {
+        value.type = c == '{' ? Type::Object : Type::Array;
+        return SkipValue(error);
+    }
+    if (c == '-' || (c >= '0' && c <= '9'))
+    {
+        NumberValue number;
+        if (!ScanNumber(data_, pos_, number, error))
+        {
+            return false;
+        }
+        value.type = Type::Number;
+        value.numberValue = number.number;
+        value.integerValue = number.integer;
+        value.isInteger = number.isInteger;
+        return true;
+    }
+
+    for (const std::string_view literal : { std::string_view("true"), std::string_view("false"), std::string_view("null") })
+    {
+        if (data_.substr(pos_, literal.size()) == literal)
+        {
+            pos_ += literal.size();
+            value.type = literal[0] == 'n' ? Type::Null : Type::Bool;
+            value.boolValue = literal[0] == 't';
+            return true;
+        }
+    }
+    error = "Unexpected token in JSON";
+    return false;
+}
+
+bool FieldExtractor::ReadString(std::string_view& value, std::string& error)
+{
+    if (pos_ >= data_.size() || data_[pos_] != '"')
+    {
+        error = "Expected '\"'";
+        return false;
+    }
+    const size_t start = ++pos_;
+    pos_ = Scan::FindQuoteOrBackslash(data_, pos_);
+    if (pos_ < data_.size())
+    {
+        if (data_[pos_] == '"')
+        {
+            value = data_.substr(start, pos_ - start);
+            ++pos_;
+            return true;
+        }
+        scratch_.resize(data_.size() - start);
+        size_t length = pos_ - start;
+        std::memcpy(scratch_.data(), data_.data() + start, length);
+        if (!CopyEscapedString(data_, pos_, scratch_.data(), length, error))
+        {
+            return false;
+        }
+        value = std::string_view(scratch_.data(), length);
+        return true;
+    }
+    error = "Unterminated string";
+    return false;
+}
+
+bool FieldExtractor::SkipValue(std::string& error)
+{
+    const char c = pos_ < data_.size() ? data_[pos_] : '\0';
+    if (c == '"')
+    {
+        return SkipString(error);
+    }
+    if (c != '{' && c != '[')
+    {
+        ViewValue scalar;
+        return ReadValue(scalar, error);
+    }
+
+    // Containers: only strings and bracket nesting matter, so skip straight to the
+    // matching closer. One bit per level records which closer is expected.
+    std::vector<bool> deepLevels;
+    uint64_t levels = 0;
+    size_t depth = 0;
+    while ((pos_ = Scan::FindStructural(data_, pos_)) < data_.size())
+    {
+        const char ch = data_[pos_];
+        if (ch == '"')
+        {
+            if (!SkipString(error))
+            {
+                return false;
+            }
+            continue;
+        }
+        ++pos_;
+        if (ch == '{' || ch == '[')
+        {
+            const bool isObject = ch == '{';
+            if (depth < 64)
+            {
+                levels = isObject ? (levels | (uint64_t{1} << depth)) : (levels & ~(uint64_t{1} << depth));
+            }
+            else
+            {
+                deepLevels.push_back(isObject);
+            }
+            ++depth;
+        }
+        else if (ch == '}' || ch == ']')
+        {
+            if (depth == 0)
+            {
+                break;
+            }
+            --depth;
+            const bool expectObject = depth < 64 ? ((levels >> depth) & 1) != 0 : deepLevels.back();
+            if (depth >= 64)
+            {
+                deepLevels.pop_back();
+            }
+            if (expectObject != (ch == '}'))
+            {
+                error = "Mismatched bracket in JSON";
+                return false;
+            }
+            if (depth == 0)
+            {
+                return true;
+            }
+        }
+    }
+    error = "Unterminated JSON container";
+    return false;
+}
+
+bool FieldExtractor::SkipString(std::string& error)
+{
+    ++pos_;
+    while ((pos_ = Scan::FindQuoteOrBackslash(data_, pos_)) < data_.size())
+    {
+        const char c = data_[pos_++];
+        if (c == '"')
+        {
+            return true;
+        }
+        ++pos_;
+    }
+    error = "Unterminated string";
+    return false;
+}
+
+bool FieldExtractor::Finish(std::string& error)
+{
+    SkipWhitespace();
+    if (pos_ != data_.size())
+    {
+        error = "Unexpected characters after JSON payload";
+        return false;
+    }
+    return true;
+}
+
+void FieldExtractor::SkipWhitespace()
+{
+    pos_ = Scan::SkipWhitespace(data_, pos_);
+}
+
 namespace
 {
     void AssignStringMember(const Value& object, const char* key, std::string& target)
@@ -411,6 +1126,21 @@ namespace
         }
     }
 
+    SymbolId InternStringMember(const Value& object, const char* key, SymbolTable& table)
+    {
+        const auto value = AsString(GetMember(object, key));
+        return value ? table.Intern(*value) : 0;
+    }
+
+    // Unparseable or missing timestamps leave the target at 0.
+    void AssignTimestampMember(const Value& object, const char* key, int64_t& target)
+    {
+        if (const auto value = AsString(GetMember(object, key)))
+        {
+            ParseTimestampEpoch(*value, target);
+        }
+    }
+
     void PopulateMmrHistorySection(const Value& root, HistorySnapshot& snapshot)
     {
         const Value* mmrValue = GetMember(root, "mmrHistory");
@@ -428,11 +1158,12 @@ namespace
 
             MmrHistoryEntry entry;
             entry.id = AsString(GetMember(record, "id")).value_or(std::string());
-            entry.timestamp = AsString(GetMember(record, "timestamp")).value_or(std::string());
-            entry.playlist = AsString(GetMember(record, "playlist")).value_or(std::string());
+            AssignTimestampMember(record, "timestamp", entry.timestamp);
+            entry.day = EpochDay(entry.timestamp);
+            entry.playlist = InternStringMember(record, "playlist", snapshot.symbols.playlists);
             entry.mmr = AsInt(GetMember(record, "mmr")).value_or(0);
             entry.gamesPlayedDiff = AsInt(GetMember(record, "gamesPlayedDiff")).value_or(0);
-            entry.source = AsString(GetMember(record, "source")).value_or(std::string());
+            entry.source = InternStringMember(record, "source", snapshot.symbols.sources);
             snapshot.mmrHistory.emplace_back(std::move(entry));
         }
     }
@@ -454,9 +1185,10 @@ namespace
 
             TrainingHistoryEntry entry;
             entry.id = AsString(GetMember(record, "id")).value_or(std::string());
-            entry.startedTime = AsString(GetMember(record, "startedTime")).value_or(std::string());
-            entry.finishedTime = AsString(GetMember(record, "finishedTime")).value_or(std::string());
-            entry.source = AsString(GetMember(record, "source")).value_or(std::string());
+            AssignTimestampMember(record, "startedTime", entry.startedTime);
+            AssignTimestampMember(record, "finishedTime", entry.finishedTime);
+            entry.day = EpochDay(entry.finishedTime != 0 ? entry.finishedTime : entry.startedTime);
+            entry.source = InternStringMember(record, "source", snapshot.symbols.sources);
             entry.presetId = AsString(GetMember(record, "presetId")).value_or(std::string());
             entry.notes = AsString(GetMember(record, "notes")).value_or(std::string());
             entry.actualDuration = AsInt(GetMember(record, "actualDuration")).value_or(0);
@@ -483,10 +1215,10 @@ namespace
             return;
         }
 
-        AssignStringMember(*statusValue, "receivedAt", snapshot.status.receivedAt);
-        AssignStringMember(*statusValue, "generatedAt", snapshot.status.generatedAt);
-        AssignStringMember(*statusValue, "lastMmrTimestamp", snapshot.status.lastMmrTimestamp);
-        AssignStringMember(*statusValue, "lastTrainingTimestamp", snapshot.status.lastTrainingTimestamp);
+        AssignTimestampMember(*statusValue, "receivedAt", snapshot.status.receivedAt);
+        AssignTimestampMember(*statusValue, "generatedAt", snapshot.status.generatedAt);
+        AssignTimestampMember(*statusValue, "lastMmrTimestamp", snapshot.status.lastMmrTimestamp);
+        AssignTimestampMember(*statusValue, "lastTrainingTimestamp", snapshot.status.lastTrainingTimestamp);
 
         AssignIntMember(*statusValue, "mmrEntries", snapshot.status.mmrEntries);
         AssignIntMember(*statusValue, "trainingSessions", snapshot.status.trainingSessions);
@@ -515,6 +1247,7 @@ bool HistoryJson::ParseHistoryResponse(const std::string& payload, HistorySnapsh
     PopulateMmrHistorySection(root, snapshot);
     PopulateTrainingHistorySection(root, snapshot);
     PopulateStatusSection(root, snapshot);
+    SnapshotIndex::Rebuild(snapshot);
 
     return true;
 }
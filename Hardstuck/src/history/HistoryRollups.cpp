@@ -0,0 +1,252 @@
+// HistoryRollups.cpp
+#include "pch.h"
+#include "history/HistoryRollups.h"
+
+#include <algorithm>
+
+namespace
+{
+    // Days since 1970-01-01 for a proleptic Gregorian date.
+    constexpr int32_t DaysFromCivil(int32_t year, int32_t month, int32_t day)
+    {
+        year -= month <= 2 ? 1 : 0;
+        const int32_t era = (year >= 0 ? year : year - 399) / 400;
+        const int32_t yearOfEra = year - era * 400;
+        const int32_t dayOfYear = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+        const int32_t dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+        return era * 146097 + dayOfEra - 719468;
+    }
+
+    // Start days of competitive seasons 1, 2, ... (free-to-play numbering).
+    constexpr int32_t kSeasonStarts[] = {
+        DaysFromCivil(2020, 9, 23),
+        DaysFromCivil(2020, 12, 9),
+        DaysFromCivil(2021, 4, 7),
+        DaysFromCivil(2021, 8, 11),
+        DaysFromCivil(2021, 11, 17),
+        DaysFromCivil(2022, 3, 9),
+        DaysFromCivil(2022, 6, 15),
+        DaysFromCivil(2022, 9, 7),
+        DaysFromCivil(2022, 12, 7),
+        DaysFromCivil(2023, 3, 8),
+        DaysFromCivil(2023, 6, 7),
+        DaysFromCivil(2023, 9, 6),
+        DaysFromCivil(2023, 12, 6),
+        DaysFromCivil(2024, 3, 6),
+        DaysFromCivil(2024, 6, 5),
+        DaysFromCivil(2024, 9, 4),
+        DaysFromCivil(2024, 12, 4),
+    };
+    constexpr int32_t kSeasonCount = static_cast<int32_t>(sizeof(kSeasonStarts) / sizeof(kSeasonStarts[0]));
+    constexpr int32_t kSeasonDays = 13 * 7;
+
+    // Floor division, so days before the epoch land in the right week.
+    int32_t FloorDiv(int32_t value, int32_t divisor)
+    {
+        const int32_t quotient = value / divisor;
+        return (value % divisor != 0 && value < 0) ? quotient - 1 : quotient;
+    }
+
+    int32_t SeasonKey(int32_t day)
+    {
+        const int32_t last = kSeasonStarts[kSeasonCount - 1];
+        if (day >= last)
+        {
+            return kSeasonCount + (day - last) / kSeasonDays;
+        }
+        return static_cast<int32_t>(std::upper_bound(std::begin(kSeasonStarts), std::end(kSeasonStarts), day)
+                                    - std::begin(kSeasonStarts));
+    }
+
+    RollupBucket& BucketFor(RollupTable& table, int32_t key)
+    {
+        std::vector<RollupBucket>& buckets = table.buckets;
+        // Ingest runs in time order, so the bucket is almost always the last one.
+        if (!buckets.empty() && buckets.back().key == key)
+        {
+            return buckets.back();
+        }
+        auto it = buckets.end();
+        if (!buckets.empty() && key < buckets.back().key)
+        {
+            it = std::lower_bound(buckets.begin(), buckets.end(), key, [](const RollupBucket& bucket, int32_t value) {
+                return bucket.key < value;
+            });
+            if (it->key == key)
+            {
+                return *it;
+            }
+        }
+        RollupBucket bucket;
+        bucket.key = key;
+        return *buckets.insert(it, std::move(bucket));
+    }
+
+    void AddMmrRow(RollupBucket& bucket, SymbolId playlist, int32_t mmr, int32_t delta, int32_t games)
+    {
+        if (playlist >= bucket.byPlaylist.size())
+        {
+            bucket.byPlaylist.resize(static_cast<size_t>(playlist) + 1);
+        }
+        RollupStats& stats = bucket.byPlaylist[playlist];
+        if (stats.entries == 0)
+        {
+            stats.open = mmr;
+            stats.min = mmr;
+            stats.max = mmr;
+        }
+        stats.close = mmr;
+        stats.min = (std::min)(stats.min, mmr);
+        stats.max = (std::max)(stats.max, mmr);
+        stats.delta += delta;
+        stats.games += games;
+        ++stats.entries;
+        bucket.lastPlaylist = playlist;
+    }
+
+    template <typename Fn>
+    void ForEachTable(PeriodRollups& rollups, Fn&& fn)
+    {
+        fn(rollups.days, RollupPeriod::Day);
+        fn(rollups.weeks, RollupPeriod::Week);
+        fn(rollups.seasons, RollupPeriod::Season);
+    }
+}
+
+int32_t HistoryRollups::Key(RollupPeriod period, int32_t day)
+{
+    switch (period)
+    {
+    case RollupPeriod::Week: return FloorDiv(day + 3, 7); // 1970-01-01 was a Thursday
+    case RollupPeriod::Season: return SeasonKey(day);
+    case RollupPeriod::Day: break;
+    }
+    return day;
+}
+
+int32_t HistoryRollups::FirstDay(RollupPeriod period, int32_t key)
+{
+    switch (period)
+    {
+    case RollupPeriod::Week: return key * 7 - 3;
+    case RollupPeriod::Season:
+        if (key <= 0)
+        {
+            return 0;
+        }
+        if (key <= kSeasonCount)
+        {
+            return kSeasonStarts[key - 1];
+        }
+        return kSeasonStarts[kSeasonCount - 1] + (key - kSeasonCount) * kSeasonDays;
+    case RollupPeriod::Day: break;
+    }
+    return key;
+}
+
+RollupTable& HistoryRollups::Table(PeriodRollups& rollups, RollupPeriod period)
+{
+    switch (period)
+    {
+    case RollupPeriod::Week: return rollups.weeks;
+    case RollupPeriod::Season: return rollups.seasons;
+    case RollupPeriod::Day: break;
+    }
+    return rollups.days;
+}
+
+const RollupTable& HistoryRollups::Table(const PeriodRollups& rollups, RollupPeriod period)
+{
+    return Table(const_cast<PeriodRollups&>(rollups), period);
+}
+
+void HistoryRollups::AddMmrRows(PeriodRollups& rollups, const MmrColumns& columns, const std::vector<MmrHistoryEntry>& history)
+{
+    const size_t count = columns.Size();
+    for (size_t row = rollups.mmrRows; row < count; ++row)
+    {
+        const int32_t day = columns.days[row];
+        const int32_t games = history[columns.entry[row]].gamesPlayedDiff;
+        ForEachTable(rollups, [&](RollupTable& table, RollupPeriod period) {
+            AddMmrRow(BucketFor(table, Key(period, day)), columns.playlist[row], columns.mmr[row], columns.delta[row], games);
+        });
+    }
+    rollups.mmrRows = (std::max)(rollups.mmrRows, count);
+}
+
+void HistoryRollups::ResetMmr(PeriodRollups& rollups)
+{
+    ForEachTable(rollups, [](RollupTable& table, RollupPeriod) {
+        for (RollupBucket& bucket : table.buckets)
+        {
+            bucket.byPlaylist.clear();
+            bucket.lastPlaylist = 0;
+        }
+    });
+    rollups.mmrRows = 0;
+}
+
+void HistoryRollups::AddSessionSeconds(PeriodRollups& rollups, int32_t day, SymbolId sessionType, double seconds)
+{
+    ForEachTable(rollups, [&](RollupTable& table, RollupPeriod period) {
+        std::vector<double>& totals = BucketFor(table, Key(period, day)).secondsBySessionType;
+        if (sessionType >= totals.size())
+        {
+            totals.resize(static_cast<size_t>(sessionType) + 1, 0.0);
+        }
+        totals[sessionType] += seconds;
+    });
+}
+
+void HistoryRollups::AddTrainingMinutes(PeriodRollups& rollups, int32_t day, float minutes)
+{
+    ForEachTable(rollups, [&](RollupTable& table, RollupPeriod period) {
+        BucketFor(table, Key(period, day)).trainingMinutes += minutes;
+    });
+}
+
+const RollupBucket* HistoryRollups::Find(const RollupTable& table, int32_t key)
+{
+    const auto range = Range(table, key, key);
+    return range.first != range.second ? &table.buckets[range.first] : nullptr;
+}
+
+std::pair<size_t, size_t> HistoryRollups::Range(const RollupTable& table, int32_t fromKey, int32_t toKey)
+{
+    const auto byKey = [](const RollupBucket& bucket, int32_t value) { return bucket.key < value; };
+    const auto first = std::lower_bound(table.buckets.begin(), table.buckets.end(), fromKey, byKey);
+    auto last = first;
+    if (toKey >= fromKey)
+    {
+        last = std::lower_bound(first, table.buckets.end(), toKey + 1, byKey);
+    }
+    return {static_cast<size_t>(first - table.buckets.begin()), static_cast<size_t>(last - table.buckets.begin())};
+}
+
+RollupStats HistoryRollups::Combine(const RollupTable& table, size_t first, size_t last, SymbolId playlist)
+{
+    RollupStats combined;
+    last = (std::min)(last, table.buckets.size());
+    for (size_t i = first; i < last; ++i)
+    {
+        const std::vector<RollupStats>& byPlaylist = table.buckets[i].byPlaylist;
+        if (playlist >= byPlaylist.size() || byPlaylist[playlist].entries == 0)
+        {
+            continue;
+        }
+        const RollupStats& stats = byPlaylist[playlist];
+        if (combined.entries == 0)
+        {
+            combined.open = stats.open;
+            combined.min = stats.min;
+            combined.max = stats.max;
+        }
+        combined.close = stats.close;
+        combined.min = (std::min)(combined.min, stats.min);
+        combined.max = (std::max)(combined.max, stats.max);
+        combined.delta += stats.delta;
+        combined.games += stats.games;
+        combined.entries += stats.entries;
+    }
+    return combined;
+}
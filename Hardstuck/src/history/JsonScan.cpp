@@ -0,0 +1,360 @@
+// JsonScan.cpp
+#include "pch.h"
+#include "history/JsonScan.h"
+
+#include <atomic>
+#include <cstdint>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define HS_JSON_SCAN_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+#if defined(HS_JSON_SCAN_X86) && (defined(__GNUC__) || defined(__clang__))
+#define HS_TARGET_SSE2 __attribute__((target("sse2")))
+#define HS_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define HS_TARGET_SSE2
+#define HS_TARGET_AVX2
+#endif
+
+using namespace HistoryJson;
+
+namespace
+{
+    bool IsQuoteOrBackslash(char c)
+    {
+        return c == '"' || c == '\\';
+    }
+
+    bool IsStructural(char c)
+    {
+        return c == '"' || c == '{' || c == '}' || c == '[' || c == ']';
+    }
+
+    bool IsWhitespace(char c)
+    {
+        return c == ' ' || (c >= '\t' && c <= '\r');
+    }
+
+    bool IsNotWhitespace(char c)
+    {
+        return !IsWhitespace(c);
+    }
+
+    bool IsNewline(char c)
+    {
+        return c == '\n';
+    }
+
+    template <typename Predicate>
+    size_t FindScalar(std::string_view data, size_t pos, Predicate matches)
+    {
+        while (pos < data.size() && !matches(data[pos]))
+        {
+            ++pos;
+        }
+        return pos;
+    }
+
+#ifdef HS_JSON_SCAN_X86
+    unsigned CountTrailingZeros(uint32_t mask)
+    {
+#ifdef _MSC_VER
+        unsigned long index = 0;
+        _BitScanForward(&index, mask);
+        return static_cast<unsigned>(index);
+#else
+        return static_cast<unsigned>(__builtin_ctz(mask));
+#endif
+    }
+
+    // Each SIMD kernel computes a bitmask of matching bytes per block; the scalar
+    // predicate finishes the final partial block.
+
+    HS_TARGET_SSE2 uint32_t QuoteOrBackslashMask16(__m128i block)
+    {
+        const __m128i quote = _mm_cmpeq_epi8(block, _mm_set1_epi8('"'));
+        const __m128i backslash = _mm_cmpeq_epi8(block, _mm_set1_epi8('\\'));
+        return static_cast<uint32_t>(_mm_movemask_epi8(_mm_or_si128(quote, backslash)));
+    }
+
+    HS_TARGET_SSE2 uint32_t StructuralMask16(__m128i block)
+    {
+        // '[' / ']' and '{' / '}' differ only in bit 0x20 from each other's pair; fold the
+        // case bit away so two compares cover four brackets.
+        const __m128i folded = _mm_or_si128(block, _mm_set1_epi8(0x20));
+        const __m128i open = _mm_cmpeq_epi8(folded, _mm_set1_epi8('{'));
+        const __m128i close = _mm_cmpeq_epi8(folded, _mm_set1_epi8('}'));
+        const __m128i quote = _mm_cmpeq_epi8(block, _mm_set1_epi8('"'));
+        return static_cast<uint32_t>(_mm_movemask_epi8(_mm_or_si128(quote, _mm_or_si128(open, close))));
+    }
+
+    HS_TARGET_SSE2 uint32_t NonWhitespaceMask16(__m128i block)
+    {
+        const __m128i space = _mm_cmpeq_epi8(block, _mm_set1_epi8(' '));
+        // \t..\r is the range 9..13: subtract 9 and test (unsigned) <= 4.
+        const __m128i shifted = _mm_sub_epi8(block, _mm_set1_epi8('\t'));
+        const __m128i control = _mm_cmpeq_epi8(_mm_min_epu8(shifted, _mm_set1_epi8(4)), shifted);
+        return ~static_cast<uint32_t>(_mm_movemask_epi8(_mm_or_si128(space, control))) & 0xFFFFu;
+    }
+
+    HS_TARGET_SSE2 uint32_t NewlineMask16(__m128i block)
+    {
+        return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(block, _mm_set1_epi8('\n'))));
+    }
+
+    HS_TARGET_AVX2 uint32_t QuoteOrBackslashMask32(__m256i block)
+    {
+        const __m256i quote = _mm256_cmpeq_epi8(block, _mm256_set1_epi8('"'));
+        const __m256i backslash = _mm256_cmpeq_epi8(block, _mm256_set1_epi8('\\'));
+        return static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_or_si256(quote, backslash)));
+    }
+
+    HS_TARGET_AVX2 uint32_t StructuralMask32(__m256i block)
+    {
+        const __m256i folded = _mm256_or_si256(block, _mm256_set1_epi8(0x20));
+        const __m256i open = _mm256_cmpeq_epi8(folded, _mm256_set1_epi8('{'));
+        const __m256i close = _mm256_cmpeq_epi8(folded, _mm256_set1_epi8('}'));
+        const __m256i quote = _mm256_cmpeq_epi8(block, _mm256_set1_epi8('"'));
+        return static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_or_si256(quote, _mm256_or_si256(open, close))));
+    }
+
+    HS_TARGET_AVX2 uint32_t NonWhitespaceMask32(__m256i block)
+    {
+        const __m256i space = _mm256_cmpeq_epi8(block, _mm256_set1_epi8(' '));
+        const __m256i shifted = _mm256_sub_epi8(block, _mm256_set1_epi8('\t'));
+        const __m256i control = _mm256_cmpeq_epi8(_mm256_min_epu8(shifted, _mm256_set1_epi8(4)), shifted);
+        return ~static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_or_si256(space, control)));
+    }
+
+    HS_TARGET_AVX2 uint32_t NewlineMask32(__m256i block)
+    {
+        return static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(block, _mm256_set1_epi8('\n'))));
+    }
+
+    template <uint32_t (*Mask)(__m128i), bool (*Matches)(char)>
+    HS_TARGET_SSE2 size_t FindSse2(std::string_view data, size_t pos)
+    {
+        while (pos + 16 <= data.size())
+        {
+            const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data.data() + pos));
+            const uint32_t mask = Mask(block);
+            if (mask != 0)
+            {
+                return pos + CountTrailingZeros(mask);
+            }
+            pos += 16;
+        }
+        return FindScalar(data, pos, Matches);
+    }
+
+    template <uint32_t (*Mask16)(__m128i), uint32_t (*Mask32)(__m256i), bool (*Matches)(char)>
+    HS_TARGET_AVX2 size_t FindAvx2(std::string_view data, size_t pos)
+    {
+        // Most JSON runs end within a few bytes, so probe one 16-byte block before
+        // touching the 256-bit registers; they only pay off on long runs.
+        if (pos + 16 <= data.size())
+        {
+            const uint32_t mask = Mask16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data.data() + pos)));
+            if (mask != 0)
+            {
+                return pos + CountTrailingZeros(mask);
+            }
+            pos += 16;
+        }
+        while (pos + 32 <= data.size())
+        {
+            const __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data.data() + pos));
+            const uint32_t mask = Mask32(block);
+            if (mask != 0)
+            {
+                return pos + CountTrailingZeros(mask);
+            }
+            pos += 32;
+        }
+        if (pos + 16 <= data.size())
+        {
+            const uint32_t mask = Mask16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data.data() + pos)));
+            if (mask != 0)
+            {
+                return pos + CountTrailingZeros(mask);
+            }
+            pos += 16;
+        }
+        return FindScalar(data, pos, Matches);
+    }
+
+    constexpr auto kFindQuoteOrBackslashSse2 = &FindSse2<QuoteOrBackslashMask16, IsQuoteOrBackslash>;
+    constexpr auto kFindStructuralSse2 = &FindSse2<StructuralMask16, IsStructural>;
+    constexpr auto kSkipWhitespaceSse2 = &FindSse2<NonWhitespaceMask16, IsNotWhitespace>;
+    constexpr auto kFindNewlineSse2 = &FindSse2<NewlineMask16, IsNewline>;
+
+    bool CpuSupportsAvx2()
+    {
+#ifdef _MSC_VER
+        int info[4] = {};
+        __cpuid(info, 0);
+        if (info[0] < 7)
+        {
+            return false;
+        }
+        __cpuid(info, 1);
+        const bool osxsave = (info[2] & (1 << 27)) != 0;
+        const bool avx = (info[2] & (1 << 28)) != 0;
+        if (!osxsave || !avx || (_xgetbv(0) & 0x6) != 0x6)
+        {
+            return false;
+        }
+        __cpuidex(info, 7, 0);
+        return (info[1] & (1 << 5)) != 0;
+#else
+        return __builtin_cpu_supports("avx2");
+#endif
+    }
+
+    bool CpuSupportsSse2()
+    {
+#if defined(_M_X64) || defined(__x86_64__)
+        return true;
+#elif defined(_MSC_VER)
+        int info[4] = {};
+        __cpuid(info, 1);
+        return (info[3] & (1 << 26)) != 0;
+#else
+        return __builtin_cpu_supports("sse2");
+#endif
+    }
+#endif
+
+    struct Dispatch
+    {
+        size_t (*findQuoteOrBackslash)(std::string_view, size_t);
+        size_t (*findStructural)(std::string_view, size_t);
+        size_t (*skipWhitespace)(std::string_view, size_t);
+        size_t (*findNewline)(std::string_view, size_t);
+    };
+
+    constexpr Dispatch kScalarDispatch{
+        &Scan::Scalar::FindQuoteOrBackslash, &Scan::Scalar::FindStructural, &Scan::Scalar::SkipWhitespace,
+        &Scan::Scalar::FindNewline
+    };
+#ifdef HS_JSON_SCAN_X86
+    constexpr Dispatch kSse2Dispatch{
+        kFindQuoteOrBackslashSse2, kFindStructuralSse2, kSkipWhitespaceSse2, kFindNewlineSse2
+    };
+    constexpr Dispatch kAvx2Dispatch{
+        &FindAvx2<QuoteOrBackslashMask16, QuoteOrBackslashMask32, IsQuoteOrBackslash>,
+        &FindAvx2<StructuralMask16, StructuralMask32, IsStructural>,
+        &FindAvx2<NonWhitespaceMask16, NonWhitespaceMask32, IsNotWhitespace>,
+        &FindAvx2<NewlineMask16, NewlineMask32, IsNewline>
+    };
+#endif
+
+    const Dispatch* DispatchFor(Scan::Level level)
+    {
+#ifdef HS_JSON_SCAN_X86
+        if (level == Scan::Level::Avx2)
+        {
+            return &kAvx2Dispatch;
+        }
+        if (level == Scan::Level::Sse2)
+        {
+            return &kSse2Dispatch;
+        }
+#endif
+        return &kScalarDispatch;
+    }
+
+    std::atomic<const Dispatch*>& ActiveDispatch()
+    {
+        static std::atomic<const Dispatch*> active{ DispatchFor(Scan::DetectedLevel()) };
+        return active;
+    }
+}
+
+Scan::Level Scan::DetectedLevel()
+{
+#ifdef HS_JSON_SCAN_X86
+    static const Level detected = CpuSupportsAvx2() ? Level::Avx2
+        : CpuSupportsSse2() ? Level::Sse2
+        : Level::Scalar;
+    return detected;
+#else
+    return Level::Scalar;
+#endif
+}
+
+Scan::Level Scan::ActiveLevel()
+{
+    const Dispatch* active = ActiveDispatch().load(std::memory_order_relaxed);
+#ifdef HS_JSON_SCAN_X86
+    if (active == &kAvx2Dispatch)
+    {
+        return Level::Avx2;
+    }
+    if (active == &kSse2Dispatch)
+    {
+        return Level::Sse2;
+    }
+#endif
+    (void)active;
+    return Level::Scalar;
+}
+
+void Scan::SetLevel(Level level)
+{
+    if (static_cast<int>(level) > static_cast<int>(DetectedLevel()))
+    {
+        level = DetectedLevel();
+    }
+    ActiveDispatch().store(DispatchFor(level), std::memory_order_relaxed);
+}
+
+size_t Scan::FindQuoteOrBackslash(std::string_view data, size_t pos)
+{
+    return ActiveDispatch().load(std::memory_order_relaxed)->findQuoteOrBackslash(data, pos);
+}
+
+size_t Scan::FindStructural(std::string_view data, size_t pos)
+{
+    return ActiveDispatch().load(std::memory_order_relaxed)->findStructural(data, pos);
+}
+
+size_t Scan::SkipWhitespace(std::string_view data, size_t pos)
+{
+    // Compact JSON rarely has whitespace; avoid the indirect call for the common case.
+    if (pos < data.size() && !IsWhitespace(data[pos]))
+    {
+        return pos;
+    }
+    return ActiveDispatch().load(std::memory_order_relaxed)->skipWhitespace(data, pos);
+}
+
+size_t Scan::FindNewline(std::string_view data, size_t pos)
+{
+    return ActiveDispatch().load(std::memory_order_relaxed)->findNewline(data, pos);
+}
+
+size_t Scan::Scalar::FindQuoteOrBackslash(std::string_view data, size_t pos)
+{
+    return FindScalar(data, pos, IsQuoteOrBackslash);
+}
+
+size_t Scan::Scalar::FindStructural(std::string_view data, size_t pos)
+{
+    return FindScalar(data, pos, IsStructural);
+}
+
+size_t Scan::Scalar::SkipWhitespace(std::string_view data, size_t pos)
+{
+    return FindScalar(data, pos, IsNotWhitespace);
+}
+
+size_t Scan::Scalar::FindNewline(std::string_view data, size_t pos)
+{
+    return FindScalar(data, pos, IsNewline);
+}
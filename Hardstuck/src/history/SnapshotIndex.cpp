@@ -0,0 +1,80 @@
+// SnapshotIndex.cpp
+#include "pch.h"
+#include "history/SnapshotIndex.h"
+
+#include "history/HistoryColumns.h"
+#include "history/HistoryRollups.h"
+
+namespace
+{
+    // Same ordering the old linear scans used: a strictly later timestamp replaces the
+    // latest entry, and among equal timestamps the first one seen stays latest.
+    void Promote(LatestMmrPair& pair, const std::vector<MmrHistoryEntry>& history, int position)
+    {
+        const int64_t timestamp = history[static_cast<size_t>(position)].timestamp;
+        if (pair.latest < 0 || timestamp > history[static_cast<size_t>(pair.latest)].timestamp)
+        {
+            pair.previous = pair.latest;
+            pair.latest = position;
+        }
+        else if (pair.previous < 0 || timestamp > history[static_cast<size_t>(pair.previous)].timestamp)
+        {
+            pair.previous = position;
+        }
+    }
+}
+
+void SnapshotIndex::AddMmrEntries(HistorySnapshot& snapshot, size_t firstEntry)
+{
+    HistorySnapshot::Index& index = snapshot.index;
+    const int previousLatest = index.overall.latest;
+    index.byPlaylist.resize(snapshot.symbols.playlists.Size());
+    for (size_t i = firstEntry; i < snapshot.mmrHistory.size(); ++i)
+    {
+        const int position = static_cast<int>(i);
+        Promote(index.overall, snapshot.mmrHistory, position);
+        Promote(index.byPlaylist[snapshot.mmrHistory[i].playlist], snapshot.mmrHistory, position);
+    }
+    if (index.overall.latest != previousLatest && index.overall.latest >= 0)
+    {
+        index.latestDay = snapshot.mmrHistory[static_cast<size_t>(index.overall.latest)].day;
+    }
+    if (!HistoryColumns::Append(snapshot.mmrColumns, snapshot.mmrHistory, firstEntry))
+    {
+        // Rows moved, so per-period open/close and deltas are refolded from the new order.
+        HistoryRollups::ResetMmr(snapshot.rollups);
+    }
+    HistoryRollups::AddMmrRows(snapshot.rollups, snapshot.mmrColumns, snapshot.mmrHistory);
+}
+
+void SnapshotIndex::AddTrainingEntries(HistorySnapshot& snapshot, size_t firstEntry)
+{
+    for (size_t i = firstEntry; i < snapshot.trainingHistory.size(); ++i)
+    {
+        const TrainingHistoryEntry& entry = snapshot.trainingHistory[i];
+        HistoryRollups::AddTrainingMinutes(snapshot.rollups, entry.day, static_cast<float>(entry.actualDuration) / 60.0f);
+    }
+}
+
+void SnapshotIndex::Rebuild(HistorySnapshot& snapshot)
+{
+    snapshot.index = HistorySnapshot::Index();
+    snapshot.mmrColumns = MmrColumns();
+    snapshot.rollups = PeriodRollups();
+    AddMmrEntries(snapshot, 0);
+    AddTrainingEntries(snapshot, 0);
+}
+
+float SnapshotIndex::LatestDayTrainingMinutes(const HistorySnapshot& snapshot)
+{
+    if (snapshot.index.overall.latest >= 0)
+    {
+        const RollupBucket* bucket = HistoryRollups::Find(snapshot.rollups.days, snapshot.index.latestDay);
+        return bucket != nullptr ? bucket->trainingMinutes : 0.0f;
+    }
+    if (!snapshot.trainingHistory.empty())
+    {
+        return static_cast<float>(snapshot.trainingHistory.back().actualDuration) / 60.0f;
+    }
+    return 0.0f;
+}
@@ -0,0 +1,44 @@
+// SymbolTable.cpp
+#include "pch.h"
+#include "history/SymbolTable.h"
+
+#include <limits>
+
+SymbolTable::SymbolTable()
+{
+    names_.emplace_back();
+    ids_.emplace(std::string(), 0);
+}
+
+SymbolId SymbolTable::Intern(std::string_view value)
+{
+    const auto it = ids_.find(value);
+    if (it != ids_.end())
+    {
+        return it->second;
+    }
+    if (names_.size() > std::numeric_limits<SymbolId>::max())
+    {
+        return 0;
+    }
+    const SymbolId id = static_cast<SymbolId>(names_.size());
+    names_.emplace_back(value);
+    ids_.emplace(names_.back(), id);
+    return id;
+}
+
+bool SymbolTable::Find(std::string_view value, SymbolId& id) const
+{
+    const auto it = ids_.find(value);
+    if (it == ids_.end())
+    {
+        return false;
+    }
+    id = it->second;
+    return true;
+}
+
+const std::string& SymbolTable::Name(SymbolId id) const
+{
+    return id < names_.size() ? names_[id] : names_.front();
+}
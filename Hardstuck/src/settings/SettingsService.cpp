@@ -60,6 +60,10 @@ void SettingsService::RegisterCVars()
     cvarManager_->registerCvar("hs_ui_debug_show_demo", "0", "Show ImGui demo window for debugging (1 = show)");
     cvarManager_->registerCvar(settings::kGamesPlayedCvarName, "1", "Increment for gamesPlayedDiff payload field");
     cvarManager_->registerCvar(settings::kPostMatchDelayCvarName, "4.0", "Seconds to wait after a match before refreshing MMR");
+    cvarManager_->registerCvar(settings::kStoreSyncIntervalCvarName, "1000", "Milliseconds between forced disk syncs of the local store (0 = every write)");
+    cvarManager_->registerCvar(settings::kStoreDurabilityCvarName, "flush", "Local store appends: buffered, flush (written per batch) or fsync (synced per batch)");
+    cvarManager_->registerCvar(settings::kApiBaseUrlCvarName, "", "Backend base URL for uploading stored payloads (empty = uploads disabled)");
+    cvarManager_->registerCvar(settings::kUploadBatchSizeCvarName, "50", "Max payloads sent per upload request");
 }
 
 void SettingsService::LoadPersistedSettings()
@@ -516,6 +520,28 @@ float SettingsService::GetPostMatchMmrDelaySeconds() const
     }
 }
 
+int SettingsService::GetStoreSyncIntervalMs() const
+{
+    const int interval = ParseIntCvar(settings::kStoreSyncIntervalCvarName, 1000);
+    return interval < 0 ? 0 : interval;
+}
+
+std::string SettingsService::GetStoreDurability() const
+{
+    return ReadStringCvar(settings::kStoreDurabilityCvarName, "flush");
+}
+
+std::string SettingsService::GetApiBaseUrl() const
+{
+    return ReadStringCvar(settings::kApiBaseUrlCvarName, "");
+}
+
+int SettingsService::GetUploadBatchSize() const
+{
+    const int batchSize = ParseIntCvar(settings::kUploadBatchSizeCvarName, 50);
+    return batchSize < 1 ? 1 : batchSize;
+}
+
 uint64_t SettingsService::ParseUint64Cvar(const char* name, uint64_t defaultValue) const
 {
     if (!cvarManager_)
@@ -0,0 +1,420 @@
+// HistoryIndex.cpp
+#include "pch.h"
+#include "storage/HistoryIndex.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <system_error>
+#include <utility>
+
+#include "utils/HsUtils.h"
+
+namespace
+{
+    constexpr size_t kMaxHeadLength = 64 * 1024;
+
+    std::filesystem::path IndexPathFor(const std::filesystem::path& storePath)
+    {
+        return std::filesystem::path(storePath.string() + ".idx");
+    }
+
+    std::filesystem::path SymbolPathFor(const std::filesystem::path& storePath)
+    {
+        return std::filesystem::path(storePath.string() + ".idx.sym");
+    }
+}
+
+HistoryIndex::HistoryIndex(std::filesystem::path storePath)
+    : storePath_(std::move(storePath))
+{
+    indexPath_ = IndexPathFor(storePath_);
+    symbolPath_ = SymbolPathFor(storePath_);
+    symbols_.emplace_back();
+    symbolIds_.emplace(std::string(), 0);
+}
+
+void HistoryIndex::SetStoreHead(uint64_t size, uint32_t headLength, uint32_t headCrc)
+{
+    storeHeadSupplied_ = true;
+    suppliedStoreSize_ = size;
+    suppliedHeadLength_ = headLength;
+    suppliedHeadCrc_ = headCrc;
+}
+
+bool HistoryIndex::Open(std::string& error)
+{
+    header_ = Header();
+    mapping_.Close();
+
+    if (!std::filesystem::exists(indexPath_))
+    {
+        error = "History index missing";
+        return false;
+    }
+    if (!mapping_.Open(indexPath_, error))
+    {
+        return false;
+    }
+
+    if (mapping_.Size() < sizeof(Header))
+    {
+        error = "History index header truncated";
+        mapping_.Close();
+        return false;
+    }
+
+    Header header;
+    std::memcpy(&header, mapping_.Data(), sizeof(Header));
+    if (std::memcmp(header.magic, Header().magic, sizeof(header.magic)) != 0
+        || header.version != Header().version
+        || header.headerCrc != HeaderCrc(header))
+    {
+        error = "History index header checksum mismatch";
+        mapping_.Close();
+        return false;
+    }
+
+    const uint64_t recordBytes = header.recordCount * sizeof(Record);
+    if (mapping_.Size() - sizeof(Header) < recordBytes)
+    {
+        error = "History index records truncated";
+        mapping_.Close();
+        return false;
+    }
+    if (Crc32(mapping_.Data() + sizeof(Header), static_cast<size_t>(recordBytes)) != header.recordsCrc)
+    {
+        error = "History index record checksum mismatch";
+        mapping_.Close();
+        return false;
+    }
+
+    // The sidecar must describe a prefix of the current store, ending on a line boundary.
+    std::error_code ec;
+    uint64_t storeSize = suppliedStoreSize_;
+    if (!storeHeadSupplied_)
+    {
+        storeSize = std::filesystem::exists(storePath_, ec)
+            ? static_cast<uint64_t>(std::filesystem::file_size(storePath_, ec))
+            : 0;
+    }
+    if (ec || storeSize < header.sourceBytes)
+    {
+        error = "History index is ahead of the store";
+        mapping_.Close();
+        return false;
+    }
+    if (storeHeadSupplied_ && header.sourceBytes != storeSize)
+    {
+        error = "History index does not cover the whole store";
+        mapping_.Close();
+        return false;
+    }
+    if (header.sourceBytes > 0)
+    {
+        uint32_t headLength = 0;
+        uint32_t headCrc = 0;
+        if (!ReadStoreHead(headLength, headCrc) || headLength != header.headLength || headCrc != header.headCrc)
+        {
+            error = "History index belongs to a different store";
+            mapping_.Close();
+            return false;
+        }
+
+        if (!storeHeadSupplied_)
+        {
+            std::ifstream store(storePath_, std::ios::in | std::ios::binary);
+            store.seekg(static_cast<std::streamoff>(header.sourceBytes - 1), std::ios::beg);
+            if (store.get() != '\n')
+            {
+                error = "History index does not end on a line boundary";
+                mapping_.Close();
+                return false;
+            }
+        }
+    }
+
+    header_ = header;
+    if (!LoadSymbols(error))
+    {
+        header_ = Header();
+        mapping_.Close();
+        return false;
+    }
+    return true;
+}
+
+void HistoryIndex::Unmap()
+{
+    mapping_.Close();
+}
+
+bool HistoryIndex::Reset(std::string& error)
+{
+    Clear();
+    return CreateFiles(error);
+}
+
+void HistoryIndex::Clear()
+{
+    mapping_.Close();
+    header_ = Header();
+    symbols_.assign(1, std::string());
+    symbolIds_.clear();
+    symbolIds_.emplace(std::string(), 0);
+    persistedSymbols_ = 0;
+    recreate_ = true;
+}
+
+bool HistoryIndex::CreateFiles(std::string& error)
+{
+    std::error_code ec;
+    std::filesystem::create_directories(indexPath_.parent_path(), ec);
+
+    std::ofstream symbols(symbolPath_, std::ios::out | std::ios::binary | std::ios::trunc);
+    std::ofstream index(indexPath_, std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!symbols.is_open() || !index.is_open())
+    {
+        error = std::string("Failed to create history index at ") + indexPath_.string();
+        return false;
+    }
+    index.close();
+    recreate_ = false;
+    return WriteHeader(error);
+}
+
+bool HistoryIndex::Append(const std::vector<Record>& records,
+                          uint64_t sourceBytes,
+                          uint32_t lineCount,
+                          uint32_t skippedLines,
+                          std::string& error)
+{
+    mapping_.Close();
+    if (recreate_ && !CreateFiles(error))
+    {
+        return false;
+    }
+
+    // Symbols first, records second, header last: a crash in between leaves the old
+    // header describing a consistent prefix.
+    if (persistedSymbols_ < symbols_.size())
+    {
+        std::ofstream output(symbolPath_, std::ios::out | std::ios::binary | std::ios::trunc);
+        if (!output.is_open())
+        {
+            error = std::string("Failed to write history index symbols at ") + symbolPath_.string();
+            return false;
+        }
+        for (const auto& symbol : symbols_)
+        {
+            const uint16_t length = static_cast<uint16_t>(std::min<size_t>(symbol.size(), 0xFFFF));
+            output.write(reinterpret_cast<const char*>(&length), sizeof(length));
+            output.write(symbol.data(), length);
+        }
+        if (!output)
+        {
+            error = std::string("Failed to write history index symbols at ") + symbolPath_.string();
+            return false;
+        }
+        persistedSymbols_ = static_cast<uint32_t>(symbols_.size());
+    }
+
+    if (!records.empty())
+    {
+        std::fstream output(indexPath_, std::ios::in | std::ios::out | std::ios::binary);
+        if (!output.is_open())
+        {
+            error = std::string("Failed to open history index at ") + indexPath_.string();
+            return false;
+        }
+        output.seekp(static_cast<std::streamoff>(sizeof(Header) + header_.recordCount * sizeof(Record)),
+                     std::ios::beg);
+        const size_t bytes = records.size() * sizeof(Record);
+        output.write(reinterpret_cast<const char*>(records.data()), static_cast<std::streamsize>(bytes));
+        if (!output)
+        {
+            error = std::string("Failed to append history index records at ") + indexPath_.string();
+            return false;
+        }
+        header_.recordCount += records.size();
+        header_.recordsCrc = Crc32(records.data(), bytes, header_.recordsCrc);
+    }
+
+    if (header_.headLength == 0 && sourceBytes > 0)
+    {
+        ReadStoreHead(header_.headLength, header_.headCrc);
+    }
+    header_.sourceBytes = sourceBytes;
+    header_.lineCount = lineCount;
+    header_.skippedLines = skippedLines;
+    header_.symbolCount = persistedSymbols_;
+    return WriteHeader(error);
+}
+
+uint16_t HistoryIndex::Intern(const std::string& value)
+{
+    const auto it = symbolIds_.find(value);
+    if (it != symbolIds_.end())
+    {
+        return it->second;
+    }
+    if (symbols_.size() > std::numeric_limits<uint16_t>::max())
+    {
+        return 0;
+    }
+    const uint16_t id = static_cast<uint16_t>(symbols_.size());
+    symbols_.push_back(value);
+    symbolIds_.emplace(value, id);
+    return id;
+}
+
+const std::string& HistoryIndex::Symbol(uint16_t id) const
+{
+    return id < symbols_.size() ? symbols_[id] : symbols_.front();
+}
+
+const HistoryIndex::Record* HistoryIndex::Records() const
+{
+    if (!mapping_.IsOpen() || header_.recordCount == 0)
+    {
+        return nullptr;
+    }
+    return reinterpret_cast<const Record*>(mapping_.Data() + sizeof(Header));
+}
+
+bool HistoryIndex::ReadStoreHead(uint32_t& length, uint32_t& crc) const
+{
+    if (storeHeadSupplied_)
+    {
+        length = suppliedHeadLength_;
+        crc = suppliedHeadCrc_;
+        return suppliedHeadLength_ > 0;
+    }
+
+    std::ifstream store(storePath_, std::ios::in | std::ios::binary);
+    if (!store.is_open())
+    {
+        return false;
+    }
+
+    std::string head;
+    char c = 0;
+    while (head.size() < kMaxHeadLength && store.get(c))
+    {
+        head.push_back(c);
+        if (c == '\n')
+        {
+            length = static_cast<uint32_t>(head.size());
+            crc = Crc32(head.data(), head.size());
+            return true;
+        }
+    }
+    return false;
+}
+
+bool HistoryIndex::LoadSymbols(std::string& error)
+{
+    symbols_.clear();
+    symbolIds_.clear();
+
+    std::ifstream input(symbolPath_, std::ios::in | std::ios::binary);
+    for (uint32_t i = 0; i < header_.symbolCount; ++i)
+    {
+        uint16_t length = 0;
+        std::string symbol;
+        if (input.read(reinterpret_cast<char*>(&length), sizeof(length)))
+        {
+            symbol.resize(length);
+            input.read(symbol.data(), length);
+        }
+        if (!input)
+        {
+            error = "History index symbols truncated";
+            symbols_.assign(1, std::string());
+            symbolIds_.emplace(std::string(), 0);
+            return false;
+        }
+        symbolIds_.emplace(symbol, static_cast<uint16_t>(symbols_.size()));
+        symbols_.push_back(std::move(symbol));
+    }
+
+    if (symbols_.empty())
+    {
+        symbols_.emplace_back();
+        symbolIds_.emplace(std::string(), 0);
+    }
+    persistedSymbols_ = header_.symbolCount;
+    return true;
+}
+
+bool HistoryIndex::WriteHeader(std::string& error)
+{
+    header_.headerCrc = HeaderCrc(header_);
+
+    std::fstream output(indexPath_, std::ios::in | std::ios::out | std::ios::binary);
+    if (!output.is_open())
+    {
+        error = std::string("Failed to open history index at ") + indexPath_.string();
+        return false;
+    }
+    output.seekp(0, std::ios::beg);
+    output.write(reinterpret_cast<const char*>(&header_), sizeof(Header));
+    if (!output)
+    {
+        error = std::string("Failed to write history index header at ") + indexPath_.string();
+        return false;
+    }
+    return true;
+}
+
+uint32_t HistoryIndex::HeaderCrc(const Header& header)
+{
+    return Crc32(&header, offsetof(Header, headerCrc));
+}
+
+bool HistoryIndex::RenameSidecars(const std::filesystem::path& from, const std::filesystem::path& to, std::string& error)
+{
+    RemoveSidecars(to);
+    for (const auto& [source, target] : { std::make_pair(IndexPathFor(from), IndexPathFor(to)),
+                                          std::make_pair(SymbolPathFor(from), SymbolPathFor(to)) })
+    {
+        std::error_code ec;
+        if (!std::filesystem::exists(source, ec))
+        {
+            continue;
+        }
+        std::filesystem::rename(source, target, ec);
+        if (ec)
+        {
+            // A stale sidecar would be rejected by Open() anyway; drop it rather than keep it.
+            error = std::string("Failed to move history index ") + source.string() + ": " + ec.message();
+            RemoveSidecars(from);
+            return false;
+        }
+    }
+    return true;
+}
+
+void HistoryIndex::RemoveSidecars(const std::filesystem::path& storePath)
+{
+    std::error_code ec;
+    std::filesystem::remove(IndexPathFor(storePath), ec);
+    std::filesystem::remove(SymbolPathFor(storePath), ec);
+}
+
+bool HistoryIndex::ReadSourceBytes(const std::filesystem::path& storePath, uint64_t& sourceBytes)
+{
+    std::ifstream input(IndexPathFor(storePath), std::ios::in | std::ios::binary);
+    Header header;
+    if (!input.read(reinterpret_cast<char*>(&header), sizeof(Header))
+        || std::memcmp(header.magic, Header().magic, sizeof(header.magic)) != 0
+        || header.version != Header().version
+        || header.headerCrc != HeaderCrc(header))
+    {
+        return false;
+    }
+    sourceBytes = header.sourceBytes;
+    return true;
+}
@@ -3,15 +3,27 @@
 #include "storage/LocalDataStore.h"
 
 #include <algorithm>
+#include <atomic>
 #include <chrono>
 #include <cctype>
+#include <cstdint>
 #include <fstream>
-#include <map>
+#include <future>
+#include <iterator>
+#include <limits>
 #include <sstream>
 #include <system_error>
+#include <thread>
 
 #include "diagnostics/DiagnosticLogger.h"
 #include "history/HistoryJson.h"
+#include "history/HistoryRollups.h"
+#include "history/JsonScan.h"
+#include "history/SnapshotIndex.h"
+#include "storage/MappedFile.h"
+#include "storage/SegmentArchive.h"
+#include "storage/StoreFile.h"
+#include "storage/StoreJournal.h"
 #include "utils/HsUtils.h"
 
 namespace
@@ -27,7 +39,7 @@ namespace
         return fallback;
     }
 
-    bool IsJsonLineEmpty(const std::string& line)
+    bool IsJsonLineEmpty(std::string_view line)
     {
         for (char c : line)
         {
@@ -39,6 +51,74 @@ namespace
         return true;
     }
 
+    constexpr int kNoMmr = std::numeric_limits<int>::min();
+
+    // Buffered appends are written once this much is pending.
+    constexpr size_t kBufferedBytes = 64 * 1024;
+
+    // Snapshot order: timestamp, then playlist id.
+    const auto kByTimestamp = [](const auto& lhs, const auto& rhs) {
+        if (lhs.timestamp == rhs.timestamp)
+        {
+            return lhs.playlist < rhs.playlist;
+        }
+        return lhs.timestamp < rhs.timestamp;
+    };
+
+    // Rotated segment `n` of the store: <store>.1 is the newest sealed one.
+    std::filesystem::path SegmentPath(const std::filesystem::path& storePath, int n)
+    {
+        return std::filesystem::path(storePath.string() + "." + std::to_string(n));
+    }
+
+    // Compressed form of a segment. Its sidecars keep the plain segment's name.
+    std::filesystem::path ArchivePath(const std::filesystem::path& segment)
+    {
+        return std::filesystem::path(segment.string() + ".hsz");
+    }
+
+    // Delete both forms of a segment along with its sidecars.
+    void RemoveSegment(const std::filesystem::path& segment)
+    {
+        std::error_code ec;
+        std::filesystem::remove(segment, ec);
+        std::filesystem::remove(ArchivePath(segment), ec);
+        HistoryIndex::RemoveSidecars(segment);
+    }
+
+    // Rename whichever form of a segment exists. False when there was none or the rename failed.
+    bool MoveSegment(const std::filesystem::path& from, const std::filesystem::path& to, std::error_code& ec)
+    {
+        bool moved = false;
+        for (const auto& [source, target] : { std::make_pair(from, to),
+                                              std::make_pair(ArchivePath(from), ArchivePath(to)) })
+        {
+            if (!std::filesystem::exists(source, ec))
+            {
+                ec.clear();
+                continue;
+            }
+            std::filesystem::rename(source, target, ec);
+            if (ec)
+            {
+                return false;
+            }
+            moved = true;
+        }
+        return moved;
+    }
+
+    // Target-table id for every id of `from`.
+    std::vector<SymbolId> TranslateSymbols(const SymbolTable& from, SymbolTable& to)
+    {
+        std::vector<SymbolId> ids(from.Size());
+        for (size_t id = 0; id < ids.size(); ++id)
+        {
+            ids[id] = to.Intern(from.Name(static_cast<SymbolId>(id)));
+        }
+        return ids;
+    }
+
     std::string SanitizeUserId(const std::string& userId)
     {
         std::string safe;
@@ -73,6 +153,45 @@ LocalDataStore::LocalDataStore(std::filesystem::path baseDirectory, std::string
     storePath_ = userDirectory_ / "local_history.jsonl";
     legacyCachePath_ = userDirectory_ / "payload_cache.jsonl";
     legacyBackupPath_ = userDirectory_ / "cached_payloads.jsonl";
+    historyIndex_ = std::make_unique<HistoryIndex>(storePath_);
+    journal_ = std::make_unique<StoreJournal>(storePath_);
+    RecoverStore();
+}
+
+void LocalDataStore::RecoverStore()
+{
+    StoreJournal::Recovery recovery;
+    std::string error;
+    if (!journal_->Recover(recovery, error))
+    {
+        DiagnosticLogger::Log(std::string("LocalDataStore: store recovery failed: ") + error);
+        return;
+    }
+    if (recovery.cutBytes == 0 && recovery.droppedFrames == 0)
+    {
+        return;
+    }
+    DiagnosticLogger::Log("LocalDataStore: cut " + std::to_string(recovery.cutBytes) + " torn bytes ("
+                          + std::to_string(recovery.droppedFrames) + " unmatched journal frames) from "
+                          + storePath_.string() + (recovery.journaled ? "" : "; journal did not match and was restarted"));
+
+    // The sidecar is trusted up to the size it records; one that reaches into the cut bytes
+    // describes lines that are gone, so it is dropped and rebuilt by the next load.
+    uint64_t indexed = 0;
+    if (HistoryIndex::ReadSourceBytes(storePath_, indexed) && indexed > recovery.storeBytes)
+    {
+        HistoryIndex::RemoveSidecars(storePath_);
+    }
+}
+
+LocalDataStore::~LocalDataStore()
+{
+    std::lock_guard<std::mutex> lock(fileMutex_);
+    std::string error;
+    if (!WritePending(error))
+    {
+        DiagnosticLogger::Log(std::string("LocalDataStore: buffered appends lost on close: ") + error);
+    }
 }
 
 bool LocalDataStore::AppendPayload(const std::string& payload, std::string& error)
@@ -96,218 +215,995 @@ bool LocalDataStore::AppendPayloads(const std::vector<std::string>& payloads, st
     return AppendLines(payloads, error);
 }
 
-bool LocalDataStore::AppendPayloadsWithVerification(const std::vector<std::string>& payloads, std::string& error)
+bool LocalDataStore::AppendPayloadsWithVerification(const std::vector<std::string>& payloads,
+                                                    std::string& error,
+                                                    AppendVerification* verification)
 {
-    if (!AppendPayloads(payloads, error))
+    error.clear();
+    if (payloads.empty())
     {
-        return false;
+        return true;
     }
 
-    // Verify last line matches last payload
-    std::ifstream input(storePath_);
-    if (!input.is_open())
+    AppendVerification local;
+    AppendVerification& result = verification ? *verification : local;
+    return AppendLines(payloads, error, &result);
+}
+
+bool LocalDataStore::Sync(std::string& error)
+{
+    std::lock_guard<std::mutex> lock(fileMutex_);
+    if (!WritePending(error))
     {
-        error = std::string("Verification failed: could not reopen ") + storePath_.string();
         return false;
     }
-
-    std::string lastLine;
-    std::string line;
-    while (std::getline(input, line))
+    if (storeFile_.IsOpen())
     {
-        if (!IsJsonLineEmpty(line))
-        {
-            lastLine = line;
-        }
+        ++appendStats_.syncs;
+        return storeFile_.Sync(error) && journal_->Sync(error);
+    }
+    if (!std::filesystem::exists(storePath_))
+    {
+        return true;
     }
+    return StoreFile::Sync(storePath_, error);
+}
 
-    if (lastLine != payloads.back())
+void LocalDataStore::SetDurability(StoreFile::Durability durability)
+{
+    std::lock_guard<std::mutex> lock(fileMutex_);
+    durability_ = durability;
+    std::string error;
+    if (durability_ != StoreFile::Durability::Buffered && !WritePending(error))
     {
-        error = "Verification failed: payload mismatch";
-        return false;
+        DiagnosticLogger::Log(std::string("LocalDataStore::SetDurability: ") + error);
     }
+}
 
-    return true;
+StoreFile::Durability LocalDataStore::GetDurability() const
+{
+    std::lock_guard<std::mutex> lock(fileMutex_);
+    return durability_;
 }
 
-bool LocalDataStore::ReadPayloadLines(std::vector<std::string>& lines, std::string& error) const
+LocalDataStore::AppendStats LocalDataStore::GetAppendStats() const
 {
     std::lock_guard<std::mutex> lock(fileMutex_);
+    return appendStats_;
+}
 
-    std::ifstream input(storePath_);
-    if (!input.is_open())
+bool LocalDataStore::ReadPayloadLines(MappedFile& mapping,
+                                      uint64_t& offset,
+                                      uint64_t& generation,
+                                      std::vector<PayloadLine>& lines,
+                                      bool& restarted,
+                                      std::string& error) const
+{
+    restarted = false;
+
+    std::error_code ec;
+    if (!std::filesystem::exists(storePath_, ec))
     {
-        if (std::filesystem::exists(storePath_))
-        {
-            error = std::string("Failed to read local store at ") + storePath_.string();
-            return false;
-        }
         // Gracefully handle missing store; caller treats empty list as "no history yet".
+        restarted = offset != 0;
+        offset = 0;
+        generation = storeGeneration_;
         return true;
     }
 
-    std::string line;
-    while (std::getline(input, line))
+    std::string mapError;
+    if (!mapping.Open(storePath_, mapError))
+    {
+        error = std::string("Failed to read local store at ") + storePath_.string() + ": " + mapError;
+        return false;
+    }
+    std::string_view data = mapping.View();
+    if (tornTail_)
+    {
+        data = data.substr(0, static_cast<size_t>((std::min)(tornOffset_, static_cast<uint64_t>(data.size()))));
+    }
+    const uint64_t size = data.size();
+
+    // A rotation (or an external truncation) invalidates the remembered offset.
+    if (generation != storeGeneration_ || size < offset)
     {
-        if (IsJsonLineEmpty(line))
+        restarted = true;
+        offset = 0;
+        generation = storeGeneration_;
+    }
+    if (size == offset)
+    {
+        return true;
+    }
+
+    // Only consume complete lines; a trailing partial line is picked up next time.
+    size_t lineStart = static_cast<size_t>(offset);
+    size_t newline = HistoryJson::Scan::FindNewline(data, lineStart);
+    while (newline < data.size())
+    {
+        PayloadLine line;
+        line.offset = lineStart;
+        line.text = data.substr(lineStart, newline - lineStart);
+        if (!line.text.empty() && line.text.back() == '\r')
         {
-            continue;
+            line.text.remove_suffix(1);
         }
         lines.push_back(line);
+        lineStart = newline + 1;
+        newline = HistoryJson::Scan::FindNewline(data, lineStart);
     }
+    offset = lineStart;
     return true;
 }
 
-bool LocalDataStore::ParsePayloadSummary(const std::string& payload, PayloadSummary& summary, std::string& error) const
+bool LocalDataStore::ParsePayloadSummary(std::string_view payload,
+                                         HistorySymbols& symbols,
+                                         PayloadSummary& summary,
+                                         std::string& error) const
 {
-    HistoryJson::Parser parser(payload);
-    HistoryJson::Value root;
-    if (!parser.Parse(root, error))
+    enum Field { kTimestamp, kPlaylist, kMmr, kGamesPlayedDiff, kSource, kSessionType, kDurationSeconds };
+    static constexpr HistoryJson::KeyList<7> kFields{
+        "timestamp", "playlist", "mmr", "gamesPlayedDiff", "source", "sessionType", "durationSeconds"
+    };
+
+    // Views may point at the extractor's scratch buffer, so intern strings as they arrive.
+    const auto internText = [](const HistoryJson::ViewValue& value, SymbolTable& table, SymbolId& target) {
+        const auto text = HistoryJson::AsString(&value);
+        if (text)
+        {
+            target = table.Intern(*text);
+        }
+        return text.has_value();
+    };
+
+    bool hasTimestamp = false;
+    bool hasPlaylist = false;
+    bool hasSource = false;
+    summary = PayloadSummary();
+
+    // Match payloads also carry teams/scoreboard arrays; the extractor skips them unparsed.
+    HistoryJson::FieldExtractor extractor(payload);
+    const bool parsed = extractor.Extract(kFields, [&](size_t field, const HistoryJson::ViewValue& value) {
+        switch (field)
+        {
+        case kTimestamp:
+            if (const auto text = HistoryJson::AsString(&value))
+            {
+                hasTimestamp = true;
+                ParseTimestampEpoch(*text, summary.timestamp);
+            }
+            break;
+        case kPlaylist:        hasPlaylist = internText(value, symbols.playlists, summary.playlist); break;
+        case kMmr:             summary.mmr = HistoryJson::AsInt(&value).value_or(0); break;
+        case kGamesPlayedDiff: summary.gamesPlayedDiff = HistoryJson::AsInt(&value).value_or(0); break;
+        case kSource:          hasSource = internText(value, symbols.sources, summary.source); break;
+        case kSessionType:     internText(value, symbols.sessionTypes, summary.sessionType); break;
+        case kDurationSeconds: summary.durationSeconds = HistoryJson::AsInt(&value).value_or(0); break;
+        }
+    }, error);
+    if (!parsed)
     {
         return false;
     }
 
-    if (root.type != HistoryJson::Type::Object)
+    if (!hasTimestamp)
     {
-        error = "Payload is not a JSON object";
-        return false;
+        summary.timestamp = ToEpochSeconds(std::chrono::system_clock::now());
+    }
+    if (!hasPlaylist)
+    {
+        summary.playlist = symbols.playlists.Intern("unknown");
+    }
+    if (!hasSource)
+    {
+        summary.source = symbols.sources.Intern("local_cache");
     }
-
-    summary.timestamp = HistoryJson::AsString(HistoryJson::GetMember(root, "timestamp"))
-                            .value_or(FormatTimestamp(std::chrono::system_clock::now()));
-    summary.playlist = HistoryJson::AsString(HistoryJson::GetMember(root, "playlist"))
-                           .value_or(std::string("unknown"));
-    summary.mmr = HistoryJson::AsInt(HistoryJson::GetMember(root, "mmr")).value_or(0);
-    summary.gamesPlayedDiff = HistoryJson::AsInt(HistoryJson::GetMember(root, "gamesPlayedDiff")).value_or(0);
-    summary.source = HistoryJson::AsString(HistoryJson::GetMember(root, "source"))
-                         .value_or(std::string("local_cache"));
-    summary.sessionType = HistoryJson::AsString(HistoryJson::GetMember(root, "sessionType"))
-                              .value_or(std::string());
-    summary.durationSeconds = HistoryJson::AsInt(HistoryJson::GetMember(root, "durationSeconds")).value_or(0);
     return true;
 }
 
-bool LocalDataStore::BuildSnapshot(const std::vector<PayloadSummary>& entries,
-                                   HistorySnapshot& snapshot,
-                                   std::string& error) const
+std::shared_ptr<const HistorySnapshot> LocalDataStore::PublishSnapshot(HistoryCache& cache) const
 {
-    snapshot = HistorySnapshot();
+    if (cache.published >= 0)
+    {
+        SnapshotBuffer& current = cache.buffers[static_cast<size_t>(cache.published)];
+        if (current.epoch == cache.epoch && current.entries == cache.entries.size())
+        {
+            return current.HandOut();
+        }
+    }
 
-    if (entries.empty())
+    // A published snapshot may still be read anywhere, so it is never changed. The other
+    // buffer is brought up to date instead: in place, appending only the entries it lacks,
+    // once every handle to it has been released; otherwise a new one is built. The acquire
+    // pairs with the release in the handle's deleter, so all reads through it are done.
+    const int target = cache.published == 0 ? 1 : 0;
+    SnapshotBuffer& buffer = cache.buffers[static_cast<size_t>(target)];
+    if (!buffer.slot || buffer.slot->handles.load(std::memory_order_acquire) > 0)
     {
-        const auto now = std::chrono::system_clock::now();
-        snapshot.status.generatedAt = FormatTimestamp(now);
-        snapshot.status.receivedAt = snapshot.status.generatedAt;
-        return true;
+        buffer = SnapshotBuffer();
+        buffer.slot = std::make_shared<SnapshotBuffer::Slot>();
+        buffer.epoch = cache.epoch;
     }
+    else if (buffer.epoch != cache.epoch || buffer.entries > cache.entries.size())
+    {
+        buffer.slot->snapshot = HistorySnapshot();
+        buffer.lastMmrByPlaylist.clear();
+        buffer.epoch = cache.epoch;
+        buffer.entries = 0;
+    }
+    AppendSnapshotEntries(cache, buffer);
+    FinalizeSnapshotStatus(buffer.slot->snapshot);
+    cache.published = target;
+    return buffer.HandOut();
+}
 
-    std::vector<PayloadSummary> sorted = entries;
-    std::sort(sorted.begin(), sorted.end(), [](const PayloadSummary& lhs, const PayloadSummary& rhs) {
-        if (lhs.timestamp == rhs.timestamp)
-        {
-            return lhs.playlist < rhs.playlist;
-        }
-        return lhs.timestamp < rhs.timestamp;
+std::shared_ptr<const HistorySnapshot> LocalDataStore::SnapshotBuffer::HandOut()
+{
+    if (std::shared_ptr<const HistorySnapshot> live = handle.lock())
+    {
+        return live;
+    }
+
+    // Counted per handle rather than by whether `handle` expired: the last reader's
+    // deleter may still be on its way, and it releases only the handle it belongs to.
+    slot->handles.fetch_add(1, std::memory_order_relaxed);
+    std::shared_ptr<const HistorySnapshot> fresh(&slot->snapshot, [owner = slot](const HistorySnapshot*) {
+        owner->handles.fetch_sub(1, std::memory_order_release);
     });
+    handle = fresh;
+    return fresh;
+}
+
+void LocalDataStore::AppendSnapshotEntries(HistoryCache& cache, SnapshotBuffer& buffer) const
+{
+    HistorySnapshot& snapshot = buffer.slot->snapshot;
+    HistorySymbols& symbols = cache.symbols;
+    const SymbolId localSource = symbols.sources.Intern("local");
+    snapshot.mmrHistory.reserve(cache.entries.size());
+    snapshot.aggregates.mmrDeltas.reserve(cache.entries.size());
+    snapshot.aggregates.secondsBySessionType.resize(symbols.sessionTypes.Size(), 0.0);
+    buffer.lastMmrByPlaylist.resize(symbols.playlists.Size(), kNoMmr);
 
-    int ordinal = 0;
-    std::map<std::string, int> lastMmrByPlaylist;
-    for (const auto& entry : sorted)
+    const size_t firstEntry = buffer.entries;
+    for (size_t i = firstEntry; i < cache.entries.size(); ++i)
     {
+        const PayloadSummary& entry = cache.entries[i];
+        const int32_t day = EpochDay(entry.timestamp);
+
         MmrHistoryEntry mmrEntry;
-        mmrEntry.id = std::string("local_") + std::to_string(ordinal++);
+        mmrEntry.id = std::string("local_") + std::to_string(i);
         mmrEntry.timestamp = entry.timestamp;
+        mmrEntry.day = day;
         mmrEntry.playlist = entry.playlist;
         mmrEntry.mmr = entry.mmr;
         mmrEntry.gamesPlayedDiff = entry.gamesPlayedDiff;
-        mmrEntry.source = entry.source.empty() ? std::string("local") : entry.source;
+        mmrEntry.source = entry.source != 0 ? entry.source : localSource;
         snapshot.mmrHistory.emplace_back(std::move(mmrEntry));
 
-        const std::string sessionKey = entry.sessionType.empty() ? std::string("unknown") : entry.sessionType;
-        snapshot.aggregates.timeBySessionType[sessionKey] +=
-            static_cast<double>(std::max(0, entry.durationSeconds));
-
-        auto it = lastMmrByPlaylist.find(entry.playlist);
-        int delta = 0;
-        if (it != lastMmrByPlaylist.end())
+        SymbolId sessionType = entry.sessionType;
+        if (sessionType == 0)
         {
-            delta = entry.mmr - it->second;
+            // Interned on first use so "unknown" only shows up when some record lacks a type.
+            sessionType = symbols.sessionTypes.Intern("unknown");
+            snapshot.aggregates.secondsBySessionType.resize(symbols.sessionTypes.Size(), 0.0);
         }
-        lastMmrByPlaylist[entry.playlist] = entry.mmr;
+        const double seconds = static_cast<double>(std::max(0, entry.durationSeconds));
+        snapshot.aggregates.secondsBySessionType[sessionType] += seconds;
+        HistoryRollups::AddSessionSeconds(snapshot.rollups, day, sessionType, seconds);
+
+        int& lastMmr = buffer.lastMmrByPlaylist[entry.playlist];
+        const int delta = lastMmr == kNoMmr ? 0 : entry.mmr - lastMmr;
+        lastMmr = entry.mmr;
 
         HistorySnapshot::Aggregates::MmrDelta deltaEntry;
         deltaEntry.timestamp = entry.timestamp;
         deltaEntry.playlist = entry.playlist;
-        deltaEntry.sessionType = entry.sessionType.empty() ? std::string("unknown") : entry.sessionType;
+        deltaEntry.sessionType = sessionType;
         deltaEntry.mmr = entry.mmr;
         deltaEntry.delta = delta;
         snapshot.aggregates.mmrDeltas.emplace_back(std::move(deltaEntry));
     }
+    buffer.entries = cache.entries.size();
+    snapshot.symbols = symbols; // small; ids only ever get added
+    SnapshotIndex::AddMmrEntries(snapshot, firstEntry);
+}
 
+void LocalDataStore::FinalizeSnapshotStatus(HistorySnapshot& snapshot) const
+{
     snapshot.status.mmrEntries = static_cast<int>(snapshot.mmrHistory.size());
     snapshot.status.trainingSessions = static_cast<int>(snapshot.trainingHistory.size());
     snapshot.status.mmrLimit = snapshot.status.mmrEntries;
     snapshot.status.sessionLimit = snapshot.status.trainingSessions;
     snapshot.status.lastMmrTimestamp = snapshot.mmrHistory.empty()
-                                            ? std::string()
+                                            ? 0
                                             : snapshot.mmrHistory.back().timestamp;
     snapshot.status.lastTrainingTimestamp = snapshot.trainingHistory.empty()
-                                                ? std::string()
+                                                ? 0
                                                 : snapshot.trainingHistory.back().finishedTime;
-    snapshot.status.receivedAt = FormatTimestamp(std::chrono::system_clock::now());
-    snapshot.status.generatedAt = snapshot.status.lastMmrTimestamp.empty()
+    snapshot.status.receivedAt = ToEpochSeconds(std::chrono::system_clock::now());
+    snapshot.status.generatedAt = snapshot.status.lastMmrTimestamp == 0
                                       ? snapshot.status.receivedAt
                                       : snapshot.status.lastMmrTimestamp;
+}
 
-    (void)error;
-    return true;
+bool LocalDataStore::ImportHistoryIndex(HistoryCache& cache) const
+{
+    std::string indexError;
+    if (!historyIndex_->Open(indexError))
+    {
+        DiagnosticLogger::Log(std::string("LocalDataStore::ImportHistoryIndex: rebuilding sidecar (") + indexError + ")");
+        if (!historyIndex_->Reset(indexError))
+        {
+            DiagnosticLogger::Log(std::string("LocalDataStore::ImportHistoryIndex: ") + indexError);
+            cache.indexWritable = false;
+        }
+        return false;
+    }
+
+    std::vector<PayloadSummary> live;
+    ReadIndexRecords(*historyIndex_, storePath_, cache.symbols, live);
+    historyIndex_->Unmap();
+
+    // Sealed segments are already in `entries`; on equal keys they stay first.
+    std::stable_sort(live.begin(), live.end(), kByTimestamp);
+    const size_t sealedCount = cache.entries.size();
+    cache.entries.insert(cache.entries.end(),
+                         std::make_move_iterator(live.begin()),
+                         std::make_move_iterator(live.end()));
+    std::inplace_merge(cache.entries.begin(),
+                       cache.entries.begin() + static_cast<std::ptrdiff_t>(sealedCount),
+                       cache.entries.end(),
+                       kByTimestamp);
+    ++cache.epoch;
+    cache.offset = historyIndex_->SourceBytes();
+    cache.linesRead = historyIndex_->LineCount();
+    cache.skipped = historyIndex_->SkippedLines();
+    return true; // the snapshot is built by LoadHistory, after the file lock is released
 }
 
-bool LocalDataStore::LoadHistory(HistorySnapshot& snapshot, std::string& error) const
+void LocalDataStore::ReadIndexRecords(const HistoryIndex& index,
+                                      const std::filesystem::path& store,
+                                      HistorySymbols& symbols,
+                                      std::vector<PayloadSummary>& entries) const
+{
+    const HistoryIndex::Record* records = index.Records();
+    const size_t count = index.RecordCount();
+    MappedFile storeFile;
+    bool storeMapped = false;
+    std::string mapError;
+    entries.reserve(entries.size() + count);
+
+    // Sidecar symbol ids -> snapshot symbol ids, resolved once per distinct id.
+    std::vector<int> playlistIds, sourceIds, sessionTypeIds;
+    const auto translate = [&index](std::vector<int>& ids, SymbolTable& table, uint16_t indexId) {
+        if (indexId >= ids.size())
+        {
+            ids.resize(static_cast<size_t>(indexId) + 1, -1);
+        }
+        if (ids[indexId] < 0)
+        {
+            ids[indexId] = table.Intern(index.Symbol(indexId));
+        }
+        return static_cast<SymbolId>(ids[indexId]);
+    };
+    for (size_t i = 0; i < count; ++i)
+    {
+        const HistoryIndex::Record& record = records[i];
+        PayloadSummary summary;
+        if (record.flags & HistoryIndex::kTimestampNeedsText)
+        {
+            // Only sidecars from older builds carry this flag.
+            if (!storeMapped)
+            {
+                storeMapped = storeFile.Open(store, mapError);
+            }
+            if (storeMapped && record.lineOffset + record.lineLength <= storeFile.Size())
+            {
+                PayloadSummary full;
+                std::string parseError;
+                const std::string_view line(storeFile.Data() + record.lineOffset, record.lineLength);
+                if (ParsePayloadSummary(line, symbols, full, parseError))
+                {
+                    summary.timestamp = full.timestamp;
+                }
+            }
+        }
+        else
+        {
+            summary.timestamp = record.timestamp;
+        }
+        summary.playlist = translate(playlistIds, symbols.playlists, record.playlistId);
+        summary.mmr = record.mmr;
+        summary.gamesPlayedDiff = record.gamesPlayedDiff;
+        summary.source = translate(sourceIds, symbols.sources, record.sourceId);
+        summary.sessionType = translate(sessionTypeIds, symbols.sessionTypes, record.sessionTypeId);
+        summary.durationSeconds = record.durationSeconds;
+        entries.emplace_back(std::move(summary));
+    }
+}
+
+struct LocalDataStore::SegmentLoad
+{
+    std::filesystem::path path; // plain name; the data is at ArchivePath(path) when compressed
+    bool compressed{false};
+    uint64_t size{0};
+    std::filesystem::file_time_type modified{};
+    size_t cached{SIZE_MAX}; // into HistoryCache::sealed when unchanged since the last load
+    HistorySymbols symbols;  // worker-local; ids are translated when segments are merged
+    std::vector<PayloadSummary> entries;
+    size_t skipped{0};
+    std::string firstParseError;
+
+    // Sidecar update, built in memory by the worker and written by CommitSealedSegments.
+    std::unique_ptr<HistoryIndex> index;
+    std::vector<HistoryIndex::Record> records;
+    uint64_t indexedBytes{0};
+    uint32_t lineCount{0};
+};
+
+std::vector<LocalDataStore::SegmentLoad> LocalDataStore::ListSealedSegments() const
+{
+    // Oldest first: <store>.N down to <store>.1.
+    std::vector<SegmentLoad> loads;
+    for (int n = 1;; ++n)
+    {
+        SegmentLoad load;
+        load.path = SegmentPath(storePath_, n);
+        std::error_code ec;
+        load.compressed = !std::filesystem::exists(load.path, ec);
+        const std::filesystem::path file = load.compressed ? ArchivePath(load.path) : load.path;
+        load.size = static_cast<uint64_t>(std::filesystem::file_size(file, ec));
+        if (!ec)
+        {
+            load.modified = std::filesystem::last_write_time(file, ec);
+        }
+        if (ec)
+        {
+            break;
+        }
+        loads.push_back(std::move(load));
+    }
+    std::reverse(loads.begin(), loads.end());
+    return loads;
+}
+
+void LocalDataStore::ParseSealedSegments(HistoryCache& cache, std::vector<SegmentLoad>& loads) const
+{
+    // Unchanged segments come from the previous load; the rest are parsed by at most one
+    // worker per hardware thread. Nothing is written here: segments and their sidecars may
+    // be renamed by a rotation meanwhile.
+    std::vector<bool> taken(cache.sealed.size(), false);
+    std::vector<size_t> toParse;
+    for (size_t i = 0; i < loads.size(); ++i)
+    {
+        for (size_t j = 0; j < cache.sealed.size(); ++j)
+        {
+            if (!taken[j] && cache.sealed[j].size == loads[i].size && cache.sealed[j].modified == loads[i].modified)
+            {
+                taken[j] = true;
+                loads[i].cached = j;
+                break;
+            }
+        }
+        if (loads[i].cached == SIZE_MAX)
+        {
+            toParse.push_back(i);
+        }
+    }
+
+    std::atomic<size_t> next{0};
+    const auto parse = [&]() {
+        for (size_t i = next++; i < toParse.size(); i = next++)
+        {
+            ParseSealedSegment(loads[toParse[i]]);
+        }
+    };
+    const size_t workerCount = (std::min)(toParse.size(), static_cast<size_t>((std::max)(1u, std::thread::hardware_concurrency())));
+    std::vector<std::future<void>> workers;
+    for (size_t i = 1; i < workerCount; ++i)
+    {
+        workers.push_back(std::async(std::launch::async, parse));
+    }
+    if (workerCount > 0)
+    {
+        parse();
+    }
+    for (auto& worker : workers)
+    {
+        worker.get();
+    }
+
+    // Symbols only ever get added, so interning for a load that is then discarded is harmless.
+    HistorySymbols& symbols = cache.symbols;
+    for (const size_t i : toParse)
+    {
+        SegmentLoad& load = loads[i];
+        const std::vector<SymbolId> playlists = TranslateSymbols(load.symbols.playlists, symbols.playlists);
+        const std::vector<SymbolId> sources = TranslateSymbols(load.symbols.sources, symbols.sources);
+        const std::vector<SymbolId> sessionTypes = TranslateSymbols(load.symbols.sessionTypes, symbols.sessionTypes);
+        for (PayloadSummary& entry : load.entries)
+        {
+            entry.playlist = playlists[entry.playlist];
+            entry.source = sources[entry.source];
+            entry.sessionType = sessionTypes[entry.sessionType];
+        }
+        std::stable_sort(load.entries.begin(), load.entries.end(), kByTimestamp);
+    }
+}
+
+void LocalDataStore::CommitSealedSegments(HistoryCache& cache, std::vector<SegmentLoad>& loads) const
+{
+    std::vector<SealedSegment> sealed(loads.size());
+    size_t total = 0;
+    for (size_t i = 0; i < loads.size(); ++i)
+    {
+        SegmentLoad& load = loads[i];
+        SealedSegment& segment = sealed[i];
+        if (load.cached != SIZE_MAX)
+        {
+            segment = std::move(cache.sealed[load.cached]);
+        }
+        else
+        {
+            std::string indexError;
+            if (load.index && !load.index->Append(load.records, load.indexedBytes, load.lineCount,
+                                                  static_cast<uint32_t>(load.skipped), indexError))
+            {
+                DiagnosticLogger::Log(std::string("LocalDataStore::LoadHistory: ") + indexError);
+            }
+            segment.size = load.size;
+            segment.modified = load.modified;
+            segment.entries = std::move(load.entries);
+            segment.skipped = load.skipped;
+            segment.firstParseError = std::move(load.firstParseError);
+        }
+        total += segment.entries.size();
+    }
+
+    cache.entries.clear();
+    ++cache.epoch;
+    cache.entries.reserve(total);
+    for (const SealedSegment& segment : sealed)
+    {
+        const size_t middle = cache.entries.size();
+        cache.entries.insert(cache.entries.end(), segment.entries.begin(), segment.entries.end());
+        std::inplace_merge(cache.entries.begin(),
+                           cache.entries.begin() + static_cast<std::ptrdiff_t>(middle),
+                           cache.entries.end(),
+                           kByTimestamp);
+    }
+    cache.sealed = std::move(sealed);
+}
+
+void LocalDataStore::ParseSealedSegment(SegmentLoad& load) const
+{
+    if (load.compressed)
+    {
+        ParseArchivedSegment(load);
+        return;
+    }
+
+    // Whatever the segment's sidecar covers is read from its records; only lines after it
+    // are parsed, and then added to the sidecar so the next cold load skips them too.
+    auto index = std::make_unique<HistoryIndex>(load.path);
+    std::string indexError;
+    uint64_t offset = 0;
+    if (index->Open(indexError))
+    {
+        ReadIndexRecords(*index, load.path, load.symbols, load.entries);
+        index->Unmap();
+        offset = index->SourceBytes();
+        load.lineCount = index->LineCount();
+        load.skipped = index->SkippedLines();
+    }
+    else
+    {
+        index->Clear();
+    }
+
+    MappedFile file;
+    std::string mapError;
+    if (!file.Open(load.path, mapError))
+    {
+        DiagnosticLogger::Log(std::string("LocalDataStore::LoadHistory: ") + mapError);
+        return;
+    }
+
+    const std::string_view data = file.View();
+    if (offset < data.size())
+    {
+        load.indexedBytes = ParseSegmentLines(data, static_cast<size_t>(offset), load,
+                                              index.get(), load.records, load.lineCount);
+        load.index = std::move(index);
+    }
+}
+
+void LocalDataStore::ParseArchivedSegment(SegmentLoad& load) const
+{
+    SegmentArchive archive;
+    std::string error;
+    if (!archive.Open(ArchivePath(load.path), error))
+    {
+        DiagnosticLogger::Log(std::string("LocalDataStore::LoadHistory: ") + load.path.filename().string() + ": " + error);
+        return;
+    }
+
+    auto index = std::make_unique<HistoryIndex>(load.path);
+    index->SetStoreHead(archive.RawSize(), archive.HeadLength(), archive.HeadCrc());
+    if (index->Open(error))
+    {
+        ReadIndexRecords(*index, load.path, load.symbols, load.entries);
+        load.skipped = index->SkippedLines();
+        return;
+    }
+
+    // Lost or stale sidecar: inflate the archive once and index it again.
+    std::string data;
+    if (!archive.ReadAll(data, error))
+    {
+        DiagnosticLogger::Log(std::string("LocalDataStore::LoadHistory: ") + load.path.filename().string() + ": " + error);
+        return;
+    }
+    index->Clear();
+    load.indexedBytes = ParseSegmentLines(data, 0, load, index.get(), load.records, load.lineCount);
+    load.index = std::move(index);
+}
+
+size_t LocalDataStore::ParseSegmentLines(std::string_view data,
+                                         size_t offset,
+                                         SegmentLoad& load,
+                                         HistoryIndex* index,
+                                         std::vector<HistoryIndex::Record>& records,
+                                         uint32_t& lineCount) const
+{
+    // Complete lines only; returns the offset just past the last one.
+    size_t lineStart = (std::min)(offset, data.size());
+    size_t newline = HistoryJson::Scan::FindNewline(data, lineStart);
+    while (newline < data.size())
+    {
+        std::string_view text = data.substr(lineStart, newline - lineStart);
+        if (!text.empty() && text.back() == '\r')
+        {
+            text.remove_suffix(1);
+        }
+        ++lineCount;
+        if (!IsJsonLineEmpty(text))
+        {
+            PayloadSummary summary;
+            std::string parseError;
+            if (ParsePayloadSummary(text, load.symbols, summary, parseError))
+            {
+                if (index != nullptr)
+                {
+                    records.push_back(MakeIndexRecord(summary, load.symbols, *index, lineStart, text.size()));
+                }
+                load.entries.push_back(summary);
+            }
+            else
+            {
+                ++load.skipped;
+                if (load.firstParseError.empty())
+                {
+                    load.firstParseError = parseError;
+                }
+                DiagnosticLogger::Log(
+                    std::string("LocalDataStore::LoadHistory: skipping line ") + std::to_string(lineCount)
+                    + " of " + load.path.filename().string() + ": " + parseError);
+            }
+        }
+        lineStart = newline + 1;
+        newline = HistoryJson::Scan::FindNewline(data, lineStart);
+    }
+    return lineStart;
+}
+
+bool LocalDataStore::CompressSealedSegments(std::string& error)
 {
     error.clear();
-    std::vector<std::string> payloadLines;
-    if (!ReadPayloadLines(payloadLines, error))
+    // Holding cacheMutex_ keeps loads from parsing a segment while it changes form.
+    std::lock_guard<std::mutex> cacheLock(cacheMutex_);
+    std::vector<std::filesystem::path> segments;
+    uint64_t generation = 0;
+    {
+        std::lock_guard<std::mutex> fileLock(fileMutex_);
+        for (const SegmentLoad& load : ListSealedSegments())
+        {
+            if (!load.compressed)
+            {
+                segments.push_back(load.path);
+            }
+        }
+        generation = storeGeneration_;
+    }
+
+    bool ok = true;
+    for (const std::filesystem::path& segment : segments)
+    {
+        std::string segmentError;
+        if (!CompressSegment(segment, generation, segmentError))
+        {
+            DiagnosticLogger::Log(std::string("LocalDataStore::CompressSealedSegments: ") + segmentError);
+            if (ok)
+            {
+                error = segmentError;
+            }
+            ok = false;
+        }
+    }
+    return ok;
+}
+
+bool LocalDataStore::CompressSegment(const std::filesystem::path& segment, uint64_t generation, std::string& error)
+{
+    // Sealed segments never grow, so once the sidecar covers every line the JSON is only
+    // needed for rebuilding the sidecar. Segments not indexed yet wait for a load.
+    HistoryIndex index(segment);
+    std::string indexError;
+    if (!index.Open(indexError))
+    {
+        return true;
+    }
+    MappedFile file;
+    if (!file.Open(segment, error))
+    {
+        return false;
+    }
+    if (file.View().empty() || index.SourceBytes() != file.View().size())
+    {
+        return true;
+    }
+
+    // Block time spans come from the sidecar. Records from older builds without a usable
+    // timestamp need the JSON line itself, so those segments stay plain.
+    std::vector<SegmentArchive::LineTime> lineTimes;
+    lineTimes.reserve(index.RecordCount());
+    const HistoryIndex::Record* records = index.Records();
+    for (size_t i = 0; i < index.RecordCount(); ++i)
+    {
+        if (records[i].flags & HistoryIndex::kTimestampNeedsText)
+        {
+            return true;
+        }
+        lineTimes.push_back({ records[i].lineOffset, records[i].timestamp });
+    }
+    index.Unmap();
+
+    // Written under a staging name without the file lock; a rotation meanwhile renames the
+    // segment, so the archive is only put in place if none happened.
+    const std::filesystem::path archive = ArchivePath(segment);
+    const std::filesystem::path staging(archive.string() + ".new");
+    if (!SegmentArchive::Write(file.View(), lineTimes, staging, error))
     {
         return false;
     }
+    std::error_code ec;
+    const uint64_t plainSize = file.View().size();
+    const std::filesystem::file_time_type plainModified = std::filesystem::last_write_time(segment, ec);
+    file.Close();
+
+    std::lock_guard<std::mutex> fileLock(fileMutex_);
+    if (generation != storeGeneration_)
+    {
+        std::filesystem::remove(staging, ec);
+        return true; // picked up again by the next run
+    }
+    std::filesystem::rename(staging, archive, ec);
+    if (!ec)
+    {
+        std::filesystem::remove(segment, ec);
+    }
+    if (ec)
+    {
+        error = segment.filename().string() + ": " + ec.message();
+        std::filesystem::remove(staging, ec);
+        std::filesystem::remove(archive, ec);
+        return false;
+    }
+
+    // Record the archive's size and time so the next load reuses this segment's entries.
+    const uint64_t size = static_cast<uint64_t>(std::filesystem::file_size(archive, ec));
+    const std::filesystem::file_time_type modified = ec ? std::filesystem::file_time_type{} : std::filesystem::last_write_time(archive, ec);
+    for (SealedSegment& cached : historyCache_.sealed)
+    {
+        if (!ec && cached.size == plainSize && cached.modified == plainModified)
+        {
+            cached.size = size;
+            cached.modified = modified;
+            break;
+        }
+    }
+    return true;
+}
+
+HistoryIndex::Record LocalDataStore::MakeIndexRecord(const PayloadSummary& summary,
+                                                     const HistorySymbols& symbols,
+                                                     HistoryIndex& index,
+                                                     uint64_t offset,
+                                                     size_t length)
+{
+    HistoryIndex::Record record;
+    record.timestamp = summary.timestamp;
+    record.lineOffset = offset;
+    record.lineLength = static_cast<uint32_t>(length);
+    record.mmr = summary.mmr;
+    record.gamesPlayedDiff = summary.gamesPlayedDiff;
+    record.durationSeconds = summary.durationSeconds;
+    record.playlistId = index.Intern(symbols.playlists.Name(summary.playlist));
+    record.sessionTypeId = index.Intern(symbols.sessionTypes.Name(summary.sessionType));
+    record.sourceId = index.Intern(symbols.sources.Name(summary.source));
+    return record;
+}
+
+bool LocalDataStore::LoadHistory(std::shared_ptr<const HistorySnapshot>& snapshot, std::string& error) const
+{
+    error.clear();
+    std::lock_guard<std::mutex> cacheLock(cacheMutex_);
+    HistoryCache& cache = historyCache_;
+
+    MappedFile storeMapping; // payloadLines view into it until they are parsed
+    std::vector<PayloadLine> payloadLines;
+    uint64_t offset = 0;
+    uint64_t generation = 0;
+    bool restarted = false;
+    std::string indexError;
+    bool loadSegments = !cache.indexImported;
+    bool rebuilding = false;
+    for (;;)
+    {
+        // Sealed segments are listed under the file lock but parsed without it, so appends
+        // carry on during a cold load. A rotation meanwhile moves lines between segments
+        // and the live store; it is caught below and the segments listed again (those that
+        // were only renamed come from the cache).
+        uint64_t listedGeneration = 0;
+        std::vector<SegmentLoad> loads;
+        if (loadSegments)
+        {
+            {
+                std::lock_guard<std::mutex> fileLock(fileMutex_);
+                loads = ListSealedSegments();
+                listedGeneration = storeGeneration_;
+            }
+            ParseSealedSegments(cache, loads);
+        }
+
+        std::lock_guard<std::mutex> fileLock(fileMutex_);
+        if (loadSegments)
+        {
+            // Sidecars are only written once the segments are known to be where they were
+            // listed.
+            if (listedGeneration != storeGeneration_)
+            {
+                continue;
+            }
+            CommitSealedSegments(cache, loads);
+        }
+        if (!WritePending(indexError))
+        {
+            DiagnosticLogger::Log(std::string("LocalDataStore::LoadHistory: ") + indexError);
+        }
+
+        // Cold start: after the sealed segments, everything the live sidecar already covers,
+        // without parsing JSON where sidecars exist.
+        if (!cache.indexImported)
+        {
+            cache.indexImported = true;
+            cache.generation = storeGeneration_;
+            ImportHistoryIndex(cache);
+        }
+        else if (rebuilding)
+        {
+            cache.generation = storeGeneration_;
+            cache.indexWritable = historyIndex_->Reset(indexError);
+        }
+
+        offset = cache.offset;
+        generation = cache.generation;
+        if (!ReadPayloadLines(storeMapping, offset, generation, payloadLines, restarted, error))
+        {
+            return false;
+        }
+
+        if (restarted && !rebuilding)
+        {
+            DiagnosticLogger::Log("LocalDataStore::LoadHistory: store rotated or truncated; rebuilding history");
+            // Symbol tables and parsed sealed segments survive; the latter reference the former.
+            HistorySymbols symbols = std::move(cache.symbols);
+            std::vector<SealedSegment> sealed = std::move(cache.sealed);
+            cache = HistoryCache();
+            cache.symbols = std::move(symbols);
+            cache.sealed = std::move(sealed);
+            cache.indexImported = true;
+            payloadLines.clear();
+            loadSegments = true;
+            rebuilding = true;
+            continue;
+        }
+        break;
+    }
+    restarted = restarted || rebuilding;
+    cache.offset = offset;
+    cache.generation = generation;
 
     std::vector<PayloadSummary> parsed;
+    std::vector<HistoryIndex::Record> indexRecords;
     parsed.reserve(payloadLines.size());
+    indexRecords.reserve(payloadLines.size());
 
-    std::string firstParseError;
-    size_t skipped = 0;
-    for (size_t i = 0; i < payloadLines.size(); ++i)
+    for (const PayloadLine& line : payloadLines)
     {
-        const std::string& line = payloadLines[i];
-        if (line.empty())
+        ++cache.linesRead;
+        if (IsJsonLineEmpty(line.text))
         {
             continue;
         }
 
         PayloadSummary summary;
         std::string parseError;
-        if (!ParsePayloadSummary(line, summary, parseError))
+        if (!ParsePayloadSummary(line.text, cache.symbols, summary, parseError))
         {
-            ++skipped;
-            if (firstParseError.empty())
+            ++cache.skipped;
+            if (cache.firstParseError.empty())
             {
-                firstParseError = parseError;
+                cache.firstParseError = parseError;
             }
             DiagnosticLogger::Log(
                 std::string("LocalDataStore::LoadHistory: skipping payload line ")
-                + std::to_string(i + 1) + ": " + parseError);
+                + std::to_string(cache.linesRead) + ": " + parseError);
             continue;
         }
 
+        if (cache.indexWritable)
+        {
+            indexRecords.push_back(MakeIndexRecord(summary, cache.symbols, *historyIndex_, line.offset, line.text.size()));
+        }
         parsed.emplace_back(std::move(summary));
     }
 
-    if (!BuildSnapshot(parsed, snapshot, error))
+    if (cache.indexWritable && (!payloadLines.empty() || restarted))
     {
-        return false;
+        // On failure the sidecar header still describes a valid prefix; stop appending to it.
+        cache.indexWritable = historyIndex_->Append(indexRecords,
+                                                    cache.offset,
+                                                    static_cast<uint32_t>(cache.linesRead),
+                                                    static_cast<uint32_t>(cache.skipped),
+                                                    indexError);
+        if (!cache.indexWritable)
+        {
+            DiagnosticLogger::Log(std::string("LocalDataStore::LoadHistory: ") + indexError);
+        }
     }
 
+    std::stable_sort(parsed.begin(), parsed.end(), kByTimestamp);
+
+    const size_t previousCount = cache.entries.size();
+    const bool appendsInOrder = previousCount == 0 || parsed.empty()
+        || !kByTimestamp(parsed.front(), cache.entries.back());
+    cache.entries.insert(cache.entries.end(),
+                         std::make_move_iterator(parsed.begin()),
+                         std::make_move_iterator(parsed.end()));
+
+    if (!appendsInOrder)
+    {
+        // Late (out-of-order) records shift ids and deltas, so snapshots are rebuilt from the
+        // cached summaries.
+        std::inplace_merge(cache.entries.begin(),
+                           cache.entries.begin() + static_cast<std::ptrdiff_t>(previousCount),
+                           cache.entries.end(),
+                           kByTimestamp);
+        ++cache.epoch;
+    }
+    snapshot = PublishSnapshot(cache);
+
+    size_t skipped = cache.skipped;
+    std::string firstParseError = cache.firstParseError;
+    for (const SealedSegment& segment : cache.sealed)
+    {
+        skipped += segment.skipped;
+        if (firstParseError.empty())
+        {
+            firstParseError = segment.firstParseError;
+        }
+    }
     if (skipped > 0 && error.empty())
     {
         std::ostringstream oss;
@@ -322,6 +1218,22 @@ bool LocalDataStore::LoadHistory(HistorySnapshot& snapshot, std::string& error)
     return true;
 }
 
+bool LocalDataStore::LoadHistory(HistorySnapshot& snapshot, std::string& error) const
+{
+    std::shared_ptr<const HistorySnapshot> shared;
+    if (!LoadHistory(shared, error))
+    {
+        return false;
+    }
+    snapshot = *shared;
+    snapshot.status.receivedAt = ToEpochSeconds(std::chrono::system_clock::now());
+    if (snapshot.mmrHistory.empty())
+    {
+        snapshot.status.generatedAt = snapshot.status.receivedAt;
+    }
+    return true;
+}
+
 bool LocalDataStore::ReplayLegacyCache(std::string& error)
 {
     error.clear();
@@ -374,33 +1286,255 @@ bool LocalDataStore::ReplayLegacyCache(std::string& error)
     return true;
 }
 
-bool LocalDataStore::AppendLines(const std::vector<std::string>& payloads, std::string& error)
+struct LocalDataStore::CommitGroup
+{
+    struct Member
+    {
+        size_t position{0};                        // of the member's first line in `bytes`
+        AppendVerification* verification{nullptr}; // record offsets relative to `position`
+        bool ok{false};
+        std::string error;
+    };
+
+    std::string bytes;
+    std::vector<Member> members;
+    size_t payloads{0};
+    bool writeThrough{false}; // a member verifies, so the bytes must reach the file
+    bool done{false};
+};
+
+bool LocalDataStore::AppendLines(const std::vector<std::string>& payloads,
+                                 std::string& error,
+                                 AppendVerification* verification)
 {
     error.clear();
+
+    // Checksums are taken before joining a group, so the commit lock only covers a copy.
+    size_t bytes = 0;
+    if (verification)
+    {
+        verification->ok = false;
+        verification->records.clear();
+        verification->records.reserve(payloads.size());
+    }
+    for (const auto& payload : payloads)
+    {
+        if (verification)
+        {
+            RecordVerification record;
+            record.offset = bytes;
+            record.length = static_cast<uint32_t>(payload.size() + 1);
+            record.crc = Crc32("\n", 1, Crc32(payload.data(), payload.size()));
+            verification->records.push_back(record);
+        }
+        bytes += payload.size() + 1;
+    }
+
+    // Group commit: callers add their lines to the open group, and the first one to find no
+    // commit in progress writes the whole group while the others wait for its result.
+    std::unique_lock<std::mutex> lock(commitMutex_);
+    if (!openGroup_)
+    {
+        openGroup_ = std::make_shared<CommitGroup>();
+    }
+    const std::shared_ptr<CommitGroup> group = openGroup_;
+    const size_t member = group->members.size();
+    CommitGroup::Member entry;
+    entry.position = group->bytes.size();
+    entry.verification = verification;
+    group->members.push_back(entry);
+    group->payloads += payloads.size();
+    group->writeThrough = group->writeThrough || verification != nullptr;
+    group->bytes.reserve(group->bytes.size() + bytes);
+    for (const auto& payload : payloads)
+    {
+        group->bytes += payload;
+        group->bytes.push_back('\n');
+    }
+
+    commitCv_.wait(lock, [this, &group]() { return group->done || !committing_; });
+    if (!group->done)
+    {
+        committing_ = true;
+        openGroup_.reset();
+        lock.unlock();
+        WriteGroup(*group);
+        lock.lock();
+        group->done = true;
+        committing_ = false;
+        commitCv_.notify_all();
+    }
+
+    error = group->members[member].error;
+    return group->members[member].ok;
+}
+
+void LocalDataStore::WriteGroup(CommitGroup& group)
+{
     std::lock_guard<std::mutex> lock(fileMutex_);
 
+    // Rotation is decided on the size the handle tracks, so appends never stat the store.
+    std::string error;
+    bool ok = OpenStoreFile(error) && RotateIfNeeded(error) && OpenStoreFile(error);
+    const uint64_t startOffset = storeFile_.Size() + pending_.size();
+    if (ok)
+    {
+        const bool buffered = durability_ == StoreFile::Durability::Buffered && !group.writeThrough;
+        if (pending_.empty() && !buffered)
+        {
+            ok = WriteStore(group.bytes, error);
+        }
+        else
+        {
+            pending_ += group.bytes;
+            ok = (buffered && pending_.size() < kBufferedBytes) || WritePending(error);
+        }
+        if (ok && durability_ == StoreFile::Durability::Fsync)
+        {
+            ++appendStats_.syncs;
+            ok = storeFile_.Sync(error) && journal_->Sync(error);
+        }
+    }
+    ++appendStats_.groups;
+    appendStats_.payloads += group.payloads;
+
+    for (CommitGroup::Member& member : group.members)
+    {
+        member.ok = ok;
+        if (!ok)
+        {
+            member.error = error;
+            continue;
+        }
+        if (member.verification)
+        {
+            for (RecordVerification& record : member.verification->records)
+            {
+                record.offset += startOffset + member.position;
+            }
+            member.ok = VerifyAppendedLines(*member.verification, member.error);
+        }
+    }
+}
+
+bool LocalDataStore::OpenStoreFile(std::string& error) const
+{
+    if (storeFile_.IsOpen())
+    {
+        return true;
+    }
     std::error_code ec;
     std::filesystem::create_directories(storePath_.parent_path(), ec);
-
-    if (!RotateIfNeeded(error))
+    if (tornTail_ && std::filesystem::exists(storePath_, ec))
     {
+        // Nothing is appended after a torn write until it is cut off; on Windows that can
+        // fail while a load still has the store mapped.
+        std::filesystem::resize_file(storePath_, tornOffset_, ec);
+        if (ec)
+        {
+            error = std::string("Failed to cut a torn append from ") + storePath_.string() + ": " + ec.message();
+            return false;
+        }
+    }
+    tornTail_ = false;
+    if (!storeFile_.Open(storePath_, error))
+    {
+        error = std::string("Failed to open local store at ") + storePath_.string() + ": " + error;
         return false;
     }
 
-    std::ofstream output(storePath_, std::ios::out | std::ios::app);
-    if (!output.is_open())
+    std::string journalError;
+    if (!journal_->Open(storeFile_.Size(), journalError))
     {
-        error = std::string("Failed to open local store at ") + storePath_.string();
+        DiagnosticLogger::Log(std::string("LocalDataStore: appending without a journal: ") + journalError);
+        journal_->Discard();
+    }
+    return true;
+}
+
+bool LocalDataStore::WritePending(std::string& error) const
+{
+    if (pending_.empty())
+    {
+        return true;
+    }
+    // A failed write is not retried (that could duplicate lines), so the buffer is dropped.
+    const bool ok = WriteStore(pending_, error);
+    pending_.clear();
+    return ok;
+}
+
+bool LocalDataStore::WriteStore(std::string_view bytes, std::string& error) const
+{
+    const uint64_t offset = storeFile_.Size();
+    ++appendStats_.writes;
+    if (!storeFile_.Write(bytes, error))
+    {
+        // Part of `bytes` may have landed. It is cut off now if possible, otherwise by
+        // OpenStoreFile before the next append, and readers stop at `offset` meanwhile.
+        storeFile_.Close();
+        journal_->Close();
+        std::error_code ec;
+        std::filesystem::resize_file(storePath_, offset, ec);
+        tornTail_ = static_cast<bool>(ec);
+        tornOffset_ = offset;
         return false;
     }
 
-    for (const auto& payload : payloads)
+    // The frames commit the lines. Should they fail, the journal goes: recovery would take
+    // unframed lines for torn ones.
+    std::string journalError;
+    if (journal_->IsOpen() && !journal_->Append(bytes, offset, journalError))
     {
-        output << payload << "\n";
+        DiagnosticLogger::Log(std::string("LocalDataStore: appending without a journal: ") + journalError);
+        journal_->Discard();
     }
     return true;
 }
 
+bool LocalDataStore::VerifyAppendedLines(AppendVerification& verification, std::string& error) const
+{
+    verification.ok = false;
+    if (verification.records.empty())
+    {
+        verification.ok = true;
+        return true;
+    }
+
+    std::ifstream input(storePath_, std::ios::in | std::ios::binary);
+    if (!input.is_open())
+    {
+        error = std::string("Verification failed: could not reopen ") + storePath_.string();
+        return false;
+    }
+
+    const RecordVerification& last = verification.records.back();
+    const uint64_t start = verification.records.front().offset;
+    const uint64_t length = last.offset + last.length - start;
+    std::string written(static_cast<size_t>(length), '\0');
+    input.seekg(static_cast<std::streamoff>(start), std::ios::beg);
+    input.read(written.data(), static_cast<std::streamsize>(length));
+    const uint64_t readBytes = static_cast<uint64_t>(input.gcount());
+
+    size_t failures = 0;
+    for (size_t i = 0; i < verification.records.size(); ++i)
+    {
+        RecordVerification& record = verification.records[i];
+        const uint64_t relative = record.offset - start;
+        record.ok = relative + record.length <= readBytes
+            && Crc32(written.data() + relative, record.length) == record.crc;
+        if (!record.ok && failures++ == 0)
+        {
+            error = "Verification failed: record " + std::to_string(i) + " at offset " +
+                    std::to_string(record.offset) + " does not match its checksum";
+            DiagnosticLogger::Log(std::string("LocalDataStore: ") + error + " in " + storePath_.string());
+        }
+    }
+
+    verification.ok = failures == 0;
+    return verification.ok;
+}
+
 void LocalDataStore::SetLimits(uint64_t maxBytes, int maxFiles)
 {
     maxBytes_ = maxBytes;
@@ -414,43 +1548,49 @@ bool LocalDataStore::RotateIfNeeded(std::string& error)
         return true;
     }
 
-    std::error_code ec;
-    const uint64_t size = std::filesystem::exists(storePath_, ec)
-        ? static_cast<uint64_t>(std::filesystem::file_size(storePath_, ec))
-        : 0;
-    if (ec)
+    // Callers hold fileMutex_ and have the store open; the size includes buffered appends.
+    if (storeFile_.Size() + pending_.size() < maxBytes_)
     {
-        error = std::string("Failed to inspect local store: ") + ec.message();
-        return false;
+        return true;
     }
-    if (size < maxBytes_)
+    if (!WritePending(error))
     {
-        return true;
+        return false;
     }
+    storeFile_.Close();
+    journal_->Close();
 
-    // simple rotation: store -> .1 -> .2 ...
+    std::error_code ec;
+    // simple rotation: store -> .1 -> .2 ...; each segment, plain or compressed, takes its
+    // index sidecars along so sealed segments load without parsing JSON.
+    std::string indexError;
     const int maxRotation = std::max(1, maxFiles_ - 1);
     for (int i = maxRotation; i >= 1; --i)
     {
-        const std::filesystem::path older = std::filesystem::path(storePath_.string() + "." + std::to_string(i));
-        const std::filesystem::path newer = std::filesystem::path(storePath_.string() + "." + std::to_string(i + 1));
-        std::filesystem::remove(newer, ec);
-        ec.clear();
-        if (std::filesystem::exists(older, ec))
+        const std::filesystem::path older = SegmentPath(storePath_, i);
+        const std::filesystem::path newer = SegmentPath(storePath_, i + 1);
+        RemoveSegment(newer);
+        if (MoveSegment(older, newer, ec) && !HistoryIndex::RenameSidecars(older, newer, indexError))
         {
-            ec.clear();
-            std::filesystem::rename(older, newer, ec);
+            DiagnosticLogger::Log(std::string("LocalDataStore::RotateIfNeeded: ") + indexError);
         }
+        ec.clear();
     }
 
-    const std::filesystem::path first = std::filesystem::path(storePath_.string() + ".1");
-    std::filesystem::remove(first, ec);
-    ec.clear();
+    const std::filesystem::path first = SegmentPath(storePath_, 1);
+    RemoveSegment(first);
     std::filesystem::rename(storePath_, first, ec);
     if (ec)
     {
         error = std::string("Failed to rotate local store: ") + ec.message();
         return false;
     }
+    if (!HistoryIndex::RenameSidecars(storePath_, first, indexError))
+    {
+        DiagnosticLogger::Log(std::string("LocalDataStore::RotateIfNeeded: ") + indexError);
+    }
+    // A sealed segment is complete; the journal restarts with the new store.
+    journal_->Discard();
+    ++storeGeneration_;
     return true;
 }
@@ -0,0 +1,204 @@
+// Lz4Block.cpp
+#include "pch.h"
+#include "storage/Lz4Block.h"
+
+#include <cstdint>
+#include <cstring>
+
+namespace
+{
+    constexpr size_t kMinMatch = 4;
+    constexpr size_t kLastLiterals = 5;  // the format requires the block to end in literals
+    constexpr size_t kMatchStartLimit = 12; // no match may start in the last 12 bytes
+    constexpr size_t kMaxOffset = 65535;
+    constexpr int kHashBits = 12;
+
+    uint32_t Read32(const uint8_t* p)
+    {
+        uint32_t value;
+        std::memcpy(&value, p, sizeof(value));
+        return value;
+    }
+
+    uint32_t Hash(uint32_t sequence)
+    {
+        return (sequence * 2654435761u) >> (32 - kHashBits);
+    }
+
+    uint8_t* WriteLength(uint8_t* out, size_t length)
+    {
+        while (length >= 255)
+        {
+            *out++ = 255;
+            length -= 255;
+        }
+        *out++ = static_cast<uint8_t>(length);
+        return out;
+    }
+
+    // One sequence: literals, then (unless this is the last sequence) a match.
+    uint8_t* WriteSequence(uint8_t* out,
+                           const uint8_t* literals,
+                           size_t literalLength,
+                           size_t offset,
+                           size_t matchLength)
+    {
+        uint8_t* token = out++;
+        *token = static_cast<uint8_t>((literalLength < 15 ? literalLength : 15) << 4);
+        if (literalLength >= 15)
+        {
+            out = WriteLength(out, literalLength - 15);
+        }
+        std::memcpy(out, literals, literalLength);
+        out += literalLength;
+        if (matchLength == 0)
+        {
+            return out;
+        }
+
+        *out++ = static_cast<uint8_t>(offset & 0xFF);
+        *out++ = static_cast<uint8_t>(offset >> 8);
+        const size_t extra = matchLength - kMinMatch;
+        *token |= static_cast<uint8_t>(extra < 15 ? extra : 15);
+        if (extra >= 15)
+        {
+            out = WriteLength(out, extra - 15);
+        }
+        return out;
+    }
+
+    // Reads a continued length (255, 255, ..., n). False when it runs past the input.
+    bool ReadLength(const uint8_t*& in, const uint8_t* end, size_t& length)
+    {
+        uint8_t byte = 255;
+        while (byte == 255)
+        {
+            if (in >= end)
+            {
+                return false;
+            }
+            byte = *in++;
+            length += byte;
+        }
+        return true;
+    }
+}
+
+size_t Lz4Block::CompressBound(size_t size)
+{
+    return size + size / 255 + 16;
+}
+
+size_t Lz4Block::Compress(const char* source, size_t size, char* dest, size_t capacity)
+{
+    if (capacity < CompressBound(size))
+    {
+        return 0;
+    }
+
+    const uint8_t* src = reinterpret_cast<const uint8_t*>(source);
+    uint8_t* out = reinterpret_cast<uint8_t*>(dest);
+    size_t anchor = 0;
+
+    if (size > kMatchStartLimit)
+    {
+        uint32_t table[1u << kHashBits] = {};
+        const size_t matchStartLimit = size - kMatchStartLimit;
+        const size_t matchEndLimit = size - kLastLiterals;
+        size_t pos = 0;
+        while (pos < matchStartLimit)
+        {
+            const uint32_t sequence = Read32(src + pos);
+            uint32_t& slot = table[Hash(sequence)];
+            const size_t candidate = slot;
+            slot = static_cast<uint32_t>(pos);
+            if (candidate >= pos || pos - candidate > kMaxOffset || Read32(src + candidate) != sequence)
+            {
+                // Step faster through data that keeps failing to match.
+                pos += 1 + ((pos - anchor) >> 6);
+                continue;
+            }
+
+            size_t matchLength = kMinMatch;
+            while (pos + matchLength < matchEndLimit && src[candidate + matchLength] == src[pos + matchLength])
+            {
+                ++matchLength;
+            }
+            out = WriteSequence(out, src + anchor, pos - anchor, pos - candidate, matchLength);
+            pos += matchLength;
+            anchor = pos;
+        }
+    }
+
+    out = WriteSequence(out, src + anchor, size - anchor, 0, 0);
+    return static_cast<size_t>(out - reinterpret_cast<uint8_t*>(dest));
+}
+
+bool Lz4Block::Decompress(const char* source, size_t size, char* dest, size_t destSize)
+{
+    const uint8_t* in = reinterpret_cast<const uint8_t*>(source);
+    const uint8_t* const inEnd = in + size;
+    uint8_t* const outBegin = reinterpret_cast<uint8_t*>(dest);
+    uint8_t* out = outBegin;
+    uint8_t* const outEnd = out + destSize;
+
+    while (in < inEnd)
+    {
+        const uint8_t token = *in++;
+
+        size_t literalLength = token >> 4;
+        if (literalLength == 15 && !ReadLength(in, inEnd, literalLength))
+        {
+            return false;
+        }
+        if (literalLength > static_cast<size_t>(inEnd - in) || literalLength > static_cast<size_t>(outEnd - out))
+        {
+            return false;
+        }
+        std::memcpy(out, in, literalLength);
+        in += literalLength;
+        out += literalLength;
+        if (in == inEnd)
+        {
+            break; // the last sequence has no match
+        }
+
+        if (inEnd - in < 2)
+        {
+            return false;
+        }
+        const size_t offset = static_cast<size_t>(in[0]) | (static_cast<size_t>(in[1]) << 8);
+        in += 2;
+        if (offset == 0 || offset > static_cast<size_t>(out - outBegin))
+        {
+            return false;
+        }
+
+        size_t matchLength = token & 15;
+        if (matchLength == 15 && !ReadLength(in, inEnd, matchLength))
+        {
+            return false;
+        }
+        matchLength += kMinMatch;
+        if (matchLength > static_cast<size_t>(outEnd - out))
+        {
+            return false;
+        }
+
+        // Overlapping copies (offset < length) repeat the last `offset` bytes.
+        const uint8_t* match = out - offset;
+        if (offset >= matchLength)
+        {
+            std::memcpy(out, match, matchLength);
+            out += matchLength;
+        }
+        else
+        {
+            for (size_t i = 0; i < matchLength; ++i)
+            {
+                *out++ = *match++;
+            }
+        }
+    }
+    return out == outEnd;
+}
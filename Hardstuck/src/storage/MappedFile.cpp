@@ -0,0 +1,138 @@
+// MappedFile.cpp
+#include "pch.h"
+#include "storage/MappedFile.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::~MappedFile()
+{
+    Close();
+}
+
+bool MappedFile::Open(const std::filesystem::path& path, std::string& error)
+{
+    Close();
+
+#ifdef _WIN32
+    HANDLE file = CreateFileW(path.wstring().c_str(),
+                              GENERIC_READ,
+                              FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                              nullptr,
+                              OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN,
+                              nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        error = std::string("Failed to open ") + path.string() + ": " + std::to_string(GetLastError());
+        return false;
+    }
+
+    LARGE_INTEGER fileSize{};
+    if (!GetFileSizeEx(file, &fileSize))
+    {
+        error = std::string("Failed to size ") + path.string() + ": " + std::to_string(GetLastError());
+        CloseHandle(file);
+        return false;
+    }
+
+    fileHandle_ = file;
+    open_ = true;
+    if (fileSize.QuadPart == 0)
+    {
+        return true;
+    }
+
+    HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mapping)
+    {
+        error = std::string("Failed to map ") + path.string() + ": " + std::to_string(GetLastError());
+        Close();
+        return false;
+    }
+    mappingHandle_ = mapping;
+
+    const void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!view)
+    {
+        error = std::string("Failed to map view of ") + path.string() + ": " + std::to_string(GetLastError());
+        Close();
+        return false;
+    }
+    data_ = static_cast<const char*>(view);
+    size_ = static_cast<size_t>(fileSize.QuadPart);
+    return true;
+#else
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        error = std::string("Failed to open ") + path.string();
+        return false;
+    }
+
+    struct stat info{};
+    if (::fstat(fd, &info) != 0)
+    {
+        error = std::string("Failed to size ") + path.string();
+        ::close(fd);
+        return false;
+    }
+
+    fd_ = fd;
+    open_ = true;
+    if (info.st_size == 0)
+    {
+        return true;
+    }
+
+    void* view = ::mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_SHARED, fd, 0);
+    if (view == MAP_FAILED)
+    {
+        error = std::string("Failed to map ") + path.string();
+        Close();
+        return false;
+    }
+    data_ = static_cast<const char*>(view);
+    size_ = static_cast<size_t>(info.st_size);
+    return true;
+#endif
+}
+
+void MappedFile::Close()
+{
+#ifdef _WIN32
+    if (data_)
+    {
+        UnmapViewOfFile(data_);
+    }
+    if (mappingHandle_)
+    {
+        CloseHandle(static_cast<HANDLE>(mappingHandle_));
+    }
+    if (fileHandle_)
+    {
+        CloseHandle(static_cast<HANDLE>(fileHandle_));
+    }
+    mappingHandle_ = nullptr;
+    fileHandle_ = nullptr;
+#else
+    if (data_)
+    {
+        ::munmap(const_cast<char*>(data_), size_);
+    }
+    if (fd_ >= 0)
+    {
+        ::close(fd_);
+    }
+    fd_ = -1;
+#endif
+    data_ = nullptr;
+    size_ = 0;
+    open_ = false;
+}
@@ -0,0 +1,251 @@
+// SegmentArchive.cpp
+#include "pch.h"
+#include "storage/SegmentArchive.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <fstream>
+#include <system_error>
+
+#include "storage/Lz4Block.h"
+#include "utils/HsUtils.h"
+
+namespace
+{
+    constexpr size_t kBlockBytes = 64 * 1024;
+    constexpr size_t kMaxHeadLength = 64 * 1024; // same limit HistoryIndex uses
+
+    // End of the block starting at `start`: the last line boundary within kBlockBytes, or the
+    // end of the first line when that line alone is longer.
+    size_t BlockEnd(std::string_view data, size_t start)
+    {
+        if (data.size() - start <= kBlockBytes)
+        {
+            return data.size();
+        }
+        const size_t newline = data.rfind('\n', start + kBlockBytes - 1);
+        if (newline != std::string_view::npos && newline >= start)
+        {
+            return newline + 1;
+        }
+        const size_t next = data.find('\n', start + kBlockBytes);
+        return next == std::string_view::npos ? data.size() : next + 1;
+    }
+}
+
+bool SegmentArchive::Write(std::string_view data,
+                           const std::vector<LineTime>& lineTimes,
+                           const std::filesystem::path& target,
+                           std::string& error)
+{
+    const std::filesystem::path temporary(target.string() + ".tmp");
+    std::ofstream output(temporary, std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!output.is_open())
+    {
+        error = std::string("Failed to create segment archive at ") + temporary.string();
+        return false;
+    }
+
+    Header header;
+    header.rawBytes = data.size();
+    const size_t headEnd = data.find('\n');
+    if (headEnd != std::string_view::npos && headEnd < kMaxHeadLength)
+    {
+        header.headLength = static_cast<uint32_t>(headEnd + 1);
+        header.headCrc = Crc32(data.data(), headEnd + 1);
+    }
+    output.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+
+    std::vector<BlockInfo> blocks;
+    std::string compressed;
+    uint64_t fileOffset = sizeof(Header);
+    auto time = lineTimes.begin();
+    for (size_t start = 0; start < data.size();)
+    {
+        const size_t end = BlockEnd(data, start);
+        BlockInfo block;
+        block.rawOffset = start;
+        block.fileOffset = fileOffset;
+        block.rawSize = static_cast<uint32_t>(end - start);
+        block.rawCrc = Crc32(data.data() + start, end - start);
+        for (; time != lineTimes.end() && time->offset < end; ++time)
+        {
+            if (time->offset < start || time->timestamp == 0)
+            {
+                continue;
+            }
+            if (block.minTimestamp == 0 || time->timestamp < block.minTimestamp)
+            {
+                block.minTimestamp = time->timestamp;
+            }
+            block.maxTimestamp = (std::max)(block.maxTimestamp, time->timestamp);
+        }
+
+        compressed.resize(Lz4Block::CompressBound(end - start));
+        const size_t size = Lz4Block::Compress(data.data() + start, end - start, compressed.data(), compressed.size());
+        if (size > 0 && size < block.rawSize)
+        {
+            block.storedSize = static_cast<uint32_t>(size);
+            output.write(compressed.data(), static_cast<std::streamsize>(size));
+        }
+        else
+        {
+            block.storedSize = block.rawSize;
+            output.write(data.data() + start, static_cast<std::streamsize>(block.rawSize));
+        }
+        fileOffset += block.storedSize;
+        blocks.push_back(block);
+        start = end;
+    }
+
+    const size_t indexBytes = blocks.size() * sizeof(BlockInfo);
+    output.write(reinterpret_cast<const char*>(blocks.data()), static_cast<std::streamsize>(indexBytes));
+    header.indexOffset = fileOffset;
+    header.blockCount = static_cast<uint32_t>(blocks.size());
+    header.indexCrc = Crc32(blocks.data(), indexBytes);
+    header.headerCrc = HeaderCrc(header);
+    output.seekp(0, std::ios::beg);
+    output.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+    output.close();
+
+    std::error_code ec;
+    if (!output)
+    {
+        error = std::string("Failed to write segment archive at ") + temporary.string();
+        std::filesystem::remove(temporary, ec);
+        return false;
+    }
+    std::filesystem::rename(temporary, target, ec);
+    if (ec)
+    {
+        error = std::string("Failed to publish segment archive ") + target.string() + ": " + ec.message();
+        std::filesystem::remove(temporary, ec);
+        return false;
+    }
+    return true;
+}
+
+bool SegmentArchive::Open(const std::filesystem::path& path, std::string& error)
+{
+    Close();
+    if (!mapping_.Open(path, error))
+    {
+        return false;
+    }
+
+    Header header;
+    if (mapping_.Size() < sizeof(Header))
+    {
+        error = "Segment archive header truncated";
+        Close();
+        return false;
+    }
+    std::memcpy(&header, mapping_.Data(), sizeof(Header));
+    if (std::memcmp(header.magic, Header().magic, sizeof(header.magic)) != 0
+        || header.version != Header().version
+        || header.headerCrc != HeaderCrc(header))
+    {
+        error = "Segment archive header checksum mismatch";
+        Close();
+        return false;
+    }
+
+    const uint64_t indexBytes = static_cast<uint64_t>(header.blockCount) * sizeof(BlockInfo);
+    if (header.indexOffset < sizeof(Header) || header.indexOffset > mapping_.Size()
+        || mapping_.Size() - header.indexOffset < indexBytes)
+    {
+        error = "Segment archive index truncated";
+        Close();
+        return false;
+    }
+    const char* index = mapping_.Data() + header.indexOffset;
+    if (Crc32(index, static_cast<size_t>(indexBytes)) != header.indexCrc)
+    {
+        error = "Segment archive index checksum mismatch";
+        Close();
+        return false;
+    }
+
+    blocks_.resize(header.blockCount);
+    std::memcpy(blocks_.data(), index, static_cast<size_t>(indexBytes));
+    for (const BlockInfo& block : blocks_)
+    {
+        if (block.fileOffset < sizeof(Header) || block.fileOffset > header.indexOffset
+            || header.indexOffset - block.fileOffset < block.storedSize
+            || block.rawOffset + block.rawSize > header.rawBytes)
+        {
+            error = "Segment archive block out of range";
+            Close();
+            return false;
+        }
+    }
+    header_ = header;
+    return true;
+}
+
+void SegmentArchive::Close()
+{
+    mapping_.Close();
+    header_ = Header();
+    blocks_.clear();
+}
+
+bool SegmentArchive::ReadBlock(size_t index, std::string& out, std::string& error) const
+{
+    if (index >= blocks_.size())
+    {
+        error = "Segment archive block index out of range";
+        return false;
+    }
+    const BlockInfo& block = blocks_[index];
+    const char* stored = mapping_.Data() + block.fileOffset;
+    const size_t start = out.size();
+    out.resize(start + block.rawSize);
+    const bool decoded = block.storedSize == block.rawSize
+        ? (std::memcpy(out.data() + start, stored, block.rawSize), true)
+        : Lz4Block::Decompress(stored, block.storedSize, out.data() + start, block.rawSize);
+    if (!decoded || Crc32(out.data() + start, block.rawSize) != block.rawCrc)
+    {
+        out.resize(start);
+        error = "Segment archive block " + std::to_string(index) + " is corrupt";
+        return false;
+    }
+    return true;
+}
+
+bool SegmentArchive::ReadAll(std::string& out, std::string& error) const
+{
+    out.reserve(out.size() + static_cast<size_t>(header_.rawBytes));
+    for (size_t i = 0; i < blocks_.size(); ++i)
+    {
+        if (!ReadBlock(i, out, error))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool SegmentArchive::ReadRange(int64_t from, int64_t to, std::string& out, std::string& error) const
+{
+    for (size_t i = 0; i < blocks_.size(); ++i)
+    {
+        const BlockInfo& block = blocks_[i];
+        const bool timed = block.minTimestamp != 0 || block.maxTimestamp != 0;
+        if (timed && (block.maxTimestamp < from || block.minTimestamp > to))
+        {
+            continue;
+        }
+        if (!ReadBlock(i, out, error))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+uint32_t SegmentArchive::HeaderCrc(const Header& header)
+{
+    return Crc32(&header, offsetof(Header, headerCrc));
+}
@@ -0,0 +1,220 @@
+// StoreFile.cpp
+#include "pch.h"
+#include "storage/StoreFile.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstring>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+bool StoreFile::ParseDurability(std::string_view text, Durability& durability)
+{
+    if (text == "buffered")
+    {
+        durability = Durability::Buffered;
+        return true;
+    }
+    if (text == "flush")
+    {
+        durability = Durability::Flush;
+        return true;
+    }
+    if (text == "fsync")
+    {
+        durability = Durability::Fsync;
+        return true;
+    }
+    return false;
+}
+
+const char* StoreFile::DurabilityName(Durability durability)
+{
+    switch (durability)
+    {
+    case Durability::Buffered: return "buffered";
+    case Durability::Flush: return "flush";
+    case Durability::Fsync: return "fsync";
+    }
+    return "flush";
+}
+
+bool StoreFile::Sync(const std::filesystem::path& path, std::string& error)
+{
+#ifdef _WIN32
+    HANDLE file = CreateFileW(path.wstring().c_str(),
+                              GENERIC_WRITE,
+                              FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                              nullptr,
+                              OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL,
+                              nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        error = std::string("Failed to open ") + path.string() + " for sync: " + std::to_string(GetLastError());
+        return false;
+    }
+    const BOOL flushed = FlushFileBuffers(file);
+    const DWORD flushError = flushed ? 0 : GetLastError();
+    CloseHandle(file);
+    if (!flushed)
+    {
+        error = std::string("FlushFileBuffers failed for ") + path.string() + ": " + std::to_string(flushError);
+        return false;
+    }
+    return true;
+#else
+    const int fd = ::open(path.c_str(), O_WRONLY);
+    if (fd < 0)
+    {
+        error = std::string("Failed to open ") + path.string() + " for sync";
+        return false;
+    }
+    const int result = ::fsync(fd);
+    ::close(fd);
+    if (result != 0)
+    {
+        error = std::string("fsync failed for ") + path.string();
+        return false;
+    }
+    return true;
+#endif
+}
+
+StoreFile::AppendHandle::~AppendHandle()
+{
+    Close();
+}
+
+bool StoreFile::AppendHandle::Open(const std::filesystem::path& path, std::string& error)
+{
+    Close();
+
+#ifdef _WIN32
+    // FILE_APPEND_DATA without FILE_WRITE_DATA: every write lands at the current end.
+    HANDLE file = CreateFileW(path.wstring().c_str(),
+                              FILE_APPEND_DATA | SYNCHRONIZE,
+                              FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                              nullptr,
+                              OPEN_ALWAYS,
+                              FILE_ATTRIBUTE_NORMAL,
+                              nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        error = std::string("Failed to open ") + path.string() + " for append: " + std::to_string(GetLastError());
+        return false;
+    }
+    LARGE_INTEGER fileSize{};
+    if (!GetFileSizeEx(file, &fileSize))
+    {
+        error = std::string("Failed to size ") + path.string() + ": " + std::to_string(GetLastError());
+        CloseHandle(file);
+        return false;
+    }
+    handle_ = file;
+    size_ = static_cast<uint64_t>(fileSize.QuadPart);
+#else
+    const int fd = ::open(path.c_str(), O_WRONLY | O_APPEND | O_CREAT | O_CLOEXEC, 0644);
+    if (fd < 0)
+    {
+        error = std::string("Failed to open ") + path.string() + " for append: " + std::strerror(errno);
+        return false;
+    }
+    struct stat info{};
+    if (::fstat(fd, &info) != 0)
+    {
+        error = std::string("Failed to size ") + path.string();
+        ::close(fd);
+        return false;
+    }
+    fd_ = fd;
+    size_ = static_cast<uint64_t>(info.st_size);
+#endif
+    path_ = path;
+    open_ = true;
+    return true;
+}
+
+void StoreFile::AppendHandle::Close()
+{
+#ifdef _WIN32
+    if (handle_)
+    {
+        CloseHandle(static_cast<HANDLE>(handle_));
+    }
+    handle_ = nullptr;
+#else
+    if (fd_ >= 0)
+    {
+        ::close(fd_);
+    }
+    fd_ = -1;
+#endif
+    size_ = 0;
+    open_ = false;
+}
+
+bool StoreFile::AppendHandle::Write(std::string_view data, std::string& error)
+{
+    if (!open_)
+    {
+        error = "Store file is not open";
+        return false;
+    }
+
+    while (!data.empty())
+    {
+#ifdef _WIN32
+        const DWORD chunk = static_cast<DWORD>((std::min<size_t>)(data.size(), 0x40000000u));
+        DWORD written = 0;
+        if (!WriteFile(static_cast<HANDLE>(handle_), data.data(), chunk, &written, nullptr))
+        {
+            error = std::string("Failed to write ") + path_.string() + ": " + std::to_string(GetLastError());
+            return false;
+        }
+#else
+        const ssize_t written = ::write(fd_, data.data(), (std::min<size_t>)(data.size(), static_cast<size_t>(INT_MAX)));
+        if (written < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            error = std::string("Failed to write ") + path_.string() + ": " + std::strerror(errno);
+            return false;
+        }
+#endif
+        size_ += static_cast<uint64_t>(written);
+        data.remove_prefix(static_cast<size_t>(written));
+    }
+    return true;
+}
+
+bool StoreFile::AppendHandle::Sync(std::string& error)
+{
+    if (!open_)
+    {
+        return true;
+    }
+#ifdef _WIN32
+    if (!FlushFileBuffers(static_cast<HANDLE>(handle_)))
+    {
+        error = std::string("FlushFileBuffers failed for ") + path_.string() + ": " + std::to_string(GetLastError());
+        return false;
+    }
+#else
+    if (::fsync(fd_) != 0)
+    {
+        error = std::string("fsync failed for ") + path_.string();
+        return false;
+    }
+#endif
+    return true;
+}
@@ -0,0 +1,296 @@
+// StoreJournal.cpp
+#include "pch.h"
+#include "storage/StoreJournal.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <fstream>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include "history/JsonScan.h"
+#include "utils/HsUtils.h"
+
+namespace
+{
+    // Frames checked from the end of the journal before recovery stops trusting it. A torn
+    // append covers one commit group, which is far fewer lines than this.
+    constexpr uint64_t kMaxRecoveryFrames = 4096;
+    constexpr size_t kScanChunk = 64 * 1024;
+
+    uint32_t FrameCrc(const StoreJournal::Frame& frame)
+    {
+        return Crc32(&frame, offsetof(StoreJournal::Frame, frameCrc));
+    }
+
+    // True when `frame` is intact and the store holds exactly the line it describes.
+    bool FrameMatches(std::ifstream& store, uint64_t storeSize, const StoreJournal::Frame& frame, std::string& line)
+    {
+        if (frame.frameCrc != FrameCrc(frame) || frame.length == 0
+            || frame.offset > storeSize || storeSize - frame.offset < frame.length)
+        {
+            return false;
+        }
+        line.resize(frame.length);
+        store.clear();
+        store.seekg(static_cast<std::streamoff>(frame.offset), std::ios::beg);
+        return store.read(line.data(), static_cast<std::streamsize>(line.size()))
+            && line.back() == '\n'
+            && Crc32(line.data(), line.size()) == frame.crc;
+    }
+
+    // End of the last complete line within the first `size` bytes of the store. Reads
+    // backwards a chunk at a time, so only the partial line (if any) is read.
+    bool LastLineEnd(std::ifstream& store, uint64_t size, uint64_t& lineEnd)
+    {
+        std::string chunk;
+        for (uint64_t end = size; end > 0;)
+        {
+            const uint64_t start = end > kScanChunk ? end - kScanChunk : 0;
+            chunk.resize(static_cast<size_t>(end - start));
+            store.clear();
+            store.seekg(static_cast<std::streamoff>(start), std::ios::beg);
+            if (!store.read(chunk.data(), static_cast<std::streamsize>(chunk.size())))
+            {
+                return false;
+            }
+            const size_t newline = chunk.rfind('\n');
+            if (newline != std::string::npos)
+            {
+                lineEnd = start + newline + 1;
+                return true;
+            }
+            end = start;
+        }
+        lineEnd = 0;
+        return true;
+    }
+}
+
+StoreJournal::StoreJournal(std::filesystem::path storePath)
+    : storePath_(std::move(storePath))
+{
+    path_ = std::filesystem::path(storePath_.string() + ".journal");
+}
+
+bool StoreJournal::Recover(Recovery& recovery, std::string& error)
+{
+    recovery = Recovery();
+    Close();
+
+    std::error_code ec;
+    if (!std::filesystem::exists(storePath_, ec))
+    {
+        Discard(); // frames of a store that is gone
+        return true;
+    }
+    const uint64_t storeSize = static_cast<uint64_t>(std::filesystem::file_size(storePath_, ec));
+    std::ifstream store(storePath_, std::ios::in | std::ios::binary);
+    if (ec || !store.is_open())
+    {
+        error = std::string("Failed to open local store at ") + storePath_.string() + " for recovery";
+        return false;
+    }
+
+    // Walk back from the last frame to the first one whose line is intact in the store.
+    // Intact frames passed on the way describe appends that did not make it.
+    uint64_t committed = storeSize;
+    uint64_t journalSize = 0;
+    uint64_t frameCount = 0;
+    uint64_t keptFrames = 0;
+    bool journaled = false;
+    bool provenTorn = false;
+    {
+        std::ifstream journal(path_, std::ios::in | std::ios::binary);
+        Header header;
+        if (journal.is_open() && ReadHeader(journal, header) && header.baseOffset <= storeSize)
+        {
+            journalSize = static_cast<uint64_t>(std::filesystem::file_size(path_, ec));
+            frameCount = ec ? 0 : (journalSize - sizeof(Header)) / sizeof(Frame);
+            const uint64_t window = (std::min)(frameCount, kMaxRecoveryFrames);
+            std::vector<Frame> frames(static_cast<size_t>(window));
+            journal.seekg(static_cast<std::streamoff>(sizeof(Header) + (frameCount - window) * sizeof(Frame)), std::ios::beg);
+            if (!ec && journal.read(reinterpret_cast<char*>(frames.data()), static_cast<std::streamsize>(window * sizeof(Frame))))
+            {
+                std::string line;
+                for (uint64_t i = window; i > 0 && !journaled; --i)
+                {
+                    const Frame& frame = frames[static_cast<size_t>(i - 1)];
+                    if (frame.frameCrc != FrameCrc(frame))
+                    {
+                        continue; // a torn frame says nothing about the store
+                    }
+                    if (FrameMatches(store, storeSize, frame, line))
+                    {
+                        committed = frame.offset + frame.length;
+                        keptFrames = frameCount - window + i;
+                        journaled = true;
+                    }
+                    else
+                    {
+                        provenTorn = true;
+                    }
+                }
+            }
+        }
+    }
+
+    if (journaled)
+    {
+        const uint64_t keptBytes = sizeof(Header) + keptFrames * sizeof(Frame);
+        if (journalSize != keptBytes)
+        {
+            std::filesystem::resize_file(path_, keptBytes, ec);
+            if (ec)
+            {
+                error = std::string("Failed to cut store journal ") + path_.string() + ": " + ec.message();
+                return false;
+            }
+        }
+        recovery.droppedFrames = frameCount - keptFrames;
+    }
+    else
+    {
+        recovery.droppedFrames = frameCount;
+    }
+
+    // Complete lines with no trusted frame against them are kept (written by a build without
+    // a journal, or the journal is stale); only a partial final line goes.
+    if (!(journaled && provenTorn) && !LastLineEnd(store, storeSize, committed))
+    {
+        error = std::string("Failed to read the end of local store ") + storePath_.string();
+        return false;
+    }
+    if (!journaled && !Restart(committed, error))
+    {
+        return false;
+    }
+    store.close();
+
+    recovery.journaled = journaled;
+    recovery.storeBytes = committed;
+    if (committed < storeSize)
+    {
+        std::filesystem::resize_file(storePath_, committed, ec);
+        if (ec)
+        {
+            error = std::string("Failed to cut torn appends from ") + storePath_.string() + ": " + ec.message();
+            recovery.storeBytes = storeSize;
+            return false;
+        }
+        recovery.cutBytes = storeSize - committed;
+    }
+    return true;
+}
+
+bool StoreJournal::Open(uint64_t storeSize, std::string& error)
+{
+    if (file_.IsOpen())
+    {
+        return true;
+    }
+
+    // Keep the journal only if its last frame ends where the store does.
+    bool inStep = false;
+    {
+        std::ifstream input(path_, std::ios::in | std::ios::binary);
+        Header header;
+        std::error_code ec;
+        const uint64_t size = input.is_open() && ReadHeader(input, header)
+            ? static_cast<uint64_t>(std::filesystem::file_size(path_, ec))
+            : 0;
+        if (!ec && size >= sizeof(Header) && (size - sizeof(Header)) % sizeof(Frame) == 0)
+        {
+            uint64_t end = header.baseOffset;
+            bool intact = true;
+            if (size > sizeof(Header))
+            {
+                Frame last;
+                input.seekg(static_cast<std::streamoff>(size - sizeof(Frame)), std::ios::beg);
+                intact = input.read(reinterpret_cast<char*>(&last), sizeof(Frame)) && last.frameCrc == FrameCrc(last);
+                end = last.offset + last.length;
+            }
+            inStep = intact && end == storeSize;
+        }
+    }
+
+    if (!inStep && !Restart(storeSize, error))
+    {
+        return false;
+    }
+    if (!file_.Open(path_, error))
+    {
+        error = std::string("Failed to open store journal at ") + path_.string() + ": " + error;
+        return false;
+    }
+    return true;
+}
+
+void StoreJournal::Close()
+{
+    file_.Close();
+}
+
+bool StoreJournal::Append(std::string_view lines, uint64_t offset, std::string& error)
+{
+    std::string frames;
+    for (size_t start = 0; start < lines.size();)
+    {
+        const size_t newline = HistoryJson::Scan::FindNewline(lines, start);
+        if (newline >= lines.size())
+        {
+            break; // a line is only committed once its newline is written
+        }
+        Frame frame;
+        frame.offset = offset + start;
+        frame.length = static_cast<uint32_t>(newline + 1 - start);
+        frame.crc = Crc32(lines.data() + start, frame.length);
+        frame.frameCrc = FrameCrc(frame);
+        frames.append(reinterpret_cast<const char*>(&frame), sizeof(Frame));
+        start = newline + 1;
+    }
+    return frames.empty() || file_.Write(frames, error);
+}
+
+bool StoreJournal::Sync(std::string& error)
+{
+    return !file_.IsOpen() || file_.Sync(error);
+}
+
+void StoreJournal::Discard()
+{
+    file_.Close();
+    std::error_code ec;
+    std::filesystem::remove(path_, ec);
+}
+
+bool StoreJournal::Restart(uint64_t baseOffset, std::string& error)
+{
+    Header header;
+    header.baseOffset = baseOffset;
+    header.headerCrc = HeaderCrc(header);
+    std::ofstream output(path_, std::ios::out | std::ios::binary | std::ios::trunc);
+    output.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+    output.close();
+    if (!output)
+    {
+        error = std::string("Failed to start store journal at ") + path_.string();
+        return false;
+    }
+    return true;
+}
+
+bool StoreJournal::ReadHeader(std::ifstream& input, Header& header)
+{
+    return input.read(reinterpret_cast<char*>(&header), sizeof(Header))
+        && std::memcmp(header.magic, Header().magic, sizeof(header.magic)) == 0
+        && header.version == Header().version
+        && header.headerCrc == HeaderCrc(header);
+}
+
+uint32_t StoreJournal::HeaderCrc(const Header& header)
+{
+    return Crc32(&header, offsetof(Header, headerCrc));
+}
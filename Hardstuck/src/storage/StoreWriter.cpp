@@ -0,0 +1,184 @@
+// StoreWriter.cpp
+#include "pch.h"
+#include "storage/StoreWriter.h"
+
+#include "diagnostics/DiagnosticLogger.h"
+#include "storage/LocalDataStore.h"
+
+StoreWriter::StoreWriter(LocalDataStore& store, Options options, BatchCallback onBatch)
+    : store_(store)
+    , options_(options)
+    , onBatch_(std::move(onBatch))
+{
+    if (options_.capacity == 0)
+    {
+        options_.capacity = 1;
+    }
+    queue_.reserve(options_.capacity);
+    store_.SetDurability(options_.durability);
+    thread_ = std::thread([this]() { Run(); });
+}
+
+StoreWriter::~StoreWriter()
+{
+    Stop();
+}
+
+bool StoreWriter::Enqueue(std::string payload)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stopping_ || queue_.size() >= options_.capacity)
+        {
+            ++stats_.rejected;
+            return false;
+        }
+        queue_.push_back(std::move(payload));
+        stats_.queueDepth = queue_.size();
+        if (stats_.queueDepth > stats_.queueHighWater)
+        {
+            stats_.queueHighWater = stats_.queueDepth;
+        }
+    }
+    wakeCv_.notify_one();
+    return true;
+}
+
+void StoreWriter::Flush()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    wakeCv_.notify_one();
+    drainedCv_.wait(lock, [this]() { return queue_.empty() && !writing_; });
+}
+
+void StoreWriter::Stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    wakeCv_.notify_one();
+    if (thread_.joinable())
+    {
+        thread_.join();
+    }
+}
+
+StoreWriter::Stats StoreWriter::GetStats() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+void StoreWriter::Reconfigure(std::chrono::milliseconds syncInterval, StoreFile::Durability durability)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        options_.syncInterval = syncInterval;
+        options_.durability = durability;
+    }
+    store_.SetDurability(durability);
+    wakeCv_.notify_one();
+}
+
+void StoreWriter::Run()
+{
+    using Clock = std::chrono::steady_clock;
+
+    Clock::time_point lastSync = Clock::now();
+    bool unsynced = false;
+    std::vector<std::string> batch;
+    batch.reserve(options_.capacity);
+
+    for (;;)
+    {
+        std::chrono::milliseconds syncInterval{0};
+        StoreFile::Durability durability = StoreFile::Durability::Flush;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            const auto hasWork = [this]() { return stopping_ || !queue_.empty(); };
+            if (unsynced)
+            {
+                wakeCv_.wait_until(lock, lastSync + options_.syncInterval, hasWork);
+            }
+            else
+            {
+                wakeCv_.wait(lock, hasWork);
+            }
+
+            if (stopping_ && queue_.empty() && !unsynced)
+            {
+                break;
+            }
+            batch.swap(queue_);
+            stats_.queueDepth = 0;
+            writing_ = !batch.empty();
+            syncInterval = options_.syncInterval;
+            durability = options_.durability;
+        }
+
+        BatchResult result;
+        if (!batch.empty())
+        {
+            const auto started = Clock::now();
+            result.success = durability == StoreFile::Durability::Buffered
+                ? store_.AppendPayloads(batch, result.error)
+                : store_.AppendPayloadsWithVerification(batch, result.error);
+            result.latency = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - started);
+            unsynced = unsynced || result.success;
+        }
+
+        // Sync on cadence, and always before exiting so a clean unload is durable.
+        std::string syncError;
+        bool stopping = false;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping = stopping_;
+        }
+        if (unsynced && (stopping || Clock::now() - lastSync >= syncInterval))
+        {
+            if (!store_.Sync(syncError))
+            {
+                DiagnosticLogger::Log(std::string("StoreWriter: sync failed: ") + syncError);
+            }
+            lastSync = Clock::now();
+            unsynced = false;
+        }
+
+        if (!batch.empty())
+        {
+            result.payloads = std::move(batch);
+            if (onBatch_)
+            {
+                onBatch_(result);
+            }
+            batch.clear();
+            batch.reserve(options_.capacity);
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!result.payloads.empty())
+            {
+                ++stats_.batchesWritten;
+                if (result.success)
+                {
+                    stats_.payloadsWritten += result.payloads.size();
+                }
+                stats_.lastLatency = result.latency;
+                if (result.latency > stats_.maxLatency)
+                {
+                    stats_.maxLatency = result.latency;
+                }
+            }
+            if (!syncError.empty())
+            {
+                stats_.lastSyncError = syncError;
+            }
+            writing_ = false;
+        }
+        drainedCv_.notify_all();
+    }
+
+    drainedCv_.notify_all();
+}
@@ -0,0 +1,364 @@
+// UploadQueue.cpp
+#include "pch.h"
+#include "storage/UploadQueue.h"
+
+#include <charconv>
+#include <fstream>
+#include <system_error>
+
+#include "diagnostics/DiagnosticLogger.h"
+#include "utils/HsUtils.h"
+
+namespace
+{
+    constexpr char kQueueFileName[] = "outbound.queue";
+    constexpr char kAckFileName[] = "outbound.ack";
+    constexpr char kDeadLetterFileName[] = "outbound.dead";
+
+    // Compaction rewrites every pending record, so only do it once acked lines dominate
+    // the file and are worth reclaiming.
+    constexpr uint64_t kCompactMinDeadBytes = 64 * 1024;
+
+    uint64_t LineBytes(uint64_t sequence, const std::string& payload)
+    {
+        return std::to_string(sequence).size() + 1 + payload.size() + 1;
+    }
+
+    bool ParseSequence(const std::string& text, uint64_t& sequence)
+    {
+        const char* first = text.data();
+        const char* last = text.data() + text.size();
+        while (last > first && (last[-1] == '\n' || last[-1] == '\r' || last[-1] == ' '))
+        {
+            --last;
+        }
+        const auto result = std::from_chars(first, last, sequence);
+        return result.ec == std::errc() && result.ptr == last && first != last;
+    }
+
+    // Write to a sibling temp file and rename it into place, so readers see either the old
+    // file or the complete new one. With `sync`, the new contents reach stable storage first.
+    bool ReplaceFile(const std::filesystem::path& path, const std::string& contents, bool sync, std::string& error)
+    {
+        std::filesystem::path temp = path;
+        temp += ".tmp";
+        {
+            std::ofstream output(temp, std::ios::out | std::ios::binary | std::ios::trunc);
+            if (!output.is_open())
+            {
+                error = std::string("Failed to open ") + temp.string();
+                return false;
+            }
+            output.write(contents.data(), static_cast<std::streamsize>(contents.size()));
+            if (!output)
+            {
+                error = std::string("Failed to write ") + temp.string();
+                return false;
+            }
+        }
+        if (sync && !StoreFile::Sync(temp, error))
+        {
+            return false;
+        }
+
+        std::error_code ec;
+        std::filesystem::rename(temp, path, ec);
+        if (ec)
+        {
+            error = std::string("Failed to replace ") + path.string() + ": " + ec.message();
+            std::filesystem::remove(temp, ec);
+            return false;
+        }
+        return true;
+    }
+}
+
+UploadQueue::UploadQueue(std::filesystem::path directory)
+    : queuePath_(directory / kQueueFileName)
+    , ackPath_(directory / kAckFileName)
+    , deadLetterPath_(directory / kDeadLetterFileName)
+{
+}
+
+bool UploadQueue::Open(std::string& error)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    file_.Close();
+    tornTail_ = false;
+    pending_.clear();
+    pendingBytes_ = 0;
+    fileBytes_ = 0;
+    ackedSequence_ = 0;
+
+    std::error_code ec;
+    std::filesystem::create_directories(queuePath_.parent_path(), ec);
+
+    {
+        std::ifstream ack(ackPath_, std::ios::in | std::ios::binary);
+        std::string text;
+        if (ack.is_open() && std::getline(ack, text) && !ParseSequence(text, ackedSequence_))
+        {
+            DiagnosticLogger::Log("UploadQueue: ignoring unreadable ack file " + ackPath_.string());
+            ackedSequence_ = 0;
+        }
+    }
+    nextSequence_ = ackedSequence_ + 1;
+
+    bool dropped = false;
+    std::ifstream input(queuePath_, std::ios::in | std::ios::binary);
+    if (input.is_open())
+    {
+        std::string line;
+        while (std::getline(input, line))
+        {
+            const uint64_t consumed = line.size() + (input.eof() ? 0 : 1);
+            fileBytes_ += consumed;
+            if (input.eof())
+            {
+                // No trailing newline: the append was torn by a crash.
+                dropped = true;
+                break;
+            }
+
+            const size_t space = line.find(' ');
+            uint64_t sequence = 0;
+            if (space == std::string::npos || !ParseSequence(line.substr(0, space), sequence))
+            {
+                dropped = true;
+                continue;
+            }
+            nextSequence_ = (std::max)(nextSequence_, sequence + 1);
+            if (sequence <= ackedSequence_ || (!pending_.empty() && sequence <= pending_.back().record.sequence))
+            {
+                dropped = true;
+                continue;
+            }
+
+            Entry entry;
+            entry.record.sequence = sequence;
+            entry.record.payload = line.substr(space + 1);
+            entry.lineBytes = consumed;
+            pendingBytes_ += consumed;
+            pending_.push_back(std::move(entry));
+        }
+    }
+
+    if (dropped && !Compact(error))
+    {
+        return false;
+    }
+
+    if (!pending_.empty())
+    {
+        DiagnosticLogger::Log("UploadQueue: " + std::to_string(pending_.size()) + " records pending from previous sessions");
+    }
+    return true;
+}
+
+bool UploadQueue::Append(const std::vector<std::string>& payloads, std::string& error)
+{
+    if (payloads.empty())
+    {
+        return true;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::string chunk;
+    std::vector<Entry> entries;
+    entries.reserve(payloads.size());
+    uint64_t sequence = nextSequence_;
+    for (const auto& payload : payloads)
+    {
+        if (payload.find_first_of("\r\n") != std::string::npos)
+        {
+            error = "UploadQueue payloads must be a single line";
+            return false;
+        }
+        Entry entry;
+        entry.record.sequence = sequence++;
+        entry.record.payload = payload;
+        entry.lineBytes = LineBytes(entry.record.sequence, payload);
+        chunk += std::to_string(entry.record.sequence);
+        chunk += ' ';
+        chunk += payload;
+        chunk += '\n';
+        entries.push_back(std::move(entry));
+    }
+
+    if (!OpenFile(error))
+    {
+        return false;
+    }
+    if (!file_.Write(chunk, error)
+        || (durability_ == StoreFile::Durability::Fsync && !file_.Sync(error)))
+    {
+        // Part of the chunk may have landed; the next append must not start after it.
+        file_.Close();
+        std::error_code ec;
+        std::filesystem::resize_file(queuePath_, fileBytes_, ec);
+        tornTail_ = static_cast<bool>(ec);
+        error = std::string("Failed to append to upload queue at ") + queuePath_.string() + ": " + error;
+        return false;
+    }
+
+    nextSequence_ = sequence;
+    fileBytes_ += chunk.size();
+    for (auto& entry : entries)
+    {
+        pendingBytes_ += entry.lineBytes;
+        pending_.push_back(std::move(entry));
+    }
+    return true;
+}
+
+bool UploadQueue::DeadLetter(const Record& record, const std::string& reason, std::string& error)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    const std::string line = "{\"seq\":" + std::to_string(record.sequence) + ",\"reason\":\"" + JsonEscape(reason)
+        + "\",\"payload\":" + record.payload + "}\n";
+    StoreFile::AppendHandle file;
+    if (!file.Open(deadLetterPath_, error)
+        || !file.Write(line, error)
+        || (durability_ == StoreFile::Durability::Fsync && !file.Sync(error)))
+    {
+        error = std::string("Failed to write dead letter to ") + deadLetterPath_.string() + ": " + error;
+        return false;
+    }
+    return true;
+}
+
+void UploadQueue::SetDurability(StoreFile::Durability durability)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    durability_ = durability == StoreFile::Durability::Fsync
+        ? StoreFile::Durability::Fsync
+        : StoreFile::Durability::Flush;
+}
+
+std::vector<UploadQueue::Record> UploadQueue::PeekBatch(size_t maxRecords, size_t maxBytes) const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<Record> batch;
+    size_t bytes = 0;
+    for (const auto& entry : pending_)
+    {
+        if (batch.size() >= maxRecords || (!batch.empty() && bytes + entry.record.payload.size() > maxBytes))
+        {
+            break;
+        }
+        bytes += entry.record.payload.size();
+        batch.push_back(entry.record);
+    }
+    return batch;
+}
+
+bool UploadQueue::Acknowledge(uint64_t sequence, std::string& error)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (sequence <= ackedSequence_)
+    {
+        return true;
+    }
+
+    if (!WriteAck(sequence, error))
+    {
+        return false;
+    }
+    ackedSequence_ = sequence;
+    while (!pending_.empty() && pending_.front().record.sequence <= sequence)
+    {
+        pendingBytes_ -= pending_.front().lineBytes;
+        pending_.pop_front();
+    }
+
+    const uint64_t deadBytes = fileBytes_ - pendingBytes_;
+    const bool drained = pending_.empty() && fileBytes_ > 0;
+    if (drained || (deadBytes >= kCompactMinDeadBytes && deadBytes > pendingBytes_))
+    {
+        return Compact(error);
+    }
+    return true;
+}
+
+size_t UploadQueue::PendingCount() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return pending_.size();
+}
+
+UploadQueue::Stats UploadQueue::GetStats() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    Stats stats;
+    stats.pending = pending_.size();
+    stats.lastSequence = nextSequence_ - 1;
+    stats.ackedSequence = ackedSequence_;
+    stats.fileBytes = fileBytes_;
+    stats.compactions = compactions_;
+    return stats;
+}
+
+bool UploadQueue::WriteAck(uint64_t sequence, std::string& error) const
+{
+    return ReplaceFile(ackPath_, std::to_string(sequence) + "\n", durability_ == StoreFile::Durability::Fsync, error);
+}
+
+bool UploadQueue::OpenFile(std::string& error)
+{
+    if (file_.IsOpen())
+    {
+        return true;
+    }
+    if (tornTail_)
+    {
+        std::error_code ec;
+        std::filesystem::resize_file(queuePath_, fileBytes_, ec);
+        if (ec)
+        {
+            error = std::string("Failed to cut a torn append from ") + queuePath_.string() + ": " + ec.message();
+            return false;
+        }
+        tornTail_ = false;
+    }
+    if (!file_.Open(queuePath_, error))
+    {
+        error = std::string("Failed to open upload queue at ") + queuePath_.string() + ": " + error;
+        return false;
+    }
+    return true;
+}
+
+bool UploadQueue::Compact(std::string& error)
+{
+    std::string contents;
+    contents.reserve(static_cast<size_t>(pendingBytes_));
+    for (const auto& entry : pending_)
+    {
+        contents += std::to_string(entry.record.sequence);
+        contents += ' ';
+        contents += entry.record.payload;
+        contents += '\n';
+    }
+
+    // The ack file must cover the highest sequence ever issued before the queue file
+    // forgets it, or a reload could hand out the same numbers again.
+    if (pending_.empty() && nextSequence_ - 1 > ackedSequence_)
+    {
+        if (!WriteAck(nextSequence_ - 1, error))
+        {
+            return false;
+        }
+        ackedSequence_ = nextSequence_ - 1;
+    }
+
+    // The handle is reopened on the next append, on the new file.
+    file_.Close();
+    if (!ReplaceFile(queuePath_, contents, durability_ == StoreFile::Durability::Fsync, error))
+    {
+        return false;
+    }
+    fileBytes_ = contents.size();
+    tornTail_ = false;
+    ++compactions_;
+    return true;
+}
@@ -1,6 +1,9 @@
 #include "pch.h"
 #include "ui/HsHistoryWindowUi.h"
-#include "utils/HsUtils.h"      // for ExtractDatePortion, FormatTimestamp
+#include "utils/HsUtils.h"      // for FormatTimestampEpochUk, FormatEpochDay
+
+#include "history/HistoryColumns.h"
+#include "history/HistoryRollups.h"
 
 #include "ui/ui_style.h"
 
@@ -10,18 +13,80 @@
 #include <vector>
 #include <string>
 #include <sstream>
-#include <set>
 
 namespace
 {
-    using TrainingMinutesByDate = std::unordered_map<std::string, float>;
+    // Display strings for epoch times and day buckets, formatted on first use and dropped
+    // when the snapshot changes, so rows do not reformat every frame.
+    class TimestampLabels
+    {
+    public:
+        const std::string& Time(int64_t epochSeconds)
+        {
+            auto it = times_.find(epochSeconds);
+            if (it == times_.end())
+            {
+                it = times_.emplace(epochSeconds, FormatTimestampEpochUk(epochSeconds)).first;
+            }
+            return it->second;
+        }
+
+        const std::string& Day(int32_t day)
+        {
+            auto it = days_.find(day);
+            if (it == days_.end())
+            {
+                it = days_.emplace(day, FormatEpochDay(day)).first;
+            }
+            return it->second;
+        }
+
+        const std::string& Period(RollupPeriod period, int32_t key)
+        {
+            if (period == RollupPeriod::Day)
+            {
+                return Day(key);
+            }
+            auto& labels = period == RollupPeriod::Week ? weeks_ : seasons_;
+            auto it = labels.find(key);
+            if (it == labels.end())
+            {
+                std::string label;
+                if (period == RollupPeriod::Week)
+                {
+                    label = "Week of " + FormatEpochDay(HistoryRollups::FirstDay(period, key));
+                }
+                else
+                {
+                    label = key > 0 ? "Season " + std::to_string(key) : "Before Season 1";
+                }
+                it = labels.emplace(key, std::move(label)).first;
+            }
+            return it->second;
+        }
+
+        void Clear()
+        {
+            times_.clear();
+            days_.clear();
+            weeks_.clear();
+            seasons_.clear();
+        }
+
+    private:
+        std::unordered_map<int64_t, std::string> times_;
+        std::unordered_map<int32_t, std::string> days_;
+        std::unordered_map<int32_t, std::string> weeks_;
+        std::unordered_map<int32_t, std::string> seasons_;
+    };
 
     struct HistoryChartData
     {
         std::vector<float> mmrSeries;
         std::vector<float> trainingSeries;
         std::vector<float> mmrDeltas;
-        std::vector<std::string> labels;
+        std::vector<int64_t> times;
+        size_t rangeEntries{0}; // entries in the selected range, before downsampling
         float mmrMin{0.0f};
         float mmrMax{0.0f};
         float trainingMax{0.0f};
@@ -29,10 +94,11 @@ namespace
         bool hasTrainingOverlay{false};
     };
 
-    struct DailyComparisonRow
+    struct ComparisonRow
     {
-        std::string date;
+        int32_t key{0}; // rollup bucket key of the selected period
         float trainingMinutes{0.0f};
+        int games{0};
         int mmrDelta{0};
         int closingMmr{0};
     };
@@ -52,11 +118,32 @@ namespace
         float totalTrainingMinutes{0.0f};
     };
 
+    struct ChartRange
+    {
+        const char* label;
+        int64_t seconds; // 0 keeps the whole history
+    };
+
+    constexpr ChartRange kChartRanges[] = {
+        {"Last 7 days", 7 * 86400},
+        {"Last 30 days", 30 * 86400},
+        {"Last 90 days", 90 * 86400},
+        {"Last year", 365 * 86400},
+        {"All history", 0},
+    };
+    constexpr int kChartRangeCount = static_cast<int>(sizeof(kChartRanges) / sizeof(kChartRanges[0]));
+
+    constexpr float kMinChartWidth = 360.0f;
+
+    constexpr const char* kComparisonPeriods[] = {"Day", "Week", "Season"};
+    constexpr int kComparisonPeriodCount = static_cast<int>(sizeof(kComparisonPeriods) / sizeof(kComparisonPeriods[0]));
+
     struct HistoryUiState
     {
-        int maxChartPoints{60};
+        int chartRange{1};
         bool showTrainingOverlay{true};
-        bool showDailyComparison{true};
+        bool showComparison{true};
+        int comparisonPeriod{0}; // RollupPeriod
         bool highlightMmrDelta{true};
         std::string playlistFilter{"All Playlists"};
     };
@@ -67,57 +154,83 @@ namespace
         return state;
     }
 
-    TrainingMinutesByDate BuildTrainingMinutes(const std::vector<TrainingHistoryEntry>& history)
+    // The playlist filter resolved to a symbol id once, so filtering compares integers.
+    struct PlaylistFilter
     {
-        TrainingMinutesByDate minutesByDate;
-        for (const auto& entry : history)
-        {
-            const std::string finishedDate = ExtractDatePortion(
-                entry.finishedTime.empty() ? entry.startedTime : entry.finishedTime
-            );
-            const float minutes = static_cast<float>(entry.actualDuration) / 60.0f;
-            minutesByDate[finishedDate] += minutes;
-        }
-        return minutesByDate;
-    }
+        bool all{true};
+        bool known{false};
+        SymbolId id{0};
 
-    std::vector<const MmrHistoryEntry*> SortMmrHistory(const std::vector<MmrHistoryEntry>& mmrHistory)
+        bool Matches(SymbolId playlist) const { return all || (known && playlist == id); }
+    };
+
+    // Everything the window derives from the snapshot, rebuilt only when its inputs change:
+    // the snapshot version, then the playlist filter, then the chart range and width or the
+    // comparison period. Display toggles only affect drawing and never invalidate it.
+    struct HistoryViewModel
     {
-        std::vector<const MmrHistoryEntry*> sorted;
-        sorted.reserve(mmrHistory.size());
-        for (const auto& entry : mmrHistory)
-        {
-            sorted.push_back(&entry);
-        }
-        std::sort(sorted.begin(), sorted.end(), [](const MmrHistoryEntry* lhs, const MmrHistoryEntry* rhs) {
-            return lhs->timestamp < rhs->timestamp;
-        });
-        return sorted;
+        const HistorySnapshot* snapshot{nullptr};
+        uint64_t version{0};
+        bool snapshotValid{false};
+        std::vector<std::string> playlistOptions;
+        TimestampLabels labels;
+
+        std::string playlistFilter;
+        bool filterValid{false};
+        PlaylistFilter filter;
+        std::vector<MmrHistoryEntry> filteredMmr;
+        HistorySnapshot::Aggregates filteredAggregates;
+        MmrColumns filteredColumns; // timestamp order
+        HistoryOverview overview;
+
+        int comparisonPeriod{0};
+        bool comparisonValid{false};
+        std::vector<ComparisonRow> comparisons;
+
+        int chartRange{0};
+        int chartWidth{0};
+        bool chartValid{false};
+        HistoryChartData chartData;
+    };
+
+    HistoryViewModel& GetViewModel()
+    {
+        static HistoryViewModel viewModel;
+        return viewModel;
     }
 
-    std::vector<std::string> BuildPlaylistOptions(const std::vector<MmrHistoryEntry>& mmrHistory)
+    // Playlists that have at least one entry, read from the snapshot index.
+    std::vector<std::string> BuildPlaylistOptions(const HistorySnapshot& snapshot)
     {
-        std::set<std::string> unique;
-        for (const auto& entry : mmrHistory)
+        std::vector<std::string> playlists;
+        const std::vector<LatestMmrPair>& byPlaylist = snapshot.index.byPlaylist;
+        for (size_t id = 1; id < byPlaylist.size(); ++id)
         {
-            if (!entry.playlist.empty())
+            if (byPlaylist[id].latest >= 0)
             {
-                unique.insert(entry.playlist);
+                playlists.push_back(snapshot.symbols.playlists.Name(static_cast<SymbolId>(id)));
             }
         }
+        std::sort(playlists.begin(), playlists.end());
 
         std::vector<std::string> options;
+        options.reserve(playlists.size() + 1);
         options.push_back("All Playlists");
-        for (const auto& playlist : unique)
-        {
-            options.push_back(playlist);
-        }
+        options.insert(options.end(), playlists.begin(), playlists.end());
         return options;
     }
 
-    std::vector<MmrHistoryEntry> FilterMmrHistory(const std::vector<MmrHistoryEntry>& history, const std::string& filter)
+    PlaylistFilter ResolvePlaylistFilter(const SymbolTable& playlists, const std::string& filter)
     {
-        if (filter.empty() || filter == "All Playlists")
+        PlaylistFilter resolved;
+        resolved.all = filter.empty() || filter == "All Playlists";
+        resolved.known = !resolved.all && playlists.Find(filter, resolved.id);
+        return resolved;
+    }
+
+    std::vector<MmrHistoryEntry> FilterMmrHistory(const std::vector<MmrHistoryEntry>& history, const PlaylistFilter& filter)
+    {
+        if (filter.all)
         {
             return history;
         }
@@ -125,7 +238,7 @@ namespace
         std::vector<MmrHistoryEntry> filtered;
         for (const auto& entry : history)
         {
-            if (entry.playlist == filter)
+            if (filter.Matches(entry.playlist))
             {
                 filtered.push_back(entry);
             }
@@ -133,9 +246,18 @@ namespace
         return filtered;
     }
 
-    HistorySnapshot::Aggregates FilterAggregates(const HistorySnapshot::Aggregates& aggregates, const std::string& filter)
+    MmrColumns FilterColumns(const MmrColumns& columns, const PlaylistFilter& filter)
     {
-        if (filter.empty() || filter == "All Playlists")
+        if (filter.all)
+        {
+            return columns;
+        }
+        return filter.known ? HistoryColumns::Filter(columns, filter.id) : MmrColumns();
+    }
+
+    HistorySnapshot::Aggregates FilterAggregates(const HistorySnapshot::Aggregates& aggregates, const PlaylistFilter& filter)
+    {
+        if (filter.all)
         {
             return aggregates;
         }
@@ -145,46 +267,64 @@ namespace
             std::remove_if(filtered.mmrDeltas.begin(), filtered.mmrDeltas.end(),
                 [&filter](const HistorySnapshot::Aggregates::MmrDelta& delta)
                 {
-                    return delta.playlist != filter;
+                    return !filter.Matches(delta.playlist);
                 }),
             filtered.mmrDeltas.end());
         return filtered;
     }
 
-    HistoryChartData BuildChartData(const std::vector<const MmrHistoryEntry*>& sortedMmr,
-                                    const TrainingMinutesByDate& trainingMinutes,
-                                    int maxPoints)
+    // The chart covers `rangeSeconds` back from the latest entry and is downsampled to at
+    // most `maxPoints` points, so the draw cost follows the plot width, not the history size.
+    HistoryChartData BuildChartData(const MmrColumns& columns,
+                                    const RollupTable& days,
+                                    int64_t rangeSeconds,
+                                    size_t maxPoints)
     {
         HistoryChartData data;
 
-        if (sortedMmr.size() < 2)
+        if (columns.Size() < 2)
         {
             return data;
         }
 
-        const size_t start = (maxPoints > 1 && sortedMmr.size() > static_cast<size_t>(maxPoints))
-            ? sortedMmr.size() - static_cast<size_t>(maxPoints)
-            : 0;
+        size_t start = 0;
+        if (rangeSeconds > 0)
+        {
+            const int64_t from = columns.timestamps.back() - rangeSeconds;
+            start = static_cast<size_t>(
+                std::lower_bound(columns.timestamps.begin(), columns.timestamps.end(), from) - columns.timestamps.begin());
+            start = (std::min)(start, columns.Size() - 2);
+        }
+        const size_t rangeCount = columns.Size() - start;
+        data.rangeEntries = rangeCount;
 
-        data.mmrSeries.reserve(sortedMmr.size() - start);
-        data.trainingSeries.reserve(sortedMmr.size() - start);
-        data.labels.reserve(sortedMmr.size() - start);
-        data.mmrDeltas.reserve(sortedMmr.size() - start);
+        std::vector<uint32_t> selected((std::min)(rangeCount, maxPoints));
+        selected.resize(HistoryColumns::DownsampleLttb(columns.mmr.data() + start, rangeCount, maxPoints, selected.data()));
+        const size_t count = selected.size();
 
-        int previousMmr = sortedMmr[start]->mmr;
-        for (size_t i = start; i < sortedMmr.size(); ++i)
+        data.mmrSeries.resize(count);
+        data.mmrDeltas.resize(count);
+        data.times.resize(count);
+        data.trainingSeries.resize(count);
+        int32_t previousDay = 0;
+        float dayMinutes = 0.0f;
+        for (size_t i = 0; i < count; ++i)
         {
-            const MmrHistoryEntry* entry = sortedMmr[i];
-            data.mmrSeries.push_back(static_cast<float>(entry->mmr));
-            data.labels.push_back(entry->timestamp);
-
-            const std::string dateKey = ExtractDatePortion(entry->timestamp);
-            const auto trainingIt = trainingMinutes.find(dateKey);
-            data.trainingSeries.push_back(trainingIt != trainingMinutes.end() ? trainingIt->second : 0.0f);
+            const size_t row = start + selected[i];
+            data.mmrSeries[i] = static_cast<float>(columns.mmr[row]);
+            data.times[i] = columns.timestamps[row];
 
-            data.mmrDeltas.push_back(static_cast<float>(entry->mmr - previousMmr));
-            previousMmr = entry->mmr;
+            // Days are sorted, so each distinct day is looked up once.
+            const int32_t day = columns.days[row];
+            if (i == 0 || day != previousDay)
+            {
+                const RollupBucket* bucket = HistoryRollups::Find(days, day);
+                dayMinutes = bucket != nullptr ? bucket->trainingMinutes : 0.0f;
+                previousDay = day;
+            }
+            data.trainingSeries[i] = dayMinutes;
         }
+        HistoryColumns::AdjacentDeltas(data.mmrSeries.data(), count, data.mmrDeltas.data());
 
         data.hasTrainingOverlay = std::any_of(
             data.trainingSeries.begin(),
@@ -195,83 +335,69 @@ namespace
 
         if (data.hasChart)
         {
-            data.mmrMin = *std::min_element(data.mmrSeries.begin(), data.mmrSeries.end());
-            data.mmrMax = *std::max_element(data.mmrSeries.begin(), data.mmrSeries.end());
+            // Scale to the whole range so dropped rows can never fall outside the plot.
+            int32_t mmrMin = 0;
+            int32_t mmrMax = 0;
+            HistoryColumns::MinMax(columns.mmr.data() + start, rangeCount, mmrMin, mmrMax);
+            data.mmrMin = static_cast<float>(mmrMin);
+            data.mmrMax = static_cast<float>(mmrMax);
             data.trainingMax = *std::max_element(data.trainingSeries.begin(), data.trainingSeries.end());
         }
 
         return data;
     }
 
-    std::vector<DailyComparisonRow> BuildDailyComparison(const std::vector<const MmrHistoryEntry*>& sortedMmr,
-                                                         const TrainingMinutesByDate& trainingMinutes)
+    // One row per rollup bucket with MMR entries for the filter or training time, oldest
+    // first. With every playlist selected, deltas and games are summed over playlists and the
+    // closing MMR is that of the playlist played last in the period.
+    std::vector<ComparisonRow> BuildComparison(const RollupTable& table, const PlaylistFilter& filter)
     {
-        std::vector<DailyComparisonRow> rows;
-        if (sortedMmr.empty() && trainingMinutes.empty())
-        {
-            return rows;
-        }
-
-        std::unordered_map<std::string, size_t> indexByDate;
-        indexByDate.reserve(sortedMmr.size() + trainingMinutes.size());
-
-        if (!sortedMmr.empty())
-        {
-            int previousMmr = sortedMmr.front()->mmr;
-            for (const MmrHistoryEntry* entry : sortedMmr)
+        std::vector<ComparisonRow> rows;
+        rows.reserve(table.buckets.size());
+        for (const RollupBucket& bucket : table.buckets)
+        {
+            ComparisonRow row;
+            row.key = bucket.key;
+            row.trainingMinutes = bucket.trainingMinutes;
+            bool played = false;
+            for (size_t id = 0; id < bucket.byPlaylist.size(); ++id)
             {
-                const std::string date = ExtractDatePortion(entry->timestamp);
-                const auto found = indexByDate.find(date);
-                if (found == indexByDate.end())
+                const RollupStats& stats = bucket.byPlaylist[id];
+                if (stats.entries == 0 || !filter.Matches(static_cast<SymbolId>(id)))
                 {
-                    rows.push_back({date, 0.0f, 0, entry->mmr});
-                    indexByDate.emplace(date, rows.size() - 1);
+                    continue;
+                }
+                played = true;
+                row.games += stats.games;
+                row.mmrDelta += stats.delta;
+                if (!filter.all || id == bucket.lastPlaylist)
+                {
+                    row.closingMmr = stats.close;
                 }
-
-                DailyComparisonRow& row = rows[indexByDate[date]];
-                row.mmrDelta += entry->mmr - previousMmr;
-                row.closingMmr = entry->mmr;
-                previousMmr = entry->mmr;
-            }
-        }
-
-        for (const auto& training : trainingMinutes)
-        {
-            const auto found = indexByDate.find(training.first);
-            if (found == indexByDate.end())
-            {
-                rows.push_back({training.first, training.second, 0, 0});
-                indexByDate.emplace(training.first, rows.size() - 1);
             }
-            else
+            if (played || row.trainingMinutes > 0.0f)
             {
-                rows[found->second].trainingMinutes = training.second;
+                rows.push_back(row);
             }
         }
-
-        std::sort(rows.begin(), rows.end(), [](const DailyComparisonRow& lhs, const DailyComparisonRow& rhs) {
-            return lhs.date < rhs.date;
-        });
         return rows;
     }
 
-    HistoryOverview BuildOverview(const HistorySnapshot& snapshot,
-                                  const std::vector<const MmrHistoryEntry*>& sortedMmr,
-                                  const TrainingMinutesByDate& trainingMinutes)
+    HistoryOverview BuildOverview(const HistorySnapshot& snapshot, const MmrColumns& columns)
     {
         HistoryOverview overview;
         overview.mmrEntries = snapshot.status.mmrEntries;
         overview.trainingEntries = snapshot.status.trainingSessions;
         overview.mmrLimit = snapshot.status.mmrLimit;
         overview.trainingLimit = snapshot.status.sessionLimit;
-        overview.lastMmrTimestamp = FormatTimestampStringUk(snapshot.status.lastMmrTimestamp);
-        overview.lastTrainingTimestamp = FormatTimestampStringUk(snapshot.status.lastTrainingTimestamp);
-        overview.generatedAt = FormatTimestampStringUk(snapshot.status.generatedAt);
-        overview.receivedAt = FormatTimestampStringUk(snapshot.status.receivedAt);
+        overview.lastMmrTimestamp = FormatTimestampEpochUk(snapshot.status.lastMmrTimestamp);
+        overview.lastTrainingTimestamp = FormatTimestampEpochUk(snapshot.status.lastTrainingTimestamp);
+        overview.generatedAt = FormatTimestampEpochUk(snapshot.status.generatedAt);
+        overview.receivedAt = FormatTimestampEpochUk(snapshot.status.receivedAt);
 
-        if (!sortedMmr.empty())
+        if (columns.Size() > 0)
         {
-            overview.latestMmr = sortedMmr.back()->mmr;
+            overview.latestMmr = columns.mmr.back();
         }
 
         if (!snapshot.trainingHistory.empty())
@@ -279,24 +405,87 @@ namespace
             overview.latestTrainingMinutes = static_cast<float>(snapshot.trainingHistory.back().actualDuration) / 60.0f;
         }
 
-        for (const auto& session : snapshot.aggregates.timeBySessionType)
+        for (const double seconds : snapshot.aggregates.secondsBySessionType)
         {
-            overview.totalTrainingMinutes += static_cast<float>(session.second) / 60.0f;
+            overview.totalTrainingMinutes += static_cast<float>(seconds) / 60.0f;
         }
 
-        if (!sortedMmr.empty())
+        if (columns.Size() > 0)
         {
-            const std::string lastDate = ExtractDatePortion(sortedMmr.back()->timestamp);
-            const auto trainingIt = trainingMinutes.find(lastDate);
-            if (trainingIt != trainingMinutes.end())
+            const RollupBucket* bucket = HistoryRollups::Find(snapshot.rollups.days, columns.days.back());
+            if (bucket != nullptr)
             {
-                overview.latestTrainingMinutes = trainingIt->second;
+                overview.latestTrainingMinutes = bucket->trainingMinutes;
             }
         }
 
         return overview;
     }
 
+    void RefreshSnapshotViews(HistoryViewModel& viewModel, const HistorySnapshot& snapshot, uint64_t version)
+    {
+        if (viewModel.snapshotValid && viewModel.snapshot == &snapshot && viewModel.version == version)
+        {
+            return;
+        }
+        viewModel.snapshot = &snapshot;
+        viewModel.version = version;
+        viewModel.snapshotValid = true;
+        viewModel.playlistOptions = BuildPlaylistOptions(snapshot);
+        viewModel.labels.Clear();
+        viewModel.filterValid = false;
+    }
+
+    void RefreshFilteredViews(HistoryViewModel& viewModel, const HistorySnapshot& snapshot, const std::string& playlistFilter)
+    {
+        if (viewModel.filterValid && viewModel.playlistFilter == playlistFilter)
+        {
+            return;
+        }
+        viewModel.playlistFilter = playlistFilter;
+        viewModel.filterValid = true;
+        viewModel.filter = ResolvePlaylistFilter(snapshot.symbols.playlists, playlistFilter);
+        viewModel.filteredMmr = FilterMmrHistory(snapshot.mmrHistory, viewModel.filter);
+        viewModel.filteredAggregates = FilterAggregates(snapshot.aggregates, viewModel.filter);
+        viewModel.filteredColumns = FilterColumns(snapshot.mmrColumns, viewModel.filter);
+        viewModel.overview = BuildOverview(snapshot, viewModel.filteredColumns);
+        viewModel.comparisonValid = false;
+        viewModel.chartValid = false;
+    }
+
+    void RefreshComparisons(HistoryViewModel& viewModel, const HistorySnapshot& snapshot, int comparisonPeriod)
+    {
+        if (viewModel.comparisonValid && viewModel.comparisonPeriod == comparisonPeriod)
+        {
+            return;
+        }
+        viewModel.comparisonPeriod = comparisonPeriod;
+        viewModel.comparisonValid = true;
+        const RollupPeriod period = static_cast<RollupPeriod>(comparisonPeriod);
+        viewModel.comparisons = BuildComparison(HistoryRollups::Table(snapshot.rollups, period), viewModel.filter);
+    }
+
+    float ChartWidth()
+    {
+        return (std::max)(kMinChartWidth, ImGui::GetContentRegionAvail().x);
+    }
+
+    // One point per horizontal pixel of the plot.
+    void RefreshChartData(HistoryViewModel& viewModel, const HistorySnapshot& snapshot, int chartRange, int chartWidth)
+    {
+        if (viewModel.chartValid && viewModel.chartRange == chartRange && viewModel.chartWidth == chartWidth)
+        {
+            return;
+        }
+        viewModel.chartRange = chartRange;
+        viewModel.chartWidth = chartWidth;
+        viewModel.chartValid = true;
+        viewModel.chartData = BuildChartData(viewModel.filteredColumns,
+                                             snapshot.rollups.days,
+                                             kChartRanges[chartRange].seconds,
+                                             static_cast<size_t>((std::max)(2, chartWidth)));
+    }
+
     void RenderStatus(const std::string& errorMessage,
                       bool loading,
                       std::chrono::system_clock::time_point lastFetched,
@@ -384,24 +573,16 @@ namespace
 
     std::vector<ImVec2> BuildPoints(const std::vector<float>& series, ImVec2 plotMin, ImVec2 plotMax, float minVal, float maxVal)
     {
+        static_assert(sizeof(ImVec2) == 2 * sizeof(float), "ImVec2 must be two packed floats");
         std::vector<ImVec2> points;
         if (series.size() < 2)
         {
             return points;
         }
 
-        const float range = std::max(1.0f, maxVal - minVal);
-        points.reserve(series.size());
-        for (size_t i = 0; i < series.size(); ++i)
-        {
-            const float xNorm = (series.size() <= 1)
-                ? 0.0f
-                : static_cast<float>(i) / static_cast<float>(series.size() - 1);
-            const float x = plotMin.x + xNorm * (plotMax.x - plotMin.x);
-            const float yNorm = (series[i] - minVal) / range;
-            const float y = plotMax.y - yNorm * (plotMax.y - plotMin.y);
-            points.emplace_back(x, y);
-        }
+        points.resize(series.size());
+        HistoryColumns::Project(series.data(), series.size(), minVal, maxVal,
+                                plotMin.x, plotMin.y, plotMax.x, plotMax.y, &points[0].x);
         return points;
     }
 
@@ -428,6 +609,7 @@ namespace
     }
 
     void RenderActivityChart(const HistoryChartData& chartData,
+                             TimestampLabels& labels,
                              bool showTrainingOverlay,
                              bool highlightMmrDelta)
     {
@@ -437,11 +619,7 @@ namespace
             return;
         }
 
-        ImVec2 chartSize(ImGui::GetContentRegionAvail().x, 260.0f);
-        if (chartSize.x < 360.0f)
-        {
-            chartSize.x = 360.0f;
-        }
+        const ImVec2 chartSize(ChartWidth(), 260.0f);
 
         ImDrawList* drawList = ImGui::GetWindowDrawList();
         ImGui::InvisibleButton("history_chart_canvas", chartSize);
@@ -468,7 +646,7 @@ namespace
 
         const bool hovered = ImGui::IsItemHovered();
         const ImVec2 mousePos = ImGui::GetIO().MousePos;
-        if (hovered && mousePos.x >= plotMin.x && mousePos.x <= plotMax.x && !chartData.labels.empty())
+        if (hovered && mousePos.x >= plotMin.x && mousePos.x <= plotMax.x && !chartData.times.empty())
         {
             const float t = (plotMax.x - plotMin.x) > 0.0f
                 ? (mousePos.x - plotMin.x) / (plotMax.x - plotMin.x)
@@ -479,7 +657,7 @@ namespace
                 static_cast<float>(chartData.mmrSeries.size() - 1)));
 
             ImGui::BeginTooltip();
-            ImGui::Text("Date: %s", chartData.labels[idx].c_str());
+            ImGui::Text("Date: %s", labels.Time(chartData.times[idx]).c_str());
             ImGui::Text("MMR: %.0f (%+.0f)", chartData.mmrSeries[idx], chartData.mmrDeltas[idx]);
             if (chartData.hasTrainingOverlay)
             {
@@ -499,13 +677,34 @@ namespace
 
     void RenderChartControls(HistoryUiState& uiState, const HistoryChartData& chartData)
     {
-        ImGui::SliderInt("Points shown", &uiState.maxChartPoints, 10, 120, "%d entries");
+        ImGui::SetNextItemWidth(140.0f);
+        if (ImGui::BeginCombo("Range", kChartRanges[uiState.chartRange].label))
+        {
+            for (int range = 0; range < kChartRangeCount; ++range)
+            {
+                const bool selected = range == uiState.chartRange;
+                if (ImGui::Selectable(kChartRanges[range].label, selected))
+                {
+                    uiState.chartRange = range;
+                }
+                if (selected)
+                {
+                    ImGui::SetItemDefaultFocus();
+                }
+            }
+            ImGui::EndCombo();
+        }
         ImGui::SameLine();
         ImGui::Checkbox("Show training overlay", &uiState.showTrainingOverlay);
         ImGui::SameLine();
         ImGui::Checkbox("Highlight MMR delta", &uiState.highlightMmrDelta);
 
         ImGui::Text("Latest MMR: %.0f", chartData.mmrSeries.empty() ? 0.0f : chartData.mmrSeries.back());
+        if (chartData.mmrSeries.size() < chartData.rangeEntries)
+        {
+            ImGui::SameLine();
+            ImGui::TextDisabled("(%zu of %zu entries plotted)", chartData.mmrSeries.size(), chartData.rangeEntries);
+        }
         if (chartData.hasTrainingOverlay)
         {
             ImGui::SameLine();
@@ -513,7 +712,22 @@ namespace
         }
     }
 
-    void RenderComparisonTable(const std::vector<DailyComparisonRow>& comparisons, bool expanded)
+    void RenderComparisonControls(HistoryUiState& uiState)
+    {
+        ImGui::Checkbox("Show comparison table", &uiState.showComparison);
+        if (!uiState.showComparison)
+        {
+            return;
+        }
+        ImGui::SameLine();
+        ImGui::SetNextItemWidth(120.0f);
+        ImGui::Combo("Group by##comparison_period", &uiState.comparisonPeriod, kComparisonPeriods, kComparisonPeriodCount);
+    }
+
+    void RenderComparisonTable(const std::vector<ComparisonRow>& comparisons,
+                               RollupPeriod period,
+                               TimestampLabels& labels,
+                               bool expanded)
     {
         if (!expanded)
         {
@@ -526,11 +740,13 @@ namespace
         }
 
         ImGui::BeginChild("comparison_child", ImVec2(0.0f, 200.0f), true);
-        ImGui::Columns(4, "comparison_columns");
-        ImGui::TextUnformatted("Date");
+        ImGui::Columns(5, "comparison_columns");
+        ImGui::TextUnformatted(kComparisonPeriods[static_cast<int>(period)]);
         ImGui::NextColumn();
         ImGui::TextUnformatted("Training (min)");
         ImGui::NextColumn();
+        ImGui::TextUnformatted("Games");
+        ImGui::NextColumn();
         ImGui::TextUnformatted("MMR delta");
         ImGui::NextColumn();
         ImGui::TextUnformatted("Closing MMR");
@@ -539,10 +755,12 @@ namespace
 
         for (const auto& row : comparisons)
         {
-            ImGui::TextUnformatted(row.date.c_str());
+            ImGui::TextUnformatted(labels.Period(period, row.key).c_str());
             ImGui::NextColumn();
             ImGui::Text("%.1f", row.trainingMinutes);
             ImGui::NextColumn();
+            ImGui::Text("%d", row.games);
+            ImGui::NextColumn();
             const ImVec4 deltaColor = row.mmrDelta > 0
                 ? ImVec4(0.50f, 0.86f, 0.63f, 1.0f)
                 : (row.mmrDelta < 0 ? ImVec4(0.93f, 0.58f, 0.50f, 1.0f) : ImVec4(0.78f, 0.82f, 0.90f, 1.0f));
@@ -556,7 +774,9 @@ namespace
         ImGui::EndChild();
     }
 
-    void RenderMmrEntries(const std::vector<MmrHistoryEntry>& entries)
+    void RenderMmrEntries(const std::vector<MmrHistoryEntry>& entries,
+                          const HistorySymbols& symbols,
+                          TimestampLabels& labels)
     {
         if (!ImGui::CollapsingHeader("MMR entries", ImGuiTreeNodeFlags_DefaultOpen))
         {
@@ -577,24 +797,30 @@ namespace
         ImGui::TextUnformatted("Game #"); ImGui::NextColumn();
         ImGui::Separator();
 
-        for (const auto& entry : entries)
+        // Rows are one line each, so only the ones scrolled into view are submitted.
+        ImGuiListClipper clipper(static_cast<int>(entries.size()));
+        while (clipper.Step())
         {
-            ImGui::TextUnformatted(entry.source.c_str());
-            ImGui::NextColumn();
-            ImGui::TextUnformatted(FormatTimestampStringUk(entry.timestamp).c_str());
-            ImGui::NextColumn();
-            ImGui::TextUnformatted(entry.playlist.c_str());
-            ImGui::NextColumn();
-            ImGui::Text("%d", entry.mmr);
-            ImGui::NextColumn();
-            ImGui::Text("%+d", entry.gamesPlayedDiff);
-            ImGui::NextColumn();
+            for (int row = clipper.DisplayStart; row < clipper.DisplayEnd; ++row)
+            {
+                const MmrHistoryEntry& entry = entries[static_cast<size_t>(row)];
+                ImGui::TextUnformatted(symbols.sources.Name(entry.source).c_str());
+                ImGui::NextColumn();
+                ImGui::TextUnformatted(labels.Time(entry.timestamp).c_str());
+                ImGui::NextColumn();
+                ImGui::TextUnformatted(symbols.playlists.Name(entry.playlist).c_str());
+                ImGui::NextColumn();
+                ImGui::Text("%d", entry.mmr);
+                ImGui::NextColumn();
+                ImGui::Text("%+d", entry.gamesPlayedDiff);
+                ImGui::NextColumn();
+            }
         }
         ImGui::Columns(1);
         ImGui::EndChild();
     }
 
-    void RenderTrainingEntries(const std::vector<TrainingHistoryEntry>& entries)
+    void RenderTrainingEntries(const std::vector<TrainingHistoryEntry>& entries, TimestampLabels& labels)
     {
         if (!ImGui::CollapsingHeader("Training sessions", ImGuiTreeNodeFlags_DefaultOpen))
         {
@@ -619,9 +845,9 @@ namespace
 
         for (const auto& entry : entries)
         {
-            ImGui::TextUnformatted(FormatTimestampStringUk(entry.startedTime).c_str());
+            ImGui::TextUnformatted(labels.Time(entry.startedTime).c_str());
             ImGui::NextColumn();
-            ImGui::TextUnformatted(FormatTimestampStringUk(entry.finishedTime).c_str());
+            ImGui::TextUnformatted(labels.Time(entry.finishedTime).c_str());
             ImGui::NextColumn();
             ImGui::TextUnformatted(entry.presetId.c_str());
             ImGui::NextColumn();
@@ -643,25 +869,28 @@ namespace
         ImGui::EndChild();
     }
 
-    void RenderAggregates(const HistorySnapshot::Aggregates& aggregates)
+    void RenderAggregates(const HistorySnapshot::Aggregates& aggregates,
+                          const HistorySymbols& symbols,
+                          TimestampLabels& labels)
     {
         if (!ImGui::CollapsingHeader("Aggregates", ImGuiTreeNodeFlags_DefaultOpen))
         {
             return;
         }
 
-        if (!aggregates.timeBySessionType.empty())
+        if (aggregates.secondsBySessionType.size() > 1)
         {
             ImGui::Columns(2, "session_time_columns");
             ImGui::TextUnformatted("Session type"); ImGui::NextColumn();
             ImGui::TextUnformatted("Minutes"); ImGui::NextColumn();
             ImGui::NextColumn();
             ImGui::Separator();
-            for (const auto& kv : aggregates.timeBySessionType)
+            // Id 0 is the empty name; stores map a missing session type to "unknown".
+            for (size_t id = 1; id < aggregates.secondsBySessionType.size(); ++id)
             {
-                ImGui::TextUnformatted(kv.first.c_str());
+                ImGui::TextUnformatted(symbols.sessionTypes.Name(static_cast<SymbolId>(id)).c_str());
                 ImGui::NextColumn();
-                ImGui::Text("%.1f", kv.second / 60.0);
+                ImGui::Text("%.1f", aggregates.secondsBySessionType[id] / 60.0);
                 ImGui::NextColumn();
             }
             ImGui::Columns(1);
@@ -688,11 +917,11 @@ namespace
             for (auto it = aggregates.mmrDeltas.rbegin(); it != aggregates.mmrDeltas.rend() && displayed < 12; ++it, ++displayed)
             {
                 const auto& delta = *it;
-                ImGui::TextUnformatted(FormatTimestampStringUk(delta.timestamp).c_str());
+                ImGui::TextUnformatted(labels.Time(delta.timestamp).c_str());
                 ImGui::NextColumn();
-                ImGui::TextUnformatted(delta.playlist.c_str());
+                ImGui::TextUnformatted(symbols.playlists.Name(delta.playlist).c_str());
                 ImGui::NextColumn();
-                ImGui::TextUnformatted(delta.sessionType.c_str());
+                ImGui::TextUnformatted(symbols.sessionTypes.Name(delta.sessionType).c_str());
                 ImGui::NextColumn();
                 ImGui::Text("%d", delta.mmr);
                 ImGui::NextColumn();
@@ -708,6 +937,7 @@ namespace
 
 void HsRenderHistoryWindowUi(
     HistorySnapshot const& snapshot,
+    uint64_t snapshotVersion,
     std::string const& errorMessage,
     bool loading,
     std::chrono::system_clock::time_point lastFetched,
@@ -730,7 +960,9 @@ void HsRenderHistoryWindowUi(
     }
 
     HistoryUiState& uiState = GetUiState();
-    const std::vector<std::string> playlistOptions = BuildPlaylistOptions(snapshot.mmrHistory);
+    HistoryViewModel& viewModel = GetViewModel();
+    RefreshSnapshotViews(viewModel, snapshot, snapshotVersion);
+    const std::vector<std::string>& playlistOptions = viewModel.playlistOptions;
     if (std::find(playlistOptions.begin(), playlistOptions.end(), uiState.playlistFilter) == playlistOptions.end())
     {
         uiState.playlistFilter = "All Playlists";
@@ -754,13 +986,14 @@ void HsRenderHistoryWindowUi(
         ImGui::EndCombo();
     }
 
-    const std::vector<MmrHistoryEntry> filteredMmr = FilterMmrHistory(snapshot.mmrHistory, uiState.playlistFilter);
-    const HistorySnapshot::Aggregates filteredAggregates = FilterAggregates(snapshot.aggregates, uiState.playlistFilter);
-    const TrainingMinutesByDate trainingMinutes = BuildTrainingMinutes(snapshot.trainingHistory);
-    const std::vector<const MmrHistoryEntry*> sortedMmr = SortMmrHistory(filteredMmr);
-    const HistoryChartData chartData = BuildChartData(sortedMmr, trainingMinutes, uiState.maxChartPoints);
-    const HistoryOverview overview = BuildOverview(snapshot, sortedMmr, trainingMinutes);
-    const std::vector<DailyComparisonRow> comparisons = BuildDailyComparison(sortedMmr, trainingMinutes);
+    RefreshFilteredViews(viewModel, snapshot, uiState.playlistFilter);
+    RefreshChartData(viewModel, snapshot, uiState.chartRange, static_cast<int>(ChartWidth()));
+    RefreshComparisons(viewModel, snapshot, uiState.comparisonPeriod);
+    const std::vector<MmrHistoryEntry>& filteredMmr = viewModel.filteredMmr;
+    const HistorySnapshot::Aggregates& filteredAggregates = viewModel.filteredAggregates;
+    const HistoryChartData& chartData = viewModel.chartData;
+    const HistoryOverview& overview = viewModel.overview;
+    const std::vector<ComparisonRow>& comparisons = viewModel.comparisons;
 
     RenderStatus(errorMessage, loading, lastFetched, activeSessionLabel, manualSessionActive);
     RenderOverviewCards(overview);
@@ -769,21 +1002,21 @@ void HsRenderHistoryWindowUi(
     ImGui::Dummy(ImVec2(0.0f, hs::ui::SectionSpacing()));
     ImGui::TextUnformatted("Training vs MMR activity");
     RenderChartControls(uiState, chartData);
-    RenderActivityChart(chartData, uiState.showTrainingOverlay, uiState.highlightMmrDelta);
+    RenderActivityChart(chartData, viewModel.labels, uiState.showTrainingOverlay, uiState.highlightMmrDelta);
 
     ImGui::Dummy(ImVec2(0.0f, hs::ui::SectionSpacing()));
-    ImGui::Checkbox("Show daily comparison table", &uiState.showDailyComparison);
-    RenderComparisonTable(comparisons, uiState.showDailyComparison);
+    RenderComparisonControls(uiState);
+    RenderComparisonTable(comparisons, static_cast<RollupPeriod>(uiState.comparisonPeriod), viewModel.labels, uiState.showComparison);
 
     ImGui::Dummy(ImVec2(0.0f, hs::ui::SectionSpacing()));
     if (ImGui::CollapsingHeader("Detailed logs (advanced)##hs_details", 0))
     {
         ImGui::Dummy(ImVec2(0.0f, hs::ui::SectionSpacing() * 0.5f));
-        RenderMmrEntries(filteredMmr);
+        RenderMmrEntries(filteredMmr, snapshot.symbols, viewModel.labels);
         ImGui::Dummy(ImVec2(0.0f, hs::ui::SectionSpacing() * 0.5f));
-        RenderTrainingEntries(snapshot.trainingHistory);
+        RenderTrainingEntries(snapshot.trainingHistory, viewModel.labels);
         ImGui::Dummy(ImVec2(0.0f, hs::ui::SectionSpacing() * 0.5f));
-        RenderAggregates(filteredAggregates);
+        RenderAggregates(filteredAggregates, snapshot.symbols, viewModel.labels);
     }
 
     ImGui::End();
@@ -1,8 +1,9 @@
 #include "pch.h"
 #include "ui/HsOverlayUi.h"
 
+#include "history/SnapshotIndex.h"
 #include "ui/ui_style.h"
-#include "utils/HsUtils.h" // FormatTimestamp, ExtractDatePortion
+#include "utils/HsUtils.h" // FormatTimestampUk
 #include <algorithm>
 #include <cstdio>
 
@@ -25,71 +26,25 @@ namespace
         int latestMmr{0};
         int latestMmrDelta{0};
         float latestTrainingMinutes{0.0f};
-        std::string lastMmrTimestamp;
-        std::string lastTrainingTimestamp;
     };
 
-    const MmrHistoryEntry* FindLatest(const std::vector<MmrHistoryEntry>& history, const MmrHistoryEntry* skip)
-    {
-        const MmrHistoryEntry* latest = nullptr;
-        for (const auto& entry : history)
-        {
-            if (&entry == skip)
-            {
-                continue;
-            }
-            if (latest == nullptr || entry.timestamp > latest->timestamp)
-            {
-                latest = &entry;
-            }
-        }
-        return latest;
-    }
-
-    float TrainingMinutesForDate(const std::vector<TrainingHistoryEntry>& history, const std::string& date)
-    {
-        float minutes = 0.0f;
-        for (const auto& entry : history)
-        {
-            const std::string finishedDate = ExtractDatePortion(
-                entry.finishedTime.empty() ? entry.startedTime : entry.finishedTime
-            );
-            if (finishedDate == date)
-            {
-                minutes += static_cast<float>(entry.actualDuration) / 60.0f;
-            }
-        }
-        return minutes;
-    }
-
+    // Reads the snapshot's precomputed index only; no scans, no allocation.
     HistoryOverlaySummary BuildOverlaySummary(const HistorySnapshot& snapshot)
     {
         HistoryOverlaySummary summary;
         summary.mmrEntries = snapshot.status.mmrEntries;
         summary.trainingEntries = snapshot.status.trainingSessions;
-        summary.lastMmrTimestamp = snapshot.status.lastMmrTimestamp;
-        summary.lastTrainingTimestamp = snapshot.status.lastTrainingTimestamp;
-
-        const MmrHistoryEntry* latest = FindLatest(snapshot.mmrHistory, nullptr);
-        const MmrHistoryEntry* previous = FindLatest(snapshot.mmrHistory, latest);
-        if (latest != nullptr)
-        {
-            summary.latestMmr = latest->mmr;
-        }
-        if (latest != nullptr && previous != nullptr)
-        {
-            summary.latestMmrDelta = latest->mmr - previous->mmr;
-        }
 
-        if (latest != nullptr)
-        {
-            const std::string dateKey = ExtractDatePortion(latest->timestamp);
-            summary.latestTrainingMinutes = TrainingMinutesForDate(snapshot.trainingHistory, dateKey);
-        }
-        else if (!snapshot.trainingHistory.empty())
+        const LatestMmrPair& recent = snapshot.index.overall;
+        if (recent.latest >= 0)
         {
-            summary.latestTrainingMinutes = static_cast<float>(snapshot.trainingHistory.back().actualDuration) / 60.0f;
+            summary.latestMmr = snapshot.mmrHistory[static_cast<size_t>(recent.latest)].mmr;
+            if (recent.previous >= 0)
+            {
+                summary.latestMmrDelta = summary.latestMmr - snapshot.mmrHistory[static_cast<size_t>(recent.previous)].mmr;
+            }
         }
+        summary.latestTrainingMinutes = SnapshotIndex::LatestDayTrainingMinutes(snapshot);
 
         return summary;
     }
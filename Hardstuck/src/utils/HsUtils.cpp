@@ -4,25 +4,8 @@
 #include <iomanip>
 #include <ctime>
 #include <cstring>
-
-std::string ExtractDatePortion(const std::string& timestamp)
-{
-    if (timestamp.empty())
-        return timestamp;
-
-    const size_t posT = timestamp.find('T');
-    if (posT != std::string::npos)
-        return timestamp.substr(0, posT);
-
-    const size_t posSpace = timestamp.find(' ');
-    if (posSpace != std::string::npos)
-        return timestamp.substr(0, posSpace);
-
-    if (timestamp.size() > 10)
-        return timestamp.substr(0, 10);
-
-    return timestamp;
-}
+#include <cstdio>
+#include <array>
 
 std::string FormatTimestamp(const std::chrono::system_clock::time_point& timePoint)
 {
@@ -55,26 +38,6 @@ std::string FormatTimestampUk(const std::chrono::system_clock::time_point& timeP
     return oss.str();
 }
 
-std::string FormatTimestampStringUk(const std::string& timestamp)
-{
-    if (timestamp.empty())
-    {
-        return timestamp;
-    }
-
-    std::tm tmUtc{};
-    std::istringstream iss(timestamp);
-    iss >> std::get_time(&tmUtc, "%Y-%m-%dT%H:%M:%SZ");
-    if (iss.fail())
-    {
-        return timestamp;
-    }
-
-    std::ostringstream oss;
-    oss << std::put_time(&tmUtc, "%d/%m/%Y %H:%M:%S");
-    return oss.str();
-}
-
 std::string JsonEscape(const std::string& value)
 {
     std::ostringstream oss;
@@ -94,3 +57,242 @@ std::string JsonEscape(const std::string& value)
     oss << '"';
     return oss.str();
 }
+
+namespace
+{
+    // Howard Hinnant's civil calendar conversions (proleptic Gregorian, UTC).
+    int64_t DaysFromCivil(int64_t year, unsigned month, unsigned day)
+    {
+        year -= month <= 2 ? 1 : 0;
+        const int64_t era = (year >= 0 ? year : year - 399) / 400;
+        const unsigned yoe = static_cast<unsigned>(year - era * 400);
+        const unsigned doy = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+        const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+        return era * 146097 + static_cast<int64_t>(doe) - 719468;
+    }
+
+    void CivilFromDays(int64_t days, int64_t& year, unsigned& month, unsigned& day)
+    {
+        days += 719468;
+        const int64_t era = (days >= 0 ? days : days - 146096) / 146097;
+        const unsigned doe = static_cast<unsigned>(days - era * 146097);
+        const unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+        const unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+        const unsigned mp = (5 * doy + 2) / 153;
+        day = doy - (153 * mp + 2) / 5 + 1;
+        month = mp < 10 ? mp + 3 : mp - 9;
+        year = static_cast<int64_t>(yoe) + era * 400 + (month <= 2 ? 1 : 0);
+    }
+
+    bool ReadDigits(std::string_view text, size_t pos, size_t count, unsigned& value)
+    {
+        value = 0;
+        if (pos + count > text.size())
+        {
+            return false;
+        }
+        for (size_t i = pos; i < pos + count; ++i)
+        {
+            if (text[i] < '0' || text[i] > '9')
+            {
+                return false;
+            }
+            value = value * 10 + static_cast<unsigned>(text[i] - '0');
+        }
+        return true;
+    }
+
+    std::array<uint32_t, 256> BuildCrcTable()
+    {
+        std::array<uint32_t, 256> table{};
+        for (uint32_t i = 0; i < 256; ++i)
+        {
+            uint32_t c = i;
+            for (int k = 0; k < 8; ++k)
+            {
+                c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : (c >> 1);
+            }
+            table[i] = c;
+        }
+        return table;
+    }
+}
+
+bool ParseTimestampEpoch(std::string_view timestamp, int64_t& epochSeconds)
+{
+    // YYYY-MM-DD[(T| )HH:MM[:SS[.fff]]][Z|+HH:MM|-HH:MM]
+    unsigned year = 0, month = 0, day = 0, hour = 0, minute = 0, second = 0;
+    if (timestamp.size() < 10 || timestamp[4] != '-' || timestamp[7] != '-'
+        || !ReadDigits(timestamp, 0, 4, year) || !ReadDigits(timestamp, 5, 2, month)
+        || !ReadDigits(timestamp, 8, 2, day))
+    {
+        return false;
+    }
+
+    size_t pos = 10;
+    if (pos < timestamp.size() && (timestamp[pos] == 'T' || timestamp[pos] == ' '))
+    {
+        if (!ReadDigits(timestamp, pos + 1, 2, hour) || pos + 3 >= timestamp.size()
+            || timestamp[pos + 3] != ':' || !ReadDigits(timestamp, pos + 4, 2, minute))
+        {
+            return false;
+        }
+        pos += 6;
+        if (pos < timestamp.size() && timestamp[pos] == ':')
+        {
+            if (!ReadDigits(timestamp, pos + 1, 2, second))
+            {
+                return false;
+            }
+            pos += 3;
+            if (pos < timestamp.size() && (timestamp[pos] == '.' || timestamp[pos] == ','))
+            {
+                const size_t fractionStart = ++pos;
+                while (pos < timestamp.size() && timestamp[pos] >= '0' && timestamp[pos] <= '9')
+                {
+                    ++pos;
+                }
+                if (pos == fractionStart)
+                {
+                    return false;
+                }
+            }
+        }
+    }
+
+    int64_t offsetSeconds = 0;
+    if (pos < timestamp.size() && (timestamp[pos] == 'Z' || timestamp[pos] == 'z'))
+    {
+        ++pos;
+    }
+    else if (pos < timestamp.size() && (timestamp[pos] == '+' || timestamp[pos] == '-'))
+    {
+        const int sign = timestamp[pos] == '-' ? -1 : 1;
+        unsigned offsetHours = 0, offsetMinutes = 0;
+        if (!ReadDigits(timestamp, pos + 1, 2, offsetHours))
+        {
+            return false;
+        }
+        pos += 3;
+        if (pos < timestamp.size() && timestamp[pos] == ':')
+        {
+            ++pos;
+        }
+        if (pos < timestamp.size())
+        {
+            if (!ReadDigits(timestamp, pos, 2, offsetMinutes))
+            {
+                return false;
+            }
+            pos += 2;
+        }
+        if (offsetHours > 23 || offsetMinutes > 59)
+        {
+            return false;
+        }
+        offsetSeconds = sign * static_cast<int64_t>(offsetHours * 3600 + offsetMinutes * 60);
+    }
+    if (pos != timestamp.size())
+    {
+        return false;
+    }
+    if (month < 1 || month > 12 || day < 1 || day > 31 || hour > 23 || minute > 59 || second > 60)
+    {
+        return false;
+    }
+
+    epochSeconds = DaysFromCivil(year, month, day) * 86400
+        + static_cast<int64_t>(hour) * 3600 + minute * 60 + second - offsetSeconds;
+    return true;
+}
+
+std::string FormatTimestampEpoch(int64_t epochSeconds)
+{
+    int64_t days = epochSeconds / 86400;
+    int64_t secondsOfDay = epochSeconds % 86400;
+    if (secondsOfDay < 0)
+    {
+        secondsOfDay += 86400;
+        --days;
+    }
+
+    int64_t year = 0;
+    unsigned month = 0;
+    unsigned day = 0;
+    CivilFromDays(days, year, month, day);
+
+    char buffer[48];
+    std::snprintf(buffer, sizeof(buffer), "%04lld-%02u-%02uT%02d:%02d:%02dZ",
+                  static_cast<long long>(year), month, day,
+                  static_cast<int>(secondsOfDay / 3600),
+                  static_cast<int>((secondsOfDay / 60) % 60),
+                  static_cast<int>(secondsOfDay % 60));
+    return buffer;
+}
+
+int64_t ToEpochSeconds(const std::chrono::system_clock::time_point& timePoint)
+{
+    return std::chrono::duration_cast<std::chrono::seconds>(timePoint.time_since_epoch()).count();
+}
+
+int32_t EpochDay(int64_t epochSeconds)
+{
+    int64_t days = epochSeconds / 86400;
+    if (epochSeconds % 86400 < 0)
+    {
+        --days;
+    }
+    return static_cast<int32_t>(days);
+}
+
+std::string FormatTimestampEpochUk(int64_t epochSeconds)
+{
+    if (epochSeconds == 0)
+    {
+        return std::string();
+    }
+
+    const int32_t days = EpochDay(epochSeconds);
+    const int64_t secondsOfDay = epochSeconds - static_cast<int64_t>(days) * 86400;
+    int64_t year = 0;
+    unsigned month = 0;
+    unsigned day = 0;
+    CivilFromDays(days, year, month, day);
+
+    char buffer[48];
+    std::snprintf(buffer, sizeof(buffer), "%02u/%02u/%04lld %02d:%02d:%02d",
+                  day, month, static_cast<long long>(year),
+                  static_cast<int>(secondsOfDay / 3600),
+                  static_cast<int>((secondsOfDay / 60) % 60),
+                  static_cast<int>(secondsOfDay % 60));
+    return buffer;
+}
+
+std::string FormatEpochDay(int32_t day)
+{
+    if (day == 0)
+    {
+        return std::string();
+    }
+
+    int64_t year = 0;
+    unsigned month = 0;
+    unsigned dayOfMonth = 0;
+    CivilFromDays(day, year, month, dayOfMonth);
+
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), "%04lld-%02u-%02u", static_cast<long long>(year), month, dayOfMonth);
+    return buffer;
+}
+
+uint32_t Crc32(const void* data, size_t size, uint32_t crc)
+{
+    static const std::array<uint32_t, 256> table = BuildCrcTable();
+    const auto* bytes = static_cast<const unsigned char*>(data);
+    crc = ~crc;
+    for (size_t i = 0; i < size; ++i)
+    {
+        crc = table[(crc ^ bytes[i]) & 0xFFu] ^ (crc >> 8);
+    }
+    return ~crc;
+}
@@ -0,0 +1,128 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "storage/MappedFile.h"
+
+// Fixed-width binary sidecar for the JSONL store (<store>.idx). Each record holds the
+// numeric columns of one payload line plus its byte offset, so a cold history load can
+// scan the mapped records instead of parsing JSON. Strings are interned into
+// <store>.idx.sym and referenced by id.
+class HistoryIndex
+{
+public:
+    enum RecordFlags : uint16_t
+    {
+        // Set by older builds for timestamps they could not convert; re-read the JSON line.
+        kTimestampNeedsText = 1 << 0,
+    };
+
+#pragma pack(push, 1)
+    struct Record
+    {
+        int64_t timestamp{0};      // epoch seconds
+        uint64_t lineOffset{0};    // byte offset of the source line in the store
+        int32_t mmr{0};
+        int32_t gamesPlayedDiff{0};
+        int32_t durationSeconds{0};
+        uint16_t playlistId{0};
+        uint16_t sessionTypeId{0};
+        uint16_t sourceId{0};
+        uint16_t flags{0};
+        uint32_t lineLength{0};
+    };
+#pragma pack(pop)
+    static_assert(sizeof(Record) == 40, "HistoryIndex::Record must stay fixed-width");
+
+    explicit HistoryIndex(std::filesystem::path storePath);
+
+    // For stores that are not plain files (compressed segments): take the store's size and
+    // first line from the caller instead of reading storePath. The sidecar must then cover
+    // the whole store.
+    void SetStoreHead(uint64_t size, uint32_t headLength, uint32_t headCrc);
+
+    // Map the sidecar and validate its checksums against the store. Returns false when the
+    // sidecar is missing or does not describe the current store; call Reset() to rebuild.
+    bool Open(std::string& error);
+
+    // Release the mapping; appends keep working.
+    void Unmap();
+
+    // Drop all records and start a fresh sidecar for the current store.
+    bool Reset(std::string& error);
+
+    // Reset() in memory only: records can be interned and built against the empty index, and
+    // the sidecar files are recreated by the next Append().
+    void Clear();
+
+    // Append records for newly indexed lines; `sourceBytes` is the store size they cover.
+    bool Append(const std::vector<Record>& records,
+                uint64_t sourceBytes,
+                uint32_t lineCount,
+                uint32_t skippedLines,
+                std::string& error);
+
+    uint16_t Intern(const std::string& value);
+    const std::string& Symbol(uint16_t id) const;
+
+    size_t RecordCount() const { return static_cast<size_t>(header_.recordCount); }
+    const Record* Records() const; // valid while mapped
+    uint64_t SourceBytes() const { return header_.sourceBytes; }
+    uint32_t LineCount() const { return header_.lineCount; }
+    uint32_t SkippedLines() const { return header_.skippedLines; }
+
+    std::filesystem::path GetIndexPath() const { return indexPath_; }
+
+    // Move or delete the sidecar files of `storePath` along with the store itself (rotation).
+    // Missing sidecars are not an error.
+    static bool RenameSidecars(const std::filesystem::path& from, const std::filesystem::path& to, std::string& error);
+    static void RemoveSidecars(const std::filesystem::path& storePath);
+
+    // Store bytes the sidecar of `storePath` covers, from its header alone. False when there
+    // is no sidecar or its header is damaged.
+    static bool ReadSourceBytes(const std::filesystem::path& storePath, uint64_t& sourceBytes);
+
+private:
+#pragma pack(push, 1)
+    struct Header
+    {
+        char magic[4]{'H', 'S', 'I', 'X'};
+        uint32_t version{1};
+        uint64_t recordCount{0};
+        uint64_t sourceBytes{0};
+        uint32_t headLength{0};   // length of the store's first line (incl. newline)
+        uint32_t headCrc{0};      // CRC of that first line; detects a replaced store
+        uint32_t recordsCrc{0};
+        uint32_t symbolCount{0};
+        uint32_t lineCount{0};
+        uint32_t skippedLines{0};
+        uint32_t reserved{0};
+        uint32_t headerCrc{0};
+    };
+#pragma pack(pop)
+    static_assert(sizeof(Header) == 56, "HistoryIndex::Header must stay fixed-width");
+
+    bool ReadStoreHead(uint32_t& length, uint32_t& crc) const;
+    bool LoadSymbols(std::string& error);
+    bool CreateFiles(std::string& error);
+    bool WriteHeader(std::string& error);
+    static uint32_t HeaderCrc(const Header& header);
+
+    std::filesystem::path storePath_;
+    std::filesystem::path indexPath_;
+    std::filesystem::path symbolPath_;
+    Header header_;
+    MappedFile mapping_;
+    std::vector<std::string> symbols_;
+    std::unordered_map<std::string, uint16_t> symbolIds_;
+    uint32_t persistedSymbols_{0};
+    bool recreate_{false}; // cleared in memory; files not truncated yet
+    bool storeHeadSupplied_{false};
+    uint64_t suppliedStoreSize_{0};
+    uint32_t suppliedHeadLength_{0};
+    uint32_t suppliedHeadCrc_{0};
+};
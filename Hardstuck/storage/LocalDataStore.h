@@ -1,28 +1,90 @@
 #pragma once
 
+#include <array>
+#include <atomic>
+#include <condition_variable>
 #include <filesystem>
+#include <memory>
 #include <mutex>
 #include <cstdint>
 #include <string>
+#include <string_view>
 #include <vector>
 
 #include "history/HistoryTypes.h"
+#include "storage/HistoryIndex.h"
+#include "storage/StoreFile.h"
+#include "storage/StoreJournal.h"
 
 // Append-only local persistence for match/MMR snapshots.
 class LocalDataStore
 {
 public:
+    // Recovers the store first: appends a crash left torn or unframed in the journal are cut
+    // from its end (see StoreJournal), reading only the end of the store.
     explicit LocalDataStore(std::filesystem::path baseDirectory, std::string userId);
+    ~LocalDataStore();
 
-    // Append one or more payloads to disk (JSONL).
+    // Append one or more payloads to disk (JSONL). Concurrent appends are group-committed:
+    // one caller writes every waiting caller's lines with a single write, and each returns
+    // once its lines have reached the configured durability.
     bool AppendPayload(const std::string& payload, std::string& error);
     bool AppendPayloads(const std::vector<std::string>& payloads, std::string& error);
 
-    // Build a HistorySnapshot from persisted payloads.
+    // Build a HistorySnapshot from persisted payloads: the rotated segments (<store>.N, oldest
+    // first) and the current store, merged by timestamp. Only lines appended since the
+    // previous call are parsed; rotation or truncation triggers a rebuild, in which sealed
+    // segments are parsed on a bounded pool without holding up appends, or taken from the
+    // previous load when unchanged.
+    //
+    // The shared form hands out the cached snapshot itself: the same pointer until something
+    // changes, never modified afterwards. The copying form is for callers that want to own
+    // their copy.
+    bool LoadHistory(std::shared_ptr<const HistorySnapshot>& snapshot, std::string& error) const;
     bool LoadHistory(HistorySnapshot& snapshot, std::string& error) const;
 
-    // Append and verify last line persisted.
-    bool AppendPayloadsWithVerification(const std::vector<std::string>& payloads, std::string& error);
+    // Replace each plain sealed segment whose sidecar covers it with its compressed form
+    // (<store>.N.hsz, see SegmentArchive). Not part of loading: run it in the background.
+    // Appends are only held for the final renames.
+    bool CompressSealedSegments(std::string& error);
+
+    // Read-back result for one appended line (payload plus newline).
+    struct RecordVerification
+    {
+        uint64_t offset{0};
+        uint32_t length{0};
+        uint32_t crc{0};
+        bool ok{false};
+    };
+
+    struct AppendVerification
+    {
+        bool ok{false};
+        std::vector<RecordVerification> records;
+    };
+
+    // Append, then read back only the bytes just written and check each line against the
+    // CRC computed before writing. `verification` (optional) receives the per-record result.
+    bool AppendPayloadsWithVerification(const std::vector<std::string>& payloads,
+                                        std::string& error,
+                                        AppendVerification* verification = nullptr);
+
+    // Force appended data to stable storage.
+    bool Sync(std::string& error);
+
+    // Flush by default. Verified appends are always written through to the file, since
+    // they read the bytes back.
+    void SetDurability(StoreFile::Durability durability);
+    StoreFile::Durability GetDurability() const;
+
+    struct AppendStats
+    {
+        uint64_t groups{0};   // commit groups, one per leader
+        uint64_t payloads{0};
+        uint64_t writes{0};   // write calls on the store file
+        uint64_t syncs{0};
+    };
+    AppendStats GetAppendStats() const;
 
     // Import cached payloads from older queue files, if any.
     bool ReplayLegacyCache(std::string& error);
@@ -34,19 +96,123 @@ public:
 private:
     struct PayloadSummary
     {
-        std::string timestamp;
-        std::string playlist;
+        int64_t timestamp{0}; // epoch seconds; 0 when the payload's timestamp is unparseable
+        SymbolId playlist{0};  // ids into the cached snapshot's symbol tables
         int mmr{0};
         int gamesPlayedDiff{0};
-        std::string source;
-        std::string sessionType;
+        SymbolId source{0};
+        SymbolId sessionType{0};
         int durationSeconds{0};
     };
 
-    bool ParsePayloadSummary(const std::string& payload, PayloadSummary& summary, std::string& error) const;
-    bool BuildSnapshot(const std::vector<PayloadSummary>& entries, HistorySnapshot& snapshot, std::string& error) const;
-    bool ReadPayloadLines(std::vector<std::string>& lines, std::string& error) const;
-    bool AppendLines(const std::vector<std::string>& payloads, std::string& error);
+    struct PayloadLine
+    {
+        uint64_t offset{0};
+        std::string_view text; // into the mapped store
+    };
+
+    // Parsed contents of one rotated segment, plain (<store>.N) or compressed
+    // (<store>.N.hsz). Rotation renames segments, so a segment is recognised by size and
+    // write time rather than by name.
+    struct SealedSegment
+    {
+        uint64_t size{0};
+        std::filesystem::file_time_type modified{};
+        std::vector<PayloadSummary> entries; // ids into the cached snapshot's symbol tables
+        size_t skipped{0};
+        std::string firstParseError;
+    };
+
+    struct SegmentLoad; // one worker's input and output, see ParseSealedSegments
+    struct CommitGroup; // lines of concurrent appenders, written together, see AppendLines
+
+    // A snapshot built from the cached entries, see PublishSnapshot.
+    struct SnapshotBuffer
+    {
+        struct Slot
+        {
+            HistorySnapshot snapshot;
+            std::atomic<int> handles{0}; // handed out and not yet released by their readers
+        };
+
+        // Hands out the snapshot, reusing the handle given out last while anyone holds it.
+        std::shared_ptr<const HistorySnapshot> HandOut();
+
+        std::shared_ptr<Slot> slot;
+        std::weak_ptr<const HistorySnapshot> handle; // last handle given out
+        std::vector<int> lastMmrByPlaylist; // indexed by playlist id; kNoMmr until seen
+        uint64_t epoch{0};                  // HistoryCache::epoch it was built in
+        size_t entries{0};                  // leading HistoryCache::entries it covers
+    };
+
+    // Parsed state of the store up to `offset`, reused by LoadHistory between calls.
+    struct HistoryCache
+    {
+        bool indexImported{false};
+        bool indexWritable{true};
+        uint64_t offset{0};
+        uint64_t generation{0};
+        size_t linesRead{0};
+        std::vector<PayloadSummary> entries; // sealed and live, sorted by timestamp, then playlist
+        uint64_t epoch{0};                   // bumped when entries change other than at the end
+        std::vector<SealedSegment> sealed;   // oldest first; kept across rebuilds
+        HistorySymbols symbols;              // every id above refers to these; outlive rebuilds
+        std::array<SnapshotBuffer, 2> buffers;
+        int published{-1};                   // buffer last handed out
+        size_t skipped{0};                   // live store only
+        std::string firstParseError;
+    };
+
+    bool ParsePayloadSummary(std::string_view payload,
+                             HistorySymbols& symbols,
+                             PayloadSummary& summary,
+                             std::string& error) const;
+    std::shared_ptr<const HistorySnapshot> PublishSnapshot(HistoryCache& cache) const;
+    void AppendSnapshotEntries(HistoryCache& cache, SnapshotBuffer& buffer) const;
+    void FinalizeSnapshotStatus(HistorySnapshot& snapshot) const;
+    bool ImportHistoryIndex(HistoryCache& cache) const;
+    void ReadIndexRecords(const HistoryIndex& index,
+                          const std::filesystem::path& store,
+                          HistorySymbols& symbols,
+                          std::vector<PayloadSummary>& entries) const;
+    // Callers hold fileMutex_.
+    std::vector<SegmentLoad> ListSealedSegments() const;
+    // Callers hold cacheMutex_ only; reads the segments and builds sidecar updates in memory.
+    void ParseSealedSegments(HistoryCache& cache, std::vector<SegmentLoad>& loads) const;
+    // Callers also hold fileMutex_, with no rotation since the segments were listed.
+    void CommitSealedSegments(HistoryCache& cache, std::vector<SegmentLoad>& loads) const;
+    void ParseSealedSegment(SegmentLoad& load) const;
+    void ParseArchivedSegment(SegmentLoad& load) const;
+    size_t ParseSegmentLines(std::string_view data,
+                             size_t offset,
+                             SegmentLoad& load,
+                             HistoryIndex* index,
+                             std::vector<HistoryIndex::Record>& records,
+                             uint32_t& lineCount) const;
+    bool CompressSegment(const std::filesystem::path& segment, uint64_t generation, std::string& error);
+    static HistoryIndex::Record MakeIndexRecord(const PayloadSummary& summary,
+                                                const HistorySymbols& symbols,
+                                                HistoryIndex& index,
+                                                uint64_t offset,
+                                                size_t length);
+    // Callers hold fileMutex_. `lines` point into `mapping`, which stays valid once the lock
+    // is released: the store is only ever appended to or renamed, never rewritten in place.
+    bool ReadPayloadLines(MappedFile& mapping,
+                          uint64_t& offset,
+                          uint64_t& generation,
+                          std::vector<PayloadLine>& lines,
+                          bool& restarted,
+                          std::string& error) const;
+    bool AppendLines(const std::vector<std::string>& payloads,
+                     std::string& error,
+                     AppendVerification* verification = nullptr);
+    bool VerifyAppendedLines(AppendVerification& verification, std::string& error) const;
+    void WriteGroup(CommitGroup& group);
+    void RecoverStore();
+    // Callers hold fileMutex_.
+    bool OpenStoreFile(std::string& error) const;
+    bool WritePending(std::string& error) const;
+    bool WriteStore(std::string_view bytes, std::string& error) const;
     bool RotateIfNeeded(std::string& error);
 
     std::filesystem::path baseDirectory_;
@@ -55,6 +221,22 @@ private:
     std::filesystem::path legacyCachePath_;
     std::filesystem::path legacyBackupPath_;
     mutable std::mutex fileMutex_;
+    uint64_t storeGeneration_{0}; // bumped on rotation; guarded by fileMutex_
+    // Write path, guarded by fileMutex_. Mutable so that reads can flush buffered appends.
+    mutable StoreFile::AppendHandle storeFile_;
+    mutable std::string pending_; // buffered appends not yet written
+    std::unique_ptr<StoreJournal> journal_;
+    mutable bool tornTail_{false}; // a failed write may have left bytes past tornOffset_
+    mutable uint64_t tornOffset_{0};
+    mutable AppendStats appendStats_;
+    StoreFile::Durability durability_{StoreFile::Durability::Flush};
+    std::mutex commitMutex_;
+    std::condition_variable commitCv_;
+    std::shared_ptr<CommitGroup> openGroup_; // collecting appenders; guarded by commitMutex_
+    bool committing_{false};                 // a leader is writing; guarded by commitMutex_
+    mutable std::mutex cacheMutex_;
+    mutable HistoryCache historyCache_;
+    std::unique_ptr<HistoryIndex> historyIndex_; // guarded by cacheMutex_
     uint64_t maxBytes_{0};
     int maxFiles_{1};
 };
@@ -0,0 +1,21 @@
+// Lz4Block.h
+#pragma once
+
+#include <cstddef>
+
+// LZ4 block format (no frame): sequences of literals and back-references within a 64 KB
+// window, decodable by any LZ4 block decoder. The encoder is a single-pass greedy matcher,
+// tuned for JSONL, where keys repeat on every line.
+namespace Lz4Block
+{
+    // Worst-case encoded size of `size` input bytes.
+    size_t CompressBound(size_t size);
+
+    // Encode `size` bytes into `dest`, which needs CompressBound(size) bytes. Returns the
+    // encoded length, or 0 when `capacity` is too small.
+    size_t Compress(const char* source, size_t size, char* dest, size_t capacity);
+
+    // Decode exactly `destSize` bytes. Returns false on malformed or truncated input and
+    // never writes outside `dest`.
+    bool Decompress(const char* source, size_t size, char* dest, size_t destSize);
+}
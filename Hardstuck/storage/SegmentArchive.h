@@ -0,0 +1,94 @@
+// SegmentArchive.h
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "storage/MappedFile.h"
+
+// Compressed, read-only copy of a sealed store segment (<segment>.hsz). The JSONL is cut
+// into line-aligned blocks of about 64 KB, each compressed with Lz4Block, followed by a
+// block index holding every block's raw offset and time span. Readers decompress only
+// the blocks they need.
+//
+// Layout: Header | block 0 | block 1 | ... | BlockInfo[blockCount]
+class SegmentArchive
+{
+public:
+    // Timestamp of the line starting at `offset` in the raw segment (0 when unknown).
+    struct LineTime
+    {
+        uint64_t offset{0};
+        int64_t timestamp{0};
+    };
+
+#pragma pack(push, 1)
+    struct BlockInfo
+    {
+        uint64_t rawOffset{0};
+        uint64_t fileOffset{0};
+        uint32_t rawSize{0};
+        uint32_t storedSize{0};    // equal to rawSize when the block is stored uncompressed
+        int64_t minTimestamp{0};   // 0/0 when no line of the block had a timestamp
+        int64_t maxTimestamp{0};
+        uint32_t rawCrc{0};
+        uint32_t reserved{0};
+    };
+#pragma pack(pop)
+    static_assert(sizeof(BlockInfo) == 48, "SegmentArchive::BlockInfo must stay fixed-width");
+
+    // Compress `data` (whole lines) into `target`, via a temporary file and a rename so a
+    // crash never leaves a partial archive under the final name. `lineTimes` must be sorted
+    // by offset; lines without an entry do not widen their block's time span.
+    static bool Write(std::string_view data,
+                      const std::vector<LineTime>& lineTimes,
+                      const std::filesystem::path& target,
+                      std::string& error);
+
+    bool Open(const std::filesystem::path& path, std::string& error);
+    void Close();
+
+    uint64_t RawSize() const { return header_.rawBytes; }
+    // Length and CRC of the raw segment's first line, as HistoryIndex records them.
+    uint32_t HeadLength() const { return header_.headLength; }
+    uint32_t HeadCrc() const { return header_.headCrc; }
+
+    size_t BlockCount() const { return blocks_.size(); }
+    const BlockInfo& Block(size_t index) const { return blocks_[index]; }
+
+    // Append the raw bytes of one block, or of the whole segment, to `out`.
+    bool ReadBlock(size_t index, std::string& out, std::string& error) const;
+    bool ReadAll(std::string& out, std::string& error) const;
+
+    // Append every block whose time span overlaps [from, to], plus blocks with no known
+    // times. The result is whole lines; callers filter lines at the edges themselves.
+    bool ReadRange(int64_t from, int64_t to, std::string& out, std::string& error) const;
+
+private:
+#pragma pack(push, 1)
+    struct Header
+    {
+        char magic[4]{'H', 'S', 'Z', '1'};
+        uint32_t version{1};
+        uint64_t rawBytes{0};
+        uint64_t indexOffset{0};
+        uint32_t blockCount{0};
+        uint32_t headLength{0};
+        uint32_t headCrc{0};
+        uint32_t indexCrc{0};
+        uint32_t reserved{0};
+        uint32_t headerCrc{0};
+    };
+#pragma pack(pop)
+    static_assert(sizeof(Header) == 48, "SegmentArchive::Header must stay fixed-width");
+
+    static uint32_t HeaderCrc(const Header& header);
+
+    MappedFile mapping_;
+    Header header_;
+    std::vector<BlockInfo> blocks_;
+};
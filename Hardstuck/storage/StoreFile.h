@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <string_view>
+
+// Low-level file helpers for the local store.
+namespace StoreFile
+{
+    // What an append has to reach before it returns.
+    enum class Durability
+    {
+        Buffered, // process memory; written when the buffer fills, on Sync() and before reads
+        Flush,    // the OS (one write per batch); survives a crash of the game, not of the machine
+        Fsync,    // stable storage (write + fsync per batch)
+    };
+
+    // "buffered", "flush" or "fsync".
+    bool ParseDurability(std::string_view text, Durability& durability);
+    const char* DurabilityName(Durability durability);
+
+    // Flush the OS cache for `path` to stable storage (FlushFileBuffers / fsync).
+    bool Sync(const std::filesystem::path& path, std::string& error);
+
+    // Append-only handle kept open across writes. Each Write is a single write call at the
+    // end of the file (repeated only if the OS accepts part of it).
+    class AppendHandle
+    {
+    public:
+        AppendHandle() = default;
+        ~AppendHandle();
+
+        AppendHandle(const AppendHandle&) = delete;
+        AppendHandle& operator=(const AppendHandle&) = delete;
+
+        // Opens (creating if needed) and positions at the end.
+        bool Open(const std::filesystem::path& path, std::string& error);
+        void Close();
+
+        bool IsOpen() const { return open_; }
+        // File size as of Open plus everything written through this handle.
+        uint64_t Size() const { return size_; }
+
+        bool Write(std::string_view data, std::string& error);
+        bool Sync(std::string& error);
+
+    private:
+        std::filesystem::path path_;
+        uint64_t size_{0};
+        bool open_{false};
+#ifdef _WIN32
+        void* handle_{nullptr};
+#else
+        int fd_{-1};
+#endif
+    };
+}
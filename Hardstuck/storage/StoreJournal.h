@@ -0,0 +1,88 @@
+// StoreJournal.h
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <iosfwd>
+#include <string>
+#include <string_view>
+
+#include "storage/StoreFile.h"
+
+// Commit log for the live store (<store>.journal). The store itself stays plain JSONL;
+// every appended line gets a fixed-width frame here with its offset, length and CRC,
+// written after the line. An intact frame whose line no longer matches the store proves
+// that append torn; the last frame that does match marks where the committed store ends.
+// Recovery only reads the end of both files, whatever the size of the store.
+//
+// Layout: Header | Frame[]
+class StoreJournal
+{
+public:
+#pragma pack(push, 1)
+    struct Frame
+    {
+        uint64_t offset{0};   // of the line in the store
+        uint32_t length{0};   // including the newline
+        uint32_t crc{0};      // of those bytes
+        uint32_t frameCrc{0}; // of the fields above
+        uint32_t reserved{0};
+    };
+#pragma pack(pop)
+    static_assert(sizeof(Frame) == 24, "StoreJournal::Frame must stay fixed-width");
+
+    struct Recovery
+    {
+        uint64_t storeBytes{0};     // committed size of the store
+        uint64_t cutBytes{0};       // removed from the end of the store
+        uint64_t droppedFrames{0};  // frames whose line was not in the store
+        bool journaled{true};       // false when no frame matched the store and only a
+                                    // partial final line could be detected
+    };
+
+    explicit StoreJournal(std::filesystem::path storePath);
+
+    // Cut the store back to before the first append its frames prove torn, and the journal
+    // to its last matching frame. Run before the store is opened for appending. Complete
+    // lines no frame speaks against are kept; only a final line lacking its newline is cut.
+    // A journal none of whose frames match (older stores, a store replaced or edited by
+    // hand, a journal discarded after a failed write) is restarted rather than trusted.
+    bool Recover(Recovery& recovery, std::string& error);
+
+    // Open for appending to a store of `storeSize` bytes. A journal that does not end where
+    // the store does is restarted there.
+    bool Open(uint64_t storeSize, std::string& error);
+    void Close();
+    bool IsOpen() const { return file_.IsOpen(); }
+
+    // Frame the whole lines of `lines`, just written to the store at `offset`, in one write.
+    bool Append(std::string_view lines, uint64_t offset, std::string& error);
+    bool Sync(std::string& error);
+
+    // Close and delete the journal. Used when it can no longer be kept in step with the
+    // store; frames missing from a journal that stayed would make recovery cut good lines.
+    void Discard();
+
+    std::filesystem::path GetPath() const { return path_; }
+
+private:
+#pragma pack(push, 1)
+    struct Header
+    {
+        char magic[4]{'H', 'S', 'J', '1'};
+        uint32_t version{1};
+        uint64_t baseOffset{0}; // store size when the journal was started
+        uint32_t reserved{0};
+        uint32_t headerCrc{0};
+    };
+#pragma pack(pop)
+    static_assert(sizeof(Header) == 24, "StoreJournal::Header must stay fixed-width");
+
+    bool Restart(uint64_t baseOffset, std::string& error);
+    static bool ReadHeader(std::ifstream& input, Header& header);
+    static uint32_t HeaderCrc(const Header& header);
+
+    std::filesystem::path storePath_;
+    std::filesystem::path path_;
+    StoreFile::AppendHandle file_;
+};
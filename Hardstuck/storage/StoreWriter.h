@@ -0,0 +1,88 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "storage/StoreFile.h"
+
+class LocalDataStore;
+
+// Single long-lived writer thread in front of a LocalDataStore. Producers push payloads into
+// a bounded queue; each wakeup drains everything pending into one verified append.
+class StoreWriter
+{
+public:
+    struct Options
+    {
+        size_t capacity{256};
+        // How often written data is forced to disk; zero syncs after every batch.
+        std::chrono::milliseconds syncInterval{1000};
+        // Applied to the store. Buffered batches skip the read-back verification, which
+        // would force them to the file.
+        StoreFile::Durability durability{StoreFile::Durability::Flush};
+    };
+
+    struct BatchResult
+    {
+        bool success{false};
+        std::vector<std::string> payloads;
+        std::string error;
+        std::chrono::microseconds latency{0};
+    };
+
+    struct Stats
+    {
+        size_t queueDepth{0};
+        size_t queueHighWater{0};
+        uint64_t batchesWritten{0};
+        uint64_t payloadsWritten{0};
+        uint64_t rejected{0};
+        std::chrono::microseconds lastLatency{0};
+        std::chrono::microseconds maxLatency{0};
+        std::string lastSyncError;
+    };
+
+    using BatchCallback = std::function<void(const BatchResult&)>;
+
+    StoreWriter(LocalDataStore& store, Options options, BatchCallback onBatch);
+    ~StoreWriter();
+
+    StoreWriter(const StoreWriter&) = delete;
+    StoreWriter& operator=(const StoreWriter&) = delete;
+
+    // Returns false (and counts a rejection) when the queue is full or stopping.
+    bool Enqueue(std::string payload);
+
+    // Block until everything enqueued so far has been written.
+    void Flush();
+
+    // Drain the queue, sync, and join the thread. Called by the destructor.
+    void Stop();
+
+    Stats GetStats() const;
+
+    // Change the sync cadence and durability of a running writer; the next batch uses them.
+    void Reconfigure(std::chrono::milliseconds syncInterval, StoreFile::Durability durability);
+
+private:
+    void Run();
+
+    LocalDataStore& store_;
+    Options options_;
+    BatchCallback onBatch_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable wakeCv_;
+    std::condition_variable drainedCv_;
+    std::vector<std::string> queue_;
+    bool writing_{false};
+    bool stopping_{false};
+    Stats stats_;
+    std::thread thread_;
+};
@@ -0,0 +1,94 @@
+// UploadQueue.h
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "storage/StoreFile.h"
+
+// Durable outbound queue for backend sync, kept next to the local store. Records are
+// appended as "<sequence> <payload>\n" to outbound.queue; the highest acknowledged
+// sequence is stored in outbound.ack. Acknowledged records are dropped from memory at once
+// and compacted out of the file when they make up most of it. Delivery is at-least-once:
+// an ack lost in a crash means the batch is sent again with the same sequence numbers.
+class UploadQueue
+{
+public:
+    struct Record
+    {
+        uint64_t sequence{0};
+        std::string payload;
+    };
+
+    struct Stats
+    {
+        size_t pending{0};
+        uint64_t lastSequence{0};
+        uint64_t ackedSequence{0};
+        uint64_t fileBytes{0};
+        uint64_t compactions{0};
+    };
+
+    explicit UploadQueue(std::filesystem::path directory);
+
+    // Load pending records from disk. Acked records and a torn final line are dropped.
+    bool Open(std::string& error);
+
+    // Assign consecutive sequence numbers and append. Payloads must be single-line. A failed
+    // append leaves nothing behind in the file.
+    bool Append(const std::vector<std::string>& payloads, std::string& error);
+
+    // Fsync by default: Append returns once the records are on stable storage, and ack and
+    // compaction files are synced before they replace the old ones. Flush leaves all of it
+    // to the OS. Buffered is treated as Flush; the syncer may send a record as soon as it
+    // is queued, so it has to be in the file by then.
+    void SetDurability(StoreFile::Durability durability);
+
+    // Oldest pending records, up to `maxRecords` and roughly `maxBytes` of payload (always
+    // at least one record when any are pending).
+    std::vector<Record> PeekBatch(size_t maxRecords, size_t maxBytes) const;
+
+    // Mark every record up to and including `sequence` as delivered.
+    bool Acknowledge(uint64_t sequence, std::string& error);
+
+    // Keep a record the server will never accept in outbound.dead, one JSON line per record
+    // ({"seq":N,"reason":"...","payload":{...}}), before it is acknowledged past. Written
+    // with the queue's durability.
+    bool DeadLetter(const Record& record, const std::string& reason, std::string& error);
+
+    size_t PendingCount() const;
+    Stats GetStats() const;
+
+    std::filesystem::path GetQueuePath() const { return queuePath_; }
+    std::filesystem::path GetDeadLetterPath() const { return deadLetterPath_; }
+
+private:
+    struct Entry
+    {
+        Record record;
+        uint64_t lineBytes{0};
+    };
+
+    bool WriteAck(uint64_t sequence, std::string& error) const;
+    bool OpenFile(std::string& error);
+    bool Compact(std::string& error);
+
+    std::filesystem::path queuePath_;
+    std::filesystem::path ackPath_;
+    std::filesystem::path deadLetterPath_;
+
+    mutable std::mutex mutex_;
+    StoreFile::AppendHandle file_;
+    StoreFile::Durability durability_{StoreFile::Durability::Fsync};
+    bool tornTail_{false}; // a failed append could not be cut back to fileBytes_ yet
+    std::deque<Entry> pending_;
+    uint64_t pendingBytes_{0};
+    uint64_t fileBytes_{0};
+    uint64_t nextSequence_{1};
+    uint64_t ackedSequence_{0};
+    uint64_t compactions_{0};
+};
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstdint>
 #include <string>
 #include <chrono>
 #include <vector>
@@ -7,9 +8,12 @@
 
 #include "history/HistoryTypes.h"   // or wherever HistorySnapshot / MmrHistoryEntry live
 
-// Renders the history window ImGui UI.
+// Renders the history window ImGui UI. Derived views (filtering, sorting, chart series,
+// daily comparison) are cached and rebuilt only when `snapshotVersion` or the window's
+// filter and point-count settings change.
 void HsRenderHistoryWindowUi(
     HistorySnapshot const& snapshot,
+    uint64_t snapshotVersion,
     std::string const& errorMessage,
     bool loading,
     std::chrono::system_clock::time_point lastFetched,
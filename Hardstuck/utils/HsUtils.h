@@ -1,9 +1,28 @@
 #pragma once
 #include <string>
 #include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
 
-std::string ExtractDatePortion(const std::string& timestamp);
 std::string FormatTimestamp(const std::chrono::system_clock::time_point& tp);
 std::string FormatTimestampUk(const std::chrono::system_clock::time_point& tp);
-std::string FormatTimestampStringUk(const std::string& timestamp);
 std::string JsonEscape(const std::string& value);
+
+// Epoch-second conversion (UTC). Parsing accepts ISO-8601 dates with an optional 'T' or
+// space separated time, fractional seconds (dropped) and a Z or +-HH:MM offset; the
+// canonical "%Y-%m-%dT%H:%M:%SZ" form round-trips through FormatTimestampEpoch.
+bool ParseTimestampEpoch(std::string_view timestamp, int64_t& epochSeconds);
+std::string FormatTimestampEpoch(int64_t epochSeconds);
+int64_t ToEpochSeconds(const std::chrono::system_clock::time_point& tp);
+
+// Whole days since 1970-01-01 (UTC), rounding towards the past.
+int32_t EpochDay(int64_t epochSeconds);
+
+// Display forms for the UI: "DD/MM/YYYY HH:MM:SS" and "YYYY-MM-DD". Both return an empty
+// string for 0, the history model's "no timestamp" value.
+std::string FormatTimestampEpochUk(int64_t epochSeconds);
+std::string FormatEpochDay(int32_t day);
+
+// CRC-32 (IEEE); pass a previous result as `crc` to continue over more data.
+uint32_t Crc32(const void* data, size_t size, uint32_t crc = 0);
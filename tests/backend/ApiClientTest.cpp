@@ -0,0 +1,199 @@
+// ApiClient against an in-process transport: URL building, status mapping, and the
+// ordering and shutdown guarantees of the async queue.
+#include <cassert>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "backend/ApiClient.h"
+
+namespace
+{
+    class FakeTransport : public IHttpTransport
+    {
+    public:
+        bool Send(const HttpRequest& request, HttpResponse& response, std::string& error) override
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            ++started_;
+            gateCv_.notify_all();
+            gateCv_.wait(lock, [this] { return open_; });
+
+            Seen seen;
+            seen.method = request.method;
+            seen.url = request.url;
+            seen.headers = request.headers;
+            seen.body = request.body ? *request.body : std::string();
+            seen_.push_back(seen);
+
+            if (seen.body == "fail-transport")
+            {
+                error = "connection reset";
+                return false;
+            }
+            response.statusCode = seen.body == "reject" ? 409 : 200;
+            response.body = seen.body == "reject" ? "duplicate" : "ok:" + seen.body;
+            return true;
+        }
+
+        void SetOpen(bool open)
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                open_ = open;
+            }
+            gateCv_.notify_all();
+        }
+
+        void WaitForStarted(size_t count)
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            gateCv_.wait(lock, [this, count] { return started_ >= count; });
+        }
+
+        struct Seen
+        {
+            std::string method;
+            std::string url;
+            std::vector<HttpHeader> headers;
+            std::string body;
+        };
+
+        std::vector<Seen> Requests()
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            return seen_;
+        }
+
+    private:
+        std::mutex mutex_;
+        std::condition_variable gateCv_;
+        bool open_{true};
+        size_t started_{0};
+        std::vector<Seen> seen_;
+    };
+
+    bool HasHeader(const std::vector<HttpHeader>& headers, const std::string& name, const std::string& value)
+    {
+        for (const auto& header : headers)
+        {
+            if (header.name == name && header.value == value)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+}
+
+int main()
+{
+    {
+        ParsedUrl parsed;
+        std::string error;
+        assert(ParseHttpUrl("https://api.example.com/v1/mmr", parsed, error));
+        assert(parsed.secure && parsed.host == "api.example.com" && parsed.port == 443 && parsed.path == "/v1/mmr");
+        assert(ParseHttpUrl("http://localhost:8080", parsed, error));
+        assert(!parsed.secure && parsed.host == "localhost" && parsed.port == 8080 && parsed.path == "/");
+        assert(!ParseHttpUrl("http://localhost:99999/", parsed, error));
+        assert(!ParseHttpUrl("ftp://localhost/", parsed, error));
+    }
+
+    auto transport = std::make_shared<FakeTransport>();
+
+    // Blocking calls.
+    {
+        ApiClient client(" https://api.example.com/ ", transport);
+        std::string response;
+        std::string error;
+        assert(client.PostJson("/mmr", "{}", { HttpHeader("Authorization", "Bearer t") }, response, error));
+        assert(response == "ok:{}" && error.empty());
+
+        assert(!client.PostJson("mmr", "reject", {}, response, error));
+        assert(error == "HTTP 409: duplicate");
+
+        assert(client.GetJson("status", {}, response, error));
+        assert(response == "ok:" && error.empty());
+
+        auto requests = transport->Requests();
+        assert(requests.size() == 3);
+        assert(requests[0].method == "POST" && requests[0].url == "https://api.example.com/mmr");
+        assert(HasHeader(requests[0].headers, "Authorization", "Bearer t"));
+        assert(HasHeader(requests[0].headers, "Content-Type", "application/json"));
+        assert(requests[1].url == "https://api.example.com/mmr");
+        assert(requests[2].method == "GET" && !HasHeader(requests[2].headers, "Content-Type", "application/json"));
+    }
+
+    // Async requests complete in submission order, through both the future and the callback form.
+    {
+        auto ordered = std::make_shared<FakeTransport>();
+        ApiClient client("http://127.0.0.1:9000", ordered);
+        std::vector<std::future<ApiResult>> futures;
+        for (int i = 0; i < 20; ++i)
+        {
+            futures.push_back(client.PostJsonAsync("/q", std::to_string(i), {}));
+        }
+
+        std::promise<ApiResult> callbackResult;
+        client.PostJsonAsync("/q", "fail-transport", {}, [&callbackResult](const ApiResult& result) {
+            callbackResult.set_value(result);
+        });
+
+        for (int i = 0; i < 20; ++i)
+        {
+            ApiResult result = futures[i].get();
+            assert(result.success && result.response == "ok:" + std::to_string(i));
+        }
+        ApiResult failed = callbackResult.get_future().get();
+        assert(!failed.success && failed.error == "connection reset");
+
+        auto requests = ordered->Requests();
+        assert(requests.size() == 21);
+        for (int i = 0; i < 20; ++i)
+        {
+            assert(requests[i].body == std::to_string(i));
+            assert(HasHeader(requests[i].headers, "Content-Type", "application/json"));
+        }
+    }
+
+    // Destroying the client finishes the request in flight and fails the rest of the queue.
+    {
+        auto gated = std::make_shared<FakeTransport>();
+        gated->SetOpen(false);
+        std::future<ApiResult> first;
+        std::future<ApiResult> second;
+        std::thread opener;
+        {
+            ApiClient client("http://127.0.0.1:9000", gated);
+            first = client.PostJsonAsync("/q", "a", {});
+            gated->WaitForStarted(1);
+            second = client.PostJsonAsync("/q", "b", {});
+            // Release "a" only once the destructor below is already waiting on the worker.
+            opener = std::thread([gated] {
+                std::this_thread::sleep_for(std::chrono::milliseconds(50));
+                gated->SetOpen(true);
+            });
+        }
+        opener.join();
+        ApiResult a = first.get();
+        ApiResult b = second.get();
+        assert(a.success && a.response == "ok:a");
+        assert(!b.success && b.error == "ApiClient shut down");
+    }
+
+    // Missing base URL is reported, not sent.
+    {
+        ApiClient client("", transport);
+        ApiResult result = client.PostJsonAsync("/q", "x", {}).get();
+        assert(!result.success && result.error == "API base URL is empty");
+    }
+
+    std::printf("ApiClientTest passed\n");
+    return 0;
+}
@@ -0,0 +1,349 @@
+// PosixHttpTransport against a loopback HTTP/1.1 server fixture: keep-alive reuse,
+// chunked and close-delimited bodies, stale pooled sockets, timeouts, and ApiClient on top.
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "backend/ApiClient.h"
+#include "backend/PosixHttpTransport.h"
+
+namespace
+{
+    bool SendAll(int fd, const std::string& data)
+    {
+        size_t written = 0;
+        while (written < data.size())
+        {
+            const ssize_t sent = ::send(fd, data.data() + written, data.size() - written, MSG_NOSIGNAL);
+            if (sent <= 0)
+            {
+                return false;
+            }
+            written += static_cast<size_t>(sent);
+        }
+        return true;
+    }
+
+    // Serves each accepted connection on its own thread until the client hangs up.
+    class LoopbackServer
+    {
+    public:
+        LoopbackServer()
+        {
+            listener_ = ::socket(AF_INET, SOCK_STREAM, 0);
+            const int reuse = 1;
+            ::setsockopt(listener_, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+            sockaddr_in address{};
+            address.sin_family = AF_INET;
+            address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+            address.sin_port = 0;
+            assert(::bind(listener_, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0);
+            assert(::listen(listener_, 16) == 0);
+            socklen_t length = sizeof(address);
+            ::getsockname(listener_, reinterpret_cast<sockaddr*>(&address), &length);
+            port_ = ntohs(address.sin_port);
+            acceptor_ = std::thread([this] { AcceptLoop(); });
+        }
+
+        ~LoopbackServer()
+        {
+            stopping_ = true;
+            acceptor_.join();
+            ::close(listener_);
+            for (auto& worker : workers_)
+            {
+                worker.join();
+            }
+        }
+
+        std::string Url(const std::string& path) const
+        {
+            return "http://127.0.0.1:" + std::to_string(port_) + path;
+        }
+
+        int Accepted() const { return accepted_.load(); }
+        int Hangs() const { return hangs_.load(); }
+
+    private:
+        void AcceptLoop()
+        {
+            while (!stopping_)
+            {
+                pollfd ready{ listener_, POLLIN, 0 };
+                if (::poll(&ready, 1, 20) <= 0)
+                {
+                    continue;
+                }
+                const int client = ::accept(listener_, nullptr, nullptr);
+                if (client < 0)
+                {
+                    continue;
+                }
+                ++accepted_;
+                workers_.emplace_back([this, client] { Serve(client); });
+            }
+        }
+
+        void Serve(int client)
+        {
+            std::string buffer;
+            char chunk[4096];
+            for (;;)
+            {
+                size_t headerEnd;
+                while ((headerEnd = buffer.find("\r\n\r\n")) == std::string::npos)
+                {
+                    pollfd ready{ client, POLLIN, 0 };
+                    if (stopping_ || ::poll(&ready, 1, 20) < 0)
+                    {
+                        ::close(client);
+                        return;
+                    }
+                    if (!(ready.revents & POLLIN))
+                    {
+                        continue;
+                    }
+                    const ssize_t got = ::recv(client, chunk, sizeof(chunk), 0);
+                    if (got <= 0)
+                    {
+                        ::close(client);
+                        return;
+                    }
+                    buffer.append(chunk, static_cast<size_t>(got));
+                }
+
+                const std::string head = buffer.substr(0, headerEnd);
+                size_t contentLength = 0;
+                const size_t lengthPos = head.find("Content-Length: ");
+                if (lengthPos != std::string::npos)
+                {
+                    contentLength = std::stoul(head.substr(lengthPos + 16));
+                }
+                while (buffer.size() < headerEnd + 4 + contentLength)
+                {
+                    const ssize_t got = ::recv(client, chunk, sizeof(chunk), 0);
+                    if (got <= 0)
+                    {
+                        ::close(client);
+                        return;
+                    }
+                    buffer.append(chunk, static_cast<size_t>(got));
+                }
+                const std::string body = buffer.substr(headerEnd + 4, contentLength);
+                buffer.erase(0, headerEnd + 4 + contentLength);
+
+                const size_t pathStart = head.find(' ') + 1;
+                const std::string path = head.substr(pathStart, head.find(' ', pathStart) - pathStart);
+                if (!Respond(client, path, head, body))
+                {
+                    ::close(client);
+                    return;
+                }
+            }
+        }
+
+        // Returns false when the route ends the connection.
+        bool Respond(int client, const std::string& path, const std::string& head, const std::string& body)
+        {
+            if (path == "/len")
+            {
+                const std::string payload = "ok:" + body;
+                return SendAll(client, "HTTP/1.1 200 OK\r\nContent-Length: " + std::to_string(payload.size()) + "\r\n\r\n" + payload);
+            }
+            if (path == "/headers")
+            {
+                const std::string payload = head;
+                return SendAll(client, "HTTP/1.1 200 OK\r\nContent-Length: " + std::to_string(payload.size()) + "\r\n\r\n" + payload);
+            }
+            if (path == "/chunked")
+            {
+                // Split across writes so the client has to reassemble chunk headers and data.
+                const std::vector<std::string> pieces{
+                    "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n7;ext=1\r\nhel",
+                    "lo, \r\n8\r\nchunked \r",
+                    "\n5\r\nworld\r\n0\r\nX-Trailer: yes\r\n\r\n"
+                };
+                for (const auto& piece : pieces)
+                {
+                    if (!SendAll(client, piece))
+                    {
+                        return false;
+                    }
+                    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+                }
+                return true;
+            }
+            if (path == "/continue")
+            {
+                return SendAll(client, "HTTP/1.1 100 Continue\r\n\r\nHTTP/1.1 201 Created\r\nContent-Length: 4\r\n\r\ndone");
+            }
+            if (path == "/close")
+            {
+                SendAll(client, "HTTP/1.1 200 OK\r\nConnection: close\r\n\r\nuntil-eof");
+                return false;
+            }
+            if (path == "/drop")
+            {
+                // Advertises keep-alive, then drops the socket as an idle timeout would.
+                SendAll(client, "HTTP/1.1 200 OK\r\nContent-Length: 7\r\n\r\ndropped");
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+                return false;
+            }
+            if (path == "/busy")
+            {
+                return SendAll(client, "HTTP/1.1 503 Service Unavailable\r\nContent-Length: 4\r\n\r\nbusy");
+            }
+            if (path == "/hang")
+            {
+                ++hangs_;
+                std::this_thread::sleep_for(std::chrono::milliseconds(300));
+                return false;
+            }
+            return SendAll(client, "HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\n\r\n");
+        }
+
+        int listener_{-1};
+        uint16_t port_{0};
+        std::atomic<bool> stopping_{false};
+        std::atomic<int> accepted_{0};
+        std::atomic<int> hangs_{0};
+        std::thread acceptor_;
+        std::vector<std::thread> workers_;
+    };
+
+    HttpResponse Post(PosixHttpTransport& transport, const std::string& url, const std::string& body)
+    {
+        HttpRequest request;
+        request.method = "POST";
+        request.url = url;
+        request.headers.emplace_back("Content-Type", "application/json");
+        request.body = &body;
+        HttpResponse response;
+        std::string error;
+        const bool sent = transport.Send(request, response, error);
+        if (!sent)
+        {
+            std::fprintf(stderr, "Send %s failed: %s\n", url.c_str(), error.c_str());
+        }
+        assert(sent);
+        return response;
+    }
+}
+
+int main()
+{
+    LoopbackServer server;
+    PosixHttpTransport transport;
+
+    // Keep-alive: sequential requests share one connection.
+    for (int i = 0; i < 5; ++i)
+    {
+        const HttpResponse response = Post(transport, server.Url("/len"), "{\"i\":" + std::to_string(i) + "}");
+        assert(response.statusCode == 200);
+        assert(response.body == "ok:{\"i\":" + std::to_string(i) + "}");
+    }
+    assert(server.Accepted() == 1);
+
+    {
+        const HttpResponse response = Post(transport, server.Url("/headers"), "");
+        assert(response.body.find("POST /headers HTTP/1.1") == 0);
+        assert(response.body.find("Host: 127.0.0.1:") != std::string::npos);
+        assert(response.body.find("Content-Type: application/json") != std::string::npos);
+        assert(response.body.find("Content-Length: 0") != std::string::npos);
+    }
+
+    {
+        const HttpResponse response = Post(transport, server.Url("/chunked"), "{}");
+        assert(response.statusCode == 200 && response.body == "hello, chunked world");
+        const HttpResponse interim = Post(transport, server.Url("/continue"), "{}");
+        assert(interim.statusCode == 201 && interim.body == "done");
+        assert(server.Accepted() == 1);
+    }
+
+    // A close-delimited body is read to EOF and the socket is not pooled.
+    {
+        const HttpResponse response = Post(transport, server.Url("/close"), "{}");
+        assert(response.body == "until-eof");
+        Post(transport, server.Url("/len"), "{}");
+        assert(server.Accepted() == 2);
+    }
+
+    // The server drops a pooled socket; the next request reconnects transparently.
+    {
+        const HttpResponse dropped = Post(transport, server.Url("/drop"), "{}");
+        assert(dropped.body == "dropped");
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        const HttpResponse response = Post(transport, server.Url("/len"), "after");
+        assert(response.body == "ok:after");
+        assert(server.Accepted() == 3);
+    }
+
+    // Timeouts and refused connections surface as errors.
+    {
+        PosixHttpTransport::Options options;
+        options.ioTimeout = std::chrono::milliseconds(100);
+        PosixHttpTransport impatient(options);
+        HttpRequest request;
+        request.method = "GET";
+        request.url = server.Url("/hang");
+        HttpResponse response;
+        std::string error;
+        assert(!impatient.Send(request, response, error));
+        assert(error == "HTTP request timed out");
+        assert(server.Hangs() == 1);
+
+        // A timeout on a pooled socket is not a stale connection: the request went out, so
+        // it must not be sent a second time.
+        Post(impatient, server.Url("/len"), "{}");
+        const int accepted = server.Accepted();
+        assert(!impatient.Send(request, response, error));
+        assert(error == "HTTP request timed out");
+        assert(server.Accepted() == accepted);
+        assert(server.Hangs() == 2);
+
+        request.url = "https://127.0.0.1:1/";
+        assert(!impatient.Send(request, response, error));
+        request.url = "http://127.0.0.1:1/";
+        assert(!impatient.Send(request, response, error));
+        assert(error.find("connect failed") == 0);
+    }
+
+    // ApiClient picks this transport by default off Windows.
+    {
+        ApiClient client(server.Url(""));
+        std::string response;
+        std::string error;
+        assert(client.PostJson("/len", "{\"a\":1}", {}, response, error));
+        assert(response == "ok:{\"a\":1}");
+        assert(!client.PostJson("/busy", "{}", {}, response, error));
+        assert(error == "HTTP 503: busy");
+
+        std::vector<std::future<ApiResult>> pending;
+        const auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < 1000; ++i)
+        {
+            pending.push_back(client.PostJsonAsync("/len", std::to_string(i), {}));
+        }
+        for (int i = 0; i < 1000; ++i)
+        {
+            ApiResult result = pending[i].get();
+            assert(result.success && result.response == "ok:" + std::to_string(i));
+        }
+        const auto elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        std::printf("1000 keep-alive POSTs in %.1f ms (%d connections opened in total)\n", elapsed, server.Accepted());
+    }
+
+    std::printf("PosixHttpTransportTest passed\n");
+    return 0;
+}
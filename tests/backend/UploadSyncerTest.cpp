@@ -0,0 +1,385 @@
+// Durable upload queue and batched syncer: sequence numbers survive restarts, acks are
+// compacted away, a backlog drains in a few requests, failures back off, and a record the
+// server rejects outright is isolated and skipped instead of blocking the queue.
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "backend/ApiClient.h"
+#include "backend/UploadSyncer.h"
+#include "storage/UploadQueue.h"
+
+#ifndef _WIN32
+#include <csignal>
+#include <sys/resource.h>
+#endif
+
+namespace
+{
+    // Fails the first `failures` requests, then accepts everything.
+    class BatchTransport : public IHttpTransport
+    {
+    public:
+        explicit BatchTransport(int failures) : failuresLeft_(failures) {}
+
+        bool Send(const HttpRequest& request, HttpResponse& response, std::string& error) override
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            bodies_.push_back(request.body ? *request.body : std::string());
+            attempts_.push_back(std::chrono::steady_clock::now());
+            if (failuresLeft_ > 0)
+            {
+                --failuresLeft_;
+                error = "connection refused";
+                return false;
+            }
+            response.statusCode = 200;
+            response.body = "{}";
+            return true;
+        }
+
+        std::vector<std::string> Bodies()
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            return bodies_;
+        }
+
+        std::vector<std::chrono::steady_clock::time_point> Attempts()
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            return attempts_;
+        }
+
+    private:
+        std::mutex mutex_;
+        int failuresLeft_;
+        std::vector<std::string> bodies_;
+        std::vector<std::chrono::steady_clock::time_point> attempts_;
+    };
+
+    // Answers `status` to any batch holding a payload marked bad (to every batch when
+    // `everything`), 200 to the rest.
+    class RejectingTransport : public IHttpTransport
+    {
+    public:
+        explicit RejectingTransport(int status = 400, bool everything = false)
+            : status_(status)
+            , everything_(everything)
+        {
+        }
+
+        bool Send(const HttpRequest& request, HttpResponse& response, std::string&) override
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            bodies_.push_back(request.body ? *request.body : std::string());
+            const bool bad = everything_ || bodies_.back().find("\"bad\"") != std::string::npos;
+            response.statusCode = bad ? status_ : 200;
+            response.body = bad ? "{\"error\":\"rejected\"}" : "{}";
+            return true;
+        }
+
+        std::vector<std::string> Bodies()
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            return bodies_;
+        }
+
+    private:
+        std::mutex mutex_;
+        int status_;
+        bool everything_;
+        std::vector<std::string> bodies_;
+    };
+
+    std::vector<std::string> MakePayloads(size_t count, size_t first = 0)
+    {
+        std::vector<std::string> payloads;
+        for (size_t i = 0; i < count; ++i)
+        {
+            payloads.push_back("{\"match\":" + std::to_string(first + i) + "}");
+        }
+        return payloads;
+    }
+
+    bool WaitUntil(const std::function<bool()>& done)
+    {
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+        while (!done())
+        {
+            if (std::chrono::steady_clock::now() > deadline)
+            {
+                return false;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        }
+        return true;
+    }
+
+    size_t CountOf(const std::string& haystack, const std::string& needle)
+    {
+        size_t count = 0;
+        for (size_t pos = haystack.find(needle); pos != std::string::npos; pos = haystack.find(needle, pos + 1))
+        {
+            ++count;
+        }
+        return count;
+    }
+}
+
+int main()
+{
+    const std::filesystem::path dir = std::filesystem::temp_directory_path() / "hs_upload_queue_test";
+    std::filesystem::remove_all(dir);
+    std::string error;
+
+    // Sequence numbers, acknowledgement and restart.
+    {
+        UploadQueue queue(dir);
+        assert(queue.Open(error));
+        assert(queue.Append(MakePayloads(5), error));
+        assert(!queue.Append({ "{\"bad\":\n1}" }, error));
+
+        auto batch = queue.PeekBatch(3, 1 << 20);
+        assert(batch.size() == 3 && batch[0].sequence == 1 && batch[2].sequence == 3);
+        assert(batch[1].payload == "{\"match\":1}");
+        assert(queue.Acknowledge(3, error));
+        assert(queue.PendingCount() == 2);
+    }
+    {
+        UploadQueue queue(dir);
+        assert(queue.Open(error));
+        assert(queue.PendingCount() == 2);
+        assert(queue.PeekBatch(10, 1 << 20).front().sequence == 4);
+        assert(queue.Append(MakePayloads(1, 5), error));
+        assert(queue.PeekBatch(10, 1 << 20).back().sequence == 6);
+
+        // Byte limit still yields at least one record.
+        assert(queue.PeekBatch(10, 1).size() == 1);
+
+        // Draining the queue truncates the file; numbering continues from the ack.
+        assert(queue.Acknowledge(6, error));
+        assert(queue.GetStats().fileBytes == 0);
+        assert(std::filesystem::file_size(queue.GetQueuePath()) == 0);
+    }
+    {
+        // A torn final line (crash mid-append) is dropped on open.
+        {
+            std::ofstream output(dir / "outbound.queue", std::ios::binary | std::ios::app);
+            output << "7 {\"match\":7}\n8 {\"mat";
+        }
+        UploadQueue queue(dir);
+        assert(queue.Open(error));
+        assert(queue.PendingCount() == 1);
+        assert(queue.Append(MakePayloads(1, 9), error));
+        const auto batch = queue.PeekBatch(10, 1 << 20);
+        assert(batch.size() == 2 && batch[0].sequence == 7 && batch[1].sequence == 8);
+        assert(queue.Acknowledge(8, error));
+    }
+
+#ifndef _WIN32
+    // An append the OS takes only part of is cut back out, so the next one lands cleanly.
+    {
+        std::filesystem::remove_all(dir);
+        UploadQueue queue(dir);
+        assert(queue.Open(error));
+        queue.SetDurability(StoreFile::Durability::Flush);
+        assert(queue.Append(MakePayloads(2), error));
+        const uint64_t before = std::filesystem::file_size(queue.GetQueuePath());
+
+        std::signal(SIGXFSZ, SIG_IGN);
+        rlimit original{};
+        getrlimit(RLIMIT_FSIZE, &original);
+        rlimit limited = original;
+        limited.rlim_cur = static_cast<rlim_t>(before + 10);
+        setrlimit(RLIMIT_FSIZE, &limited);
+        const bool appended = queue.Append(MakePayloads(3, 2), error);
+        setrlimit(RLIMIT_FSIZE, &original);
+        assert(!appended && !error.empty());
+        assert(std::filesystem::file_size(queue.GetQueuePath()) == before);
+
+        queue.SetDurability(StoreFile::Durability::Fsync);
+        assert(queue.Append(MakePayloads(1, 9), error));
+        assert(queue.GetStats().fileBytes == std::filesystem::file_size(queue.GetQueuePath()));
+        UploadQueue reopened(dir);
+        assert(reopened.Open(error));
+        const auto batch = reopened.PeekBatch(10, 1 << 20);
+        assert(batch.size() == 3 && batch[2].sequence == 3 && batch[2].payload == "{\"match\":9}");
+        assert(reopened.Acknowledge(3, error));
+    }
+#endif
+
+    // Compaction kicks in once acked bytes dominate the file.
+    {
+        UploadQueue queue(dir);
+        assert(queue.Open(error));
+        const std::string big(1024, 'x');
+        std::vector<std::string> payloads;
+        for (int i = 0; i < 200; ++i)
+        {
+            payloads.push_back("{\"pad\":\"" + big + "\"}");
+        }
+        assert(queue.Append(payloads, error));
+        const uint64_t first = queue.PeekBatch(1, 1 << 20).front().sequence;
+        assert(queue.Acknowledge(first + 149, error));
+        const UploadQueue::Stats stats = queue.GetStats();
+        assert(stats.pending == 50);
+        assert(stats.compactions >= 1);
+        assert(stats.fileBytes < 60 * 1100);
+        assert(std::filesystem::file_size(queue.GetQueuePath()) == stats.fileBytes);
+        assert(queue.Acknowledge(first + 199, error));
+    }
+
+    // Backoff grows exponentially, is capped, and keeps half of each step fixed.
+    {
+        UploadSyncer::Options options;
+        options.initialBackoff = std::chrono::milliseconds(1000);
+        options.maxBackoff = std::chrono::milliseconds(60000);
+        std::mt19937_64 rng(42);
+        for (int trial = 0; trial < 100; ++trial)
+        {
+            for (uint32_t failures = 1; failures <= 12; ++failures)
+            {
+                const int64_t step = (std::min)(int64_t{1000} << (failures - 1), int64_t{60000});
+                const int64_t delay = UploadSyncer::BackoffDelay(failures, options, rng).count();
+                assert(delay >= step / 2 && delay <= step);
+            }
+        }
+        assert(UploadSyncer::BackoffDelay(0, options, rng).count() == 0);
+    }
+
+    // A backlog of 230 records drains in 5 requests of up to 50, after two failed attempts.
+    {
+        std::filesystem::remove_all(dir);
+        UploadQueue queue(dir);
+        assert(queue.Open(error));
+        assert(queue.Append(MakePayloads(230), error));
+
+        auto transport = std::make_shared<BatchTransport>(2);
+        ApiClient client("http://127.0.0.1:1", transport);
+        UploadSyncer::Options options;
+        options.batchSize = 50;
+        options.initialBackoff = std::chrono::milliseconds(40);
+        options.maxBackoff = std::chrono::milliseconds(200);
+        UploadSyncer syncer(queue, client, options);
+
+        // Stats are updated after the ack, so wait on them rather than on the queue.
+        assert(WaitUntil([&] { return syncer.GetStats().recordsSent == 230; }));
+        assert(queue.PendingCount() == 0);
+        const auto bodies = transport->Bodies();
+        assert(bodies.size() == 7);
+        assert(bodies[0] == bodies[1] && bodies[1] == bodies[2]);
+        assert(bodies[0].rfind("{\"records\":[{\"seq\":1,\"payload\":{\"match\":0}}", 0) == 0);
+        size_t records = 0;
+        for (size_t i = 2; i < bodies.size(); ++i)
+        {
+            records += CountOf(bodies[i], "\"seq\":");
+        }
+        assert(records == 230);
+
+        const auto attempts = transport->Attempts();
+        assert(attempts[1] - attempts[0] >= std::chrono::milliseconds(20));
+        assert(attempts[2] - attempts[1] >= std::chrono::milliseconds(40));
+
+        const UploadSyncer::Stats stats = syncer.GetStats();
+        assert(stats.batchesSent == 5 && stats.recordsSent == 230 && stats.failedRequests == 2);
+        assert(stats.consecutiveFailures == 0 && stats.lastError.empty());
+
+        // New records after the backlog wake the thread.
+        assert(queue.Append(MakePayloads(3, 230), error));
+        syncer.Notify();
+        assert(WaitUntil([&] { return queue.PendingCount() == 0; }));
+        assert(transport->Bodies().size() == 8);
+    }
+
+    // Record rejections versus failures that are retried.
+    {
+        assert(UploadSyncer::IsRecordRejection(400) && UploadSyncer::IsRecordRejection(413) && UploadSyncer::IsRecordRejection(422));
+        for (const int status : { 0, 301, 401, 403, 404, 405, 408, 429, 500, 503 })
+        {
+            assert(!UploadSyncer::IsRecordRejection(status));
+        }
+    }
+
+    // A wrong URL (404) or bad credentials (401): the queue is kept and the batch retried
+    // after a backoff.
+    for (const int status : { 404, 401 })
+    {
+        std::filesystem::remove_all(dir);
+        UploadQueue queue(dir);
+        assert(queue.Open(error));
+        assert(queue.Append(MakePayloads(20), error));
+
+        auto transport = std::make_shared<RejectingTransport>(status, true);
+        ApiClient client("http://127.0.0.1:1", transport);
+        UploadSyncer::Options options;
+        options.batchSize = 8;
+        options.initialBackoff = std::chrono::milliseconds(60000);
+        UploadSyncer syncer(queue, client, options);
+
+        assert(WaitUntil([&] { return syncer.GetStats().failedRequests == 1; }));
+        const UploadSyncer::Stats stats = syncer.GetStats();
+        assert(stats.droppedRecords == 0 && stats.rejectedRequests == 0 && stats.currentBackoff.count() > 0);
+        assert(queue.PendingCount() == 20 && transport->Bodies().size() == 1);
+        assert(!std::filesystem::exists(queue.GetDeadLetterPath()));
+    }
+
+    // A 400 for one record: the batch is split until that record is alone, it is dropped,
+    // and everything around it is delivered without any backoff.
+    {
+        std::filesystem::remove_all(dir);
+        UploadQueue queue(dir);
+        assert(queue.Open(error));
+        std::vector<std::string> payloads = MakePayloads(20);
+        payloads[6] = "{\"bad\":true}";
+        assert(queue.Append(payloads, error));
+
+        auto transport = std::make_shared<RejectingTransport>();
+        ApiClient client("http://127.0.0.1:1", transport);
+        UploadSyncer::Options options;
+        options.batchSize = 8;
+        options.initialBackoff = std::chrono::milliseconds(60000);
+        UploadSyncer syncer(queue, client, options);
+
+        assert(WaitUntil([&] { return syncer.GetStats().recordsSent == 19; }));
+        assert(queue.PendingCount() == 0);
+        const UploadSyncer::Stats stats = syncer.GetStats();
+        assert(stats.droppedRecords == 1 && stats.recordsSent == 19);
+        assert(stats.failedRequests == 0 && stats.consecutiveFailures == 0);
+        assert(stats.rejectedRequests == 4); // 8, 4, 2, then the record on its own
+
+        size_t delivered = 0;
+        for (const std::string& body : transport->Bodies())
+        {
+            if (body.find("\"bad\"") == std::string::npos)
+            {
+                delivered += CountOf(body, "\"seq\":");
+            }
+        }
+        assert(delivered == 19);
+        // Back to full batches once past the rejected range.
+        assert(CountOf(transport->Bodies().back(), "\"seq\":") == 4);
+
+        // The rejected record is kept whole in the dead-letter file.
+        std::ifstream deadLetters(queue.GetDeadLetterPath());
+        std::string line;
+        std::string extra;
+        assert(std::getline(deadLetters, line) && !std::getline(deadLetters, extra));
+        const std::string tail = "\"payload\":{\"bad\":true}}";
+        assert(line.rfind("{\"seq\":7,\"reason\":\"", 0) == 0);
+        assert(line.size() > tail.size() && line.compare(line.size() - tail.size(), tail.size(), tail) == 0);
+    }
+
+    std::filesystem::remove_all(dir);
+    std::printf("UploadSyncerTest passed\n");
+    return 0;
+}
@@ -0,0 +1,150 @@
+// Per-call latency of DiagnosticLogger::Log as seen by the calling (game) thread. The
+// "legacy" column reproduces the old path: global mutex, localtime, ostringstream, and an
+// ofstream opened and closed for every line. Also checks that every record was either
+// written or counted as dropped.
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "diagnostics/DiagnosticLogger.h"
+
+namespace
+{
+    constexpr int kCallsPerThread = 20000;
+
+    std::mutex g_legacyMutex;
+
+    void LegacyLog(const std::filesystem::path& path, const std::string& msg)
+    {
+        std::lock_guard<std::mutex> lock(g_legacyMutex);
+        auto now = std::chrono::system_clock::now();
+        std::time_t t = std::chrono::system_clock::to_time_t(now);
+        std::tm tm;
+        localtime_r(&t, &tm);
+        std::ostringstream oss;
+        oss << std::put_time(&tm, "%Y-%m-%d %H:%M:%S") << " - " << msg << "\n";
+        std::ofstream ofs(path, std::ios::out | std::ios::app);
+        if (ofs)
+        {
+            ofs << oss.str();
+        }
+    }
+
+    struct Percentiles
+    {
+        double p50;
+        double p99;
+        double p999;
+        double max;
+    };
+
+    Percentiles Summarize(std::vector<double>& samples)
+    {
+        std::sort(samples.begin(), samples.end());
+        auto at = [&samples](double q) { return samples[static_cast<size_t>(q * (samples.size() - 1))]; };
+        return Percentiles{ at(0.5), at(0.99), at(0.999), samples.back() };
+    }
+
+    // Runs `threads` producers; each paces itself a little so the ring is not permanently
+    // saturated (the game thread logs in bursts, not a tight loop).
+    template <typename Fn>
+    void Measure(const char* name, int threads, int pauseEvery, Fn&& log)
+    {
+        std::vector<std::vector<double>> perThread(threads);
+        std::vector<std::thread> workers;
+        const auto start = std::chrono::steady_clock::now();
+        for (int t = 0; t < threads; ++t)
+        {
+            workers.emplace_back([&, t] {
+                auto& samples = perThread[t];
+                samples.reserve(kCallsPerThread);
+                const std::string message = "HandleGameEnd: playlist=13 mmr=1234 thread=" + std::to_string(t) + " call=";
+                for (int i = 0; i < kCallsPerThread; ++i)
+                {
+                    const std::string line = message + std::to_string(i);
+                    const auto before = std::chrono::steady_clock::now();
+                    log(line);
+                    samples.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - before).count());
+                    if (pauseEvery > 0 && i % pauseEvery == pauseEvery - 1)
+                    {
+                        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                    }
+                }
+            });
+        }
+        for (auto& worker : workers)
+        {
+            worker.join();
+        }
+        const double wallMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        std::vector<double> all;
+        for (auto& samples : perThread)
+        {
+            all.insert(all.end(), samples.begin(), samples.end());
+        }
+        const Percentiles p = Summarize(all);
+        std::printf("%-22s threads=%d  p50=%7.2fus  p99=%8.2fus  p99.9=%8.2fus  max=%9.1fus  wall=%7.1fms\n",
+                    name, threads, p.p50, p.p99, p.p999, p.max, wallMs);
+    }
+}
+
+int main()
+{
+    const std::filesystem::path root = std::filesystem::temp_directory_path() / "hs_logger_bench";
+    std::filesystem::remove_all(root);
+    std::filesystem::create_directories(root);
+    setenv("APPDATA", root.string().c_str(), 1);
+
+    const std::filesystem::path legacyPath = root / "legacy.log";
+    for (int threads : { 1, 4 })
+    {
+        Measure("legacy (open per line)", threads, 100, [&legacyPath](const std::string& line) { LegacyLog(legacyPath, line); });
+        Measure("ring + flusher", threads, 100, [](const std::string& line) { DiagnosticLogger::Log(line); });
+    }
+    // Unpaced burst from 4 threads: shows the cost of a full ring (drops, not blocking).
+    Measure("ring, unpaced burst", 4, 0, [](const std::string& line) { DiagnosticLogger::Log(line); });
+
+    DiagnosticLogger::Flush();
+    const DiagnosticLogger::Stats stats = DiagnosticLogger::GetStats();
+    const uint64_t logged = static_cast<uint64_t>(kCallsPerThread) * (1 + 4 + 4);
+    std::printf("written=%llu dropped=%llu capacity=%zu\n",
+                static_cast<unsigned long long>(stats.written),
+                static_cast<unsigned long long>(stats.dropped),
+                stats.capacity);
+    assert(stats.written + stats.dropped == logged);
+    assert(stats.queued == 0);
+
+    DiagnosticLogger::Shutdown();
+
+    // Header + written records + one "dropped" notice per flush that saw new drops.
+    size_t lines = 0;
+    size_t dropNotices = 0;
+    for (const auto& entry : std::filesystem::directory_iterator(root / "bakkesmod" / "hardstuck_logs"))
+    {
+        std::ifstream input(entry.path());
+        std::string line;
+        while (std::getline(input, line))
+        {
+            ++lines;
+            dropNotices += line.find("DiagnosticLogger: ring full") != std::string::npos;
+        }
+    }
+    assert(lines == 1 + stats.written + dropNotices);
+
+    // After shutdown, Log() still works, synchronously.
+    DiagnosticLogger::Log("after shutdown");
+    std::filesystem::remove_all(root);
+    return 0;
+}
@@ -0,0 +1,162 @@
+// Compares HistoryJson::Parser (std::map/std::string DOM), the arena-backed ViewDocument
+// and the streaming FieldExtractor on a generated 100k-line history file. Build like the other tests,
+// with optimisations on, and run without arguments.
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "history/HistoryJson.h"
+
+namespace
+{
+    std::atomic<size_t> g_allocations{0};
+}
+
+void* operator new(size_t size)
+{
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1))
+    {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+    std::free(p);
+}
+
+namespace
+{
+    constexpr int kLines = 100000;
+
+    struct Result
+    {
+        double milliseconds{0.0};
+        size_t allocations{0};
+        long long checksum{0};
+    };
+
+    std::filesystem::path WriteHistoryFile()
+    {
+        const std::filesystem::path path = std::filesystem::temp_directory_path() / "hs_history_json_bench.jsonl";
+        std::ofstream output(path, std::ios::out | std::ios::binary | std::ios::trunc);
+        const char* playlists[] = { "Ranked Duels", "Ranked Doubles", "Ranked Standard", "Casual" };
+        for (int i = 0; i < kLines; ++i)
+        {
+            char line[1024];
+            std::snprintf(line, sizeof(line),
+                          "{\"timestamp\":\"2024-%02d-%02dT%02d:%02d:00Z\",\"playlist\":\"%s\",\"mmr\":%d,"
+                          "\"gamesPlayedDiff\":1,\"source\":\"bakkesmod\",\"sessionType\":\"ranked\","
+                          "\"userId\":\"steam:7656119%08d\",\"focus\":[\"aerials\",\"shadow \\\"defense\\\"\"],"
+                          "\"match\":{\"goals\":%d,\"saves\":%d,\"mvp\":%s},"
+                          "\"teams\":[{\"name\":\"Blue\",\"score\":%d},{\"name\":\"Orange\",\"score\":%d}],"
+                          "\"scoreboard\":[{\"player\":\"a\",\"score\":420,\"goals\":1,\"shots\":3},"
+                          "{\"player\":\"b\",\"score\":310,\"goals\":0,\"shots\":2},"
+                          "{\"player\":\"c\",\"score\":150,\"goals\":0,\"shots\":1}]}\n",
+                          1 + i % 12, 1 + i % 28, i % 24, i % 60, playlists[i % 4], 900 + i % 400,
+                          i, i % 5, i % 3, (i % 7 == 0) ? "true" : "false", i % 5, i % 4);
+            output << line;
+        }
+        return path;
+    }
+
+    std::vector<std::string> ReadLines(const std::filesystem::path& path)
+    {
+        std::vector<std::string> lines;
+        lines.reserve(kLines);
+        std::ifstream input(path, std::ios::in | std::ios::binary);
+        std::string line;
+        while (std::getline(input, line))
+        {
+            lines.push_back(std::move(line));
+        }
+        return lines;
+    }
+
+    template <typename Fn>
+    Result Measure(const std::vector<std::string>& lines, Fn&& parseLine)
+    {
+        Result result;
+        const size_t before = g_allocations.load();
+        const auto start = std::chrono::steady_clock::now();
+        for (const auto& line : lines)
+        {
+            result.checksum += parseLine(line);
+        }
+        const auto elapsed = std::chrono::steady_clock::now() - start;
+        result.allocations = g_allocations.load() - before;
+        result.milliseconds = std::chrono::duration<double, std::milli>(elapsed).count();
+        return result;
+    }
+
+    void Report(const char* name, const Result& result)
+    {
+        std::printf("%-14s %9.1f ms %11zu allocations (%.2f/line)  checksum=%lld\n",
+                    name, result.milliseconds, result.allocations,
+                    static_cast<double>(result.allocations) / kLines, result.checksum);
+    }
+}
+
+int main()
+{
+    const std::filesystem::path path = WriteHistoryFile();
+    const std::vector<std::string> lines = ReadLines(path);
+
+    const Result tree = Measure(lines, [](const std::string& line) -> long long {
+        HistoryJson::Parser parser(line);
+        HistoryJson::Value root;
+        std::string error;
+        if (!parser.Parse(root, error))
+        {
+            return 0;
+        }
+        return HistoryJson::AsInt(HistoryJson::GetMember(root, "mmr")).value_or(0)
+            + static_cast<long long>(HistoryJson::AsString(HistoryJson::GetMember(root, "playlist")).value_or("").size());
+    });
+
+    HistoryJson::ViewDocument document;
+    const Result view = Measure(lines, [&document](const std::string& line) -> long long {
+        std::string error;
+        if (!document.Parse(line, error))
+        {
+            return 0;
+        }
+        const HistoryJson::ViewValue& root = document.Root();
+        return HistoryJson::AsInt(HistoryJson::GetMember(root, "mmr")).value_or(0)
+            + static_cast<long long>(HistoryJson::AsString(HistoryJson::GetMember(root, "playlist")).value_or("").size());
+    });
+
+    static constexpr HistoryJson::KeyList<2> kKeys{ "mmr", "playlist" };
+    const Result stream = Measure(lines, [](const std::string& line) -> long long {
+        long long value = 0;
+        std::string error;
+        HistoryJson::FieldExtractor extractor(line);
+        const bool ok = extractor.Extract(kKeys, [&value](size_t field, const HistoryJson::ViewValue& member) {
+            value += field == 0
+                ? HistoryJson::AsInt(&member).value_or(0)
+                : static_cast<long long>(HistoryJson::AsString(&member).value_or("").size());
+        }, error);
+        return ok ? value : 0;
+    });
+
+    std::printf("HistoryJson parse of %d lines (%s)\n", kLines, path.string().c_str());
+    Report("Parser/Value", tree);
+    Report("ViewDocument", view);
+    Report("FieldExtractor", stream);
+
+    std::filesystem::remove(path);
+    return tree.checksum == view.checksum && tree.checksum == stream.checksum ? 0 : 1;
+}
@@ -0,0 +1,156 @@
+// Micro-benchmark for the history window's chart path on 50k MMR entries. Compares the
+// array-of-structs path (sort entry pointers by timestamp, then chase each pointer for the
+// mmr value) with the columnar MmrColumns kept next to the snapshot (contiguous mmr and
+// timestamp arrays fed to the HistoryColumns kernels), and times the LTTB reduction of the
+// whole history to one point per plot pixel.
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "history/HistoryColumns.h"
+#include "history/SnapshotIndex.h"
+
+namespace
+{
+    constexpr size_t kEntries = 50000;
+    constexpr int kRounds = 50;
+
+    // Plot rectangle of the window's chart.
+    constexpr float kX0 = 10.0f, kY0 = 40.0f, kX1 = 730.0f, kY1 = 300.0f;
+
+    struct Point
+    {
+        float x;
+        float y;
+    };
+
+    template <typename Fn>
+    void Measure(const char* name, Fn&& body)
+    {
+        double checksum = 0.0;
+        const auto start = std::chrono::steady_clock::now();
+        for (int round = 0; round < kRounds; ++round)
+        {
+            checksum += body();
+        }
+        const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / kRounds;
+        std::printf("%-30s %8.3f ms/build  checksum=%.0f\n", name, ms, checksum);
+    }
+
+    // The previous BuildChartData/BuildPoints over sorted entry pointers.
+    double ChartFromEntries(const std::vector<MmrHistoryEntry>& history)
+    {
+        std::vector<const MmrHistoryEntry*> sorted;
+        sorted.reserve(history.size());
+        for (const auto& entry : history)
+        {
+            sorted.push_back(&entry);
+        }
+        std::sort(sorted.begin(), sorted.end(), [](const MmrHistoryEntry* lhs, const MmrHistoryEntry* rhs) {
+            return lhs->timestamp < rhs->timestamp;
+        });
+
+        std::vector<float> series;
+        std::vector<float> deltas;
+        std::vector<int64_t> times;
+        series.reserve(sorted.size());
+        deltas.reserve(sorted.size());
+        times.reserve(sorted.size());
+        int previousMmr = sorted.front()->mmr;
+        for (const MmrHistoryEntry* entry : sorted)
+        {
+            series.push_back(static_cast<float>(entry->mmr));
+            times.push_back(entry->timestamp);
+            deltas.push_back(static_cast<float>(entry->mmr - previousMmr));
+            previousMmr = entry->mmr;
+        }
+        const float minVal = *std::min_element(series.begin(), series.end());
+        const float maxVal = *std::max_element(series.begin(), series.end());
+
+        std::vector<Point> points;
+        points.reserve(series.size());
+        const float range = std::max(1.0f, maxVal - minVal);
+        for (size_t i = 0; i < series.size(); ++i)
+        {
+            const float xNorm = static_cast<float>(i) / static_cast<float>(series.size() - 1);
+            const float yNorm = (series[i] - minVal) / range;
+            points.push_back({kX0 + xNorm * (kX1 - kX0), kY1 - yNorm * (kY1 - kY0)});
+        }
+        return points.back().y + deltas.back() + static_cast<double>(times.back() % 1000);
+    }
+
+    double ChartFromColumns(const MmrColumns& columns)
+    {
+        const size_t count = columns.Size();
+        std::vector<float> series(count);
+        std::vector<float> deltas(count);
+        std::vector<Point> points(count);
+        HistoryColumns::ToFloat(columns.mmr.data(), count, series.data());
+        HistoryColumns::AdjacentDeltas(series.data(), count, deltas.data());
+        const std::vector<int64_t> times(columns.timestamps.begin(), columns.timestamps.end());
+        int32_t minVal = 0;
+        int32_t maxVal = 0;
+        HistoryColumns::MinMax(columns.mmr.data(), count, minVal, maxVal);
+        HistoryColumns::Project(series.data(), count, static_cast<float>(minVal), static_cast<float>(maxVal),
+                                kX0, kY0, kX1, kY1, &points[0].x);
+        return points.back().y + deltas.back() + static_cast<double>(times.back() % 1000);
+    }
+}
+
+int main()
+{
+    std::mt19937 rng(7);
+    std::uniform_int_distribution<int> step(-25, 25);
+    std::uniform_int_distribution<int> gap(30, 3600);
+    const char* playlists[] = { "Ranked Doubles", "Ranked Duel", "Ranked Standard", "Casual" };
+
+    // Mostly in order with some late arrivals, as a merged local + server history looks.
+    HistorySnapshot snapshot;
+    snapshot.mmrHistory.reserve(kEntries);
+    int64_t timestamp = 1700000000;
+    int mmr = 1200;
+    for (size_t i = 0; i < kEntries; ++i)
+    {
+        timestamp += gap(rng);
+        mmr += step(rng);
+        MmrHistoryEntry entry;
+        entry.id = "local_" + std::to_string(i);
+        entry.timestamp = (i % 50 == 0) ? timestamp - 86400 : timestamp;
+        entry.day = static_cast<int32_t>(entry.timestamp / 86400);
+        entry.playlist = snapshot.symbols.playlists.Intern(playlists[i % 4]);
+        entry.source = snapshot.symbols.sources.Intern("local");
+        entry.mmr = mmr;
+        snapshot.mmrHistory.push_back(entry);
+    }
+
+    std::printf("%zu entries, sizeof(MmrHistoryEntry)=%zu, column bytes/row=%zu\n",
+                kEntries, sizeof(MmrHistoryEntry),
+                sizeof(int64_t) + sizeof(int32_t) * 3 + sizeof(SymbolId) + sizeof(uint32_t));
+
+    Measure("AoS sort + pointer walk", [&]() { return ChartFromEntries(snapshot.mmrHistory); });
+    Measure("SoA column rebuild", [&]() {
+        SnapshotIndex::Rebuild(snapshot);
+        return static_cast<double>(snapshot.mmrColumns.Size());
+    });
+    Measure("SoA kernels (columns kept)", [&]() { return ChartFromColumns(snapshot.mmrColumns); });
+    Measure("LTTB 50k -> plot width", [&]() {
+        std::vector<uint32_t> selected(static_cast<size_t>(kX1 - kX0));
+        const size_t kept = HistoryColumns::DownsampleLttb(snapshot.mmrColumns.mmr.data(), snapshot.mmrColumns.Size(),
+                                                           selected.size(), selected.data());
+        return static_cast<double>(kept + selected[kept / 2]);
+    });
+
+    // Both paths must draw the same chart.
+    const double aos = ChartFromEntries(snapshot.mmrHistory);
+    const double soa = ChartFromColumns(snapshot.mmrColumns);
+    if (std::fabs(aos - soa) > 1e-3)
+    {
+        std::printf("mismatch: %f vs %f\n", aos, soa);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,147 @@
+// Micro-benchmark for JSON number conversion on the shapes our payloads carry: small
+// integers (mmr, gamesPlayedDiff, durationSeconds) with the odd fractional value.
+// Compares the old std::stod(substr) + round path with std::from_chars, then times
+// AsInt over whole payload lines through the view parser.
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "history/HistoryJson.h"
+
+namespace
+{
+    std::atomic<size_t> g_allocations{0};
+}
+
+void* operator new(size_t size)
+{
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1))
+    {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+    std::free(p);
+}
+
+namespace
+{
+    constexpr int kTokens = 1000000;
+    constexpr int kLines = 200000;
+
+    template <typename Fn>
+    void Measure(const char* name, Fn&& body)
+    {
+        const size_t before = g_allocations.load();
+        const auto start = std::chrono::steady_clock::now();
+        const long long checksum = body();
+        const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        std::printf("%-28s %8.1f ms %9zu allocations  checksum=%lld\n",
+                    name, ms, g_allocations.load() - before, checksum);
+    }
+}
+
+int main()
+{
+    std::mt19937 rng(7);
+    std::uniform_int_distribution<int> mmr(200, 2400);
+    std::uniform_int_distribution<int> games(0, 3);
+    std::uniform_int_distribution<int> duration(60, 900);
+    std::uniform_int_distribution<int> shape(0, 19);
+
+    // One token buffer, as the parser sees it: numbers embedded in a larger string.
+    std::string source;
+    std::vector<std::string_view> tokens;
+    std::vector<std::pair<size_t, size_t>> spans;
+    for (int i = 0; i < kTokens; ++i)
+    {
+        std::string token;
+        switch (shape(rng))
+        {
+        case 0:  token = std::to_string(mmr(rng)) + "." + std::to_string(games(rng) * 25); break;
+        case 1:  token = "-" + std::to_string(games(rng)); break;
+        default: token = std::to_string(i % 3 == 0 ? mmr(rng) : i % 3 == 1 ? games(rng) : duration(rng)); break;
+        }
+        spans.emplace_back(source.size(), token.size());
+        source += token;
+        source += ',';
+    }
+    for (const auto& [offset, length] : spans)
+    {
+        tokens.emplace_back(source.data() + offset, length);
+    }
+
+    std::printf("%d number tokens, %d payload lines\n", kTokens, kLines);
+
+    Measure("stod(substr) + round", [&]() {
+        long long sum = 0;
+        for (const auto& [offset, length] : spans)
+        {
+            sum += static_cast<long long>(std::round(std::stod(source.substr(offset, length))));
+        }
+        return sum;
+    });
+
+    Measure("from_chars int64/double", [&]() {
+        long long sum = 0;
+        for (const std::string_view token : tokens)
+        {
+            int64_t integer = 0;
+            const auto result = std::from_chars(token.data(), token.data() + token.size(), integer);
+            if (result.ec == std::errc() && result.ptr == token.data() + token.size())
+            {
+                sum += integer;
+                continue;
+            }
+            double number = 0.0;
+            std::from_chars(token.data(), token.data() + token.size(), number);
+            sum += static_cast<long long>(std::round(number));
+        }
+        return sum;
+    });
+
+    std::vector<std::string> lines;
+    lines.reserve(kLines);
+    for (int i = 0; i < kLines; ++i)
+    {
+        lines.push_back("{\"timestamp\":\"2024-05-01T12:00:00Z\",\"playlist\":\"Ranked Doubles\",\"mmr\":" +
+                        std::string(tokens[i % tokens.size()]) + ",\"gamesPlayedDiff\":" + std::to_string(i % 2) +
+                        ",\"durationSeconds\":" + std::to_string(300 + i % 200) + "}");
+    }
+
+    Measure("ViewDocument + AsInt x3", [&]() {
+        HistoryJson::ViewDocument document;
+        long long sum = 0;
+        std::string error;
+        for (const std::string& line : lines)
+        {
+            if (!document.Parse(line, error))
+            {
+                continue;
+            }
+            const HistoryJson::ViewValue& root = document.Root();
+            sum += HistoryJson::AsInt(HistoryJson::GetMember(root, "mmr")).value_or(0);
+            sum += HistoryJson::AsInt(HistoryJson::GetMember(root, "gamesPlayedDiff")).value_or(0);
+            sum += HistoryJson::AsInt(HistoryJson::GetMember(root, "durationSeconds")).value_or(0);
+        }
+        return sum;
+    });
+    return 0;
+}
@@ -0,0 +1,238 @@
+// Peak RSS and wall time of reading a 50 MB local store: getline into owned strings, the
+// previous ReadPayloadLines (whole tail read into a buffer, then every line copied out of
+// it), the mapped path LoadHistory now uses (MappedFile + vectorized newline scan,
+// string_views handed to the parser), and a cold LocalDataStore::LoadHistory with no
+// sidecar. Mapped pages are clean and count towards RSS only while resident. Peak RSS is
+// a per-process high-water mark, so each variant runs in a child process of its own.
+// Build like the other tests, with optimisations on, and run without arguments.
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "history/HistoryJson.h"
+#include "history/JsonScan.h"
+#include "storage/LocalDataStore.h"
+#include "storage/MappedFile.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#pragma comment(lib, "psapi.lib")
+#else
+#include <sys/resource.h>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace
+{
+    constexpr uint64_t kStoreBytes = 50ull * 1024 * 1024;
+    const char* const kUser = "bench-user";
+
+    double PeakRssMegabytes()
+    {
+#ifdef _WIN32
+        PROCESS_MEMORY_COUNTERS counters{};
+        GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters));
+        return static_cast<double>(counters.PeakWorkingSetSize) / (1024.0 * 1024.0);
+#else
+        rusage usage{};
+        getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+        return static_cast<double>(usage.ru_maxrss) / (1024.0 * 1024.0);
+#else
+        return static_cast<double>(usage.ru_maxrss) / 1024.0;
+#endif
+#endif
+    }
+
+    fs::path WriteStore(const fs::path& base)
+    {
+        LocalDataStore store(base, kUser);
+        const fs::path path = store.GetStorePath();
+        fs::create_directories(path.parent_path());
+        std::ofstream output(path, std::ios::out | std::ios::binary | std::ios::trunc);
+        const char* playlists[] = { "Ranked Duel", "Ranked Doubles", "Ranked Standard", "Casual" };
+        uint64_t written = 0;
+        for (int i = 0; written < kStoreBytes; ++i)
+        {
+            char line[1024];
+            const int length = std::snprintf(
+                line, sizeof(line),
+                "{\"timestamp\":\"20%02d-%02d-%02dT%02d:%02d:00Z\",\"playlist\":\"%s\",\"mmr\":%d,"
+                "\"gamesPlayedDiff\":1,\"source\":\"bakkesmod\",\"sessionType\":\"ranked\",\"durationSeconds\":%d,"
+                "\"match\":{\"goals\":%d,\"saves\":%d,\"mvp\":%s},"
+                "\"scoreboard\":[{\"player\":\"a\",\"score\":420,\"goals\":1,\"shots\":3},"
+                "{\"player\":\"b\",\"score\":310,\"goals\":0,\"shots\":2}]}\n",
+                20 + (i / 200000) % 5, 1 + (i / 16000) % 12, 1 + (i / 600) % 28, (i / 25) % 24, i % 60,
+                playlists[i % 4], 900 + i % 400, 300 + i % 200, i % 5, i % 3, (i % 7 == 0) ? "true" : "false");
+            output.write(line, length);
+            written += static_cast<uint64_t>(length);
+        }
+        return path;
+    }
+
+    long long ParseLine(std::string_view line)
+    {
+        static constexpr HistoryJson::KeyList<2> kKeys{ "mmr", "playlist" };
+        long long value = 0;
+        std::string error;
+        HistoryJson::FieldExtractor extractor(line);
+        const bool ok = extractor.Extract(kKeys, [&value](size_t field, const HistoryJson::ViewValue& member) {
+            value += field == 0
+                ? HistoryJson::AsInt(&member).value_or(0)
+                : static_cast<long long>(HistoryJson::AsString(&member).value_or("").size());
+        }, error);
+        return ok ? value : 0;
+    }
+
+    long long ReadGetline(const fs::path& path)
+    {
+        std::vector<std::string> lines;
+        std::ifstream input(path, std::ios::in | std::ios::binary);
+        std::string line;
+        while (std::getline(input, line))
+        {
+            lines.push_back(std::move(line));
+        }
+        long long checksum = 0;
+        for (const auto& text : lines)
+        {
+            checksum += ParseLine(text);
+        }
+        return checksum;
+    }
+
+    // The previous ReadPayloadLines: the file in one buffer, plus a copy of every line.
+    long long ReadCopied(const fs::path& path)
+    {
+        std::ifstream input(path, std::ios::in | std::ios::binary);
+        std::string buffer(static_cast<size_t>(fs::file_size(path)), '\0');
+        input.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+        struct Line
+        {
+            uint64_t offset;
+            std::string text;
+        };
+        std::vector<Line> lines;
+        size_t lineStart = 0;
+        for (size_t newline = buffer.find('\n'); newline != std::string::npos; newline = buffer.find('\n', lineStart))
+        {
+            lines.push_back({ lineStart, buffer.substr(lineStart, newline - lineStart) });
+            lineStart = newline + 1;
+        }
+        long long checksum = 0;
+        for (const Line& line : lines)
+        {
+            checksum += ParseLine(line.text);
+        }
+        return checksum;
+    }
+
+    long long ReadMapped(const fs::path& path)
+    {
+        MappedFile mapping;
+        std::string error;
+        if (!mapping.Open(path, error))
+        {
+            return 0;
+        }
+        struct Line
+        {
+            uint64_t offset;
+            std::string_view text;
+        };
+        std::vector<Line> lines;
+        const std::string_view data = mapping.View();
+        size_t lineStart = 0;
+        for (size_t newline = HistoryJson::Scan::FindNewline(data, 0); newline < data.size();
+             newline = HistoryJson::Scan::FindNewline(data, lineStart))
+        {
+            lines.push_back({ lineStart, data.substr(lineStart, newline - lineStart) });
+            lineStart = newline + 1;
+        }
+        long long checksum = 0;
+        for (const Line& line : lines)
+        {
+            checksum += ParseLine(line.text);
+        }
+        return checksum;
+    }
+
+    long long LoadStore(const fs::path& base)
+    {
+        LocalDataStore store(base, kUser);
+        HistorySnapshot snapshot;
+        std::string error;
+        if (!store.LoadHistory(snapshot, error))
+        {
+            std::fprintf(stderr, "LoadHistory failed: %s\n", error.c_str());
+            return 0;
+        }
+        return static_cast<long long>(snapshot.mmrHistory.size());
+    }
+
+    int RunVariant(const std::string& variant, const fs::path& base)
+    {
+        const fs::path path = LocalDataStore(base, kUser).GetStorePath();
+        const double rssBefore = PeakRssMegabytes();
+        const auto start = std::chrono::steady_clock::now();
+        long long checksum = 0;
+        if (variant == "getline")
+        {
+            checksum = ReadGetline(path);
+        }
+        else if (variant == "copied")
+        {
+            checksum = ReadCopied(path);
+        }
+        else if (variant == "mapped")
+        {
+            checksum = ReadMapped(path);
+        }
+        else if (variant == "store")
+        {
+            std::error_code ec;
+            fs::remove(fs::path(path.string() + ".idx"), ec);
+            fs::remove(fs::path(path.string() + ".idx.sym"), ec);
+            checksum = LoadStore(base);
+        }
+        else
+        {
+            return 2;
+        }
+        const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        std::printf("%-8s %9.1f ms  peak RSS %7.1f MB (%+.1f MB)  checksum=%lld\n",
+                    variant.c_str(), ms, PeakRssMegabytes(), PeakRssMegabytes() - rssBefore, checksum);
+        return checksum != 0 ? 0 : 1;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    if (argc == 3)
+    {
+        return RunVariant(argv[1], argv[2]);
+    }
+
+    const fs::path base = fs::temp_directory_path() / "hs_store_read_bench";
+    fs::remove_all(base);
+    const fs::path path = WriteStore(base);
+    std::printf("Local store read of %.1f MB (%s)\n", static_cast<double>(fs::file_size(path)) / (1024.0 * 1024.0),
+                path.string().c_str());
+    std::fflush(stdout);
+
+    int failures = 0;
+    for (const char* variant : { "getline", "copied", "mapped", "store" })
+    {
+        const std::string command = "\"" + std::string(argv[0]) + "\" " + variant + " \"" + base.string() + "\"";
+        failures += std::system(command.c_str()) != 0 ? 1 : 0;
+    }
+    fs::remove_all(base);
+    return failures == 0 ? 0 : 1;
+}
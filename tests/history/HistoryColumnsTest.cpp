@@ -0,0 +1,121 @@
+// HistoryColumns: incremental column maintenance against a full rebuild, playlist
+// filtering, and the LTTB downsampler's guarantees (bounded size, ascending rows, end
+// points and isolated spikes kept).
+#include <algorithm>
+#include <cassert>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "history/HistoryColumns.h"
+#include "history/SnapshotIndex.h"
+
+namespace
+{
+    bool SameColumns(const MmrColumns& lhs, const MmrColumns& rhs)
+    {
+        return lhs.timestamps == rhs.timestamps && lhs.days == rhs.days && lhs.mmr == rhs.mmr
+            && lhs.playlist == rhs.playlist && lhs.delta == rhs.delta && lhs.entry == rhs.entry;
+    }
+
+    void CheckSelection(const std::vector<int32_t>& values, size_t target)
+    {
+        std::vector<uint32_t> selected((std::min)(values.size(), target));
+        const size_t written = HistoryColumns::DownsampleLttb(values.data(), values.size(), target, selected.data());
+        assert(written == (std::min)(values.size(), target));
+        if (written == 0)
+        {
+            return;
+        }
+        assert(selected.front() == 0);
+        if (written > 1)
+        {
+            assert(selected.back() == values.size() - 1);
+        }
+        for (size_t i = 1; i < written; ++i)
+        {
+            assert(selected[i] > selected[i - 1]);
+        }
+    }
+}
+
+int main()
+{
+    std::mt19937 rng(11);
+
+    // Appending in batches, with late entries mixed in, matches a rebuild from scratch.
+    {
+        HistorySnapshot snapshot;
+        const SymbolId playlists[] = {
+            snapshot.symbols.playlists.Intern("Ranked Doubles"),
+            snapshot.symbols.playlists.Intern("Ranked Duel"),
+        };
+        int64_t timestamp = 1700000000;
+        for (int batch = 0; batch < 40; ++batch)
+        {
+            const size_t first = snapshot.mmrHistory.size();
+            for (int i = 0; i < 5; ++i)
+            {
+                MmrHistoryEntry entry;
+                timestamp += 600;
+                entry.timestamp = (rng() % 7 == 0) ? timestamp - 5000 : timestamp;
+                entry.day = static_cast<int32_t>(entry.timestamp / 86400);
+                entry.playlist = playlists[rng() % 2];
+                entry.mmr = 1000 + static_cast<int>(rng() % 300);
+                snapshot.mmrHistory.push_back(entry);
+            }
+            SnapshotIndex::AddMmrEntries(snapshot, first);
+
+            MmrColumns rebuilt;
+            HistoryColumns::Rebuild(rebuilt, snapshot.mmrHistory);
+            assert(SameColumns(snapshot.mmrColumns, rebuilt));
+            assert(std::is_sorted(rebuilt.timestamps.begin(), rebuilt.timestamps.end()));
+        }
+
+        // Deltas are per playlist and survive filtering.
+        const MmrColumns duel = HistoryColumns::Filter(snapshot.mmrColumns, playlists[1]);
+        assert(duel.Size() > 1 && duel.delta.front() == 0);
+        for (size_t i = 1; i < duel.Size(); ++i)
+        {
+            assert(duel.playlist[i] == playlists[1]);
+            assert(duel.delta[i] == duel.mmr[i] - duel.mmr[i - 1]);
+        }
+    }
+
+    // Downsampling.
+    {
+        std::vector<int32_t> values(20000);
+        int32_t mmr = 1200;
+        for (auto& value : values)
+        {
+            mmr += static_cast<int32_t>(rng() % 21) - 10;
+            value = mmr;
+        }
+        values[12345] = 5000; // one isolated spike
+        values[777] = -5000;
+
+        for (const size_t target : { size_t{0}, size_t{1}, size_t{2}, size_t{3}, size_t{700}, size_t{20000}, size_t{50000} })
+        {
+            CheckSelection(values, target);
+        }
+        CheckSelection(std::vector<int32_t>{ 5 }, 700);
+        CheckSelection(std::vector<int32_t>{}, 700);
+
+        std::vector<uint32_t> selected(700);
+        selected.resize(HistoryColumns::DownsampleLttb(values.data(), values.size(), selected.size(), selected.data()));
+        assert(std::find(selected.begin(), selected.end(), 12345u) != selected.end());
+        assert(std::find(selected.begin(), selected.end(), 777u) != selected.end());
+
+        // A straight line needs no more than its end points to look right, but the
+        // budget is still used and rows stay ascending.
+        std::vector<int32_t> line(1000);
+        for (size_t i = 0; i < line.size(); ++i)
+        {
+            line[i] = static_cast<int32_t>(i);
+        }
+        CheckSelection(line, 50);
+    }
+
+    std::printf("HistoryColumnsTest passed\n");
+    return 0;
+}
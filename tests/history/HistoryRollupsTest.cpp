@@ -0,0 +1,203 @@
+// HistoryRollups: period keys, and day/week/season tables maintained while entries and
+// training arrive in batches (late entries included) against a regroup of the sorted
+// columns from scratch. Range and Combine must agree with the per-bucket values.
+#include <cassert>
+#include <cmath>
+#include <cstdio>
+#include <map>
+#include <random>
+#include <vector>
+
+#include "history/HistoryColumns.h"
+#include "history/HistoryRollups.h"
+#include "history/SnapshotIndex.h"
+#include "utils/HsUtils.h"
+
+namespace
+{
+    int32_t Day(const char* date)
+    {
+        int64_t epoch = 0;
+        const bool parsed = ParseTimestampEpoch(date, epoch);
+        assert(parsed);
+        (void)parsed;
+        return EpochDay(epoch);
+    }
+
+    struct Expected
+    {
+        std::map<SymbolId, RollupStats> byPlaylist;
+        SymbolId lastPlaylist = 0;
+        float trainingMinutes = 0.0f;
+    };
+
+    std::map<int32_t, Expected> Regroup(const HistorySnapshot& snapshot, RollupPeriod period)
+    {
+        std::map<int32_t, Expected> expected;
+        const MmrColumns& columns = snapshot.mmrColumns;
+        for (size_t row = 0; row < columns.Size(); ++row)
+        {
+            Expected& bucket = expected[HistoryRollups::Key(period, columns.days[row])];
+            RollupStats& stats = bucket.byPlaylist[columns.playlist[row]];
+            const int32_t mmr = columns.mmr[row];
+            if (stats.entries == 0)
+            {
+                stats.open = stats.min = stats.max = mmr;
+            }
+            stats.close = mmr;
+            stats.min = (std::min)(stats.min, mmr);
+            stats.max = (std::max)(stats.max, mmr);
+            stats.delta += columns.delta[row];
+            stats.games += snapshot.mmrHistory[columns.entry[row]].gamesPlayedDiff;
+            ++stats.entries;
+            bucket.lastPlaylist = columns.playlist[row];
+        }
+        for (const auto& entry : snapshot.trainingHistory)
+        {
+            expected[HistoryRollups::Key(period, entry.day)].trainingMinutes += static_cast<float>(entry.actualDuration) / 60.0f;
+        }
+        return expected;
+    }
+
+    void CheckTable(const HistorySnapshot& snapshot, RollupPeriod period)
+    {
+        const std::map<int32_t, Expected> expected = Regroup(snapshot, period);
+        const RollupTable& table = HistoryRollups::Table(snapshot.rollups, period);
+        assert(table.buckets.size() == expected.size());
+        size_t i = 0;
+        for (const auto& [key, bucket] : expected)
+        {
+            const RollupBucket& actual = table.buckets[i++];
+            assert(actual.key == key);
+            assert(std::fabs(actual.trainingMinutes - bucket.trainingMinutes) < 1e-3f);
+            if (!bucket.byPlaylist.empty())
+            {
+                assert(actual.lastPlaylist == bucket.lastPlaylist);
+            }
+            size_t played = 0;
+            for (size_t id = 0; id < actual.byPlaylist.size(); ++id)
+            {
+                const RollupStats& stats = actual.byPlaylist[id];
+                if (stats.entries == 0)
+                {
+                    continue;
+                }
+                ++played;
+                const RollupStats& want = bucket.byPlaylist.at(static_cast<SymbolId>(id));
+                assert(stats.open == want.open && stats.close == want.close);
+                assert(stats.min == want.min && stats.max == want.max);
+                assert(stats.delta == want.delta && stats.games == want.games && stats.entries == want.entries);
+            }
+            assert(played == bucket.byPlaylist.size());
+        }
+    }
+}
+
+int main()
+{
+    // Keys.
+    {
+        assert(HistoryRollups::Key(RollupPeriod::Day, 19000) == 19000);
+        const int32_t monday = Day("2024-03-04");
+        const int32_t week = HistoryRollups::Key(RollupPeriod::Week, monday);
+        assert(HistoryRollups::FirstDay(RollupPeriod::Week, week) == monday);
+        assert(HistoryRollups::Key(RollupPeriod::Week, monday + 6) == week);
+        assert(HistoryRollups::Key(RollupPeriod::Week, monday - 1) == week - 1);
+        assert(HistoryRollups::FirstDay(RollupPeriod::Week, HistoryRollups::Key(RollupPeriod::Week, -1)) == -3); // 1969-12-29
+
+        assert(HistoryRollups::Key(RollupPeriod::Season, Day("2020-09-22")) == 0);
+        assert(HistoryRollups::Key(RollupPeriod::Season, Day("2020-09-23")) == 1);
+        assert(HistoryRollups::Key(RollupPeriod::Season, Day("2024-03-05")) == 13);
+        assert(HistoryRollups::Key(RollupPeriod::Season, Day("2024-03-06")) == 14);
+        assert(HistoryRollups::FirstDay(RollupPeriod::Season, 14) == Day("2024-03-06"));
+        for (int32_t key = 1; key < 40; ++key)
+        {
+            const int32_t first = HistoryRollups::FirstDay(RollupPeriod::Season, key);
+            assert(HistoryRollups::Key(RollupPeriod::Season, first) == key);
+            assert(HistoryRollups::Key(RollupPeriod::Season, first - 1) == key - 1);
+        }
+    }
+
+    // Incremental tables match a regroup after every batch.
+    std::mt19937 rng(20);
+    HistorySnapshot snapshot;
+    const SymbolId playlists[] = {
+        snapshot.symbols.playlists.Intern("Ranked Doubles"),
+        snapshot.symbols.playlists.Intern("Ranked Duel"),
+        snapshot.symbols.playlists.Intern("Ranked Standard"),
+    };
+    int64_t timestamp = 1718000000; // June 2024, so batches cross week and season edges
+    for (int batch = 0; batch < 60; ++batch)
+    {
+        const size_t firstMmr = snapshot.mmrHistory.size();
+        for (int i = 0; i < 20; ++i)
+        {
+            timestamp += 1800 + static_cast<int64_t>(rng() % 20000);
+            MmrHistoryEntry entry;
+            entry.timestamp = (rng() % 9 == 0) ? timestamp - 300000 : timestamp;
+            entry.day = EpochDay(entry.timestamp);
+            entry.playlist = playlists[rng() % 3];
+            entry.mmr = 900 + static_cast<int>(rng() % 400);
+            entry.gamesPlayedDiff = static_cast<int>(rng() % 3);
+            snapshot.mmrHistory.push_back(entry);
+        }
+        SnapshotIndex::AddMmrEntries(snapshot, firstMmr);
+
+        const size_t firstTraining = snapshot.trainingHistory.size();
+        for (int i = 0; i < 3; ++i)
+        {
+            TrainingHistoryEntry training;
+            training.finishedTime = timestamp - static_cast<int64_t>(rng() % 800000);
+            training.day = EpochDay(training.finishedTime);
+            training.actualDuration = 300 + static_cast<int>(rng() % 3000);
+            snapshot.trainingHistory.push_back(training);
+        }
+        SnapshotIndex::AddTrainingEntries(snapshot, firstTraining);
+
+        CheckTable(snapshot, RollupPeriod::Day);
+        CheckTable(snapshot, RollupPeriod::Week);
+        CheckTable(snapshot, RollupPeriod::Season);
+    }
+
+    // Session seconds are plain sums per bucket.
+    {
+        const SymbolId ranked = snapshot.symbols.sessionTypes.Intern("ranked");
+        const int32_t day = snapshot.mmrColumns.days.back();
+        HistoryRollups::AddSessionSeconds(snapshot.rollups, day, ranked, 120.0);
+        HistoryRollups::AddSessionSeconds(snapshot.rollups, day - 1, ranked, 60.0);
+        const RollupBucket* bucket = HistoryRollups::Find(snapshot.rollups.days, day);
+        assert(bucket != nullptr && bucket->secondsBySessionType[ranked] == 120.0);
+        const RollupBucket* week = HistoryRollups::Find(snapshot.rollups.weeks, HistoryRollups::Key(RollupPeriod::Week, day));
+        assert(week != nullptr && week->secondsBySessionType[ranked] >= 120.0);
+    }
+
+    // Combining every week of a playlist gives the playlist's whole history.
+    {
+        const RollupTable& weeks = snapshot.rollups.weeks;
+        const auto all = HistoryRollups::Range(weeks, weeks.buckets.front().key, weeks.buckets.back().key);
+        assert(all.first == 0 && all.second == weeks.buckets.size());
+        const RollupStats duel = HistoryRollups::Combine(weeks, all.first, all.second, playlists[1]);
+        const MmrColumns rows = HistoryColumns::Filter(snapshot.mmrColumns, playlists[1]);
+        assert(duel.entries == static_cast<int32_t>(rows.Size()));
+        assert(duel.open == rows.mmr.front() && duel.close == rows.mmr.back());
+        assert(duel.delta == rows.mmr.back() - rows.mmr.front());
+
+        const int32_t middle = weeks.buckets[weeks.buckets.size() / 2].key;
+        const auto one = HistoryRollups::Range(weeks, middle, middle);
+        assert(one.second == one.first + 1 && weeks.buckets[one.first].key == middle);
+        const auto none = HistoryRollups::Range(weeks, middle, middle - 1);
+        assert(none.first == none.second);
+        assert(HistoryRollups::Find(weeks, weeks.buckets.back().key + 1) == nullptr);
+    }
+
+    // A rebuild drops the tables and folds everything again.
+    {
+        HistorySnapshot rebuilt = snapshot;
+        SnapshotIndex::Rebuild(rebuilt);
+        CheckTable(rebuilt, RollupPeriod::Day);
+        CheckTable(rebuilt, RollupPeriod::Season);
+    }
+
+    std::printf("HistoryRollupsTest passed\n");
+    return 0;
+}
@@ -0,0 +1,146 @@
+// Differential test: every SIMD scan level the CPU supports must agree with the scalar
+// reference, both on raw buffers and through the parsers built on top of them.
+#include <cassert>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "history/HistoryJson.h"
+#include "history/JsonScan.h"
+
+namespace
+{
+    using HistoryJson::Scan::Level;
+
+    std::vector<Level> SupportedLevels()
+    {
+        std::vector<Level> levels{ Level::Scalar };
+        if (HistoryJson::Scan::DetectedLevel() != Level::Scalar)
+        {
+            levels.push_back(Level::Sse2);
+        }
+        if (HistoryJson::Scan::DetectedLevel() == Level::Avx2)
+        {
+            levels.push_back(Level::Avx2);
+        }
+        return levels;
+    }
+
+    // Biased towards the bytes the scanners care about, plus high-bit bytes that would
+    // break a signed compare.
+    std::string RandomBuffer(std::mt19937& rng, size_t length)
+    {
+        static const char kAlphabet[] = "\"\\{}[]:, \t\r\n\v\faz09-.eE[{\x7f\x80\xdb\xfb\xfd";
+        std::uniform_int_distribution<size_t> pick(0, sizeof(kAlphabet) - 2);
+        std::uniform_int_distribution<int> plain(0, 3);
+        std::string buffer(length, 'x');
+        for (auto& c : buffer)
+        {
+            if (plain(rng) == 0)
+            {
+                c = kAlphabet[pick(rng)];
+            }
+        }
+        return buffer;
+    }
+
+    std::string RandomDocument(std::mt19937& rng)
+    {
+        std::uniform_int_distribution<int> count(0, 6);
+        std::uniform_int_distribution<int> run(0, 70);
+        std::string json = "{";
+        const int members = count(rng);
+        for (int i = 0; i < members; ++i)
+        {
+            json += i ? ", " : " ";
+            json += "\"k" + std::to_string(i) + "\" :\t";
+            switch (count(rng) % 4)
+            {
+            case 0: json += "\"" + std::string(run(rng), 'a') + "\\\"" + std::string(run(rng), 'b') + "\""; break;
+            case 1: json += std::to_string(run(rng) - 35); break;
+            case 2: json += "[" + std::string(run(rng), ' ') + "{\"x\":\"" + std::string(run(rng), ']') + "\"}]"; break;
+            default: json += "\"" + std::string(run(rng), 'c') + "\""; break;
+            }
+        }
+        json += std::string(run(rng) % 40, ' ') + "}";
+        if (count(rng) == 0)
+        {
+            // Occasionally corrupt a byte so error paths are compared too.
+            json[std::uniform_int_distribution<size_t>(0, json.size() - 1)(rng)] = '"';
+        }
+        return json;
+    }
+
+    std::string Describe(const std::string& json)
+    {
+        std::string result;
+        std::string error;
+
+        HistoryJson::Parser parser(json);
+        HistoryJson::Value value;
+        result += parser.Parse(value, error) ? "P1" : "P0:" + error;
+        for (const auto& [key, member] : value.objectValue)
+        {
+            result += "|" + key + "=" + member.stringValue + std::to_string(member.arrayValue.size());
+        }
+
+        HistoryJson::ViewDocument document;
+        error.clear();
+        result += document.Parse(json, error) ? " V1" : " V0:" + error;
+        for (uint32_t i = 0; i < document.Root().size && document.Root().type == HistoryJson::Type::Object; ++i)
+        {
+            result += "|" + std::string(document.Root().members[i].value.stringValue);
+        }
+
+        static constexpr HistoryJson::KeyList<3> kKeys{ "k0", "k2", "k4" };
+        HistoryJson::FieldExtractor extractor(json);
+        error.clear();
+        const bool extracted = extractor.Extract(kKeys, [&result](size_t index, const HistoryJson::ViewValue& member) {
+            result += "|" + std::to_string(index) + ":" + std::string(member.stringValue);
+        }, error);
+        result += extracted ? " X1" : " X0:" + error;
+        return result;
+    }
+}
+
+int main()
+{
+    const std::vector<Level> levels = SupportedLevels();
+    std::mt19937 rng(20240601);
+
+    for (int iteration = 0; iteration < 2000; ++iteration)
+    {
+        const std::string buffer = RandomBuffer(rng, iteration % 200);
+        for (size_t pos = 0; pos <= buffer.size() + 1; ++pos)
+        {
+            const size_t quote = HistoryJson::Scan::Scalar::FindQuoteOrBackslash(buffer, pos);
+            const size_t structural = HistoryJson::Scan::Scalar::FindStructural(buffer, pos);
+            const size_t whitespace = HistoryJson::Scan::Scalar::SkipWhitespace(buffer, pos);
+            const size_t newline = HistoryJson::Scan::Scalar::FindNewline(buffer, pos);
+            for (Level level : levels)
+            {
+                HistoryJson::Scan::SetLevel(level);
+                assert(HistoryJson::Scan::FindQuoteOrBackslash(buffer, pos) == quote);
+                assert(HistoryJson::Scan::FindStructural(buffer, pos) == structural);
+                assert(HistoryJson::Scan::SkipWhitespace(buffer, pos) == whitespace);
+                assert(HistoryJson::Scan::FindNewline(buffer, pos) == newline);
+            }
+        }
+    }
+
+    for (int iteration = 0; iteration < 20000; ++iteration)
+    {
+        const std::string json = RandomDocument(rng);
+        HistoryJson::Scan::SetLevel(Level::Scalar);
+        const std::string expected = Describe(json);
+        for (Level level : levels)
+        {
+            HistoryJson::Scan::SetLevel(level);
+            assert(Describe(json) == expected);
+        }
+    }
+
+    std::printf("JsonScan differential test passed (%zu level(s))\n", levels.size());
+    return 0;
+}
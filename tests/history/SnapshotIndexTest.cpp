@@ -0,0 +1,210 @@
+// SnapshotIndex against the linear scans the overlay used to run every frame: incremental
+// updates, in any arrival order and with duplicate timestamps, must pick the same latest
+// and previous entries and the same per-day training minutes.
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "history/SnapshotIndex.h"
+#include "utils/HsUtils.h"
+
+namespace
+{
+    const MmrHistoryEntry* ScanLatest(const std::vector<MmrHistoryEntry>& history, const MmrHistoryEntry* skip)
+    {
+        const MmrHistoryEntry* latest = nullptr;
+        for (const auto& entry : history)
+        {
+            if (&entry != skip && (latest == nullptr || entry.timestamp > latest->timestamp))
+            {
+                latest = &entry;
+            }
+        }
+        return latest;
+    }
+
+    float ScanTrainingMinutes(const std::vector<TrainingHistoryEntry>& history, int32_t day)
+    {
+        float minutes = 0.0f;
+        for (const auto& entry : history)
+        {
+            if (EpochDay(entry.finishedTime != 0 ? entry.finishedTime : entry.startedTime) == day)
+            {
+                minutes += static_cast<float>(entry.actualDuration) / 60.0f;
+            }
+        }
+        return minutes;
+    }
+
+    int64_t RandomTimestamp(std::mt19937& rng)
+    {
+        // A narrow range so equal timestamps are common.
+        std::uniform_int_distribution<int> day(1, 4);
+        std::uniform_int_distribution<int> hour(10, 13);
+        char buffer[32];
+        std::snprintf(buffer, sizeof(buffer), "2024-03-%02dT%02d:00:00Z", day(rng), hour(rng));
+        int64_t epoch = 0;
+        const bool parsed = ParseTimestampEpoch(buffer, epoch);
+        assert(parsed);
+        (void)parsed;
+        return epoch;
+    }
+
+    void CheckAgainstScan(const HistorySnapshot& snapshot)
+    {
+        const MmrHistoryEntry* latest = ScanLatest(snapshot.mmrHistory, nullptr);
+        const MmrHistoryEntry* previous = ScanLatest(snapshot.mmrHistory, latest);
+        const LatestMmrPair& pair = snapshot.index.overall;
+        assert((latest == nullptr) == (pair.latest < 0));
+        assert((previous == nullptr) == (pair.previous < 0));
+        if (latest)
+        {
+            assert(&snapshot.mmrHistory[pair.latest] == latest);
+            const float expected = ScanTrainingMinutes(snapshot.trainingHistory, EpochDay(latest->timestamp));
+            assert(std::fabs(SnapshotIndex::LatestDayTrainingMinutes(snapshot) - expected) < 1e-3f);
+        }
+        if (previous)
+        {
+            assert(&snapshot.mmrHistory[pair.previous] == previous);
+        }
+
+        for (size_t playlist = 0; playlist < snapshot.index.byPlaylist.size(); ++playlist)
+        {
+            const LatestMmrPair& playlistPair = snapshot.index.byPlaylist[playlist];
+            std::vector<MmrHistoryEntry> subset;
+            std::vector<int> positions;
+            for (size_t i = 0; i < snapshot.mmrHistory.size(); ++i)
+            {
+                if (snapshot.mmrHistory[i].playlist == playlist)
+                {
+                    subset.push_back(snapshot.mmrHistory[i]);
+                    positions.push_back(static_cast<int>(i));
+                }
+            }
+            const MmrHistoryEntry* subsetLatest = ScanLatest(subset, nullptr);
+            const MmrHistoryEntry* subsetPrevious = ScanLatest(subset, subsetLatest);
+            if (!subsetLatest)
+            {
+                assert(playlistPair.latest < 0 && playlistPair.previous < 0);
+                continue;
+            }
+            assert(positions[subsetLatest - subset.data()] == playlistPair.latest);
+            assert(subsetPrevious ? positions[subsetPrevious - subset.data()] == playlistPair.previous
+                                  : playlistPair.previous < 0);
+        }
+    }
+}
+
+int main()
+{
+    // Timestamp parsing and day buckets.
+    {
+        int64_t epoch = 0;
+        assert(ParseTimestampEpoch("2024-03-01T10:00:00Z", epoch) && epoch == 1709287200);
+        assert(FormatTimestampEpoch(epoch) == "2024-03-01T10:00:00Z");
+        assert(ParseTimestampEpoch("2024-03-01 10:00:00.250", epoch) && epoch == 1709287200);
+        assert(ParseTimestampEpoch("2024-03-01T12:30:00+02:30", epoch) && epoch == 1709287200);
+        assert(ParseTimestampEpoch("2024-03-01T05:00-05:00", epoch) && epoch == 1709287200);
+        assert(ParseTimestampEpoch("2024-03-01", epoch) && epoch == 1709251200);
+        assert(!ParseTimestampEpoch("t1", epoch) && !ParseTimestampEpoch("2024-03-01T10", epoch));
+        assert(!ParseTimestampEpoch("2024-13-01T10:00:00Z", epoch) && !ParseTimestampEpoch("2024-03-01T10:00:00Zx", epoch));
+        assert(EpochDay(1709287200) == 19783 && EpochDay(-1) == -1);
+        assert(FormatEpochDay(19783) == "2024-03-01");
+        assert(FormatTimestampEpochUk(1709287200) == "01/03/2024 10:00:00");
+        assert(FormatTimestampEpochUk(0).empty());
+    }
+
+    std::mt19937 rng(7);
+    const std::vector<std::string> playlists{ "Ranked Doubles", "Ranked Duel", "Ranked Standard" };
+
+    for (int round = 0; round < 200; ++round)
+    {
+        HistorySnapshot snapshot;
+        std::uniform_int_distribution<int> batch(0, 6);
+        for (int step = 0; step < 8; ++step)
+        {
+            const size_t firstMmr = snapshot.mmrHistory.size();
+            for (int i = batch(rng); i > 0; --i)
+            {
+                MmrHistoryEntry entry;
+                entry.timestamp = RandomTimestamp(rng);
+                entry.day = EpochDay(entry.timestamp);
+                entry.playlist = snapshot.symbols.playlists.Intern(playlists[rng() % playlists.size()]);
+                entry.mmr = 900 + static_cast<int>(rng() % 400);
+                snapshot.mmrHistory.push_back(entry);
+            }
+            SnapshotIndex::AddMmrEntries(snapshot, firstMmr);
+
+            const size_t firstTraining = snapshot.trainingHistory.size();
+            for (int i = batch(rng) / 2; i > 0; --i)
+            {
+                TrainingHistoryEntry entry;
+                (rng() % 3 == 0 ? entry.startedTime : entry.finishedTime) = RandomTimestamp(rng);
+                entry.day = EpochDay(entry.finishedTime != 0 ? entry.finishedTime : entry.startedTime);
+                entry.actualDuration = 60 + static_cast<int>(rng() % 1200);
+                snapshot.trainingHistory.push_back(entry);
+            }
+            SnapshotIndex::AddTrainingEntries(snapshot, firstTraining);
+
+            CheckAgainstScan(snapshot);
+        }
+
+        HistorySnapshot rebuilt = snapshot;
+        SnapshotIndex::Rebuild(rebuilt);
+        assert(rebuilt.index.overall.latest == snapshot.index.overall.latest);
+        assert(rebuilt.index.overall.previous == snapshot.index.overall.previous);
+        assert(rebuilt.index.latestDay == snapshot.index.latestDay);
+    }
+
+    // Training only: fall back to the last session.
+    {
+        HistorySnapshot snapshot;
+        TrainingHistoryEntry entry;
+        entry.finishedTime = 1709287200; // 2024-03-01T10:00:00Z
+        entry.day = EpochDay(entry.finishedTime);
+        entry.actualDuration = 90;
+        snapshot.trainingHistory.push_back(entry);
+        SnapshotIndex::Rebuild(snapshot);
+        assert(std::fabs(SnapshotIndex::LatestDayTrainingMinutes(snapshot) - 1.5f) < 1e-6f);
+    }
+
+    // The per-frame read stays flat as history grows.
+    for (size_t entries : { size_t{1000}, size_t{100000} })
+    {
+        HistorySnapshot snapshot;
+        for (size_t i = 0; i < entries; ++i)
+        {
+            MmrHistoryEntry entry;
+            entry.timestamp = RandomTimestamp(rng);
+            entry.day = EpochDay(entry.timestamp);
+            entry.playlist = snapshot.symbols.playlists.Intern(playlists[i % playlists.size()]);
+            entry.mmr = static_cast<int>(i);
+            snapshot.mmrHistory.push_back(entry);
+            TrainingHistoryEntry training;
+            training.finishedTime = entry.timestamp;
+            training.day = entry.day;
+            training.actualDuration = 600;
+            snapshot.trainingHistory.push_back(training);
+        }
+        SnapshotIndex::Rebuild(snapshot);
+
+        constexpr int kReads = 100000;
+        float sink = 0.0f;
+        const auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < kReads; ++i)
+        {
+            const LatestMmrPair& pair = snapshot.index.overall;
+            sink += static_cast<float>(snapshot.mmrHistory[pair.latest].mmr - snapshot.mmrHistory[pair.previous].mmr);
+            sink += SnapshotIndex::LatestDayTrainingMinutes(snapshot);
+        }
+        const double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / kReads;
+        std::printf("%zu entries: %.1f ns per overlay read (sink %.0f)\n", entries, ns, sink);
+    }
+
+    std::printf("SnapshotIndexTest passed\n");
+    return 0;
+}
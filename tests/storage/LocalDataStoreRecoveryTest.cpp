@@ -0,0 +1,219 @@
+// Startup recovery: what a crash provably tore at the end of the store (a partial line, a
+// damaged last line, frames for bytes that never reached the disk) is cut back to the last
+// committed line, a torn frame is dropped, the history sidecar is dropped when it covered
+// cut bytes, and appends and loads carry on cleanly. Complete lines no frame speaks against
+// (no journal, a stale journal, lines written without one) are never cut.
+#include <cassert>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "storage/LocalDataStore.h"
+
+namespace fs = std::filesystem;
+
+namespace
+{
+    std::string Payload(int i)
+    {
+        char timestamp[32];
+        std::snprintf(timestamp, sizeof(timestamp), "2024-06-%02dT%02d:%02d:00Z", 1 + i / 1440, (i / 60) % 24, i % 60);
+        return std::string("{\"timestamp\":\"") + timestamp + "\",\"playlist\":\"Ranked Doubles\",\"mmr\":"
+            + std::to_string(1000 + i) + ",\"sessionType\":\"ranked\"}";
+    }
+
+    void AppendRaw(const fs::path& path, const std::string& bytes)
+    {
+        std::ofstream output(path, std::ios::out | std::ios::binary | std::ios::app);
+        output.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+    }
+
+    size_t LoadCount(LocalDataStore& store)
+    {
+        HistorySnapshot snapshot;
+        std::string error;
+        const bool ok = store.LoadHistory(snapshot, error);
+        assert(ok && error.empty());
+        (void)ok;
+        return snapshot.mmrHistory.size();
+    }
+
+    // A store of `count` payloads, each appended (and framed) on its own, loaded once so the
+    // sidecar covers all of it.
+    uint64_t Populate(const fs::path& base, const std::string& user, int count)
+    {
+        LocalDataStore store(base, user);
+        for (int i = 0; i < count; ++i)
+        {
+            std::string error;
+            const bool ok = store.AppendPayload(Payload(i), error);
+            assert(ok);
+            (void)ok;
+        }
+        assert(LoadCount(store) == static_cast<size_t>(count));
+        return fs::file_size(store.GetStorePath());
+    }
+
+    fs::path JournalPath(const fs::path& store)
+    {
+        return fs::path(store.string() + ".journal");
+    }
+
+    fs::path IndexPath(const fs::path& store)
+    {
+        return fs::path(store.string() + ".idx");
+    }
+}
+
+int main()
+{
+    const fs::path base = fs::temp_directory_path() / "hs_store_recovery_test";
+    fs::remove_all(base);
+    constexpr int kCount = 20;
+
+    // Partial final line.
+    {
+        const uint64_t committed = Populate(base, "partial", kCount);
+        const fs::path path = LocalDataStore(base, "partial").GetStorePath();
+        AppendRaw(path, "{\"timestamp\":\"2024-06-02T0");
+
+        LocalDataStore store(base, "partial");
+        assert(fs::file_size(path) == committed);
+        assert(fs::exists(IndexPath(path)));
+        assert(LoadCount(store) == kCount);
+
+        LocalDataStore::AppendVerification verification;
+        std::string error;
+        const bool ok = store.AppendPayloadsWithVerification({ Payload(kCount) }, error, &verification);
+        assert(ok && verification.ok && verification.records[0].offset == committed);
+        assert(LoadCount(store) == kCount + 1);
+    }
+
+    // Complete lines past the last frame are kept, a partial one after them is not.
+    {
+        Populate(base, "unframed", kCount);
+        const fs::path path = LocalDataStore(base, "unframed").GetStorePath();
+        AppendRaw(path, Payload(kCount) + "\n" + Payload(kCount + 1) + "\n");
+        const uint64_t complete = fs::file_size(path);
+        AppendRaw(path, Payload(kCount + 2).substr(0, 25));
+
+        LocalDataStore store(base, "unframed");
+        assert(fs::file_size(path) == complete);
+        assert(LoadCount(store) == kCount + 2);
+
+        std::string error;
+        const bool ok = store.AppendPayload(Payload(kCount + 2), error);
+        assert(ok && LoadCount(store) == kCount + 3);
+    }
+
+    // A store replaced behind the journal's back: no frame matches, nothing complete is cut,
+    // and the journal starts over at the end of the store.
+    {
+        Populate(base, "replaced", kCount);
+        const fs::path path = LocalDataStore(base, "replaced").GetStorePath();
+        fs::remove(IndexPath(path));
+        {
+            std::ofstream output(path, std::ios::out | std::ios::binary | std::ios::trunc);
+            for (int i = 0; i < kCount + 5; ++i)
+            {
+                const std::string line = Payload(100 + i) + "\n";
+                output.write(line.data(), static_cast<std::streamsize>(line.size()));
+            }
+        }
+        const uint64_t replaced = fs::file_size(path);
+
+        LocalDataStore store(base, "replaced");
+        assert(fs::file_size(path) == replaced);
+        assert(fs::file_size(JournalPath(path)) == 24);
+        assert(LoadCount(store) == kCount + 5);
+
+        std::string error;
+        const bool ok = store.AppendPayload(Payload(kCount + 200), error);
+        assert(ok && LoadCount(store) == kCount + 6);
+        assert(fs::file_size(JournalPath(path)) == 24 + sizeof(StoreJournal::Frame));
+    }
+
+    // A damaged last line is cut, and the sidecar that indexed it is rebuilt.
+    {
+        const uint64_t committed = Populate(base, "damaged", kCount);
+        const fs::path path = LocalDataStore(base, "damaged").GetStorePath();
+        const uint64_t lastLine = committed - (Payload(kCount - 1).size() + 1);
+        {
+            std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+            file.seekp(static_cast<std::streamoff>(lastLine + 20));
+            file.put('#');
+        }
+        const uint64_t journalSize = fs::file_size(JournalPath(path));
+
+        LocalDataStore store(base, "damaged");
+        assert(fs::file_size(path) == lastLine);
+        assert(fs::file_size(JournalPath(path)) == journalSize - sizeof(StoreJournal::Frame));
+        assert(!fs::exists(IndexPath(path)));
+        assert(LoadCount(store) == kCount - 1);
+
+        std::string error;
+        const bool ok = store.AppendPayload(Payload(kCount - 1), error);
+        assert(ok && LoadCount(store) == kCount);
+    }
+
+    // A torn frame is dropped; the line before it stays committed.
+    {
+        const uint64_t committed = Populate(base, "torn-frame", kCount);
+        const fs::path path = LocalDataStore(base, "torn-frame").GetStorePath();
+        const uint64_t journalSize = fs::file_size(JournalPath(path));
+        AppendRaw(JournalPath(path), std::string(10, '\x7f'));
+
+        LocalDataStore store(base, "torn-frame");
+        assert(fs::file_size(path) == committed);
+        assert(fs::file_size(JournalPath(path)) == journalSize);
+        assert(LoadCount(store) == kCount);
+    }
+
+    // Frames written, store bytes lost (power cut before the data reached the disk).
+    {
+        Populate(base, "lost", kCount);
+        const fs::path path = LocalDataStore(base, "lost").GetStorePath();
+        const uint64_t lastLine = fs::file_size(path) - (Payload(kCount - 1).size() + 1);
+        fs::resize_file(path, lastLine + 7);
+
+        LocalDataStore store(base, "lost");
+        assert(fs::file_size(path) == lastLine);
+        assert(LoadCount(store) == kCount - 1);
+    }
+
+    // No journal: complete lines are all kept, a partial final line is not.
+    {
+        const fs::path path = LocalDataStore(base, "legacy").GetStorePath();
+        fs::create_directories(path.parent_path());
+        fs::remove(JournalPath(path));
+        AppendRaw(path, Payload(0) + "\n" + Payload(1) + "\n" + Payload(2) + "\n");
+        const uint64_t complete = fs::file_size(path);
+        AppendRaw(path, Payload(3).substr(0, 30));
+
+        LocalDataStore store(base, "legacy");
+        assert(fs::file_size(path) == complete);
+        assert(fs::file_size(JournalPath(path)) == 24);
+        assert(LoadCount(store) == 3);
+
+        std::string error;
+        const bool ok = store.AppendPayload(Payload(3), error);
+        assert(ok && LoadCount(store) == 4);
+        assert(fs::file_size(JournalPath(path)) == 24 + sizeof(StoreJournal::Frame));
+    }
+
+    // A clean store is left alone.
+    {
+        const uint64_t committed = Populate(base, "clean", kCount);
+        const fs::path path = LocalDataStore(base, "clean").GetStorePath();
+        LocalDataStore store(base, "clean");
+        assert(fs::file_size(path) == committed);
+        assert(fs::exists(IndexPath(path)));
+        assert(LoadCount(store) == kCount);
+    }
+
+    fs::remove_all(base);
+    std::printf("LocalDataStoreRecoveryTest passed\n");
+    return 0;
+}
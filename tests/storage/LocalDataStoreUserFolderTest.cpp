@@ -1,5 +1,8 @@
+#include <algorithm>
 #include <cassert>
+#include <cstdio>
 #include <filesystem>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -23,6 +26,76 @@ int main()
     fs::path expected = base / userId / "local_history.jsonl";
     assert(fs::exists(expected));
 
+    // Incremental history loads pick up appended lines without a full rebuild
+    LocalDataStore historyStore(base, "history-user");
+    fs::remove(historyStore.GetStorePath());
+    historyStore.AppendPayloads(payloads, error);
+    HistorySnapshot snapshot;
+    ok = historyStore.LoadHistory(snapshot, error);
+    assert(ok && snapshot.mmrHistory.size() == 1);
+    historyStore.AppendPayloads({ "{\"timestamp\":\"t2\",\"playlist\":\"p\",\"mmr\":4,\"sessionType\":\"ranked\"}" }, error);
+    ok = historyStore.LoadHistory(snapshot, error);
+    assert(ok && snapshot.mmrHistory.size() == 2);
+    assert(snapshot.aggregates.mmrDeltas.back().delta == 3);
+
+    // Shared loads hand out the cached snapshot: the same one while nothing changes, never
+    // modified once handed out, and its buffer reused once released
+    {
+        const auto mmrPayload = [](int day, int mmr) {
+            return std::string("{\"timestamp\":\"2024-07-0") + std::to_string(day)
+                + "T10:00:00Z\",\"playlist\":\"Ranked Duel\",\"mmr\":" + std::to_string(mmr) + "}";
+        };
+        LocalDataStore shared(base, "shared-user");
+        fs::remove(shared.GetStorePath());
+        fs::remove(fs::path(shared.GetStorePath().string() + ".idx"));
+        shared.AppendPayloads({ mmrPayload(2, 1000) }, error);
+        std::shared_ptr<const HistorySnapshot> first;
+        std::shared_ptr<const HistorySnapshot> again;
+        ok = shared.LoadHistory(first, error) && shared.LoadHistory(again, error);
+        assert(ok && first == again && first->mmrHistory.size() == 1);
+        const HistorySnapshot* firstBuffer = first.get();
+
+        shared.AppendPayloads({ mmrPayload(3, 1010) }, error);
+        std::shared_ptr<const HistorySnapshot> second;
+        ok = shared.LoadHistory(second, error);
+        assert(ok && second != first && second->mmrHistory.size() == 2);
+        assert(first->mmrHistory.size() == 1 && second->aggregates.mmrDeltas.back().delta == 10);
+
+        // Released: caught up in place, late entries included.
+        first.reset();
+        again.reset();
+        shared.AppendPayloads({ mmrPayload(1, 990) }, error);
+        std::shared_ptr<const HistorySnapshot> third;
+        ok = shared.LoadHistory(third, error);
+        assert(ok && third.get() == firstBuffer && third->mmrHistory.size() == 3);
+        assert(third->mmrHistory.front().mmr == 990 && third->aggregates.mmrDeltas[1].delta == 10);
+        assert(second->mmrHistory.size() == 2);
+
+        // Still held: a new one is built.
+        shared.AppendPayloads({ mmrPayload(4, 1020) }, error);
+        std::shared_ptr<const HistorySnapshot> fourth;
+        ok = shared.LoadHistory(fourth, error);
+        assert(ok && fourth != second && fourth != third && fourth->mmrHistory.size() == 4);
+        assert(fourth->status.mmrEntries == 4 && second->mmrHistory.size() == 2 && third->mmrHistory.size() == 3);
+        assert(fourth->symbols.playlists.Name(fourth->mmrHistory.back().playlist) == "Ranked Duel");
+
+        // Released and asked for again with nothing changed: the same snapshot, handed out anew.
+        const HistorySnapshot* fourthBuffer = fourth.get();
+        fourth.reset();
+        std::shared_ptr<const HistorySnapshot> fifth;
+        ok = shared.LoadHistory(fifth, error);
+        assert(ok && fifth.get() == fourthBuffer && fifth->mmrHistory.size() == 4);
+    }
+
+    // Verification reads back only the appended records and reports each one
+    LocalDataStore::AppendVerification verification;
+    const uint64_t before = fs::file_size(historyStore.GetStorePath());
+    ok = historyStore.AppendPayloadsWithVerification({ payloads[0], payloads[0] }, error, &verification);
+    assert(ok && verification.ok && verification.records.size() == 2);
+    assert(verification.records[0].offset == before);
+    assert(verification.records[1].offset == before + payloads[0].size() + 1);
+    assert(verification.records[1].ok && verification.records[1].crc != 0);
+
     // Force rotation
     for (int i = 0; i < 10; ++i)
     {
@@ -32,6 +105,68 @@ int main()
     fs::path rotated = base / userId / "local_history.jsonl.1";
     assert(fs::exists(rotated));
 
+    // History spans rotated segments: nothing rotated out is lost, segments merge by time,
+    // and sealed segments get their own sidecars for the next cold load
+    {
+        LocalDataStore segmented(base, "segments-user");
+        fs::remove_all(segmented.GetStorePath().parent_path());
+        segmented.SetLimits(300, 64);
+        const auto payloadAt = [](int minute, int mmr) {
+            char timestamp[32];
+            std::snprintf(timestamp, sizeof(timestamp), "2024-05-%02dT%02d:%02d:00Z", 1 + minute / 1440, (minute / 60) % 24, minute % 60);
+            return std::string("{\"timestamp\":\"") + timestamp + "\",\"playlist\":\"Ranked Duel\",\"mmr\":"
+                + std::to_string(mmr) + ",\"sessionType\":\"ranked\",\"durationSeconds\":60}";
+        };
+
+        size_t appended = 0;
+        for (int i = 0; i < 40; ++i)
+        {
+            // Every tenth payload is late, so it sorts into an older segment's range.
+            const int minute = (i % 10 == 9) ? i * 30 - 200 : i * 30;
+            ok = segmented.AppendPayloads({ payloadAt(minute, 1000 + i) }, error);
+            assert(ok);
+            ++appended;
+            if (i % 3 == 0)
+            {
+                ok = segmented.LoadHistory(snapshot, error);
+                assert(ok && snapshot.mmrHistory.size() == appended);
+            }
+        }
+        const fs::path sealed = fs::path(segmented.GetStorePath().string() + ".1");
+        const fs::path third = fs::path(segmented.GetStorePath().string() + ".3");
+        assert(fs::exists(third) || fs::exists(fs::path(third.string() + ".hsz")));
+
+        ok = segmented.LoadHistory(snapshot, error);
+        assert(ok && error.empty() && snapshot.mmrHistory.size() == appended);
+        assert(std::is_sorted(snapshot.mmrHistory.begin(), snapshot.mmrHistory.end(),
+                              [](const MmrHistoryEntry& lhs, const MmrHistoryEntry& rhs) { return lhs.timestamp < rhs.timestamp; }));
+        assert(fs::exists(fs::path(sealed.string() + ".idx")));
+
+        // Loading leaves segments as they are; compressing them afterwards keeps their
+        // entries cached, and the sidecars stay under the plain name.
+        assert(fs::exists(sealed));
+        ok = segmented.CompressSealedSegments(error);
+        assert(ok && error.empty());
+        assert(!fs::exists(sealed) && fs::exists(fs::path(sealed.string() + ".hsz")));
+        assert(!fs::exists(third) && fs::exists(fs::path(third.string() + ".hsz")));
+        ok = segmented.LoadHistory(snapshot, error);
+        assert(ok && error.empty() && snapshot.mmrHistory.size() == appended);
+
+        // Cold load: sealed segments from their sidecars, or inflated and parsed when a
+        // sidecar is damaged.
+        fs::resize_file(fs::path(sealed.string() + ".idx"), 10);
+        LocalDataStore reopened(base, "segments-user");
+        HistorySnapshot cold;
+        ok = reopened.LoadHistory(cold, error);
+        assert(ok && error.empty() && cold.mmrHistory.size() == appended);
+        for (size_t i = 0; i < appended; ++i)
+        {
+            assert(cold.mmrHistory[i].timestamp == snapshot.mmrHistory[i].timestamp);
+            assert(cold.mmrHistory[i].mmr == snapshot.mmrHistory[i].mmr);
+        }
+        assert(fs::file_size(fs::path(sealed.string() + ".idx")) > 10);
+    }
+
     // Resolver sanity checks
     const std::string resolvedPlatform = UserIdResolver::ResolveUserIdFromStrings("Epic-ABC_123", "");
     assert(resolvedPlatform.find("epic-abc-123") != std::string::npos);
@@ -0,0 +1,193 @@
+// Lz4Block round trips (empty, tiny, incompressible, repetitive, JSONL) and rejects
+// malformed input; SegmentArchive restores a segment byte for byte, reads only the blocks
+// a time range touches, and reports a damaged block instead of returning bad bytes.
+#include <cassert>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "storage/Lz4Block.h"
+#include "storage/SegmentArchive.h"
+
+namespace fs = std::filesystem;
+
+namespace
+{
+    std::string RoundTrip(const std::string& input)
+    {
+        std::string encoded(Lz4Block::CompressBound(input.size()), '\0');
+        const size_t size = Lz4Block::Compress(input.data(), input.size(), encoded.data(), encoded.size());
+        assert(size > 0 && size <= encoded.size());
+        encoded.resize(size);
+
+        std::string decoded(input.size(), '\0');
+        const bool ok = Lz4Block::Decompress(encoded.data(), encoded.size(), decoded.data(), decoded.size());
+        assert(ok && decoded == input);
+        (void)ok;
+        return encoded;
+    }
+
+    std::string JsonLine(int i)
+    {
+        const int64_t timestamp = 1714521600 + i * 600;
+        return std::string("{\"timestamp\":") + std::to_string(timestamp)
+            + ",\"playlist\":\"Ranked Doubles\",\"mmr\":" + std::to_string(1000 + (i * 37) % 300)
+            + ",\"sessionType\":\"ranked\",\"gamesPlayedDiff\":1,\"durationSeconds\":" + std::to_string(300 + i % 120) + "}\n";
+    }
+}
+
+int main()
+{
+    // Lz4Block.
+    {
+        RoundTrip("");
+        RoundTrip("a");
+        RoundTrip("abcdefghijkl");
+        RoundTrip(std::string(100000, 'x'));
+
+        std::mt19937 rng(22);
+        std::string noise(70000, '\0');
+        for (char& c : noise)
+        {
+            c = static_cast<char>(rng());
+        }
+        RoundTrip(noise);
+
+        std::string jsonl;
+        for (int i = 0; i < 2000; ++i)
+        {
+            jsonl += JsonLine(i);
+        }
+        const std::string encoded = RoundTrip(jsonl);
+        assert(encoded.size() * 3 < jsonl.size());
+
+        // Wrong output size, truncation and a bad offset are all refused.
+        std::string out(jsonl.size(), '\0');
+        assert(!Lz4Block::Decompress(encoded.data(), encoded.size(), out.data(), out.size() - 1));
+        assert(!Lz4Block::Decompress(encoded.data(), encoded.size() / 2, out.data(), out.size()));
+        const char badOffset[] = { 0x10, 'a', 0x00, 0x00, 0x00 };
+        assert(!Lz4Block::Decompress(badOffset, sizeof(badOffset), out.data(), 8));
+        const char farOffset[] = { 0x10, 'a', 0x05, 0x00, 0x00 };
+        assert(!Lz4Block::Decompress(farOffset, sizeof(farOffset), out.data(), 8));
+    }
+
+    const fs::path directory = fs::temp_directory_path() / "hs_segment_archive_test";
+    fs::remove_all(directory);
+    fs::create_directories(directory);
+    const fs::path path = directory / "local_history.jsonl.1.hsz";
+
+    std::string data;
+    std::vector<SegmentArchive::LineTime> lineTimes;
+    for (int i = 0; i < 6000; ++i)
+    {
+        lineTimes.push_back({ data.size(), 1714521600 + i * 600 });
+        data += JsonLine(i);
+    }
+
+    std::string error;
+    bool ok = SegmentArchive::Write(data, lineTimes, path, error);
+    assert(ok && error.empty());
+    assert(!fs::exists(fs::path(path.string() + ".tmp")));
+    assert(fs::file_size(path) * 3 < data.size());
+
+    // Whole segment.
+    {
+        SegmentArchive archive;
+        ok = archive.Open(path, error);
+        assert(ok);
+        assert(archive.RawSize() == data.size() && archive.BlockCount() > 4);
+        const size_t headLength = data.find('\n') + 1;
+        assert(archive.HeadLength() == headLength);
+
+        std::string restored;
+        ok = archive.ReadAll(restored, error);
+        assert(ok && restored == data);
+
+        uint64_t expectedOffset = 0;
+        for (size_t i = 0; i < archive.BlockCount(); ++i)
+        {
+            const SegmentArchive::BlockInfo& block = archive.Block(i);
+            assert(block.rawOffset == expectedOffset);
+            assert(block.rawOffset == 0 || data[block.rawOffset - 1] == '\n');
+            assert(block.minTimestamp <= block.maxTimestamp);
+            expectedOffset += block.rawSize;
+        }
+        assert(expectedOffset == data.size());
+
+        // A range inside one block inflates just that block.
+        const SegmentArchive::BlockInfo& middle = archive.Block(archive.BlockCount() / 2);
+        std::string range;
+        ok = archive.ReadRange(middle.minTimestamp, middle.minTimestamp, range, error);
+        assert(ok && range == data.substr(middle.rawOffset, middle.rawSize));
+
+        range.clear();
+        ok = archive.ReadRange(middle.minTimestamp, archive.Block(archive.BlockCount() - 1).maxTimestamp, range, error);
+        assert(ok && range == data.substr(middle.rawOffset));
+
+        range.clear();
+        ok = archive.ReadRange(0, 1000, range, error);
+        assert(ok && range.empty());
+    }
+
+    // Single lines longer than a block, and lines without timestamps.
+    {
+        const std::string longLine = std::string(200000, 'z') + "\n";
+        const std::string mixed = JsonLine(0) + longLine + JsonLine(1);
+        const std::vector<SegmentArchive::LineTime> times = { { 0, 1714521600 } };
+        const fs::path mixedPath = directory / "mixed.hsz";
+        ok = SegmentArchive::Write(mixed, times, mixedPath, error);
+        assert(ok);
+        SegmentArchive archive;
+        ok = archive.Open(mixedPath, error);
+        assert(ok);
+        std::string restored;
+        ok = archive.ReadAll(restored, error);
+        assert(ok && restored == mixed);
+
+        // Blocks with no known times are always part of a range.
+        std::string range;
+        ok = archive.ReadRange(0, 1000, range, error);
+        assert(ok && !range.empty() && range.find(longLine) != std::string::npos);
+    }
+
+    // Damage: a flipped byte in a block fails that block only; a damaged index fails Open.
+    {
+        SegmentArchive archive;
+        ok = archive.Open(path, error);
+        assert(ok);
+        const SegmentArchive::BlockInfo second = archive.Block(1);
+        archive.Close();
+
+        {
+            std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+            file.seekg(static_cast<std::streamoff>(second.fileOffset + second.storedSize / 2));
+            const char c = static_cast<char>(file.get());
+            file.seekp(static_cast<std::streamoff>(second.fileOffset + second.storedSize / 2));
+            file.put(static_cast<char>(c ^ 0x5A));
+        }
+        ok = archive.Open(path, error);
+        assert(ok);
+        std::string block;
+        ok = archive.ReadBlock(0, block, error);
+        assert(ok && block == data.substr(0, archive.Block(0).rawSize));
+        block.clear();
+        error.clear();
+        ok = archive.ReadBlock(1, block, error);
+        assert(!ok && block.empty() && !error.empty());
+        std::string restored;
+        ok = archive.ReadAll(restored, error);
+        assert(!ok);
+        archive.Close();
+
+        fs::resize_file(path, fs::file_size(path) - 1);
+        ok = archive.Open(path, error);
+        assert(!ok);
+    }
+
+    fs::remove_all(directory);
+    std::printf("SegmentArchiveTest passed\n");
+    return 0;
+}